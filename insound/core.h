@@ -5,21 +5,33 @@
 #include "core/AudioLoader.h"
 #include "core/BufferView.h"
 #include "core/Bus.h"
+#include "core/ChannelLayout.h"
 #include "core/Command.h"
+#include "core/CpuFeatures.h"
+#include "core/DataConverter.h"
 #include "core/Engine.h"
 #include "core/Effect.h"
 #include "core/effects.h"
+#include "core/Envelope.h"
 #include "core/Error.h"
 #include "core/Handle.h"
+#include "core/Interpolation.h"
 #include "core/logging.h"
 #include "core/Marker.h"
+#include "core/MixKernels.h"
 #include "core/MultiPool.h"
 #include "core/PCMSource.h"
 #include "core/PerfTimer.h"
+#include "core/platform/NullAudioDevice.h"
 #include "core/Pool.h"
+#include "core/RealtimeCheck.h"
+#include "core/RealtimeThread.h"
+#include "core/Resampler.h"
+#include "core/SampleConversion.h"
 #include "core/SampleFormat.h"
 #include "core/SoundBuffer.h"
 #include "core/Source.h"
+#include "core/SourceEvent.h"
 #include "core/StreamSource.h"
 #include "core/TimeUnit.h"
 #include "core/util.h"
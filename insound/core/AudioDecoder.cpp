@@ -7,6 +7,7 @@
 
 #include "external/miniaudio.h"
 #include "external/miniaudio_decoder_backends.h"
+#include "external/miniaudio_resampler.h"
 
 #include <vector>
 
@@ -47,19 +48,25 @@ namespace insound {
 
     AudioDecoder::AudioDecoder(AudioDecoder &&other) noexcept : m(other.m)
     {
-        close();
         other.m = nullptr;
     }
 
     AudioDecoder::~AudioDecoder()
     {
-        delete m;
+        if (m)
+        {
+            close();
+            delete m;
+        }
     }
 
     AudioDecoder &AudioDecoder::operator=(AudioDecoder &&other) noexcept
     {
-        close();
-        delete m;
+        if (m)
+        {
+            close();
+            delete m;
+        }
         m = other.m;
         other.m = nullptr;
 
@@ -157,6 +164,7 @@ namespace insound {
         config.pCustomBackendUserData = nullptr;
         config.ppCustomBackendVTables = customBackendVTables.data();
         config.customBackendCount = static_cast<ma_uint32>(customBackendVTables.size());
+        insound_ma_use_polyphase_resampler(&config.resampling, ResampleQuality::Medium);
 
         if (auto result = ma_decoder_init(
                 ma_decoder_on_read_rstream,
@@ -193,7 +201,15 @@ namespace insound {
         m->spec.channels = static_cast<int>(channels);
         m->spec.freq = static_cast<int>(sampleRate);
         m->spec.format = toFormat(format);
+
+        // Zero-ed target spec fields pass through the source's native format
         m->targetSpec = targetSpec;
+        if (m->targetSpec.freq == 0)
+            m->targetSpec.freq = m->spec.freq;
+        if (m->targetSpec.channels == 0)
+            m->targetSpec.channels = m->spec.channels;
+        if (m->targetSpec.format.flags() == 0)
+            m->targetSpec.format = m->spec.format;
         return true;
     }
 
@@ -222,57 +238,53 @@ namespace insound {
             return 0;
         }
 
-        uint64_t cursor;
-        if (!getCursorPCMFrames(&cursor))
-        {
-            return 0;
-        }
-
-        ma_uint64 framesRead = 0;
-        int framesLeft = static_cast<int>(pcmFrames - cursor);
-        if (framesLeft <= 0)
+        const auto frameBytes = m->targetSpec.bytesPerFrame();
+        int framesRead = 0;
+        bool restarted = false; // guards against spinning when a restarted loop still yields no frames
+        while (framesRead < sampleFrames)
         {
-            if (!m->looping)
-                return 0;
-        }
-        else
-        {
-            if (auto result = ma_decoder_read_pcm_frames(m->decoder, buffer, std::min(framesLeft, sampleFrames), &framesRead);
-                result != MA_SUCCESS && result != MA_AT_END)
+            uint64_t cursor;
+            if (!getCursorPCMFrames(&cursor))
             {
-                INSOUND_PUSH_ERROR(Result::MaErr, ma_result_description(result));
-                return -1;
+                break;
             }
-        }
 
-        if (m->looping)
-        {
-            while (true)
+            ma_uint64 read = 0;
+            if (cursor < pcmFrames)
             {
-                if (!getCursorPCMFrames(&cursor))
+                const auto toRead = std::min<uint64_t>(pcmFrames - cursor, sampleFrames - framesRead);
+                if (auto result = ma_decoder_read_pcm_frames(m->decoder, buffer + framesRead * frameBytes,
+                        toRead, &read);
+                    result != MA_SUCCESS && result != MA_AT_END)
                 {
-                    return static_cast<int>(framesRead);
+                    INSOUND_PUSH_ERROR(Result::MaErr, ma_result_description(result));
+                    return -1;
                 }
+            }
 
-                framesLeft = static_cast<int>(pcmFrames - cursor);
-                if (framesLeft == 0)
-                {
-                    auto result = ma_decoder_seek_to_pcm_frame(m->decoder, 0);
-                    if (result != MA_SUCCESS)
-                    {
-                        INSOUND_PUSH_ERROR(Result::MaErr, ma_result_description(result));
-                        return static_cast<int>(framesRead);
-                    }
-                }
+            if (read > 0)
+            {
+                framesRead += static_cast<int>(read);
+                restarted = false;
+                continue;
+            }
 
-                if (framesRead >= sampleFrames)
-                    break;
-                framesRead += readFrames(
-                    static_cast<int>(sampleFrames - framesRead),
-                    buffer + framesRead * m->targetSpec.bytesPerFrame());
+            // Reached the end. The resampler's latency may end output slightly before the reported length, so an
+            // empty read is treated as the end too, instead of waiting on a cursor that no longer advances.
+            if (!m->looping || restarted)
+            {
+                break;
+            }
+
+            if (auto result = ma_decoder_seek_to_pcm_frame(m->decoder, 0); result != MA_SUCCESS)
+            {
+                INSOUND_PUSH_ERROR(Result::MaErr, ma_result_description(result));
+                break;
             }
+            restarted = true;
         }
-        return static_cast<int>(framesRead);
+
+        return framesRead;
     }
 
     int AudioDecoder::readBytes(const int bytesToRead, uint8_t *buffer)
@@ -18,7 +18,7 @@ namespace insound {
 
         /// Open the file for streaming
         /// @param filepath     path to the file to open
-        /// @param targetSpec   spec to convert the audio to
+        /// @param targetSpec   spec to convert the audio to, any zero-ed fields keep the source's native values
         /// @param inMemory     whether to copy entire file into memory, from which to stream;
         ///                         true:  copy file into memory and stream from memory
         ///                         false: stream directly from file (default)
@@ -24,12 +24,15 @@ namespace insound {
 
         /// Open audio device
         /// @param frequency         requested sample rate for the output device
+        /// @param channels          requested number of interleaved output channels, up to 8; backends that can't
+        ///                          open that many open stereo instead, check `spec` for the channels obtained
         /// @param sampleFrameBuffer number of sample frames per buffer
         /// @param audioCallback     callback that the AudioDevice uses to retrieve mix output data to send to the audio card
         /// @param userdata          userdata to pass to the audio callback
         /// @returns whether device was successfully opened
         virtual bool open(
             int frequency,
+            int channels,
             int sampleFrameBuffer,
             AudioCallback audioCallback, ///< buffer to fill, may be swapped with internal buffer as long as it maintains its size
             void *userdata) = 0;
@@ -57,8 +57,8 @@ namespace insound {
             }
 
             auto sndBuffer = &emplacedIt->second;
-            auto future = m_threads.push([finalPath, sndBuffer, this](const int id) {
-                if (sndBuffer->load(finalPath, m_targetSpec))
+            auto future = m_threads.push([finalPath, sndBuffer, targetSpec = m_targetSpec, this](const int id) {
+                if (sndBuffer->load(finalPath, targetSpec))
                     m_count.store(m_count.load() + 1);
             });
 
@@ -157,6 +157,16 @@ namespace insound {
         return m->empty();
     }
 
+    const AudioSpec &AudioLoader::targetSpec() const
+    {
+        return m->m_targetSpec;
+    }
+
+    void AudioLoader::setTargetSpec(const AudioSpec &spec)
+    {
+        m->m_targetSpec = spec;
+    }
+
     const std::string &AudioLoader::baseDir() const
     {
         return m->m_baseDir;
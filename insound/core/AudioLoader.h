@@ -37,6 +37,14 @@ namespace insound {
         [[nodiscard]]
         bool empty() const;
 
+        /// Spec that files loaded afterward are converted to, defaults to the engine's spec
+        [[nodiscard]]
+        const AudioSpec &targetSpec() const;
+
+        /// Set the spec that files loaded afterward are converted to, e.g. int16 with 0 channels to keep sound effects
+        /// in a compact layout. See `SoundBuffer::load` for the supported layouts.
+        void setTargetSpec(const AudioSpec &spec);
+
         [[nodiscard]]
         const std::string &baseDir() const;
         void setBaseDir(const std::string &path);
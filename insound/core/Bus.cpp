@@ -1,9 +1,12 @@
 #include "Bus.h"
 
 #include "Command.h"
-#include "CpuIntrinsics.h"
 #include "Engine.h"
 #include "Error.h"
+#include "MixKernels.h"
+#include "ScratchArena.h"
+
+#include <algorithm>
 
 namespace insound {
 #define HANDLE_GUARD() do { if (detail::peekSystemError().code == Result::InvalidHandle) { \
@@ -14,11 +17,11 @@ namespace insound {
 
     Bus::Bus() :
         Source(),
-        m_sources(), m_buffer(), m_parent(), m_isMaster()
+        m_sources(), m_parent(), m_isMaster()
     {}
 
     Bus::Bus(Bus &&other) noexcept : Source(std::move(other)), m_sources(std::move(other.m_sources)),
-        m_buffer(std::move(other.m_buffer)), m_parent(other.m_parent), m_isMaster(other.m_isMaster)
+        m_parent(other.m_parent), m_isMaster(other.m_isMaster)
     {}
 
     bool Bus::updateParentClock(const uint32_t parentClock)
@@ -46,11 +49,11 @@ namespace insound {
 
         // Erase-remove idiom on all sound sources with discard flagged true
         m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(), [engine] (Handle<Source> &handle) {
-            if (!handle.isValid())
+            const auto source = handle.tryGet();
+            if (!source)
                 return true;
-            const auto source = handle.get();
 
-            if (const auto bus = dynamic_cast<Bus *>(source))
+            if (const auto bus = poolCast<Bus>(source))
                 bus->processRemovals(); // if graph is huge, this recursive call could be a problem...
 
             if (source->shouldDiscard())
@@ -83,6 +86,7 @@ namespace insound {
                     }
 
                     subBus->m_parent = command.bus;
+                    m_engine->markGraphChanged(); // the graph may have deepened
                 }
 
                 applyAppendSource(source);
@@ -105,160 +109,66 @@ namespace insound {
 
     int Bus::readImpl(uint8_t *output, int length)
     {
-        // calculate mix
-        int sourcei = 0;
-        for (const int sourcemax = static_cast<int>(m_sources.size()) - 4; sourcei <= sourcemax; sourcei += 4)
+        // Each batch of sources holds its scratch buffers until it has been summed into the output
+        auto &scratch = m_engine->getScratchArena();
+
+        const auto frames = static_cast<uint32_t>(length / (channelCount(m_layout) * sizeof(float)));
+        const auto samples = reinterpret_cast<float *>(output);
+
+        const float *batch[SumBatchSize];
+        int batchSize = 0;
+        const auto mark = scratch.mark();
+        for (const auto &handle : m_sources)
         {
-            // Read data from sources (unrolled).
             // note: these should be guaranteed valid because invalidation won't take place until deferred commands
-            const auto &sourceA = m_sources[sourcei].get();
-            const auto &sourceB = m_sources[sourcei + 1].get();
-            const auto &sourceC = m_sources[sourcei + 2].get();
-            const auto &sourceD = m_sources[sourcei + 3].get();
-
-            const float *dataA, *dataB, *dataC, *dataD;
-            sourceA->read(reinterpret_cast<const uint8_t **>(&dataA), length);
-            sourceB->read(reinterpret_cast<const uint8_t **>(&dataB), length);
-            sourceC->read(reinterpret_cast<const uint8_t **>(&dataC), length);
-            sourceD->read(reinterpret_cast<const uint8_t **>(&dataD), length);
-
-            // Sum each source together with output
-            const auto sampleLength =static_cast<int>(length / sizeof(float));
-            auto head = reinterpret_cast<float *>(output);
-            int i = 0;
-#if INSOUND_SSE
-            for (; i <= sampleLength - 16; i += 16)
-            {
-                const auto a0 = _mm_load_ps(dataA + i);
-                const auto a1 = _mm_load_ps(dataA + i + 4);
-                const auto a2 = _mm_load_ps(dataA + i + 8);
-                const auto a3 = _mm_load_ps(dataA + i + 12);
-                const auto b0 = _mm_load_ps(dataB + i);
-                const auto b1 = _mm_load_ps(dataB + i + 4);
-                const auto b2 = _mm_load_ps(dataB + i + 8);
-                const auto b3 = _mm_load_ps(dataB + i + 12);
-                const auto c0 = _mm_load_ps(dataC + i);
-                const auto c1 = _mm_load_ps(dataC + i + 4);
-                const auto c2 = _mm_load_ps(dataC + i + 8);
-                const auto c3 = _mm_load_ps(dataC + i + 12);
-                const auto d0 = _mm_load_ps(dataD + i);
-                const auto d1 = _mm_load_ps(dataD + i + 4);
-                const auto d2 = _mm_load_ps(dataD + i + 8);
-                const auto d3 = _mm_load_ps(dataD + i + 12);
-
-                const auto sample0 = _mm_add_ps(_mm_add_ps(a0, b0), _mm_add_ps(c0, d0));
-                const auto sample1 = _mm_add_ps(_mm_add_ps(a1, b1), _mm_add_ps(c1, d1));
-                const auto sample2 = _mm_add_ps(_mm_add_ps(a2, b2), _mm_add_ps(c2, d2));
-                const auto sample3 = _mm_add_ps(_mm_add_ps(a3, b3), _mm_add_ps(c3, d3));
-
-                const auto head0 = _mm_load_ps(head + i);
-                const auto head1 = _mm_load_ps(head + i + 4);
-                const auto head2 = _mm_load_ps(head + i + 8);
-                const auto head3 = _mm_load_ps(head + i + 12);
-
-                _mm_store_ps(head + i, _mm_add_ps(head0, sample0));
-                _mm_store_ps(head + i + 4, _mm_add_ps(head1, sample1));
-                _mm_store_ps(head + i + 8, _mm_add_ps(head2, sample2));
-                _mm_store_ps(head + i + 12, _mm_add_ps(head3, sample3));
-            }
-#elif INSOUND_WASM_SIMD
-            for (; i <= sampleLength - 16; i += 16)
-            {
-                const auto a0 = wasm_v128_load(dataA + i);
-                const auto a1 = wasm_v128_load(dataA + i + 4);
-                const auto a2 = wasm_v128_load(dataA + i + 8);
-                const auto a3 = wasm_v128_load(dataA + i + 12);
-                const auto b0 = wasm_v128_load(dataB + i);
-                const auto b1 = wasm_v128_load(dataB + i + 4);
-                const auto b2 = wasm_v128_load(dataB + i + 8);
-                const auto b3 = wasm_v128_load(dataB + i + 12);
-                const auto c0 = wasm_v128_load(dataC + i);
-                const auto c1 = wasm_v128_load(dataC + i + 4);
-                const auto c2 = wasm_v128_load(dataC + i + 8);
-                const auto c3 = wasm_v128_load(dataC + i + 12);
-                const auto d0 = wasm_v128_load(dataD + i);
-                const auto d1 = wasm_v128_load(dataD + i + 4);
-                const auto d2 = wasm_v128_load(dataD + i + 8);
-                const auto d3 = wasm_v128_load(dataD + i + 12);
-
-                const auto sample0 = wasm_f32x4_add(wasm_f32x4_add(a0, b0), wasm_f32x4_add(c0, d0));
-                const auto sample1 = wasm_f32x4_add(wasm_f32x4_add(a1, b1), wasm_f32x4_add(c1, d1));
-                const auto sample2 = wasm_f32x4_add(wasm_f32x4_add(a2, b2), wasm_f32x4_add(c2, d2));
-                const auto sample3 = wasm_f32x4_add(wasm_f32x4_add(a3, b3), wasm_f32x4_add(c3, d3));
-
-                const auto head0 = wasm_v128_load(head + i);
-                const auto head1 = wasm_v128_load(head + i + 4);
-                const auto head2 = wasm_v128_load(head + i + 8);
-                const auto head3 = wasm_v128_load(head + i + 12);
-
-                wasm_v128_store(head + i, wasm_f32x4_add(head0, sample0));
-                wasm_v128_store(head + i + 4, wasm_f32x4_add(head1, sample1));
-                wasm_v128_store(head + i + 8, wasm_f32x4_add(head2, sample2));
-                wasm_v128_store(head + i + 12, wasm_f32x4_add(head3, sample3));
-            }
-#elif INSOUND_ARM_NEON
-            for (; i <= (int)sampleLength - 16; i += 16)
+            const auto source = handle.get();
+            if (source->m_layout != m_layout)
             {
-                const auto a0 = vld1q_f32(dataA + i);
-                const auto a1 = vld1q_f32(dataA + i + 4);
-                const auto a2 = vld1q_f32(dataA + i + 8);
-                const auto a3 = vld1q_f32(dataA + i +  12);
-                const auto b0 = vld1q_f32(dataB + i);
-                const auto b1 = vld1q_f32(dataB + i + 4);
-                const auto b2 = vld1q_f32(dataB + i + 8);
-                const auto b3 = vld1q_f32(dataB + i + 12);
-                const auto c0 = vld1q_f32(dataC + i);
-                const auto c1 = vld1q_f32(dataC + i + 4);
-                const auto c2 = vld1q_f32(dataC + i + 8);
-                const auto c3 = vld1q_f32(dataC + i + 12);
-                const auto d0 = vld1q_f32(dataD + i);
-                const auto d1 = vld1q_f32(dataD + i + 4);
-                const auto d2 = vld1q_f32(dataD + i + 8);
-                const auto d3 = vld1q_f32(dataD + i + 12);
-
-                const auto sample0 = vaddq_f32(vaddq_f32(a0, b0), vaddq_f32(c0, d0));
-                const auto sample1 = vaddq_f32(vaddq_f32(a1, b1), vaddq_f32(c1, d1));
-                const auto sample2 = vaddq_f32(vaddq_f32(a2, b2), vaddq_f32(c2, d2));
-                const auto sample3 = vaddq_f32(vaddq_f32(a3, b3), vaddq_f32(c3, d3));
-
-                const auto head0 = vld1q_f32(head + i);
-                const auto head1 = vld1q_f32(head + i + 4);
-                const auto head2 = vld1q_f32(head + i + 8);
-                const auto head3 = vld1q_f32(head + i + 12);
-
-                vst1q_f32(head + i, vaddq_f32(head0, sample0));
-                vst1q_f32(head + i + 4, vaddq_f32(head1, sample1));
-                vst1q_f32(head + i + 8, vaddq_f32(head2, sample2));
-                vst1q_f32(head + i + 12, vaddq_f32(head3, sample3));
+                // Converted to this bus's layout on its own, above the batch's buffers
+                mixSource(source, samples, frames);
+                continue;
             }
-#endif
-            // Catch the leftover samples (should be divisible by 2 because of stereo)
-            for (; i <= sampleLength - 2; i += 2)
+
+            source->read(reinterpret_cast<const uint8_t **>(&batch[batchSize]), length);
+            if (++batchSize == SumBatchSize)
             {
-                const auto sample0 = dataA[i] + dataB[i] + dataC[i] + dataD[i];
-                const auto sample1 = dataA[i + 1] + dataB[i + 1] + dataC[i + 1] + dataD[i + 1];
-                head[i] += sample0;
-                head[i + 1] += sample1;
+                mixKernels().sum(batch, nullptr, batchSize, samples, static_cast<uint32_t>(length / sizeof(float)));
+                scratch.release(mark);
+                batchSize = 0;
             }
         }
-        // Catch the leftover sources
-        for (const int sourcecount = (int)m_sources.size(); sourcei < sourcecount; ++sourcei)
+
+        if (batchSize > 0)
         {
-            auto source = m_sources[sourcei].get();
+            mixKernels().sum(batch, nullptr, batchSize, samples, static_cast<uint32_t>(length / sizeof(float)));
+            scratch.release(mark);
+        }
+        return length;
+    }
 
-            const float *data0;
-            auto floatsToRead0 = source->read((const uint8_t **)&data0, length) / sizeof(float);
+    void Bus::mixSource(Source *source, float *output, const uint32_t frames)
+    {
+        auto &scratch = m_engine->getScratchArena();
+        const auto mark = scratch.mark();
 
-            auto head = reinterpret_cast<float *>(output);
-            for (int i = 0; i < floatsToRead0; i += 4)
-            {
-                head[i] += data0[i];
-                head[i + 1] += data0[i + 1];
-                head[i + 2] += data0[i + 2];
-                head[i + 3] += data0[i + 3];
-            }
+        const float *data;
+        source->read(reinterpret_cast<const uint8_t **>(&data),
+            static_cast<int>(frames * channelCount(source->m_layout) * sizeof(float)));
+        mixChannels(data, source->m_layout, output, m_layout, frames);
+
+        scratch.release(mark);
+    }
+
+    size_t Bus::height() const
+    {
+        size_t childHeight = 0;
+        for (const auto &handle : m_sources)
+        {
+            if (const auto bus = poolCast<Bus>(handle.tryGet()))
+                childHeight = std::max(childHeight, bus->height());
         }
-        return length;
+
+        return childHeight + 1;
     }
 
     bool Bus::applyAppendSource(const Handle<Source> &handle)
@@ -298,11 +208,11 @@ namespace insound {
             bool result = true;
             for (auto &handle : m_sources)
             {
-                if (!handle.isValid())
+                const auto source = handle.tryGet();
+                if (!source)
                     continue; // flag false result here?
 
-                auto source = handle.get();
-                if (auto bus = dynamic_cast<Bus *>(source))
+                if (auto bus = poolCast<Bus>(source))
                 {
                     if (!bus->release(true))
                         result = false;
@@ -349,9 +259,9 @@ namespace insound {
         return Source::release();
     }
 
-    bool Bus::init(Engine *engine, const Handle<Bus> &parent, bool paused)
+    bool Bus::init(Engine *engine, const Handle<Bus> &parent, bool paused, const ChannelLayout layout)
     {
-        if (!Source::init(engine, engine && parent && parent.isValid() ? parent->m_clock : 0, paused))
+        if (!Source::init(engine, engine && parent && parent.isValid() ? parent->m_clock : 0, paused, layout))
             return false;
         m_parent = parent;
         return true;
@@ -6,14 +6,19 @@
 namespace insound {
     struct BusCommand;
 
-    /// An audio bus that contains a list of audio sources and sums them into one output stream
+    /// An audio bus that contains a list of audio sources and sums them into one output stream in its channel layout.
+    /// Sources in other layouts are up- or downmixed as they are summed, see `mixChannels`.
     class Bus : public Source {
     public:
+        /// Most sources a bus reads before summing them into its output in one pass. Each holds up to two scratch
+        /// buffers until then, see `ScratchArena`.
+        static constexpr int SumBatchSize = 16;
+
         explicit Bus();
         Bus(Bus &&other) noexcept;
         ~Bus() override = default;
 
-        bool init(Engine *engine, const Handle<Bus> &parent, bool paused);
+        bool init(Engine *engine, const Handle<Bus> &parent, bool paused, ChannelLayout layout = ChannelLayout::Stereo);
 
         /// Connect a Source to an output Bus.
         /// Caller must manage duplicates.
@@ -46,12 +51,22 @@ namespace insound {
         bool applyRemoveSource(const Handle<Source> &bus);
 
         int readImpl(uint8_t *output, int length) override;
+
+        /// Read a source and add it to the output, converting it to this bus's layout
+        /// @param source source to read
+        /// @param output frames in this bus's layout to add to
+        /// @param frames number of frames to read
+        void mixSource(Source *source, float *output, uint32_t frames);
+
+        /// Number of bus levels from this bus down to its deepest sub-bus, 1 if it has none
+        [[nodiscard]]
+        size_t height() const;
+
         bool release(bool recursive);
         bool release() override;
 
     private: // Members
         std::vector<Handle<Source>> m_sources;
-        AlignedVector<float, 16> m_buffer; ///< temp buffer to calculate mix
         Handle<Bus> m_parent;
         bool m_isMaster;
     };
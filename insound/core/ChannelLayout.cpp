@@ -0,0 +1,360 @@
+#include "ChannelLayout.h"
+
+#include "CpuIntrinsics.h"
+#include "MixKernels.h"
+
+namespace insound {
+    namespace {
+        enum Speaker : uint8_t {
+            FrontLeft, FrontRight, FrontCenter, LowFrequency, BackLeft, BackRight, SideLeft, SideRight,
+            SpeakerCount
+        };
+
+        constexpr int LayoutCount = 5;
+
+        /// Gain that folds a speaker into its neighbours at equal power
+        constexpr float FoldGain = 0.70710678f;
+
+        /// Index of a layout in the matrix table
+        int layoutIndex(const ChannelLayout layout)
+        {
+            switch(layout)
+            {
+                case ChannelLayout::Mono: return 0;
+                case ChannelLayout::Stereo: return 1;
+                case ChannelLayout::Quad: return 2;
+                case ChannelLayout::Surround51: return 3;
+                default: return 4;
+            }
+        }
+
+        constexpr ChannelLayout Layouts[LayoutCount] = {
+            ChannelLayout::Mono, ChannelLayout::Stereo, ChannelLayout::Quad, ChannelLayout::Surround51,
+            ChannelLayout::Surround71,
+        };
+
+        const Speaker *speakers(const ChannelLayout layout)
+        {
+            static constexpr Speaker Mono[] = {FrontCenter};
+            static constexpr Speaker Stereo[] = {FrontLeft, FrontRight};
+            static constexpr Speaker Quad[] = {FrontLeft, FrontRight, BackLeft, BackRight};
+            static constexpr Speaker Surround51[] = {FrontLeft, FrontRight, FrontCenter, LowFrequency, BackLeft,
+                BackRight};
+            static constexpr Speaker Surround71[] = {FrontLeft, FrontRight, FrontCenter, LowFrequency, BackLeft,
+                BackRight, SideLeft, SideRight};
+
+            switch(layout)
+            {
+                case ChannelLayout::Mono: return Mono;
+                case ChannelLayout::Stereo: return Stereo;
+                case ChannelLayout::Quad: return Quad;
+                case ChannelLayout::Surround51: return Surround51;
+                default: return Surround71;
+            }
+        }
+
+        /// Gains from each input channel into each output channel of a pair of layouts
+        struct Matrix {
+            float gains[MaxChannels][MaxChannels]; ///< [output channel][input channel]
+        };
+
+        class MatrixBuilder {
+        public:
+            MatrixBuilder(const ChannelLayout input, const ChannelLayout output, Matrix *matrix) :
+                m_outputChannels(channelCount(output)), m_output(speakers(output)), m_matrix(matrix)
+            {
+                const auto inputSpeakers = speakers(input);
+                for (int i = 0; i < channelCount(input); ++i)
+                    add(i, inputSpeakers[i], 1.f);
+            }
+
+        private:
+            [[nodiscard]]
+            int find(const Speaker speaker) const
+            {
+                for (int o = 0; o < m_outputChannels; ++o)
+                {
+                    if (m_output[o] == speaker)
+                        return o;
+                }
+                return -1;
+            }
+
+            /// Route a speaker to the output, folding it into the nearest speakers the output has
+            void add(const int inputChannel, const Speaker speaker, const float gain)
+            {
+                if (const auto o = find(speaker); o != -1)
+                {
+                    m_matrix->gains[o][inputChannel] += gain;
+                    return;
+                }
+
+                switch(speaker)
+                {
+                    case FrontLeft: case FrontRight:
+                        add(inputChannel, FrontCenter, gain * FoldGain);
+                        break;
+                    case FrontCenter:
+                        add(inputChannel, FrontLeft, gain * FoldGain);
+                        add(inputChannel, FrontRight, gain * FoldGain);
+                        break;
+                    case BackLeft:
+                        if (find(SideLeft) != -1)
+                            add(inputChannel, SideLeft, gain);
+                        else
+                            add(inputChannel, FrontLeft, gain * FoldGain);
+                        break;
+                    case BackRight:
+                        if (find(SideRight) != -1)
+                            add(inputChannel, SideRight, gain);
+                        else
+                            add(inputChannel, FrontRight, gain * FoldGain);
+                        break;
+                    case SideLeft:
+                        if (find(BackLeft) != -1)
+                            add(inputChannel, BackLeft, gain);
+                        else
+                            add(inputChannel, FrontLeft, gain * FoldGain);
+                        break;
+                    case SideRight:
+                        if (find(BackRight) != -1)
+                            add(inputChannel, BackRight, gain);
+                        else
+                            add(inputChannel, FrontRight, gain * FoldGain);
+                        break;
+                    default: // LFE isn't folded into full-range speakers
+                        break;
+                }
+            }
+
+            int m_outputChannels;
+            const Speaker *m_output;
+            Matrix *m_matrix;
+        };
+
+        struct MatrixTable {
+            MatrixTable() : matrices()
+            {
+                for (int in = 0; in < LayoutCount; ++in)
+                {
+                    for (int out = 0; out < LayoutCount; ++out)
+                        MatrixBuilder(Layouts[in], Layouts[out], &matrices[in][out]);
+                }
+            }
+
+            Matrix matrices[LayoutCount][LayoutCount]; ///< [input layout][output layout]
+        };
+
+        /// Built on load, so the mixer never initializes it
+        const MatrixTable s_table;
+
+        const Matrix &matrix(const ChannelLayout input, const ChannelLayout output)
+        {
+            return s_table.matrices[layoutIndex(input)][layoutIndex(output)];
+        }
+
+        /// Downmix into stereo, two output frames per vector
+        void mixToStereo(const float *input, const int inputChannels, float *output, const Matrix &m,
+            const uint32_t frames)
+        {
+            // Skip silent input channels, e.g. LFE
+            int active[MaxChannels];
+            int activeCount = 0;
+            for (int i = 0; i < inputChannels; ++i)
+            {
+                if (m.gains[0][i] != 0 || m.gains[1][i] != 0)
+                    active[activeCount++] = i;
+            }
+
+            uint32_t f = 0;
+#if     INSOUND_SSE
+            __m128 columns[MaxChannels];
+            for (int c = 0; c < activeCount; ++c)
+                columns[c] = _mm_set_ps(m.gains[1][active[c]], m.gains[0][active[c]], m.gains[1][active[c]],
+                    m.gains[0][active[c]]);
+            for (; f + 2 <= frames; f += 2)
+            {
+                const auto frame0 = input + f * inputChannels;
+                const auto frame1 = frame0 + inputChannels;
+                auto sum = _mm_loadu_ps(output + f * 2);
+                for (int c = 0; c < activeCount; ++c)
+                {
+                    const auto samples = _mm_movelh_ps(_mm_set1_ps(frame0[active[c]]),
+                        _mm_set1_ps(frame1[active[c]]));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(samples, columns[c]));
+                }
+                _mm_storeu_ps(output + f * 2, sum);
+            }
+#elif   INSOUND_WASM_SIMD
+            v128_t columns[MaxChannels];
+            for (int c = 0; c < activeCount; ++c)
+                columns[c] = wasm_f32x4_make(m.gains[0][active[c]], m.gains[1][active[c]], m.gains[0][active[c]],
+                    m.gains[1][active[c]]);
+            for (; f + 2 <= frames; f += 2)
+            {
+                const auto frame0 = input + f * inputChannels;
+                const auto frame1 = frame0 + inputChannels;
+                auto sum = wasm_v128_load(output + f * 2);
+                for (int c = 0; c < activeCount; ++c)
+                {
+                    const auto samples = wasm_f32x4_make(frame0[active[c]], frame0[active[c]],
+                        frame1[active[c]], frame1[active[c]]);
+                    sum = wasm_f32x4_add(sum, wasm_f32x4_mul(samples, columns[c]));
+                }
+                wasm_v128_store(output + f * 2, sum);
+            }
+#elif   INSOUND_ARM_NEON
+            float32x4_t columns[MaxChannels];
+            for (int c = 0; c < activeCount; ++c)
+                columns[c] = float32x4_t{m.gains[0][active[c]], m.gains[1][active[c]], m.gains[0][active[c]],
+                    m.gains[1][active[c]]};
+            for (; f + 2 <= frames; f += 2)
+            {
+                const auto frame0 = input + f * inputChannels;
+                const auto frame1 = frame0 + inputChannels;
+                auto sum = vld1q_f32(output + f * 2);
+                for (int c = 0; c < activeCount; ++c)
+                {
+                    const auto samples = vcombine_f32(vdup_n_f32(frame0[active[c]]), vdup_n_f32(frame1[active[c]]));
+                    sum = vmlaq_f32(sum, samples, columns[c]);
+                }
+                vst1q_f32(output + f * 2, sum);
+            }
+#endif
+            for (; f < frames; ++f)
+            {
+                const auto frame = input + f * inputChannels;
+                for (int c = 0; c < activeCount; ++c)
+                {
+                    output[f * 2] += frame[active[c]] * m.gains[0][active[c]];
+                    output[f * 2 + 1] += frame[active[c]] * m.gains[1][active[c]];
+                }
+            }
+        }
+
+        /// Mix into any layout, four output channels of a frame per vector
+        void mixToAny(const float *input, const int inputChannels, float *output, const int outputChannels,
+            const Matrix &m, const uint32_t frames)
+        {
+            int active[MaxChannels];
+            int activeCount = 0;
+            for (int i = 0; i < inputChannels; ++i)
+            {
+                for (int o = 0; o < outputChannels; ++o)
+                {
+                    if (m.gains[o][i] != 0)
+                    {
+                        active[activeCount++] = i;
+                        break;
+                    }
+                }
+            }
+
+            // Output channels past the last full vector, e.g. the back pair of 5.1
+            const int vectorChannels = outputChannels / 4 * 4;
+#if     INSOUND_SSE
+            __m128 columns[MaxChannels / 4][MaxChannels];
+            for (int v = 0; v < vectorChannels; v += 4)
+            {
+                for (int c = 0; c < activeCount; ++c)
+                    columns[v / 4][c] = _mm_set_ps(m.gains[v + 3][active[c]], m.gains[v + 2][active[c]],
+                        m.gains[v + 1][active[c]], m.gains[v][active[c]]);
+            }
+#elif   INSOUND_WASM_SIMD
+            v128_t columns[MaxChannels / 4][MaxChannels];
+            for (int v = 0; v < vectorChannels; v += 4)
+            {
+                for (int c = 0; c < activeCount; ++c)
+                    columns[v / 4][c] = wasm_f32x4_make(m.gains[v][active[c]], m.gains[v + 1][active[c]],
+                        m.gains[v + 2][active[c]], m.gains[v + 3][active[c]]);
+            }
+#elif   INSOUND_ARM_NEON
+            float32x4_t columns[MaxChannels / 4][MaxChannels];
+            for (int v = 0; v < vectorChannels; v += 4)
+            {
+                for (int c = 0; c < activeCount; ++c)
+                    columns[v / 4][c] = float32x4_t{m.gains[v][active[c]], m.gains[v + 1][active[c]],
+                        m.gains[v + 2][active[c]], m.gains[v + 3][active[c]]};
+            }
+#endif
+
+            for (uint32_t f = 0; f < frames; ++f)
+            {
+                const auto in = input + f * inputChannels;
+                const auto out = output + f * outputChannels;
+                int o = 0;
+#if     INSOUND_SSE
+                for (; o < vectorChannels; o += 4)
+                {
+                    auto sum = _mm_loadu_ps(out + o);
+                    for (int c = 0; c < activeCount; ++c)
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(in[active[c]]), columns[o / 4][c]));
+                    _mm_storeu_ps(out + o, sum);
+                }
+#elif   INSOUND_WASM_SIMD
+                for (; o < vectorChannels; o += 4)
+                {
+                    auto sum = wasm_v128_load(out + o);
+                    for (int c = 0; c < activeCount; ++c)
+                        sum = wasm_f32x4_add(sum, wasm_f32x4_mul(wasm_f32x4_splat(in[active[c]]),
+                            columns[o / 4][c]));
+                    wasm_v128_store(out + o, sum);
+                }
+#elif   INSOUND_ARM_NEON
+                for (; o < vectorChannels; o += 4)
+                {
+                    auto sum = vld1q_f32(out + o);
+                    for (int c = 0; c < activeCount; ++c)
+                        sum = vmlaq_n_f32(sum, columns[o / 4][c], in[active[c]]);
+                    vst1q_f32(out + o, sum);
+                }
+#endif
+                for (; o < outputChannels; ++o)
+                {
+                    for (int c = 0; c < activeCount; ++c)
+                        out[o] += in[active[c]] * m.gains[o][active[c]];
+                }
+            }
+        }
+    }
+
+    bool layoutFromChannels(const int channels, ChannelLayout *outLayout)
+    {
+        for (const auto layout : Layouts)
+        {
+            if (channelCount(layout) == channels)
+            {
+                if (outLayout)
+                    *outLayout = layout;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    float channelGain(const ChannelLayout input, const int inputChannel, const ChannelLayout output,
+        const int outputChannel)
+    {
+        if (inputChannel < 0 || inputChannel >= channelCount(input) ||
+            outputChannel < 0 || outputChannel >= channelCount(output))
+            return 0;
+        return matrix(input, output).gains[outputChannel][inputChannel];
+    }
+
+    void mixChannels(const float *input, const ChannelLayout inputLayout, float *output,
+        const ChannelLayout outputLayout, const uint32_t frames)
+    {
+        if (inputLayout == outputLayout)
+        {
+            mixKernels().add(input, output, frames * channelCount(outputLayout));
+            return;
+        }
+
+        const auto &m = matrix(inputLayout, outputLayout);
+        if (outputLayout == ChannelLayout::Stereo)
+            mixToStereo(input, channelCount(inputLayout), output, m, frames);
+        else
+            mixToAny(input, channelCount(inputLayout), output, channelCount(outputLayout), m, frames);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+
+namespace insound {
+
+    /// Speaker arrangement of interleaved frames. Each value is its channel count, and channels are ordered as in
+    /// WAVE files.
+    enum class ChannelLayout : uint8_t {
+        Mono = 1,       ///< C
+        Stereo = 2,     ///< L, R
+        Quad = 4,       ///< L, R, back L, back R
+        Surround51 = 6, ///< L, R, C, LFE, back L, back R
+        Surround71 = 8, ///< L, R, C, LFE, back L, back R, side L, side R
+    };
+
+    /// Most channels in any layout
+    static constexpr int MaxChannels = 8;
+
+    /// Number of interleaved channels in a frame of `layout`
+    [[nodiscard]]
+    inline int channelCount(const ChannelLayout layout) { return static_cast<int>(layout); }
+
+    /// Get the layout with a number of channels
+    /// @param channels      channel count, e.g. of an opened device
+    /// @param outLayout [out] pointer to receive the layout
+    /// @returns whether a layout has this many channels
+    bool layoutFromChannels(int channels, ChannelLayout *outLayout);
+
+    /// Gain that a channel of one layout is mixed into a channel of another with. Speakers missing from the output
+    /// are folded into the nearest ones at equal power, e.g. center into left and right at -3 dB. Side and back
+    /// pairs stand in for each other. LFE is dropped when the output has none, and upmixing only feeds the matching
+    /// speakers, so stereo into 5.1 plays from the front left and right.
+    /// @param input         layout to mix from
+    /// @param inputChannel  channel index in `input`
+    /// @param output        layout to mix into
+    /// @param outputChannel channel index in `output`
+    [[nodiscard]]
+    float channelGain(ChannelLayout input, int inputChannel, ChannelLayout output, int outputChannel);
+
+    /// Add interleaved frames to frames of another layout, up- or downmixing by `channelGain`. Frames of the same
+    /// layout are summed.
+    /// @param input        frames to mix
+    /// @param inputLayout  layout of `input`
+    /// @param output       frames to add to
+    /// @param outputLayout layout of `output`
+    /// @param frames       number of frames in both buffers
+    void mixChannels(const float *input, ChannelLayout inputLayout, float *output, ChannelLayout outputLayout,
+        uint32_t frames);
+}
@@ -1,6 +1,9 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
+#include "Envelope.h"
+#include "Interpolation.h"
 #include "MultiPool.h"
 
 namespace insound {
@@ -85,6 +88,7 @@ namespace insound {
             struct {
                 uint32_t clock;
                 float value;
+                FadeCurve curve;
             } addfadepoint;
 
             struct {
@@ -125,6 +129,8 @@ namespace insound {
             SetSpeed,
             SetLooping,
             SetOneShot,
+            SetInterpolation,
+            SetLoopRegion,
         } type;
 
         /// Data union for the various commands set by `type`
@@ -144,6 +150,40 @@ namespace insound {
             struct {
                 bool oneshot;
             } setoneshot;
+
+            struct {
+                InterpolationMode mode;
+            } setinterpolation;
+
+            struct {
+                int index;          ///< loop region index in the buffer, -1 for the whole buffer
+                uint32_t start;
+                uint32_t end;
+                uint32_t crossfade;
+                const float *crossfadeData;
+            } setloopregion;
+        };
+    };
+
+    /// Identifies the parameter a command sets, commands with equal keys supersede each other
+    struct CommandKey {
+        const void *target; ///< object the command is applied to
+        int type;           ///< command type and subtype
+        int index;          ///< parameter index, or 0 if the command has none
+
+        bool operator==(const CommandKey &other) const
+        {
+            return target == other.target && type == other.type && index == other.index;
+        }
+
+        struct Hash {
+            size_t operator()(const CommandKey &key) const
+            {
+                auto h = reinterpret_cast<uintptr_t>(key.target);
+                h ^= static_cast<uintptr_t>(key.type) * 0x9E3779B1u + (h << 6) + (h >> 2);
+                h ^= static_cast<uintptr_t>(key.index) * 0x85EBCA77u + (h << 6) + (h >> 2);
+                return static_cast<size_t>(h);
+            }
         };
     };
 
@@ -165,6 +205,38 @@ namespace insound {
             BusCommand         bus;
         };
 
+        /// Get the key of a command that only sets the latest value of a continuous parameter, so that a newer
+        /// command with the same key may replace it in the queue instead of both being applied.
+        /// @param outKey [out] receives the key
+        /// @returns whether this command may be coalesced
+        bool getCoalesceKey(CommandKey *outKey) const
+        {
+            switch(type)
+            {
+                case Effect:
+                {
+                    if (effect.type == EffectCommand::SetFloat)
+                        *outKey = {effect.effect, (Effect << 8) | EffectCommand::SetFloat, effect.setfloat.index};
+                    else if (effect.type == EffectCommand::SetInt)
+                        *outKey = {effect.effect, (Effect << 8) | EffectCommand::SetInt, effect.setint.index};
+                    else
+                        return false;
+                    return true;
+                }
+
+                case PCMSource:
+                {
+                    if (pcmsource.type != PCMSourceCommand::SetSpeed)
+                        return false;
+                    *outKey = {pcmsource.source, (PCMSource << 8) | PCMSourceCommand::SetSpeed, 0};
+                    return true;
+                }
+
+                default:
+                    return false;
+            }
+        }
+
         // ====== Static helpers =============================================
 
         static Command makeBusAppendSource(Handle<class Bus> bus, Handle<class Source> handle)
@@ -218,6 +290,7 @@ namespace insound {
             Command c{};
             c.type = Effect;
             c.effect.effect = effect;
+            c.effect.type = EffectCommand::SetFloat;
             c.effect.setfloat.index = index;
             c.effect.setfloat.value = value;
 
@@ -228,6 +301,7 @@ namespace insound {
             Command c{};
             c.type = Effect;
             c.effect.effect = effect;
+            c.effect.type = EffectCommand::SetInt;
             c.effect.setint.index = index;
             c.effect.setint.value = value;
 
@@ -238,6 +312,7 @@ namespace insound {
             Command c{};
             c.type = Effect;
             c.effect.effect = effect;
+            c.effect.type = EffectCommand::SetString;
             c.effect.setstring.index = index;
             c.effect.setstring.value = value;
 
@@ -268,7 +343,8 @@ namespace insound {
             return c;
         }
 
-        static Command makeSourceAddFadePoint(class Source *source, const uint32_t clock, const float value)
+        static Command makeSourceAddFadePoint(class Source *source, const uint32_t clock, const float value,
+            const FadeCurve curve)
         {
             Command c{};
             c.type = Source;
@@ -276,11 +352,13 @@ namespace insound {
             c.source.type = SourceCommand::AddFadePoint;
             c.source.addfadepoint.clock = clock;
             c.source.addfadepoint.value = value;
+            c.source.addfadepoint.curve = curve;
 
             return c;
         }
 
-        static Command makeSourceAddFadeTo(class Source *source, const uint32_t clock, const float value)
+        static Command makeSourceAddFadeTo(class Source *source, const uint32_t clock, const float value,
+            const FadeCurve curve)
         {
             Command c{};
             c.type = Source;
@@ -288,6 +366,7 @@ namespace insound {
             c.source.type = SourceCommand::AddFadeTo;
             c.source.addfadepoint.clock = clock;
             c.source.addfadepoint.value = value;
+            c.source.addfadepoint.curve = curve;
 
             return c;
         }
@@ -330,7 +409,7 @@ namespace insound {
         {
             Command c{};
             c.type = PCMSource;
-            c.pcmsource.type = PCMSourceCommand::SetSpeed;
+            c.pcmsource.type = PCMSourceCommand::SetLooping;
             c.pcmsource.source = source;
             c.pcmsource.setlooping.looping = looping;
 
@@ -341,11 +420,38 @@ namespace insound {
         {
             Command c{};
             c.type = PCMSource;
-            c.pcmsource.type = PCMSourceCommand::SetSpeed;
+            c.pcmsource.type = PCMSourceCommand::SetOneShot;
             c.pcmsource.source = source;
             c.pcmsource.setoneshot.oneshot = oneshot;
 
             return c;
         }
+
+        static Command makePCMSourceSetInterpolation(class PCMSource *source, const InterpolationMode mode)
+        {
+            Command c{};
+            c.type = PCMSource;
+            c.pcmsource.type = PCMSourceCommand::SetInterpolation;
+            c.pcmsource.source = source;
+            c.pcmsource.setinterpolation.mode = mode;
+
+            return c;
+        }
+
+        static Command makePCMSourceSetLoopRegion(class PCMSource *source, const int index, const uint32_t start,
+            const uint32_t end, const uint32_t crossfade, const float *crossfadeData)
+        {
+            Command c{};
+            c.type = PCMSource;
+            c.pcmsource.type = PCMSourceCommand::SetLoopRegion;
+            c.pcmsource.source = source;
+            c.pcmsource.setloopregion.index = index;
+            c.pcmsource.setloopregion.start = start;
+            c.pcmsource.setloopregion.end = end;
+            c.pcmsource.setloopregion.crossfade = crossfade;
+            c.pcmsource.setloopregion.crossfadeData = crossfadeData;
+
+            return c;
+        }
     };
 }
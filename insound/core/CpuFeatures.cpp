@@ -0,0 +1,96 @@
+#include "CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define INSOUND_CPUID 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace insound {
+#if INSOUND_CPUID
+    /// Registers of a cpuid leaf: eax, ebx, ecx, edx
+    static void cpuid(const uint32_t leaf, const uint32_t subleaf, uint32_t *registers)
+    {
+#if defined(_MSC_VER)
+        int result[4];
+        __cpuidex(result, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+            registers[i] = static_cast<uint32_t>(result[i]);
+#else
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    /// Register state the operating system saves on context switches
+    static uint64_t xgetbv()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+
+    static CpuFeatures detect()
+    {
+        CpuFeatures features;
+
+        uint32_t registers[4];
+        cpuid(0, 0, registers);
+        const auto maxLeaf = registers[0];
+        if (maxLeaf < 1)
+            return features;
+
+        cpuid(1, 0, registers);
+        features.sse2 = (registers[3] >> 26) & 1;
+
+        const bool osxsave = (registers[2] >> 27) & 1;
+        if (!osxsave)
+            return features;
+
+        const auto state = xgetbv();
+        const bool ymm = (state & 0x6) == 0x6;    // xmm and ymm registers
+        const bool zmm = (state & 0xE6) == 0xE6;  // and the opmask and upper zmm registers
+        features.avx = ymm && ((registers[2] >> 28) & 1);
+        features.fma = ymm && ((registers[2] >> 12) & 1);
+
+        if (maxLeaf >= 7)
+        {
+            cpuid(7, 0, registers);
+            features.avx2 = features.avx && ((registers[1] >> 5) & 1);
+            features.avx512f = zmm && ((registers[1] >> 16) & 1);
+        }
+
+        return features;
+    }
+#else
+    static CpuFeatures detect()
+    {
+        return {};
+    }
+#endif
+
+    const CpuFeatures &cpuFeatures()
+    {
+        static const CpuFeatures features = detect();
+        return features;
+    }
+
+    const char *simdPathName(const SimdPath path)
+    {
+        switch(path)
+        {
+            case SimdPath::Neon: return "NEON";
+            case SimdPath::WasmSimd: return "WASM SIMD";
+            case SimdPath::Sse: return "SSE";
+            case SimdPath::Avx2: return "AVX2";
+            case SimdPath::Avx512: return "AVX-512";
+            default: return "Scalar";
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+namespace insound {
+
+    /// Instruction set extensions of the running CPU that the mix kernels can use. Each is only set if the
+    /// operating system also saves its registers across context switches.
+    struct CpuFeatures {
+        CpuFeatures() : sse2(), avx(), avx2(), fma(), avx512f() { }
+        bool sse2;
+        bool avx;
+        bool avx2;
+        bool fma;
+        bool avx512f;
+    };
+
+    /// Features detected on first call, then cached. All false on non-x86 CPUs.
+    [[nodiscard]]
+    const CpuFeatures &cpuFeatures();
+
+    /// Set of kernels the mixer runs with, from narrowest to widest vectors
+    enum class SimdPath : uint8_t {
+        Scalar,   ///< built without intrinsics, or for a CPU the build has no vector path for
+        Neon,     ///< 128-bit ARM
+        WasmSimd, ///< 128-bit WebAssembly
+        Sse,      ///< 128-bit x86, the path chosen at compile time
+        Avx2,     ///< 256-bit x86 with FMA, chosen at runtime
+        Avx512,   ///< 512-bit x86, chosen at runtime
+    };
+
+    /// Readable name of a path, e.g. for logs and benchmarks
+    [[nodiscard]]
+    const char *simdPathName(SimdPath path);
+}
@@ -29,9 +29,34 @@ inline float32x4_t vdivq_f32_approx(float32x4_t a, float32x4_t b) {
 #include <immintrin.h>
 #endif
 
+#ifdef __AVX2__
+#define INSOUND_AVX2 1
+#endif
+
 #ifdef __SSE__
 #define INSOUND_SSE 1
 #include <xmmintrin.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INSOUND_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef __SSSE3__
+#define INSOUND_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+// 256 and 512-bit kernels are compiled for their own targets and selected at runtime, see MixKernels.h
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(__EMSCRIPTEN__)
+#define INSOUND_X86_DISPATCH 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define INSOUND_TARGET(features) __attribute__((target(features)))
+#else
+#define INSOUND_TARGET(features)
+#endif
+#endif
+
 #endif
@@ -1,55 +1,409 @@
 #include "DataConverter.h"
 
-using namespace insound;
+#include "Error.h"
+#include "SampleConversion.h"
+#include "util.h"
 
-struct DataConverter::Impl {
-    AudioSpec inSpec, outSpec;
-};
+#include "external/miniaudio.h"
+#include "external/miniaudio_resampler.h"
 
-bool DataConverter::convert(uint8_t **inFrames, uint64_t inFrameCount) {
-#if defined(INSOUND_BACKEND_SDL2)
-    SDL_AudioCVT cvt;
-    auto cvtResult = SDL_BuildAudioCVT(&cvt,
-        inSpec.format.flags(), inSpec.channels, inSpec.freq,
-        outSpec.format.flags(), outSpec.channels, outSpec.freq);
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
-    if (cvtResult < 0)
+namespace insound {
+    /// Converts `count` samples of some format into float32
+    using ToFloatKernel = void(*)(const uint8_t *input, float *output, size_t count);
+
+    /// Converts `frames` of float32 data from one channel count to another
+    using ChannelKernel = void(*)(const float *input, float *output, size_t frames);
+
+    static void u8ToF32(const uint8_t *input, float *output, const size_t count)
+    {
+        convertU8ToF32(input, output, count);
+    }
+
+    static void s16ToF32(const uint8_t *input, float *output, const size_t count)
+    {
+        convertS16ToF32(reinterpret_cast<const int16_t *>(input), output, count);
+    }
+
+    static void s24ToF32(const uint8_t *input, float *output, const size_t count)
+    {
+        convertS24ToF32(input, output, count);
+    }
+
+    static void s32ToF32(const uint8_t *input, float *output, const size_t count)
     {
-        INSOUND_PUSH_ERROR(Result::SdlErr, SDL_GetError());
+        convertS32ToF32(reinterpret_cast<const int32_t *>(input), output, count);
+    }
+
+    static void f32ToF32(const uint8_t *input, float *output, const size_t count)
+    {
+        std::memcpy(output, input, count * sizeof(float));
+    }
+
+    /// @returns kernel to convert a sample format to float32, or nullptr if there is no fast path for it
+    static ToFloatKernel pickToFloatKernel(const SampleFormat &format)
+    {
+        if (format.bits() > 8 && format.isBigEndian() != (endian::native == endian::big))
+            return nullptr;
+
+        if (format.isFloat())
+            return format.bits() == 32 ? f32ToF32 : nullptr;
+
+        switch(format.bits())
+        {
+            case 8:
+                return format.isSigned() ? nullptr : u8ToF32;
+            case 16:
+                return format.isSigned() ? s16ToF32 : nullptr;
+            case 24:
+                return format.isSigned() ? s24ToF32 : nullptr;
+            case 32:
+                return format.isSigned() ? s32ToF32 : nullptr;
+            default:
+                return nullptr;
+        }
+    }
+
+    /// @returns whether a fast channel kernel is available, `outKernel` receives nullptr when none is required
+    static bool pickChannelKernel(const int inChannels, const int outChannels, ChannelKernel *outKernel)
+    {
+        if (inChannels == outChannels)
+        {
+            *outKernel = nullptr;
+            return true;
+        }
+
+        if (inChannels == 1 && outChannels == 2)
+        {
+            *outKernel = monoToStereo;
+            return true;
+        }
+
+        if (inChannels == 2 && outChannels == 1)
+        {
+            *outKernel = stereoToMono;
+            return true;
+        }
+
         return false;
     }
 
-    if (cvtResult == 0 && !cvt.needed) // no conversion needed, same formats
+    /// Number of samples converted per chunk before channel mapping and resampling, sized to stay in L1 cache
+    static constexpr uint64_t ChunkSamples = 1024;
+
+    struct DataConverter::Impl {
+        AudioSpec inSpec{}, outSpec{};
+        ToFloatKernel toFloat{};
+        ChannelKernel mapChannels{};
+        bool isFastPath{};
+        bool isResampling{};
+        Resampler resampler{};          ///< used by the fast path when sample rates differ
+        ma_data_converter *converter{}; ///< fallback used when there is no fast path
+
+        void cleanupConverter()
+        {
+            if (converter)
+            {
+                ma_data_converter_uninit(converter, nullptr);
+                delete converter;
+                converter = nullptr;
+            }
+        }
+
+        /// Convert input to float32 with the output's channel count
+        /// @returns pointer to converted data, either `output` or one of the chunk buffers
+        const float *toFloatChunk(const uint8_t *input, const uint64_t frames, float *chunkA, float *chunkB) const
+        {
+            toFloat(input, chunkA, frames * inSpec.channels);
+            if (!mapChannels)
+                return chunkA;
+
+            mapChannels(chunkA, chunkB, frames);
+            return chunkB;
+        }
+
+        /// Fast path with sample rate conversion: convert chunks to float32, then run the resampler on each
+        void processResample(const uint8_t *input, uint64_t *inFrameCount, float *output, uint64_t *outFrameCount)
+        {
+            alignas(16) float chunkA[ChunkSamples];
+            alignas(16) float chunkB[ChunkSamples];
+
+            const auto chunkFrames = ChunkSamples / std::max(inSpec.channels, outSpec.channels);
+            const auto inFrameBytes = inSpec.bytesPerFrame();
+            const auto inCount = *inFrameCount, outCount = *outFrameCount;
+
+            uint64_t inUsed = 0, outDone = 0;
+            do {
+                auto inFrames = std::min(chunkFrames, inCount - inUsed);
+                auto outFrames = outCount - outDone;
+
+                const auto data = input ? toFloatChunk(input + inUsed * inFrameBytes, inFrames, chunkA, chunkB) :
+                    nullptr; // silence flushes the resampler
+                resampler.process(data, &inFrames, output + outDone * outSpec.channels, &outFrames);
+
+                inUsed += inFrames;
+                outDone += outFrames;
+                if (inFrames == 0 && outFrames == 0)
+                    break;
+            } while (inUsed < inCount && outDone < outCount);
+
+            *inFrameCount = inUsed;
+            *outFrameCount = outDone;
+        }
+    };
+
+    DataConverter::DataConverter() : m(new Impl)
+    {
+    }
+
+    DataConverter::DataConverter(const AudioSpec &input, const AudioSpec &output, const ResampleQuality quality) :
+        m(new Impl)
+    {
+        setSpecs(input, output, quality);
+    }
+
+    DataConverter::~DataConverter()
+    {
+        m->cleanupConverter();
+        delete m;
+    }
+
+    bool DataConverter::setSpecs(const AudioSpec &input, const AudioSpec &output, const ResampleQuality quality)
     {
-        if (outLength)
-            *outLength = length;
-        if (outBuffer)
-            *outBuffer = audioData;
-        else
-            std::free(audioData);
+        m->cleanupConverter();
+        m->inSpec = input;
+        m->outSpec = output;
+        m->isResampling = input.freq != output.freq;
+
+        ChannelKernel mapChannels = nullptr;
+        const auto toFloat = pickToFloatKernel(input.format);
+        const auto outIsFloat = output.format.isFloat() && output.format.bits() == 32 &&
+            output.format.isBigEndian() == (endian::native == endian::big);
+
+        if (toFloat && outIsFloat && pickChannelKernel(input.channels, output.channels, &mapChannels))
+        {
+            if (m->isResampling && !m->resampler.init(output.channels, input.freq, output.freq, quality))
+                return false;
+
+            m->toFloat = toFloat;
+            m->mapChannels = mapChannels;
+            m->isFastPath = true;
+            return true;
+        }
+
+        m->toFloat = nullptr;
+        m->mapChannels = nullptr;
+        m->isFastPath = false;
+
+        auto config = ma_data_converter_config_init(
+            (ma_format)toMaFormat(input.format), (ma_format)toMaFormat(output.format),
+            input.channels, output.channels, input.freq, output.freq);
+        insound_ma_use_polyphase_resampler(&config.resampling, quality);
+
+        const auto converter = new ma_data_converter;
+        if (const auto result = ma_data_converter_init(&config, nullptr, converter);
+            result != MA_SUCCESS)
+        {
+            delete converter;
+            INSOUND_PUSH_ERROR(Result::MaErr, ma_result_description(result));
+            return false;
+        }
+
+        m->converter = converter;
+        return true;
+    }
+
+    const AudioSpec &DataConverter::inputSpec() const
+    {
+        return m->inSpec;
+    }
+
+    const AudioSpec &DataConverter::outputSpec() const
+    {
+        return m->outSpec;
+    }
+
+    bool DataConverter::isFastPath() const
+    {
+        return m->isFastPath;
+    }
+
+    uint64_t DataConverter::toInFrames(const uint64_t outputFrames) const
+    {
+        if (m->isFastPath)
+            return m->isResampling ? m->resampler.requiredInputFrames(outputFrames) : outputFrames;
+
+        ma_uint64 inputFrames = 0;
+        if (m->converter)
+            ma_data_converter_get_required_input_frame_count(m->converter, outputFrames, &inputFrames);
+        return inputFrames;
+    }
+
+    uint64_t DataConverter::toOutFrames(const uint64_t inputFrames) const
+    {
+        if (m->isFastPath)
+            return m->isResampling ? m->resampler.expectedOutputFrames(inputFrames) : inputFrames;
+
+        ma_uint64 outputFrames = 0;
+        if (m->converter)
+            ma_data_converter_get_expected_output_frame_count(m->converter, inputFrames, &outputFrames);
+        return outputFrames;
+    }
+
+    bool DataConverter::process(const uint8_t *inFrames, uint64_t *inFrameCount, uint8_t *outFrames,
+                                uint64_t *outFrameCount)
+    {
+        if (!inFrameCount || !outFrameCount)
+        {
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "inFrameCount and outFrameCount must not be null");
+            return false;
+        }
+
+        if (!m->isFastPath)
+        {
+            if (!m->converter)
+            {
+                INSOUND_PUSH_ERROR(Result::LogicErr, "DataConverter specs were not set");
+                return false;
+            }
+
+            ma_uint64 frameCountIn = *inFrameCount;
+            ma_uint64 frameCountOut = *outFrameCount;
+            if (const auto result = ma_data_converter_process_pcm_frames(m->converter,
+                    inFrames, &frameCountIn, outFrames, &frameCountOut);
+                result != MA_SUCCESS)
+            {
+                INSOUND_PUSH_ERROR(Result::MaErr, ma_result_description(result));
+                return false;
+            }
+
+            *inFrameCount = frameCountIn;
+            *outFrameCount = frameCountOut;
+            return true;
+        }
+
+        auto output = reinterpret_cast<float *>(outFrames);
+        if (m->isResampling)
+        {
+            m->processResample(inFrames, inFrameCount, output, outFrameCount);
+            return true;
+        }
+
+        const auto frames = std::min(*inFrameCount, *outFrameCount);
+        const auto inChannels = static_cast<uint64_t>(m->inSpec.channels);
+
+        if (!m->mapChannels) // same channel count, convert directly into the output
+        {
+            m->toFloat(inFrames, output, frames * inChannels);
+        }
+        else                 // convert in small chunks that stay in cache, then map the channels to the output
+        {
+            alignas(16) float chunk[ChunkSamples];
+
+            const auto chunkFrames = ChunkSamples / inChannels;
+            const auto inFrameBytes = m->inSpec.bytesPerFrame();
+            const auto outChannels = static_cast<uint64_t>(m->outSpec.channels);
+
+            for (uint64_t frame = 0; frame < frames; frame += chunkFrames)
+            {
+                const auto count = std::min(chunkFrames, frames - frame);
+                m->toFloat(inFrames + frame * inFrameBytes, chunk, count * inChannels);
+                m->mapChannels(chunk, output + frame * outChannels, count);
+            }
+        }
+
+        *inFrameCount = frames;
+        *outFrameCount = frames;
         return true;
     }
 
-    // Convert audio
-    cvt.len = (int)length;
-    cvt.buf = (uint8_t *)std::realloc(audioData, cvt.len * cvt.len_mult);
-    cvtResult = SDL_ConvertAudio(&cvt);
+    bool DataConverter::convert(uint8_t **inFrames, const uint64_t inFrameCount, uint64_t *outFrameCount)
+    {
+        if (!inFrames)
+        {
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "inFrames must not be null");
+            return false;
+        }
+
+        // Whole-buffer conversion maps input time 1:1 to output time, so the result's length is known up front
+        const auto frameCount = m->isResampling ?
+            (inFrameCount * m->outSpec.freq + m->inSpec.freq - 1) / m->inSpec.freq :
+            inFrameCount;
+        const auto outFrameBytes = m->outSpec.bytesPerFrame();
+        auto output = static_cast<uint8_t *>(std::malloc(frameCount * outFrameBytes));
+        if (!output)
+        {
+            INSOUND_PUSH_ERROR(Result::OutOfMemory, "Failed to allocate conversion buffer");
+            return false;
+        }
 
-    if (outLength)
-        *outLength = cvt.len_cvt;
+        uint64_t inUsed = 0, outDone = 0;
+        while (inUsed < inFrameCount && outDone < frameCount)
+        {
+            auto inCount = inFrameCount - inUsed;
+            auto outCount = frameCount - outDone;
+            if (!process(*inFrames + inUsed * m->inSpec.bytesPerFrame(), &inCount,
+                output + outDone * outFrameBytes, &outCount))
+            {
+                std::free(output);
+                return false;
+            }
 
-    if (outBuffer)
-        *outBuffer = cvt.buf;
-    else
-        std::free(cvt.buf);
+            inUsed += inCount;
+            outDone += outCount;
+            if (inCount == 0 && outCount == 0)
+                break;
+        }
 
-    if (cvtResult != 0)
-        INSOUND_PUSH_ERROR(Result::SdlErr, SDL_GetError());
+        // Flush the resampler's tail with silence
+        if (m->isResampling && outDone < frameCount)
+        {
+            if (m->isFastPath)
+            {
+                while (outDone < frameCount)
+                {
+                    auto inCount = m->resampler.requiredInputFrames(frameCount - outDone);
+                    auto outCount = frameCount - outDone;
+                    m->processResample(nullptr, &inCount, reinterpret_cast<float *>(output) +
+                        outDone * m->outSpec.channels, &outCount);
+                    outDone += outCount;
+                    if (outCount == 0)
+                        break;
+                }
+            }
+            else
+            {
+                // silence in the input format: unsigned 8-bit is centered at 128, every other format at 0
+                const auto inFrameBytes = m->inSpec.bytesPerFrame();
+                uint8_t silence[ChunkSamples * sizeof(float)];
+                std::memset(silence, m->inSpec.format.bits() == 8 && !m->inSpec.format.isSigned() ? 0x80 : 0,
+                    sizeof(silence));
 
-    return cvtResult == 0;;
-#elif defined(INSOUND_BACKEND_SDL3)
-    return false; // TODO: implement
-#else
-    return false; // TODO: implement
-#endif
+                while (outDone < frameCount)
+                {
+                    auto inCount = static_cast<uint64_t>(sizeof(silence) / inFrameBytes);
+                    auto outCount = frameCount - outDone;
+                    if (!process(silence, &inCount, output + outDone * outFrameBytes, &outCount))
+                    {
+                        std::free(output);
+                        return false;
+                    }
+
+                    outDone += outCount;
+                    if (outCount == 0 && inCount == 0)
+                        break;
+                }
+            }
+        }
+
+        std::free(*inFrames);
+        *inFrames = output;
+
+        if (outFrameCount)
+            *outFrameCount = outDone;
+        return true;
+    }
 }
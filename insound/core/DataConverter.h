@@ -1,28 +1,56 @@
 #pragma once
 
 #include "AudioSpec.h"
+#include "Resampler.h"
 
 namespace insound {
-    /// Handles conversions of channel and sample formats
+    /// Handles conversions of channel and sample formats, and sample rate.
+    /// Conversions to native-endian float32 with equal channel counts or mono <-> stereo run through vectorized
+    /// kernels selected in `setSpecs`, followed by the polyphase `Resampler` if sample rates differ.
+    /// All other conversions fall back to miniaudio, still using the polyphase resampler.
     class DataConverter {
     public:
         DataConverter();
-        DataConverter(const AudioSpec &input, const AudioSpec &output);
+        DataConverter(const AudioSpec &input, const AudioSpec &output,
+            ResampleQuality quality = ResampleQuality::Medium);
         ~DataConverter();
 
-        void setSpecs(const AudioSpec &input, const AudioSpec &output);
+        DataConverter(const DataConverter &) = delete;
+        DataConverter &operator=(const DataConverter &) = delete;
+
+        /// Set the input and output specs, selecting the conversion path to use
+        /// @param input   spec of the data to convert
+        /// @param output  spec to convert to
+        /// @param quality resampler quality tier, used when sample rates differ
+        /// @returns whether operation succeeded, check `popError()` for details on `false`
+        bool setSpecs(const AudioSpec &input, const AudioSpec &output,
+            ResampleQuality quality = ResampleQuality::Medium);
         [[nodiscard]] const AudioSpec &inputSpec() const;
         [[nodiscard]] const AudioSpec &outputSpec() const;
 
+        /// @returns whether conversion runs through the built-in vectorized kernels, rather than miniaudio
+        [[nodiscard]] bool isFastPath() const;
+
         [[nodiscard]] uint64_t toInFrames(uint64_t outputFrames) const;
         [[nodiscard]] uint64_t toOutFrames(uint64_t inputFrames) const;
 
-        bool process(uint8_t *inFrames, uint64_t inFrameCount, uint8_t *outFrames, uint64_t *outFrameCount);
+        /// Convert a block of sample frames. When resampling, output lags input by the filter's latency, so not all
+        /// input may produce output until more is provided.
+        /// @param inFrames        input data, in the format of `inputSpec()`
+        /// @param inFrameCount    [in/out] pass number of frames available in `inFrames`, receives number consumed
+        /// @param outFrames       output buffer to write converted data in the format of `outputSpec()`
+        /// @param outFrameCount   [in/out] pass the capacity of `outFrames` in frames, receives number of frames written
+        /// @returns whether operation succeeded, check `popError()` for details on `false`
+        bool process(const uint8_t *inFrames, uint64_t *inFrameCount, uint8_t *outFrames, uint64_t *outFrameCount);
 
-        /// Intended for a single conversion of an entire buffer at one time.
-        /// Buffer is resized, if necessary and returned. If this function returns true, the initial pointer will be
-        /// invalidated and a new one is returned, filled with the sample data.
-        bool convert(uint8_t **inFrames, uint64_t inFrameCount);
+        /// Intended for a single conversion of an entire buffer at one time. The resampler's tail is flushed, so the
+        /// result holds every converted frame.
+        /// If this function returns true, the initial pointer will be freed and replaced with a new one that was
+        /// allocated with `std::malloc`, filled with the converted sample data.
+        /// @param inFrames        [in/out] pointer to the `std::malloc`-ed buffer to convert
+        /// @param inFrameCount    number of frames in the buffer
+        /// @param outFrameCount   [out] optional, receives the number of frames in the resulting buffer
+        bool convert(uint8_t **inFrames, uint64_t inFrameCount, uint64_t *outFrameCount = nullptr);
     private:
         struct Impl;
         Impl *m;
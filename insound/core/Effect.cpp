@@ -9,7 +9,8 @@ namespace insound {
     return false; \
 } } while(0)
 
-    Effect::Effect(Effect &&other) noexcept : m_engine(other.m_engine)
+    Effect::Effect(Effect &&other) noexcept : PoolTyped(other), m_engine(other.m_engine),
+        m_channels(other.m_channels)
     {}
 
     bool Effect::sendFloat(int index, float value)
@@ -1,15 +1,25 @@
 #pragma once
+#include "Pool.h"
+
+#include <cstdint>
 
 namespace insound {
     struct EffectCommand;
     class Engine;
 
+    /// Order of the samples an Effect processes
+    enum class SampleOrder : uint8_t {
+        Interleaved, ///< frames of `channels()` samples, passed to `process`
+        Planar,      ///< a block of samples per channel, passed to `processPlanar`
+        Either,      ///< planar while the Source's block already is, so it's never converted for this effect
+    };
+
     /// Base class for an audio effect, which is insertable into any Source object
-    class Effect {
+    class Effect : public PoolTyped {
     public:
         virtual ~Effect() = default;
     protected:
-        Effect() : m_engine() { }
+        Effect() : m_engine(), m_channels(2) { }
         Effect(Effect &&other) noexcept;
 
         /// Set a floating point parameter value
@@ -30,6 +40,10 @@ namespace insound {
         [[nodiscard]]
         const Engine *engine() const { return m_engine; }
 
+        /// Number of interleaved channels in each frame passed to `process`, the channel count of the Source's layout
+        [[nodiscard]]
+        int channels() const { return m_channels; }
+
         /// Clean up logic
         virtual void release() { }
     private:
@@ -61,14 +75,35 @@ namespace insound {
 
         /// Required to override for this effect's processing logic
         /// @param input  input buffer filled with data to process
-        /// @param output output buffer to write to (comes cleared to 0)
+        /// @param output output buffer to write to, its previous contents are unspecified, so every sample must be
+        ///               written. Same as `input` if `processesInPlace` returns true.
         /// @param count  number of samples, the length of both input and output arrays. This value is guaranteed to
         ///               be a multiple of 4 for optimization purposes.
-        /// @note both input and output buffers are interleaved stereo, so samples will occur in L-R-L-R order
+        /// @note both input and output buffers are interleaved in the Source's layout, `channels()` samples per
+        ///       frame, e.g. L-R-L-R order for stereo
         /// @returns whether anything has been processed. For efficiency if nothing should be altered, return false,
         ///          and it will act as if bypassed. Return true otherwise when data has been processed normally.
         virtual bool process(const float *input, float *output, int count) = 0;
 
+        /// Override to return true if `process` works when `input` and `output` are the same buffer, i.e. it reads
+        /// every input sample it needs before writing over it. Saves the Source a buffer swap.
+        [[nodiscard]]
+        virtual bool processesInPlace() const { return false; }
+
+        /// Override to receive planar blocks in `processPlanar`, e.g. for filters and other per-channel effects
+        /// that would otherwise shuffle channels apart. The Source deinterleaves its block for the first planar
+        /// effect, and interleaves it again for the next one that isn't.
+        [[nodiscard]]
+        virtual SampleOrder sampleOrder() const { return SampleOrder::Interleaved; }
+
+        /// Required to override if `sampleOrder` isn't `Interleaved`, processes a block in-place
+        /// @param planes one pointer per channel, `channels()` of them, each to `frames` samples. Planes are only
+        ///               16-byte aligned when `frames` is a multiple of 4.
+        /// @param frames number of frames in the block
+        /// @returns whether anything has been processed, false acts as if bypassed
+        virtual bool processPlanar(float *const *planes, int frames) { return false; }
+
         Engine *m_engine;
+        int m_channels; ///< set by the Source the effect is added to
     };
 }
@@ -9,11 +9,20 @@
 #include "Error.h"
 #include "lib.h"
 #include "PCMSource.h"
+#include "RealtimeCheck.h"
+#include "RealtimeThread.h"
+#include "ScratchArena.h"
 #include "SoundBuffer.h"
 #include "StreamSource.h"
 #include "Source.h"
+#include "SpscQueue.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace insound {
@@ -28,14 +37,39 @@ namespace insound {
 #define ENGINE_INIT_GUARD()
 #endif
 
+    /// Number of sources the mixer can queue for release between calls to `Engine::update`
+    static constexpr size_t GarbageQueueCapacity = 1024;
+    /// Number of errors the mixer can report between calls to `Engine::update`
+    static constexpr size_t AudioErrorQueueCapacity = 128;
+    /// Number of events the mixer can queue between calls to `Engine::update`
+    static constexpr size_t EventQueueCapacity = 1024;
+    /// Scratch buffers the mixer may hold per bus level: the bus's output, and two each for the rest of a batch read
+    /// ahead of the one being read, whose own buffers are counted by the level below
+    static constexpr size_t ScratchBuffersPerLevel = 1 + 2 * (Bus::SumBatchSize - 1);
+    /// Scratch buffers a source may hold without a bus: its output and an effect's output
+    static constexpr size_t ScratchBuffersPerSource = 2;
+    /// Frames the mixer renders at a time unless set otherwise, see `Engine::setRenderQuantum`. Smaller quanta shrink
+    /// the mix buffers further, but add the per-read overhead of every source once more per quantum.
+    static constexpr int DefaultRenderQuantum = 512;
+
     struct Engine::Impl {
     public:
-        explicit Impl(Engine *engine) : m_engine(engine), m_clock(), m_masterBus(),
-                                        m_device(), m_deferredCommands(),
+        Impl(Engine *engine, AudioDevice *device) : m_engine(engine), m_clock(), m_masterBus(),
+                                        m_device(), m_deferredCommands(), m_coalesceSlots(), m_processingCommands(),
                                         m_immediateCommands(),
-                                        m_discardFlag(false), m_immediateCommandMutex(), m_deferredCommandMutex(), m_mixMutex()
+                                        m_discardFlag(false), m_garbage(GarbageQueueCapacity),
+                                        m_garbageOverflows(0), m_garbageCollected(0), m_deadSources(),
+                                        m_deadEffects(), m_audioErrors(AudioErrorQueueCapacity),
+                                        m_events(EventQueueCapacity), m_eventsEnabled(false), m_droppedEvents(0),
+                                        m_eventCallback(), m_eventUserdata(), m_scratch(), m_graphHeight(),
+                                        m_scratchChannels(), m_scratchFrames(),
+                                        m_renderQuantum(DefaultRenderQuantum), m_graphChanged(false),
+                                        m_realtimeOptions(), m_realtimeVersion(), m_setupThread(), m_setupVersion(),
+                                        m_threadSettings(), m_priorityRaised(false), m_pinned(false), m_threadSetups(0),
+                                        m_immediateCommandMutex(), m_deferredCommandMutex(),
+                                        m_mixMutex()
         {
-            m_device = AudioDevice::create();
+            m_device = device ? device : AudioDevice::create();
         }
 
         ~Impl()
@@ -45,15 +79,25 @@ namespace insound {
             AudioDevice::destroy(m_device); // delete the device
         }
 
-        bool open(const int frequency = 0, const int samples = 1024)
+        bool open(const int frequency = 0, const int samples = 1024,
+            const ChannelLayout layout = ChannelLayout::Stereo)
         {
-            if (!m_device->open(frequency, samples, &Impl::audioCallback, this))
+            if (!m_device->open(frequency, channelCount(layout), samples, &Impl::audioCallback, this))
             {
                 return false;
             }
 
+            // The device may open with other channels than requested, the master bus mixes for the ones it has
+            ChannelLayout deviceLayout;
+            if (!layoutFromChannels(m_device->spec().channels, &deviceLayout))
+            {
+                INSOUND_PUSH_ERROR(Result::NotSupported, "Engine::open: device opened with an unsupported channel count");
+                m_device->close();
+                return false;
+            }
+
             Handle<Bus> busHandle;
-            if (!createBus(false, {}, &busHandle, true))
+            if (!createBus(false, {}, deviceLayout, &busHandle, true))
             {
                 m_device->close();
                 return false;
@@ -70,22 +114,33 @@ namespace insound {
             {
                 if (m_masterBus.isValid())
                 {
-                    auto lockGuard = std::lock_guard(m_mixMutex);
-                    m_masterBus->m_isMaster = false; // enable bus deletion
-                    release(
-                        static_cast<Handle<Source>>(m_masterBus), true);
+                    {
+                        auto lockGuard = std::lock_guard(m_mixMutex);
+                        m_masterBus->m_isMaster = false; // enable bus deletion
+                        release(
+                            static_cast<Handle<Source>>(m_masterBus), true);
 
-                    processCommands(this, m_immediateCommands); // flush command buffers
-                    processCommands(this, m_deferredCommands);
+                        processCommands(this, m_immediateCommands); // flush command buffers
+                        m_coalesceSlots.clear();
+                        processCommands(this, m_deferredCommands);
 
-                    m_masterBus->processRemovals();
-                    m_engine->destroySource(
-                        static_cast<Handle<Source>>(m_masterBus));
-                    m_masterBus = {};
+                        Source *source;
+                        while (m_garbage.tryPop(&source)) { } // the graph is released recursively anyway
+
+                        m_masterBus->processRemovals();
+                        destroySource(static_cast<Handle<Source>>(m_masterBus));
+                        m_masterBus = {};
+                    }
+
+                    freeGarbage();
                 }
 
                 m_clock = 0;
+                m_graphHeight = 0; // resized for the next device on open
+                m_scratchChannels = 0;
+                m_scratchFrames = 0;
                 m_device->close();
+                m_audioErrors.flush();
             }
         }
 
@@ -113,7 +168,7 @@ namespace insound {
         {
             ENGINE_INIT_GUARD();
             std::lock_guard lockGuard(m_mixMutex);
-            if (!buffer || !buffer->isLoaded())
+            if (!buffer || !buffer->isLoaded() || !SoundBuffer::isPlayableSpec(buffer->spec()))
             {
                 INSOUND_PUSH_ERROR(Result::InvalidSoundBuffer, "Failed to play sound");
                 return false;
@@ -138,7 +193,7 @@ namespace insound {
                 return false;
             }
 
-            const auto newSource = m_objectPool.allocate<PCMSource>(
+            const auto newSource = allocateSource<PCMSource>(
                 m_engine, buffer, clock, paused, looping, oneshot);
 
             pushImmediateCommand(
@@ -168,7 +223,7 @@ namespace insound {
             if (!result)
                 return false;
 
-            const auto newSource = m_objectPool.allocate<StreamSource>(
+            const auto newSource = allocateSource<StreamSource>(
                 m_engine, filepath, clock, paused, looping, oneshot, inMemory);
 
             pushImmediateCommand(
@@ -180,7 +235,8 @@ namespace insound {
             return true;
         }
 
-        bool createBus(bool paused, const Handle<Bus> &output, Handle<Bus> *outBus, const bool isMaster)
+        bool createBus(bool paused, const Handle<Bus> &output, const ChannelLayout layout, Handle<Bus> *outBus,
+            const bool isMaster)
         {
             ENGINE_INIT_GUARD();
             std::lock_guard lockGuard(m_mixMutex);
@@ -194,16 +250,23 @@ namespace insound {
             auto outputBus =  isMaster ? Handle<Bus>{} :  // if creating the master bus => no output
                 output.isValid() ? output : m_masterBus;  // otherwise use provided output or master if null
 
-            const auto newBusHandle = m_objectPool.allocate<Bus>(
+            const auto newBusHandle = allocateSource<Bus>(
                 m_engine,
                 outputBus,
-                paused);
+                paused,
+                layout);
 
             // Connect bus to output
             if (outputBus)
                 pushImmediateCommand(
                     Command::makeBusAppendSource(outputBus, newBusHandle.cast<Source>()));
 
+            // The mixer reads the bus from its next buffer, so size scratch memory for its level now
+            size_t level = 1;
+            for (auto bus = outputBus; bus.isValid(); bus = bus->m_parent)
+                ++level;
+            reserveScratch(level, channelCount(layout));
+
             if (isMaster) // flag master
                 newBusHandle->m_isMaster = true;
 
@@ -305,69 +368,349 @@ namespace insound {
             ENGINE_INIT_GUARD();
             m_device->update();
 
+            // Report errors from the mixer on this thread
+            m_audioErrors.flush();
+
             {
-                auto deferredCommandGuard = std::lock_guard(m_deferredCommandMutex);
-                if (!m_deferredCommands.empty())
+                // Take the commands first, so ones pushed while processing (e.g. by `Bus::release`) don't deadlock
                 {
-                    if (m_mixMutex.try_lock())
+                    auto deferredCommandGuard = std::lock_guard(m_deferredCommandMutex);
+                    m_processingCommands.swap(m_deferredCommands);
+                    m_coalesceSlots.clear();
+                }
+
+                auto lockGuard = std::lock_guard(m_mixMutex);
+                processCommands(this, m_processingCommands);
+
+                // Grow scratch memory for a deeper graph before the mixer reads it
+                if (m_graphChanged)
+                {
+                    reserveScratch(m_masterBus->height(), m_scratchChannels);
+                    m_graphChanged = false;
+                }
+
+                // Release sources the mixer has queued, e.g. oneshots that ended
+                Source *source;
+                while (m_garbage.tryPop(&source))
+                {
+                    if (!source->shouldDiscard())
+                        releaseSource(source, false);
+                    m_discardFlag = true;
+                }
+
+                if (m_discardFlag)
+                {
+                    if (!m_masterBus.isValid())
                     {
-                        try
-                        {
-                            processCommands(this, m_deferredCommands);
-                        }
-                        catch(...)
-                        {
-                            m_mixMutex.unlock();
-                            throw;
-                        }
-                        m_mixMutex.unlock();
+                        INSOUND_PUSH_ERROR(Result::InvalidHandle, "Internal error: master bus is invalidated");
+                        return false;
                     }
 
+                    m_masterBus->processRemovals();
+                    m_discardFlag = false;
                 }
             }
 
-            if (m_discardFlag)
+            // Deallocate what was removed from the graph without holding up the mixer
+            freeGarbage();
+
+            // Deliver events last, without the mix lock, so callbacks may call back into the engine
+            SourceEvent event;
+            while (m_events.tryPop(&event))
+            {
+                if (m_eventCallback)
+                    m_eventCallback(event, m_eventUserdata);
+            }
+
+            return true;
+        }
+
+        bool setEventCallback(const SourceEventCallback callback, void *userdata)
+        {
+            ENGINE_INIT_GUARD();
+
+            m_eventCallback = callback;
+            m_eventUserdata = userdata;
+            m_eventsEnabled.store(callback != nullptr, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool getDroppedEvents(size_t *outCount) const
+        {
+            ENGINE_INIT_GUARD();
+
+            if (outCount)
+                *outCount = m_droppedEvents.load(std::memory_order_relaxed);
+            return true;
+        }
+
+        [[nodiscard]]
+        bool eventsEnabled() const
+        {
+            return m_eventsEnabled.load(std::memory_order_relaxed);
+        }
+
+        /// Called from the mix thread
+        void pushEvent(const SourceEvent &event)
+        {
+            if (!m_events.tryPush(event))
+                m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Called from the mix thread, queue a source to be released on the next `update`
+        bool queueRelease(Source *source)
+        {
+            if (m_garbage.tryPush(source))
+                return true;
+
+            m_garbageOverflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /// Defer deallocation of a source that was removed from the mix graph until the mix lock is released
+        void destroySource(const Handle<Source> &source)
+        {
+            m_deadSources.emplace_back(source);
+        }
+
+        void destroyEffect(const Handle<Effect> &effect)
+        {
+            m_deadEffects.emplace_back(effect);
+        }
+
+        bool getDroppedAudioErrors(size_t *outCount) const
+        {
+            ENGINE_INIT_GUARD();
+
+            if (outCount)
+                *outCount = m_audioErrors.dropped();
+            return true;
+        }
+
+        bool getGarbageStats(GarbageStats *outStats) const
+        {
+            ENGINE_INIT_GUARD();
+
+            if (outStats)
+            {
+                outStats->pending = m_garbage.size() + m_deadSources.size() + m_deadEffects.size();
+                outStats->collected = m_garbageCollected;
+                outStats->overflows = m_garbageOverflows.load(std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        bool getMemoryStats(MemoryStats *outStats) const
+        {
+            ENGINE_INIT_GUARD();
+
+            if (outStats)
+            {
+                outStats->scratchBytes = m_scratch.bytes();
+                outStats->scratchBuffers = m_scratch.capacity();
+                outStats->peakScratchBuffers = m_scratch.peak();
+                outStats->graphHeight = m_graphHeight;
+            }
+
+            return true;
+        }
+
+        bool setRenderQuantum(const int frames)
+        {
+            if (frames < 0 || frames % 4 != 0)
+            {
+                INSOUND_PUSH_ERROR(Result::InvalidArg, "Engine::setRenderQuantum: frames must be a non-negative "
+                    "multiple of 4");
+                return false;
+            }
+
+            auto lockGuard = std::lock_guard(m_mixMutex);
+            m_renderQuantum = frames;
+            if (isOpen())
+                reserveScratch(m_graphHeight, m_scratchChannels); // resized for the new quantum
+            return true;
+        }
+
+        bool setRealtimeOptions(const RealtimeOptions &options)
+        {
+            if (options.priority < 0 || options.priority > 99 || options.core < -1)
+            {
+                INSOUND_PUSH_ERROR(Result::InvalidArg, "Engine::setRealtimeOptions: priority must be from 0 to 99, "
+                    "and core -1 or above");
+                return false;
+            }
+
+            bool locked;
+            {
+                auto lockGuard = std::lock_guard(m_mixMutex);
+                m_realtimeOptions = options;
+                ++m_realtimeVersion; // the mixer reapplies priority and affinity on its next buffer
+                locked = m_scratch.setLocked(options.lockMemory);
+            }
+
+            locked &= m_objectPool.setLocked(options.lockMemory);
+            if (!locked)
+            {
+                INSOUND_PUSH_ERROR(Result::RuntimeErr, "Engine::setRealtimeOptions: could not lock memory");
+                return false;
+            }
+
+            return true;
+        }
+
+        bool getRealtimeOptions(RealtimeOptions *outOptions) const
+        {
+            if (outOptions)
+            {
+                auto lockGuard = std::lock_guard(m_mixMutex);
+                *outOptions = m_realtimeOptions;
+            }
+            return true;
+        }
+
+        bool getRealtimeStats(RealtimeStats *outStats) const
+        {
+            if (outStats)
             {
-                if (m_masterBus.isValid()) // is this necessary?
                 {
                     auto lockGuard = std::lock_guard(m_mixMutex);
-                    if (m_mixMutex.try_lock())
-                    {
-                        try
-                        {
-                            m_masterBus->processRemovals();
-                        }
-                        catch(...)
-                        {
-                            m_mixMutex.unlock();
-                            throw;
-                        }
-
-                        m_discardFlag = false;
-                        m_mixMutex.unlock();
-                    }
-
+                    outStats->denormalsFlushed = m_realtimeOptions.flushDenormals && detail::canFlushDenormals();
+                    outStats->lockedBytes = m_scratch.lockedBytes();
                 }
+                outStats->lockedBytes += m_objectPool.lockedBytes();
+                outStats->priorityRaised = m_priorityRaised.load(std::memory_order_relaxed);
+                outStats->pinned = m_pinned.load(std::memory_order_relaxed);
+                outStats->threadSetups = m_threadSetups.load(std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        /// Apply priority and affinity to the calling mix thread, if it's new or the options changed since, restoring
+        /// the thread's own settings when they're unset again. A thread the mixer has left keeps its settings.
+        /// Mix lock should be applied.
+        void setUpMixThread()
+        {
+            const auto thread = std::this_thread::get_id();
+            if (thread == m_setupThread && m_setupVersion == m_realtimeVersion)
+                return;
+
+            // Stats report the current thread, starting from its own settings
+            bool raised = false, pinned = false;
+            if (thread == m_setupThread)
+            {
+                raised = m_priorityRaised.load(std::memory_order_relaxed);
+                pinned = m_pinned.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                m_threadSettings.save();
+            }
+            m_setupThread = thread;
+            m_setupVersion = m_realtimeVersion;
+
+            // A failed change leaves the thread as it was
+            const auto &options = m_realtimeOptions;
+            if (options.priority > 0)
+            {
+                if (detail::setThreadRealtimePriority(options.priority))
+                    raised = true;
                 else
-                {
-                    INSOUND_PUSH_ERROR(Result::InvalidHandle, "Internal error: master bus is invalidated");
-                    return false;
-                }
+                    INSOUND_PUSH_ERROR(Result::RuntimeErr, "Engine: could not raise the mix thread's priority");
+            }
+            else if (raised)
+            {
+                if (m_threadSettings.restorePriority())
+                    raised = false;
+                else
+                    INSOUND_PUSH_ERROR(Result::RuntimeErr, "Engine: could not restore the mix thread's priority");
+            }
 
+            if (options.core >= 0)
+            {
+                if (detail::setThreadAffinity(options.core))
+                    pinned = true;
+                else
+                    INSOUND_PUSH_ERROR(Result::RuntimeErr, "Engine: could not pin the mix thread to its core");
+            }
+            else if (pinned)
+            {
+                if (m_threadSettings.restoreAffinity())
+                    pinned = false;
+                else
+                    INSOUND_PUSH_ERROR(Result::RuntimeErr, "Engine: could not unpin the mix thread");
             }
 
+            m_priorityRaised.store(raised, std::memory_order_relaxed);
+            m_pinned.store(pinned, std::memory_order_relaxed);
+            m_threadSetups.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool getRenderQuantum(int *outFrames) const
+        {
+            if (outFrames)
+                *outFrames = m_renderQuantum;
             return true;
         }
 
+        /// Frames the mixer renders at a time: the render quantum, or the device's buffer if it's smaller or unset
+        [[nodiscard]]
+        size_t renderFrames() const
+        {
+            const auto deviceFrames = m_device->bufferSize() / (m_device->spec().channels * sizeof(float));
+            return m_renderQuantum > 0 ? std::min(deviceFrames, static_cast<size_t>(m_renderQuantum)) : deviceFrames;
+        }
+
+        /// Grow the mixer's scratch arena to cover a graph of `height` bus levels, with buffers for a render quantum
+        /// of `channels`, mix lock should be applied. Never shrinks, so a bus the mixer hasn't appended yet stays
+        /// covered.
+        void reserveScratch(const size_t height, const int channels)
+        {
+            // Sounds and streams are stereo, whatever the device's layout
+            const auto scratchChannels = std::max({m_scratchChannels, channels, 2});
+            const auto frames = renderFrames();
+            if (height <= m_graphHeight && scratchChannels == m_scratchChannels && frames == m_scratchFrames)
+                return;
+
+            m_graphHeight = std::max(m_graphHeight, height);
+            m_scratchChannels = scratchChannels;
+            m_scratchFrames = frames;
+            m_scratch.reserve(ScratchBuffersPerLevel * m_graphHeight + ScratchBuffersPerSource,
+                frames * m_scratchChannels * sizeof(float));
+        }
+
         bool pushCommand(const Command &command)
         {
             ENGINE_INIT_GUARD();
 
             std::lock_guard lockGuard(m_deferredCommandMutex);
+
+            // Overwrite a queued value of the same parameter, the command keeps the earlier slot in the queue
+            CommandKey key;
+            if (command.getCoalesceKey(&key))
+            {
+                const auto [it, inserted] = m_coalesceSlots.try_emplace(key, m_deferredCommands.size());
+                if (!inserted)
+                {
+                    m_deferredCommands[it->second] = command;
+                    return true;
+                }
+            }
+
             m_deferredCommands.emplace_back(command);
             return true;
         }
 
+        bool getPendingCommands(size_t *outCount)
+        {
+            ENGINE_INIT_GUARD();
+
+            std::lock_guard lockGuard(m_deferredCommandMutex);
+            if (outCount)
+                *outCount = m_deferredCommands.size();
+            return true;
+        }
+
         bool pushImmediateCommand(const Command &command)
         {
             ENGINE_INIT_GUARD();
@@ -385,19 +728,11 @@ namespace insound {
             {
                 case EngineCommand::ReleaseSource:
                 {
-                    auto &source = command.deallocsource.source;
+                    const auto source = command.deallocsource.source.tryGet();
                     if (!source)
                         break;
 
-                    if (const auto bus = source.getAs<Bus>())
-                    {
-                        bus->release(command.deallocsource.recursive);
-                    }
-                    else
-                    {
-                        source->release();
-                    }
-
+                    releaseSource(source, command.deallocsource.recursive);
                     m_discardFlag = true;
                 } break;
 
@@ -407,15 +742,7 @@ namespace insound {
                     if (!source)
                         break;
 
-                    if (const auto bus = dynamic_cast<Bus *>(source))
-                    {
-                        bus->release(command.deallocsourceraw.recursive);
-                    }
-                    else
-                    {
-                        source->release();
-                    }
-
+                    releaseSource(source, command.deallocsourceraw.recursive);
                     m_discardFlag = true;
                 } break;
 
@@ -438,6 +765,17 @@ namespace insound {
             return m_objectPool;
         }
 
+        [[nodiscard]]
+        ScratchArena &getScratchArena()
+        {
+            return m_scratch;
+        }
+
+        void markGraphChanged()
+        {
+            m_graphChanged = true;
+        }
+
         AudioDevice &getAudioDevice()
         {
             return *m_device;
@@ -445,6 +783,42 @@ namespace insound {
 
         std::lock_guard<std::mutex> mixLockGuard() { return std::lock_guard(m_mixMutex); }
     private:
+        /// Allocate a source, letting it know its own handle for the events it sends
+        template <typename T, typename...TArgs>
+        Handle<T> allocateSource(TArgs &&...args)
+        {
+            auto source = m_objectPool.allocate<T>(std::forward<TArgs>(args)...);
+            if (const auto ptr = source.tryGet())
+                ptr->m_handle = source.template cast<Source>();
+            return source;
+        }
+
+        /// Run a source's release logic, flagging it for removal from the mix graph
+        static void releaseSource(Source *source, const bool recursive)
+        {
+            if (const auto bus = poolCast<Bus>(source))
+            {
+                bus->release(recursive);
+            }
+            else
+            {
+                source->release();
+            }
+        }
+
+        /// Deallocate sources and effects that were removed from the mix graph, call without the mix lock
+        void freeGarbage()
+        {
+            // indexed, since releasing a source may destroy more effects
+            for (size_t i = 0; i < m_deadSources.size(); ++i)
+                m_objectPool.deallocate(m_deadSources[i]);
+            for (size_t i = 0; i < m_deadEffects.size(); ++i)
+                m_objectPool.deallocate(m_deadEffects[i]);
+
+            m_garbageCollected += m_deadSources.size() + m_deadEffects.size();
+            m_deadSources.clear();
+            m_deadEffects.clear();
+        }
 
         /// Process a vector of commands
         /// @param engine   context object, we may not need it
@@ -500,23 +874,37 @@ namespace insound {
         /// @param outBuffer buffer to fill or swap, as long as the lengths are equal
         static void audioCallback(void *userptr, AlignedVector<uint8_t, 16> *outBuffer)
         {
+            const detail::AudioThreadScope audioThreadScope;
             const auto engine = static_cast<Impl *>(userptr);
+            const detail::ErrorQueueScope errorQueueScope(&engine->m_audioErrors); // no logging or allocation here
             if (!engine->isOpen() || !engine->m_masterBus)
                 return;
 
             auto guard = std::lock_guard(engine->m_mixMutex);
+            const detail::DenormalScope denormalScope(engine->m_realtimeOptions.flushDenormals);
+            engine->setUpMixThread();
+
             // Process commands that require sample-accurate immediacy
             {
                 auto deferredCommandGuard = std::lock_guard(engine->m_deferredCommandMutex);
                 if (!engine->m_immediateCommands.empty())
                     Engine::Impl::processCommands(engine, engine->m_immediateCommands);
             }
+            // Render in quanta small enough for every source's buffer to stay in cache, whatever the device's size
             const auto size = outBuffer->size();
-            engine->m_masterBus->read(nullptr, static_cast<int>(size));
-            engine->m_clock += size / (2 * sizeof(float));
-            engine->m_masterBus->updateParentClock(engine->m_clock);
-
-            engine->m_masterBus->swapBuffers(outBuffer);
+            const auto frameSize = engine->m_device->spec().channels * sizeof(float);
+            const auto quantumSize = engine->m_scratchFrames * frameSize;
+            for (size_t offset = 0; offset < size; offset += quantumSize)
+            {
+                const auto length = std::min(quantumSize, size - offset);
+                const auto mark = engine->m_scratch.mark();
+                const uint8_t *data;
+                engine->m_masterBus->read(&data, static_cast<int>(length));
+                std::memcpy(outBuffer->data() + offset, data, length);
+                engine->m_scratch.release(mark);
+                engine->m_clock += length / frameSize;
+                engine->m_masterBus->updateParentClock(engine->m_clock);
+            }
 
             // if (engine->m_mixMutex.try_lock())
             // {
@@ -531,11 +919,11 @@ namespace insound {
             //     {
             //         const auto size = outBuffer->size();
             //
-            //         engine->m_masterBus->read(nullptr, static_cast<int>(size));
-            //         engine->m_clock += size / (2 * sizeof(float));
+            //         const uint8_t *data;
+            //         engine->m_masterBus->read(&data, static_cast<int>(size));
+            //         std::memcpy(outBuffer->data(), data, size);
+            //         engine->m_clock += size / (engine->m_device->spec().channels * sizeof(float));
             //         engine->m_masterBus->updateParentClock(engine->m_clock);
-            //
-            //         engine->m_masterBus->swapBuffers(outBuffer);
             //     }
             //     catch(const std::exception &e)
             //     {
@@ -566,9 +954,37 @@ namespace insound {
         AudioDevice *m_device;
 
         std::vector<Command> m_deferredCommands;
+        /// index in `m_deferredCommands` of the queued command for each continuous parameter
+        std::unordered_map<CommandKey, size_t, CommandKey::Hash> m_coalesceSlots;
+        std::vector<Command> m_processingCommands; ///< deferred commands taken by `update`, reused to avoid allocations
         std::vector<Command> m_immediateCommands;
 
         bool m_discardFlag; ///< set to true when sound source discard should be made
+        SpscQueue<Source *> m_garbage;              ///< sources the mixer released, drained in `update`
+        std::atomic<size_t> m_garbageOverflows;     ///< number of times `m_garbage` was full
+        size_t m_garbageCollected;                  ///< total objects deallocated by `freeGarbage`
+        std::vector<Handle<Source>> m_deadSources;  ///< removed from the graph, awaiting deallocation
+        std::vector<Handle<Effect>> m_deadEffects;  ///< removed from their source, awaiting deallocation
+        detail::ErrorQueue m_audioErrors;           ///< errors pushed by the mixer, reported in `update`
+        SpscQueue<SourceEvent> m_events;            ///< events pushed by the mixer, delivered in `update`
+        std::atomic<bool> m_eventsEnabled;          ///< whether the mixer should push events, set with a callback
+        std::atomic<size_t> m_droppedEvents;        ///< number of events lost because `m_events` was full
+        SourceEventCallback m_eventCallback;
+        void *m_eventUserdata;
+        ScratchArena m_scratch;                     ///< buffers sources mix into, held while their parent reads them
+        size_t m_graphHeight;                       ///< most bus levels the graph has had, `m_scratch` is sized for it
+        int m_scratchChannels;                      ///< most channels of any Source's layout, `m_scratch` is sized for it
+        size_t m_scratchFrames;                     ///< frames per render quantum, `m_scratch` is sized for it
+        int m_renderQuantum;                        ///< requested frames per render quantum, 0 for the device's buffer
+        bool m_graphChanged;                        ///< set when a bus is appended, to resize `m_scratch` in `update`
+        RealtimeOptions m_realtimeOptions;          ///< guarded by the mix lock
+        uint32_t m_realtimeVersion;                 ///< bumped when `m_realtimeOptions` changes
+        std::thread::id m_setupThread;              ///< mix thread priority and affinity were last applied to
+        uint32_t m_setupVersion;                    ///< `m_realtimeVersion` they were last applied for
+        detail::ThreadSettings m_threadSettings;    ///< `m_setupThread`'s settings before they were applied
+        std::atomic<bool> m_priorityRaised;         ///< written by the mix thread, read by stats
+        std::atomic<bool> m_pinned;                 ///< written by the mix thread, read by stats
+        std::atomic<size_t> m_threadSetups;         ///< written by the mix thread, read by stats
         MultiPool m_objectPool; ///< manages multiple pools of different source types (also effects)
 
         std::mutex m_immediateCommandMutex;
@@ -576,7 +992,10 @@ namespace insound {
         mutable std::mutex m_mixMutex;
     };
 
-    Engine::Engine() : m(new Impl(this))
+    Engine::Engine() : m(new Impl(this, nullptr))
+    { }
+
+    Engine::Engine(AudioDevice *device) : m(new Impl(this, device))
     { }
 
     Engine::~Engine()
@@ -584,9 +1003,9 @@ namespace insound {
         delete m;
     }
 
-    bool Engine::open(const int samplerate, const int bufferFrameSize)
+    bool Engine::open(const int samplerate, const int bufferFrameSize, const ChannelLayout layout)
     {
-        return m->open(samplerate, bufferFrameSize);
+        return m->open(samplerate, bufferFrameSize, layout);
     }
 
     void Engine::close()
@@ -613,12 +1032,18 @@ namespace insound {
 
     bool Engine::createBus(const bool paused, const Handle<Bus> &output, Handle<Bus> *outBus)
     {
-        return m->createBus(paused, output, outBus, false);
+        return m->createBus(paused, output, ChannelLayout::Stereo, outBus, false);
+    }
+
+    bool Engine::createBus(const bool paused, const Handle<Bus> &output, const ChannelLayout layout,
+        Handle<Bus> *outBus)
+    {
+        return m->createBus(paused, output, layout, outBus, false);
     }
 
     bool Engine::createBus(const bool paused, Handle<Bus> *outBus)
     {
-        return m->createBus(paused, {}, outBus, false);
+        return m->createBus(paused, {}, ChannelLayout::Stereo, outBus, false);
     }
 
     std::lock_guard<std::mutex> Engine::mixLockGuard()
@@ -681,9 +1106,84 @@ namespace insound {
         return m->update();
     }
 
+    bool Engine::getGarbageStats(GarbageStats *outStats) const
+    {
+        return m->getGarbageStats(outStats);
+    }
+
+    bool Engine::setEventCallback(const SourceEventCallback callback, void *userdata)
+    {
+        return m->setEventCallback(callback, userdata);
+    }
+
+    bool Engine::getDroppedEvents(size_t *outCount) const
+    {
+        return m->getDroppedEvents(outCount);
+    }
+
+    bool Engine::eventsEnabled() const
+    {
+        return m->eventsEnabled();
+    }
+
+    void Engine::pushEvent(const SourceEvent &event)
+    {
+        m->pushEvent(event);
+    }
+
+    bool Engine::getPendingCommands(size_t *outCount) const
+    {
+        return m->getPendingCommands(outCount);
+    }
+
+    bool Engine::getDroppedAudioErrors(size_t *outCount) const
+    {
+        return m->getDroppedAudioErrors(outCount);
+    }
+
+    bool Engine::getMemoryStats(MemoryStats *outStats) const
+    {
+        return m->getMemoryStats(outStats);
+    }
+
+    bool Engine::setRenderQuantum(const int frames)
+    {
+        return m->setRenderQuantum(frames);
+    }
+
+    bool Engine::getRenderQuantum(int *outFrames) const
+    {
+        return m->getRenderQuantum(outFrames);
+    }
+
+    bool Engine::setRealtimeOptions(const RealtimeOptions &options)
+    {
+        return m->setRealtimeOptions(options);
+    }
+
+    bool Engine::getRealtimeOptions(RealtimeOptions *outOptions) const
+    {
+        return m->getRealtimeOptions(outOptions);
+    }
+
+    bool Engine::getRealtimeStats(RealtimeStats *outStats) const
+    {
+        return m->getRealtimeStats(outStats);
+    }
+
+    bool Engine::queueRelease(Source *source)
+    {
+        return m->queueRelease(source);
+    }
+
     void Engine::destroySource(const Handle<Source> &source)
     {
-        m->getObjectPool().deallocate(source);
+        m->destroySource(source);
+    }
+
+    void Engine::destroyEffect(const Handle<Effect> &effect)
+    {
+        m->destroyEffect(effect);
     }
 
     const MultiPool &Engine::getObjectPool() const
@@ -696,6 +1196,16 @@ namespace insound {
         return m->getObjectPool();
     }
 
+    ScratchArena &Engine::getScratchArena()
+    {
+        return m->getScratchArena();
+    }
+
+    void Engine::markGraphChanged()
+    {
+        m->markGraphChanged();
+    }
+
     AudioDevice &Engine::device()
     {
         return m->getAudioDevice();
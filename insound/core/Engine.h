@@ -1,6 +1,8 @@
 #pragma once
 #include "AudioDevice.h"
+#include "ChannelLayout.h"
 #include "MultiPool.h"
+#include "SourceEvent.h"
 
 #include <cstdint>
 
@@ -9,18 +11,61 @@ namespace insound {
     class BufferPool;
     class Bus;
     struct Command;
+    class Effect;
     struct EngineCommand;
     class PCMSource;
+    class ScratchArena;
     class SoundBuffer;
     class Source;
     class StreamSource;
 
+    /// Counters for objects waiting on teardown, see `Engine::getGarbageStats`
+    struct GarbageStats {
+        size_t pending;   ///< sources and effects queued for release or deallocation by the next `Engine::update`
+        size_t collected; ///< total sources and effects deallocated so far
+        size_t overflows; ///< times the mixer's release queue was full, those sources retry on the next buffer
+    };
+
+    /// Memory held by the mixer, see `Engine::getMemoryStats`
+    struct MemoryStats {
+        size_t scratchBytes;       ///< bytes allocated for the buffers sources mix into, shared by all sources
+        size_t scratchBuffers;     ///< number of scratch buffers, sized by the height of the graph
+        size_t peakScratchBuffers; ///< most scratch buffers the mixer has held at once
+        size_t graphHeight;        ///< most bus levels from the master bus down to a sub-bus the graph has had
+    };
+
+    /// Setup of the thread the mixer runs on, see `Engine::setRealtimeOptions`
+    struct RealtimeOptions {
+        RealtimeOptions() : flushDenormals(true), priority(), core(-1), lockMemory() { }
+        bool flushDenormals; ///< flush denormal floats to zero while mixing (FTZ/DAZ), e.g. in decaying feedback
+        int priority;        ///< SCHED_FIFO priority from 1 to 99 to raise the mix thread to, 0 for its own priority
+        int core;            ///< CPU core to pin the mix thread to, -1 for its own affinity
+        bool lockMemory;     ///< lock the object pools and mix buffers into physical memory, so they never page-fault
+    };
+
+    /// What the engine could apply of its `RealtimeOptions`, see `Engine::getRealtimeStats`
+    struct RealtimeStats {
+        bool denormalsFlushed; ///< whether denormals are flushed while mixing, false if the CPU has no such mode
+        bool priorityRaised;   ///< whether the mix thread runs at a raised priority, e.g. false without permission
+        bool pinned;           ///< whether the mix thread is pinned to a core
+        size_t lockedBytes;    ///< bytes of object pools and mix buffers locked into physical memory
+        size_t threadSetups;   ///< times priority and affinity were applied, once per mix thread and options change
+    };
+
     class Engine {
     public:
         Engine();
+        /// Create an engine that outputs to a specific device, instead of the platform's default backend
+        /// @param device device to use, the engine takes ownership of it; e.g. a `NullAudioDevice` for tests
+        explicit Engine(AudioDevice *device);
         ~Engine();
 
-        bool open(int samplerate, int bufferFrameSize);
+        /// Open the audio device and create the master bus
+        /// @param samplerate      requested sample rate, 0 for the device's default
+        /// @param bufferFrameSize number of frames per buffer
+        /// @param layout          requested speaker layout; the master bus takes the layout the device opens with
+        /// @returns whether function succeeded, check `popError()` for details
+        bool open(int samplerate, int bufferFrameSize, ChannelLayout layout = ChannelLayout::Stereo);
         void close();
 
         /// Whether engine is currently open from a prior call to `Engine::open`
@@ -47,6 +92,13 @@ namespace insound {
         bool createBus(bool paused, const Handle<Bus> &output, Handle<Bus> *outBus);
         bool createBus(bool paused, Handle<Bus> *outBus);
 
+        /// Create a new bus that mixes in a specific channel layout, e.g. a 5.1 bus to pan ambiences around
+        /// @param paused whether bus should start off paused on initialization
+        /// @param output output bus to feed this bus to, if nullptr, the master Bus will be used
+        /// @param layout layout its sources are up- or downmixed to, it's converted to its output bus's layout in turn
+        /// @param outBus [out] pointer to retrieve created bus reference
+        bool createBus(bool paused, const Handle<Bus> &output, ChannelLayout layout, Handle<Bus> *outBus);
+
         /// Retrieve the engine's device ID. If zero, the audio device is uninitialized.
         bool getDeviceID(uint32_t *outDeviceID) const;
 
@@ -59,7 +111,8 @@ namespace insound {
         /// Get the master bus
         bool getMasterBus(Handle<Bus> *outBus) const;
 
-        /// Push a command to be deferred until `update` is called
+        /// Push a command to be deferred until `update` is called. A command that sets a continuous parameter
+        /// replaces one still queued for the same object and parameter, since only the latest value is applied.
         bool pushCommand(const Command &command);
 
         /// Push a command that will immediately be processed the next audio buffer.
@@ -73,14 +126,94 @@ namespace insound {
         /// Get if the device is paused
         bool getPaused(bool *outValue) const;
 
+        /// Apply deferred commands, then release and deallocate sources that were closed, including oneshots
+        /// the mixer queued when they ended. The audio thread never frees memory itself, it only queues sources here.
+        /// Errors raised in the mixer since the last update are pushed here, check `popError()` afterward.
         bool update();
 
+        /// Set the callback that receives events from the mixer, such as a sound ending or crossing a marker.
+        /// Events are delivered in a batch at the end of `update`, and are only collected while a callback is set.
+        /// @param callback function to receive events, or nullptr to stop collecting them
+        /// @param userdata custom data passed to the callback
+        /// @returns whether function succeeded, check `popError()` for details
+        bool setEventCallback(SourceEventCallback callback, void *userdata = nullptr);
+
+        /// Get the number of events lost because too many occurred between calls to `update`
+        /// @param outCount pointer to receive the count
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getDroppedEvents(size_t *outCount) const;
+
+        /// Get the number of deferred commands queued for the next call to `update`, after coalescing
+        /// @param outCount pointer to receive the count
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getPendingCommands(size_t *outCount) const;
+
+        /// Get the number of mixer errors lost because too many were raised between calls to `update`
+        /// @param outCount pointer to receive the count
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getDroppedAudioErrors(size_t *outCount) const;
+
+        /// Get counters for sources and effects waiting on teardown in `update`
+        /// @param outStats pointer to receive the counters
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getGarbageStats(GarbageStats *outStats) const;
+
+        /// Get the memory held by the mixer's scratch buffers. Sources don't own mix buffers, so this grows with
+        /// the depth of the bus graph, not with the number of sources.
+        /// @param outStats pointer to receive the stats
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getMemoryStats(MemoryStats *outStats) const;
+
+        /// Set the number of frames the mixer renders at a time. The device's buffer is filled in several quanta,
+        /// so the mix buffers sources read into stay small however large the device buffer is. Volume changes ramp
+        /// over one quantum. Defaults to 512; may be set before or while the engine is open.
+        /// @param frames frames per quantum, or 0 to render the device's whole buffer at once. Must be a multiple of
+        ///               4, so effects receive sample counts that are too, and each quantum of the device's buffer
+        ///               stays 16-byte aligned. Quanta larger than the device's buffer are clamped to it.
+        /// @returns whether function succeeded, check `popError()` for details
+        bool setRenderQuantum(int frames);
+
+        /// Set up the thread the mixer runs on for real-time work. Priority and affinity are applied by the mixer
+        /// itself, from the first buffer it mixes on each thread, since backends create their own threads. Unsetting
+        /// them restores the thread's own priority and affinity.
+        /// Failures to apply them are reported by `update`, and what took effect by `getRealtimeStats`.
+        /// May be set before or while the engine is open.
+        /// @param options options to apply
+        /// @returns whether function succeeded, false if memory couldn't be locked, e.g. past the process's lock
+        ///          limit; the other options still apply. Check `popError()` for details
+        bool setRealtimeOptions(const RealtimeOptions &options);
+
+        /// Get the options set with `setRealtimeOptions`
+        /// @param outOptions pointer to receive the options
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getRealtimeOptions(RealtimeOptions *outOptions) const;
+
+        /// Get which of the real-time options took effect on the mix thread
+        /// @param outStats pointer to receive the stats
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getRealtimeStats(RealtimeStats *outStats) const;
+
+        /// Get the number of frames the mixer renders at a time, as set with `setRenderQuantum`
+        /// @param outFrames pointer to receive the frames, 0 if the device's whole buffer is rendered at once
+        /// @returns whether function succeeded, check `popError()` for details
+        bool getRenderQuantum(int *outFrames) const;
+
         template <typename T>
         bool tryFindHandle(T *ptr, Handle<T> *outHandle)
         {
             return getObjectPool().tryFind(ptr, outHandle);
         }
 
+        /// Preallocate pool pages for `count` objects of type `T`, so creating them won't allocate memory.
+        /// Every Source also creates a `PanEffect` and a `VolumeEffect`, reserve those to cover its default effects.
+        /// @tparam T  concrete pooled type, e.g. `PCMSource`, `Bus`, or an Effect subclass
+        /// @param count  number of objects to reserve space for
+        template <typename T>
+        void reserveObjects(size_t count)
+        {
+            getObjectPool().reserve<T>(count);
+        }
+
         struct Impl;
     private:
         friend class Bus;
@@ -96,11 +229,26 @@ namespace insound {
 
         bool releaseSoundImpl(const Handle<Source> &source);
         bool releaseSoundRaw(Source *source, bool recursive);
+        /// Lock-free, for the mix thread: queue a source to be released on the next `update`
+        /// @returns whether it was queued, false if the queue is full
+        bool queueRelease(Source *source);
+        /// Deallocate objects removed from the mix graph, deferred until `update` releases the mix lock
         void destroySource(const Handle<Source> &source);
+        void destroyEffect(const Handle<Effect> &effect);
+        /// Lock-free, for the mix thread: whether an event callback is set
+        [[nodiscard]]
+        bool eventsEnabled() const;
+        /// Lock-free, for the mix thread: queue an event for the next `update`, dropped if the queue is full
+        void pushEvent(const SourceEvent &event);
         [[nodiscard]]
         const MultiPool &getObjectPool() const;
         [[nodiscard]]
         MultiPool &getObjectPool();
+        /// For the mix thread: buffers for sources to read into
+        [[nodiscard]]
+        ScratchArena &getScratchArena();
+        /// Resize scratch memory for the graph's height on the next `update`, mix lock should be applied
+        void markGraphChanged();
 
         AudioDevice &device();
 
@@ -0,0 +1,183 @@
+#include "Envelope.h"
+
+#include "MixKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace insound {
+    /// Non-linear segments are evaluated exactly at this frame interval, and ramped linearly between
+    static constexpr uint32_t CurveStepFrames = 32;
+
+    static constexpr float HalfPi = 1.5707963267948966f;
+
+    /// Evaluate a segment's curve
+    /// @param t position in the segment, 0 to 1
+    static float evaluate(const FadeCurve curve, const float value0, const float value1, const float t)
+    {
+        switch(curve)
+        {
+            case FadeCurve::Exponential:
+            {
+                if (value0 > 0 && value1 > 0)
+                    return value0 * std::pow(value1 / value0, t);
+            } break;
+
+            case FadeCurve::EqualPower:
+            {
+                // Shape the change rather than mixing both values, which would overshoot between non-zero points,
+                // e.g. peak at sqrt(2) from 1 to 1. Rising takes the sine quarter, falling the cosine one.
+                if (value1 >= value0)
+                    return value0 + (value1 - value0) * std::sin(t * HalfPi);
+                return value1 + (value0 - value1) * std::cos(t * HalfPi);
+            }
+
+            case FadeCurve::SCurve:
+            {
+                return value0 + (value1 - value0) * (t * t * (3.f - 2.f * t));
+            }
+
+            default:
+                break;
+        }
+
+        return value0 + (value1 - value0) * t;
+    }
+
+    /// Multiply interleaved frames by a gain that changes by `delta` each frame
+    static void applyRamp(float *samples, const uint32_t frames, const int channels, const float gain,
+        const float delta)
+    {
+        if (channels != 2)
+        {
+            for (uint32_t f = 0; f < frames; ++f)
+            {
+                const auto g = gain + delta * static_cast<float>(f);
+                for (int c = 0; c < channels; ++c)
+                    samples[f * channels + c] *= g;
+            }
+            return;
+        }
+
+        mixKernels().stereoRamp(samples, samples, frames, gain, delta);
+    }
+
+    void Envelope::addPoint(const uint32_t clock, const float value, const FadeCurve curve)
+    {
+        const auto it = std::lower_bound(m_points.begin(), m_points.end(), clock,
+            [](const FadePoint &point, const uint32_t c) { return point.clock < c; });
+        if (it != m_points.end() && it->clock == clock) // replace the value
+        {
+            it->value = value;
+            it->curve = curve;
+            return;
+        }
+
+        if (static_cast<size_t>(it - m_points.begin()) < m_cursor) // inserted behind the cursor
+            ++m_cursor;
+        m_points.insert(it, FadePoint(clock, value, curve));
+    }
+
+    void Envelope::removePoints(const uint32_t start, const uint32_t end)
+    {
+        size_t removedBehindCursor = 0;
+        for (size_t i = 0; i < m_cursor && i < m_points.size(); ++i)
+        {
+            if (m_points[i].clock >= start && m_points[i].clock < end)
+                ++removedBehindCursor;
+        }
+
+        m_points.erase(std::remove_if(m_points.begin(), m_points.end(), [start, end](const FadePoint &point) {
+            return point.clock >= start && point.clock < end;
+        }), m_points.end());
+        m_cursor -= removedBehindCursor;
+    }
+
+    void Envelope::clear()
+    {
+        m_points.clear();
+        m_cursor = 0;
+        m_value = 1.f;
+    }
+
+    void Envelope::process(float *samples, const uint32_t clock, const uint32_t frames, const int channels)
+    {
+        struct Target {
+            float *samples;
+            int channels;
+        } target {samples, channels};
+
+        process(clock, frames, [](const uint32_t frame, const uint32_t count, const float gain, const float delta,
+            void *userdata) {
+            if (gain == 1.f && delta == 0) // no effect
+                return;
+            const auto target = static_cast<Target *>(userdata);
+            applyRamp(target->samples + frame * target->channels, count, target->channels, gain, delta);
+        }, &target);
+    }
+
+    void Envelope::process(const uint32_t clock, const uint32_t frames, const RampCallback callback,
+        void *userdata)
+    {
+        uint32_t frame = 0;
+        while (frame < frames)
+        {
+            const auto now = clock + frame;
+
+            // Pass the points reached, their values hold until the next segment begins
+            while (m_cursor < m_points.size() && m_points[m_cursor].clock <= now)
+                m_value = m_points[m_cursor++].value;
+
+            if (m_cursor == m_points.size())
+            {
+                callback(frame, frames - frame, m_value, 0, userdata);
+                break;
+            }
+
+            const auto &next = m_points[m_cursor];
+            const auto length = std::min(frames - frame, next.clock - now);
+            if (m_cursor == 0) // before the first point
+            {
+                callback(frame, length, m_value, 0, userdata);
+                frame += length;
+                continue;
+            }
+
+            const auto &prev = m_points[m_cursor - 1];
+            const auto segmentLength = static_cast<float>(next.clock - prev.clock);
+            const auto offset = now - prev.clock;
+            if (next.curve == FadeCurve::Linear)
+            {
+                const auto delta = (next.value - prev.value) / segmentLength;
+                callback(frame, length, prev.value + delta * static_cast<float>(offset), delta, userdata);
+                m_value = prev.value + delta * static_cast<float>(offset + length);
+            }
+            else
+            {
+                auto gain = evaluate(next.curve, prev.value, next.value, static_cast<float>(offset) / segmentLength);
+                for (uint32_t f = 0; f < length; )
+                {
+                    const auto step = std::min(CurveStepFrames, length - f);
+                    const auto nextGain = evaluate(next.curve, prev.value, next.value,
+                        static_cast<float>(offset + f + step) / segmentLength);
+                    callback(frame + f, step, gain, (nextGain - gain) / static_cast<float>(step), userdata);
+                    gain = nextGain;
+                    f += step;
+                }
+                m_value = gain;
+            }
+
+            frame += length;
+        }
+
+        // Drop passed points, keeping the start of the current segment. Waits until they make up half the list, so
+        // erasing from the front stays amortized constant per point, however many were scheduled ahead.
+        const size_t keep = m_cursor > 0 && m_cursor < m_points.size() ? 1 : 0;
+        if (m_cursor > keep && (m_cursor - keep) * 2 >= m_points.size())
+        {
+            m_points.erase(m_points.begin(), m_points.begin() + static_cast<std::ptrdiff_t>(m_cursor - keep));
+            m_cursor = keep;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace insound {
+
+    /// Shape of a fade segment
+    enum class FadeCurve : uint8_t {
+        Linear,      ///< constant change per frame
+        Exponential, ///< constant ratio per frame, even in decibels; falls back to linear to or from zero
+        EqualPower,  ///< quarter sine rising, quarter cosine falling; keeps constant power crossfading to or from zero
+        SCurve,      ///< smoothstep, eases in and out of the segment
+    };
+
+    struct FadePoint {
+        FadePoint() : clock(), value(), curve() { }
+        FadePoint(uint32_t clock, float value, FadeCurve curve = FadeCurve::Linear) :
+            clock(clock), value(value), curve(curve) { }
+        uint32_t clock;
+        float value;
+        FadeCurve curve; ///< shape of the segment from the previous point to this one
+    };
+
+    /// Gain automation over a clock, made of fade points. Keeps a cursor into its points between calls to `process`,
+    /// and drops points once they've been passed, so the cost per buffer doesn't grow over a session.
+    class Envelope {
+    public:
+        Envelope() : m_points(), m_cursor(), m_value(1.f) { }
+
+        /// Add a point, replacing the value and curve of any existing point at the same clock
+        void addPoint(uint32_t clock, float value, FadeCurve curve = FadeCurve::Linear);
+
+        /// Remove points between start (inclusive) and end (exclusive) clock times
+        void removePoints(uint32_t start, uint32_t end);
+
+        /// Remove all points and reset the value to 1
+        void clear();
+
+        /// Receives a run of frames over which the envelope's gain changes linearly
+        /// @param frame    offset of the run's first frame from the start of the processed range
+        /// @param frames   number of frames in the run
+        /// @param gain     gain at the first frame
+        /// @param delta    change in gain per frame
+        /// @param userdata context passed to `process`
+        using RampCallback = void (*)(uint32_t frame, uint32_t frames, float gain, float delta, void *userdata);
+
+        /// Multiply interleaved frames by the envelope
+        /// @param samples  interleaved samples to apply gain to in-place
+        /// @param clock    clock time of the first frame, should follow the last call's range
+        /// @param frames   number of frames in `samples`
+        /// @param channels number of channels in each frame
+        void process(float *samples, uint32_t clock, uint32_t frames, int channels = 2);
+
+        /// Advance the envelope over a range of frames, passing its gain to a callback as consecutive linear runs,
+        /// e.g. to apply it in the same pass as other gains
+        /// @param clock    clock time of the first frame, should follow the last call's range
+        /// @param frames   number of frames to advance
+        /// @param callback receives each run, covering the range in order
+        /// @param userdata context to pass to `callback`
+        void process(uint32_t clock, uint32_t frames, RampCallback callback, void *userdata);
+
+        /// Gain reached at the end of the last processed frame
+        [[nodiscard]]
+        float value() const { return m_value; }
+
+        [[nodiscard]]
+        const std::vector<FadePoint> &points() const { return m_points; }
+
+        void reserve(size_t count) { m_points.reserve(count); }
+    private:
+        std::vector<FadePoint> m_points; ///< sorted by clock time
+        size_t m_cursor;                 ///< number of points at or before the processed clock time
+        float m_value;                   ///< current gain, held outside a segment
+    };
+}
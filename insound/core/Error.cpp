@@ -4,11 +4,38 @@
 #include <utility>
 
 namespace insound {
+    constexpr int MAX_ERR_STACK_SIZE = 32;
+
+    /// Stack of errors held in place, so pushing never allocates. Handles push onto it wherever they're
+    /// dereferenced, which includes the audio thread.
+    class FixedErrorStack {
+    public:
+        FixedErrorStack() : m_errors(), m_size() { }
+
+        [[nodiscard]]
+        bool empty() const { return m_size == 0; }
+
+        [[nodiscard]]
+        size_t size() const { return m_size; }
+
+        [[nodiscard]]
+        const Result &top() const { return m_errors[m_size - 1]; }
+
+        void pop() { --m_size; }
+
+        /// Caller checks that the stack isn't full
+        void emplace(const Result::Code code, const char *message) { m_errors[m_size++] = Result(code, message); }
+
+    private:
+        Result m_errors[MAX_ERR_STACK_SIZE];
+        size_t m_size;
+    };
+
     /// Each thread has its own error stack to prevent data races
     thread_local static std::stack<Result> s_errors;    // client error stack
-    thread_local static std::stack<Result> s_sysErrors; // used by the program
+    thread_local static FixedErrorStack s_sysErrors;    // used by the program
+    thread_local static detail::ErrorQueue *t_errorQueue; // set on the audio thread, replaces the client stack
     static const Result NoErrors {Result::Ok, nullptr};
-    constexpr int MAX_ERR_STACK_SIZE = 32;
     static const char *s_codeNames[] = {
         "No errors",
         "SDL Error",
@@ -39,6 +66,12 @@ namespace insound {
 
     void pushError(Result::Code code, const char *message, const char *functionName, const char *fileName, int lineNumber)
     {
+        if (t_errorQueue)
+        {
+            t_errorQueue->push({code, message, functionName, fileName, lineNumber});
+            return;
+        }
+
         if (s_sysErrors.size() >= MAX_ERR_STACK_SIZE)
             return;
 #if INSOUND_DEBUG || INSOUND_LOGGING
@@ -94,7 +127,7 @@ namespace insound {
             return NoErrors;
         }
 
-        const auto &err = s_sysErrors.top();
+        const auto err = s_sysErrors.top(); // copied, the slot is reused by the next push
         s_sysErrors.pop();
 
         return err;
@@ -135,4 +168,27 @@ namespace insound {
     {
         return !s_errors.empty();
     }
+
+    size_t detail::ErrorQueue::flush()
+    {
+        size_t count = 0;
+        ErrorRecord record;
+        while (m_queue.tryPop(&record))
+        {
+            pushError(record.code, record.message, record.functionName, record.fileName, record.lineNumber);
+            ++count;
+        }
+
+        return count;
+    }
+
+    detail::ErrorQueueScope::ErrorQueueScope(ErrorQueue *queue) : m_lastQueue(t_errorQueue)
+    {
+        t_errorQueue = queue;
+    }
+
+    detail::ErrorQueueScope::~ErrorQueueScope()
+    {
+        t_errorQueue = m_lastQueue;
+    }
 }
@@ -1,4 +1,8 @@
 #pragma once
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <cstddef>
 
 namespace insound {
     struct Result {
@@ -27,6 +31,7 @@ namespace insound {
             Count,
         };
 
+        Result() : code(Ok), message(nullptr) { }
         Result(Code code, const char *message);
 
         Code code;
@@ -46,9 +51,57 @@ namespace insound {
     bool lastErrorIs(Result::Code code);
 
     namespace detail {
+        /// Push onto the calling thread's system error stack, e.g. an invalid handle dereferenced. The stack has a
+        /// fixed capacity, so this never allocates, also on the audio thread.
         void pushSystemError(Result::Code code, const char *message = nullptr);
         Result popSystemError();
         const Result &peekSystemError();
+
+        /// Arguments of a `pushError` call, messages must be string literals or otherwise outlive the queue
+        struct ErrorRecord {
+            Result::Code code;
+            const char *message;
+            const char *functionName;
+            const char *fileName;
+            int lineNumber;
+        };
+
+        /// Fixed-size, lock-free queue that collects errors pushed on the audio thread without allocating or
+        /// logging there. Another thread formats and logs them later via `flush`.
+        class ErrorQueue {
+        public:
+            explicit ErrorQueue(size_t capacity) : m_queue(capacity), m_dropped(0) { }
+
+            /// Producer side, called by `pushError` on a thread routed here via `ErrorQueueScope`
+            void push(const ErrorRecord &record)
+            {
+                if (!m_queue.tryPush(record))
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            /// Consumer side: push queued errors onto the calling thread's error stack, logging each one
+            /// @returns number of errors flushed
+            size_t flush();
+
+            /// Number of errors lost because the queue was full
+            [[nodiscard]]
+            size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+        private:
+            SpscQueue<ErrorRecord> m_queue;
+            std::atomic<size_t> m_dropped;
+        };
+
+        /// Routes `pushError` calls on the current thread into `queue` for the lifetime of this object
+        class ErrorQueueScope {
+        public:
+            explicit ErrorQueueScope(ErrorQueue *queue);
+            ~ErrorQueueScope();
+
+            ErrorQueueScope(const ErrorQueueScope &) = delete;
+            ErrorQueueScope &operator=(const ErrorQueueScope &) = delete;
+        private:
+            ErrorQueue *m_lastQueue;
+        };
     }
 
 }
@@ -1,56 +1,99 @@
 #pragma once
 #include "Pool.h"
 
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+/// Whether `Handle::get` asserts that the handle is valid. Internal code such as bus mixing relies on handles it
+/// dereferences staying valid until deferred commands run; enabled by default in debug builds to catch violations.
+#ifndef INSOUND_HANDLE_CHECKS
+#   ifdef INSOUND_DEBUG
+#       define INSOUND_HANDLE_CHECKS 1
+#   else
+#       define INSOUND_HANDLE_CHECKS 0
+#   endif
+#endif
+
 namespace insound {
+    /// Generational reference to a pooled object, packed into 64 bits: the pool's registry tag, the slot generation,
+    /// and the slot index. Stale handles fail validation once their slot is deallocated, even if it is reused.
     template <typename T>
     class Handle {
     public:
-        Handle() : m_id(), m_pool() { } // invalid null handle
-        Handle(PoolID id, PoolBase *pool) : m_id(id), m_pool(pool) { }
+        Handle() : m_value() { } // invalid null handle
+        Handle(PoolID id, const PoolBase *pool) :
+            m_value(static_cast<uint64_t>(pool->tag()) << TagShift |
+                static_cast<uint64_t>(id.generation) << PoolID::IndexBits | id.index) { }
         ~Handle() = default;
 
         [[nodiscard]]
         T *operator ->() const
         {
-            if (!isValid())
-                detail::pushSystemError(Result::InvalidHandle);
-            return (T *)m_pool->get(m_id);
+            const auto pool = this->pool();
+            if (const auto ptr = pool ? pool->tryGet(id()) : nullptr)
+                return (T *)ptr;
+
+            // Invalid: the function called via the pointer checks for this error via `HANDLE_GUARD`
+            detail::pushSystemError(Result::InvalidHandle);
+            return (T *)pool->get(id());
+        }
+
+        /// Get raw pointer if the handle is valid, checking and resolving it in one step
+        /// @returns pointer to the object, or `nullptr` if the handle is invalid
+        [[nodiscard]]
+        T *tryGet() const
+        {
+            const auto pool = this->pool();
+            return pool ? (T *)pool->tryGet(id()) : nullptr;
         }
 
         /// Get raw pointer, it's best to check `Handle::isValid()`
         /// first unless you are sure it's valid.
         [[nodiscard]]
-        T *get() const { return (T *)m_pool->get(m_id); }
+        T *get() const
+        {
+#if INSOUND_HANDLE_CHECKS
+            assert(isValid() && "Handle::get called on an invalid handle");
+#endif
+            return (T *)pool()->get(id());
+        }
 
-        T &operator *() const { return *(T *)m_pool->get(m_id); }
+        T &operator *() const { return *get(); }
 
-        /// Dynamic cast to target type. Will return nullptr if type is not in the inheritance hierarchy.
+        /// Checked cast to target type, see `poolCast`. Will return nullptr if the object is not a `U`, or if the
+        /// handle is invalid.
         template <typename U>
         [[nodiscard]]
         U *getAs() const
         {
-            return dynamic_cast<U *>(get());
+            return poolCast<U>(tryGet());
         }
 
         /// Check with owning pool that this handle is valid
         [[nodiscard]]
         bool isValid() const
         {
-            // checking for `nullptr` covers default-constructed null handles
-            return m_pool != nullptr && m_pool->isValid(m_id);
+            // null handles have tag 0, whose registry entry stays `nullptr`
+            const auto pool = this->pool();
+            return pool != nullptr && pool->isValid(id());
         }
 
         [[nodiscard]]
         explicit operator bool() const
         {
-            return static_cast<bool>(m_id);
+            return m_value != 0;
         }
 
+        /// Convert to a handle of another type in the hierarchy. Conversions to a base class keep the handle as-is,
+        /// downcasts check the object's concrete type and result in a null handle if it isn't `U` or if invalid.
         template <typename U>
         explicit operator Handle<U>() const
         {
-            auto uptr = dynamic_cast<U *>(get());
-            return uptr ? Handle<U>(m_id, m_pool) : Handle<U>();
+            if constexpr (std::is_base_of_v<std::remove_cv_t<U>, std::remove_cv_t<T>>)
+                return Handle<U>(m_value);
+            else
+                return getAs<U>() ? Handle<U>(m_value) : Handle<U>();
         }
 
         template <typename U>
@@ -63,7 +106,7 @@ namespace insound {
         [[nodiscard]]
         bool operator ==(const Handle<U> &other) const
         {
-            return m_id.id == other.m_id.id && m_pool == other.m_pool;
+            return m_value == other.m_value;
         }
 
         template <typename U>
@@ -74,11 +117,30 @@ namespace insound {
         }
 
         [[nodiscard]]
-        PoolID id() const { return m_id; }
+        PoolID id() const
+        {
+            return {static_cast<uint32_t>(m_value & IndexMask),
+                static_cast<uint32_t>(m_value >> PoolID::IndexBits) & PoolID::GenerationMask};
+        }
+
+        /// Pool this handle points into, `nullptr` for null handles or if the pool was destroyed
+        [[nodiscard]]
+        PoolBase *pool() const
+        {
+            return detail::poolRegistry[m_value >> TagShift];
+        }
 
     private:
+        template <typename U>
+        friend class Handle;
         friend class MultiPool;
-        PoolID m_id;
-        mutable PoolBase *m_pool;
+
+        explicit Handle(uint64_t value) : m_value(value) { }
+
+        static constexpr uint32_t TagShift = PoolID::IndexBits + PoolID::GenerationBits;
+        static constexpr uint64_t IndexMask = (uint64_t(1) << PoolID::IndexBits) - 1u;
+        static_assert(TagShift + detail::PoolTagBits == 64, "Handle fields must fill 64 bits");
+
+        uint64_t m_value; ///< tag | generation | index
     };
 }
@@ -0,0 +1,300 @@
+#include "Interpolation.h"
+
+#include "CpuIntrinsics.h"
+
+#include <cmath>
+
+namespace insound {
+    static constexpr int SincTaps = 8;
+    static constexpr int SincPhases = 256;
+
+    /// 8-tap Blackman-windowed sinc coefficients for each fractional phase, each row normalized to unity gain.
+    /// Every tap is stored twice, once per stereo channel, so a row multiplies directly against interleaved frames.
+    struct SincTable {
+        SincTable()
+        {
+            constexpr double Pi = 3.14159265358979323846;
+            constexpr double HalfWidth = SincTaps / 2;
+
+            for (int phase = 0; phase <= SincPhases; ++phase)
+            {
+                const double t = static_cast<double>(phase) / SincPhases;
+                double taps[SincTaps];
+                double sum = 0;
+                for (int tap = 0; tap < SincTaps; ++tap)
+                {
+                    const auto x = static_cast<double>(tap - InterpolationPadBefore) - t;
+                    const auto sinc = x == 0 ? 1.0 : std::sin(Pi * x) / (Pi * x);
+                    const auto window = std::abs(x) >= HalfWidth ? 0 :
+                        .42 + .5 * std::cos(Pi * x / HalfWidth) + .08 * std::cos(2.0 * Pi * x / HalfWidth);
+                    taps[tap] = sinc * window;
+                    sum += taps[tap];
+                }
+
+                for (int tap = 0; tap < SincTaps; ++tap)
+                {
+                    coefs[phase][tap * 2] = static_cast<float>(taps[tap] / sum);
+                    coefs[phase][tap * 2 + 1] = coefs[phase][tap * 2];
+                }
+            }
+        }
+
+        alignas(16) float coefs[SincPhases + 1][SincTaps * 2];
+    };
+
+    // Built at static initialization, so the audio thread never pays for it
+    static const SincTable s_sincTable;
+
+    /// @returns read position of output frame `i`
+    static inline float positionAt(const float position, const float step, const float stepDelta, const int i)
+    {
+        const auto fi = static_cast<float>(i);
+        return position + fi * step + stepDelta * (fi * (fi - 1.f) * .5f);
+    }
+
+    // ===== Per-frame kernels, used by the scalar path and for leftovers ====================================
+
+    struct NearestKernel {
+        static inline void frame(const float *frames, const float position, float *output)
+        {
+            const auto x = frames + static_cast<int>(position + .5f) * 2;
+            output[0] = x[0];
+            output[1] = x[1];
+        }
+    };
+
+    struct LinearKernel {
+        static inline void frame(const float *frames, const float position, float *output)
+        {
+            const auto index = static_cast<int>(position);
+            const auto t = position - static_cast<float>(index);
+            const auto x = frames + index * 2;
+            output[0] = x[0] + (x[2] - x[0]) * t;
+            output[1] = x[1] + (x[3] - x[1]) * t;
+        }
+    };
+
+    struct CubicKernel {
+        static inline void frame(const float *frames, const float position, float *output)
+        {
+            const auto index = static_cast<int>(position);
+            const auto t = position - static_cast<float>(index);
+            const auto x = frames + (index - 1) * 2;
+            for (int c = 0; c < 2; ++c)
+            {
+                const auto xm1 = x[c], x0 = x[c + 2], x1 = x[c + 4], x2 = x[c + 6];
+                const auto c1 = .5f * (x1 - xm1);
+                const auto c2 = xm1 - 2.5f * x0 + 2.f * x1 - .5f * x2;
+                const auto c3 = .5f * (x2 - xm1) + 1.5f * (x0 - x1);
+                output[c] = ((c3 * t + c2) * t + c1) * t + x0;
+            }
+        }
+    };
+
+    struct SincKernel {
+        static inline const float *row(const float position, int *outIndex)
+        {
+            const auto index = static_cast<int>(position);
+            const auto phase = static_cast<int>((position - static_cast<float>(index)) * SincPhases + .5f);
+            *outIndex = index;
+            return s_sincTable.coefs[phase];
+        }
+
+        static inline void frame(const float *frames, const float position, float *output)
+        {
+            int index;
+            const auto coefs = row(position, &index);
+            const auto x = frames + (index - InterpolationPadBefore) * 2;
+
+            float left = 0, right = 0;
+            for (int tap = 0; tap < SincTaps; ++tap)
+            {
+                left += x[tap * 2] * coefs[tap * 2];
+                right += x[tap * 2 + 1] * coefs[tap * 2 + 1];
+            }
+
+            output[0] = left;
+            output[1] = right;
+        }
+    };
+
+    // ===== Vectorized kernels, rendering two stereo frames per vector ======================================
+
+#if INSOUND_SSE || INSOUND_WASM_SIMD || INSOUND_ARM_NEON
+#define INSOUND_INTERPOLATION_SIMD 1
+
+#if     INSOUND_SSE
+    using f32x4 = __m128;
+
+    static inline f32x4 vSplat(const float v) { return _mm_set1_ps(v); }
+    static inline f32x4 vLoad(const float *p) { return _mm_loadu_ps(p); }
+    static inline void vStore(float *p, const f32x4 v) { _mm_storeu_ps(p, v); }
+    static inline f32x4 vAdd(const f32x4 a, const f32x4 b) { return _mm_add_ps(a, b); }
+    static inline f32x4 vSub(const f32x4 a, const f32x4 b) { return _mm_sub_ps(a, b); }
+    static inline f32x4 vMul(const f32x4 a, const f32x4 b) { return _mm_mul_ps(a, b); }
+
+    /// @returns [a, a, b, b]
+    static inline f32x4 vPair(const float a, const float b) { return _mm_setr_ps(a, a, b, b); }
+
+    /// @returns the stereo frames at `a` and `b` in one vector: [a0, a1, b0, b1]
+    static inline f32x4 vFrames(const float *a, const float *b)
+    {
+        return _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)a), (const __m64 *)b);
+    }
+
+    /// @returns [a0 + a2, a1 + a3, b0 + b2, b1 + b3]
+    static inline f32x4 vSumHalves(const f32x4 a, const f32x4 b)
+    {
+        return _mm_add_ps(_mm_movelh_ps(a, b), _mm_movehl_ps(b, a));
+    }
+#elif   INSOUND_WASM_SIMD
+    using f32x4 = v128_t;
+
+    static inline f32x4 vSplat(const float v) { return wasm_f32x4_splat(v); }
+    static inline f32x4 vLoad(const float *p) { return wasm_v128_load(p); }
+    static inline void vStore(float *p, const f32x4 v) { wasm_v128_store(p, v); }
+    static inline f32x4 vAdd(const f32x4 a, const f32x4 b) { return wasm_f32x4_add(a, b); }
+    static inline f32x4 vSub(const f32x4 a, const f32x4 b) { return wasm_f32x4_sub(a, b); }
+    static inline f32x4 vMul(const f32x4 a, const f32x4 b) { return wasm_f32x4_mul(a, b); }
+    static inline f32x4 vPair(const float a, const float b) { return wasm_f32x4_make(a, a, b, b); }
+
+    static inline f32x4 vFrames(const float *a, const float *b)
+    {
+        return wasm_f32x4_make(a[0], a[1], b[0], b[1]);
+    }
+
+    static inline f32x4 vSumHalves(const f32x4 a, const f32x4 b)
+    {
+        return wasm_f32x4_add(wasm_i32x4_shuffle(a, b, 0, 1, 4, 5), wasm_i32x4_shuffle(a, b, 2, 3, 6, 7));
+    }
+#elif   INSOUND_ARM_NEON
+    using f32x4 = float32x4_t;
+
+    static inline f32x4 vSplat(const float v) { return vdupq_n_f32(v); }
+    static inline f32x4 vLoad(const float *p) { return vld1q_f32(p); }
+    static inline void vStore(float *p, const f32x4 v) { vst1q_f32(p, v); }
+    static inline f32x4 vAdd(const f32x4 a, const f32x4 b) { return vaddq_f32(a, b); }
+    static inline f32x4 vSub(const f32x4 a, const f32x4 b) { return vsubq_f32(a, b); }
+    static inline f32x4 vMul(const f32x4 a, const f32x4 b) { return vmulq_f32(a, b); }
+    static inline f32x4 vPair(const float a, const float b) { return vcombine_f32(vdup_n_f32(a), vdup_n_f32(b)); }
+
+    static inline f32x4 vFrames(const float *a, const float *b)
+    {
+        return vcombine_f32(vld1_f32(a), vld1_f32(b));
+    }
+
+    static inline f32x4 vSumHalves(const f32x4 a, const f32x4 b)
+    {
+        return vcombine_f32(vadd_f32(vget_low_f32(a), vget_high_f32(a)),
+            vadd_f32(vget_low_f32(b), vget_high_f32(b)));
+    }
+#endif
+
+    struct NearestPairKernel : NearestKernel {
+        static inline f32x4 pair(const float *frames, const float a, const float b)
+        {
+            return vFrames(frames + static_cast<int>(a + .5f) * 2, frames + static_cast<int>(b + .5f) * 2);
+        }
+    };
+
+    struct LinearPairKernel : LinearKernel {
+        static inline f32x4 pair(const float *frames, const float a, const float b)
+        {
+            const auto indexA = static_cast<int>(a), indexB = static_cast<int>(b);
+            const auto t = vPair(a - static_cast<float>(indexA), b - static_cast<float>(indexB));
+            const auto xa = frames + indexA * 2, xb = frames + indexB * 2;
+
+            const auto x0 = vFrames(xa, xb);
+            const auto x1 = vFrames(xa + 2, xb + 2);
+            return vAdd(x0, vMul(vSub(x1, x0), t));
+        }
+    };
+
+    struct CubicPairKernel : CubicKernel {
+        static inline f32x4 pair(const float *frames, const float a, const float b)
+        {
+            const auto indexA = static_cast<int>(a), indexB = static_cast<int>(b);
+            const auto t = vPair(a - static_cast<float>(indexA), b - static_cast<float>(indexB));
+            const auto xa = frames + (indexA - 1) * 2, xb = frames + (indexB - 1) * 2;
+
+            const auto xm1 = vFrames(xa, xb);
+            const auto x0 = vFrames(xa + 2, xb + 2);
+            const auto x1 = vFrames(xa + 4, xb + 4);
+            const auto x2 = vFrames(xa + 6, xb + 6);
+
+            const auto half = vSplat(.5f);
+            const auto c1 = vMul(half, vSub(x1, xm1));
+            const auto c2 = vSub(vAdd(xm1, vMul(vSplat(2.f), x1)),
+                vAdd(vMul(vSplat(2.5f), x0), vMul(half, x2)));
+            const auto c3 = vAdd(vMul(half, vSub(x2, xm1)), vMul(vSplat(1.5f), vSub(x0, x1)));
+            return vAdd(vMul(vAdd(vMul(vAdd(vMul(c3, t), c2), t), c1), t), x0);
+        }
+    };
+
+    struct SincPairKernel : SincKernel {
+        /// @returns [left, right, left, right] partial sums of the filter at `position`
+        static inline f32x4 partial(const float *frames, const float position)
+        {
+            int index;
+            const auto coefs = row(position, &index);
+            const auto x = frames + (index - InterpolationPadBefore) * 2;
+
+            const auto sum0 = vAdd(vMul(vLoad(x), vLoad(coefs)), vMul(vLoad(x + 4), vLoad(coefs + 4)));
+            const auto sum1 = vAdd(vMul(vLoad(x + 8), vLoad(coefs + 8)), vMul(vLoad(x + 12), vLoad(coefs + 12)));
+            return vAdd(sum0, sum1);
+        }
+
+        static inline f32x4 pair(const float *frames, const float a, const float b)
+        {
+            return vSumHalves(partial(frames, a), partial(frames, b));
+        }
+    };
+#else
+    using NearestPairKernel = NearestKernel;
+    using LinearPairKernel = LinearKernel;
+    using CubicPairKernel = CubicKernel;
+    using SincPairKernel = SincKernel;
+#endif
+
+    template <typename Kernel>
+    static void render(const float *frames, const float position, const float step, const float stepDelta,
+        float *output, const int count)
+    {
+        int i = 0;
+#if INSOUND_INTERPOLATION_SIMD
+        for (; i <= count - 4; i += 4)
+        {
+            vStore(output + i * 2, Kernel::pair(frames,
+                positionAt(position, step, stepDelta, i),
+                positionAt(position, step, stepDelta, i + 1)));
+            vStore(output + i * 2 + 4, Kernel::pair(frames,
+                positionAt(position, step, stepDelta, i + 2),
+                positionAt(position, step, stepDelta, i + 3)));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            Kernel::frame(frames, positionAt(position, step, stepDelta, i), output + i * 2);
+        }
+    }
+
+    void interpolateStereo(const InterpolationMode mode, const float *frames, const float position, const float step,
+        const float stepDelta, float *output, const int count)
+    {
+        switch(mode)
+        {
+            case InterpolationMode::Nearest:
+                render<NearestPairKernel>(frames, position, step, stepDelta, output, count);
+                break;
+            case InterpolationMode::Linear:
+                render<LinearPairKernel>(frames, position, step, stepDelta, output, count);
+                break;
+            case InterpolationMode::Cubic:
+                render<CubicPairKernel>(frames, position, step, stepDelta, output, count);
+                break;
+            case InterpolationMode::Sinc:
+                render<SincPairKernel>(frames, position, step, stepDelta, output, count);
+                break;
+        }
+    }
+}
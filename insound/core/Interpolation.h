@@ -0,0 +1,30 @@
+#pragma once
+
+namespace insound {
+    /// Interpolation used when a PCMSource plays back at a speed other than 1
+    enum class InterpolationMode {
+        Nearest, ///< nearest sample, cheapest, adds audible aliasing and stepping noise
+        Linear,  ///< 2-point linear interpolation, default
+        Cubic,   ///< 4-point, 3rd-order Hermite (Catmull-Rom) interpolation
+        Sinc,    ///< 8-tap windowed sinc, flattest passband; does not band-limit when speeding up
+    };
+
+    /// Number of frames before the read position that `interpolateStereo` may access
+    constexpr int InterpolationPadBefore = 3;
+
+    /// Number of frames after the read position that `interpolateStereo` may access
+    constexpr int InterpolationPadAfter = 5;
+
+    /// Render interleaved stereo frames by reading a source at a fractional position that advances by a linearly
+    /// ramping step each frame: output frame `i` reads from `position + i * step + stepDelta * i * (i - 1) / 2`.
+    /// @param mode       interpolation mode to use
+    /// @param frames     interleaved stereo source frames; must be readable from `InterpolationPadBefore` frames
+    ///                   before `position` to `InterpolationPadAfter` frames after the last read position
+    /// @param position   read position of the first output frame, relative to `frames`; must not be negative
+    /// @param step       frames to advance between the first and second output frame, i.e. the playback speed
+    /// @param stepDelta  amount the step changes per output frame, for speed ramps
+    /// @param output     buffer to receive `count` interleaved stereo frames
+    /// @param count      number of frames to render
+    void interpolateStereo(InterpolationMode mode, const float *frames, float position, float step, float stepDelta,
+        float *output, int count);
+}
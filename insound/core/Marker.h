@@ -11,4 +11,15 @@ namespace insound {
         std::string label;    ///< marker name
         uint32_t    position; ///< position in samples, check sample rate retrieved from spec for conversion to seconds, etc.
     };
+
+    /// Region of a sound that plays repeatedly while looping, after the frames before it play once
+    struct LoopRegion {
+        LoopRegion() : start(), end(), crossfade() { }
+        LoopRegion(uint32_t start, uint32_t end, uint32_t crossfade = 0) :
+            start(start), end(end), crossfade(crossfade) { }
+
+        uint32_t start;     ///< first frame of the loop
+        uint32_t end;       ///< frame after the last frame of the loop
+        uint32_t crossfade; ///< number of frames before `end` blended into the frames before `start`, 0 for a hard loop
+    };
 }
@@ -0,0 +1,558 @@
+#include "MixKernels.h"
+
+#include "CpuIntrinsics.h"
+
+#include <algorithm>
+
+namespace insound {
+    namespace {
+        // ----- Compile-time path: SSE, WASM SIMD, NEON or scalar ------------------------------------------------
+
+        void addBase(const float *input, float *output, const uint32_t count)
+        {
+            uint32_t i = 0;
+#if     INSOUND_SSE
+            for (; i + 8 <= count; i += 8)
+            {
+                _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_loadu_ps(input + i)));
+                _mm_storeu_ps(output + i + 4, _mm_add_ps(_mm_loadu_ps(output + i + 4), _mm_loadu_ps(input + i + 4)));
+            }
+#elif   INSOUND_WASM_SIMD
+            for (; i + 8 <= count; i += 8)
+            {
+                wasm_v128_store(output + i, wasm_f32x4_add(wasm_v128_load(output + i), wasm_v128_load(input + i)));
+                wasm_v128_store(output + i + 4, wasm_f32x4_add(wasm_v128_load(output + i + 4),
+                    wasm_v128_load(input + i + 4)));
+            }
+#elif   INSOUND_ARM_NEON
+            for (; i + 8 <= count; i += 8)
+            {
+                vst1q_f32(output + i, vaddq_f32(vld1q_f32(output + i), vld1q_f32(input + i)));
+                vst1q_f32(output + i + 4, vaddq_f32(vld1q_f32(output + i + 4), vld1q_f32(input + i + 4)));
+            }
+#endif
+            for (; i < count; ++i)
+                output[i] += input[i];
+        }
+
+        void sum4Base(const float *a, const float *b, const float *c, const float *d, const float *gains,
+            float *output, const uint32_t count)
+        {
+            uint32_t i = 0;
+#if     INSOUND_SSE
+            const auto gainA = _mm_set1_ps(gains[0]);
+            const auto gainB = _mm_set1_ps(gains[1]);
+            const auto gainC = _mm_set1_ps(gains[2]);
+            const auto gainD = _mm_set1_ps(gains[3]);
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto sample = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), gainA), _mm_mul_ps(_mm_loadu_ps(b + i), gainB)),
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(c + i), gainC), _mm_mul_ps(_mm_loadu_ps(d + i), gainD)));
+                _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), sample));
+            }
+#elif   INSOUND_WASM_SIMD
+            const auto gainA = wasm_f32x4_splat(gains[0]);
+            const auto gainB = wasm_f32x4_splat(gains[1]);
+            const auto gainC = wasm_f32x4_splat(gains[2]);
+            const auto gainD = wasm_f32x4_splat(gains[3]);
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto sample = wasm_f32x4_add(
+                    wasm_f32x4_add(wasm_f32x4_mul(wasm_v128_load(a + i), gainA),
+                        wasm_f32x4_mul(wasm_v128_load(b + i), gainB)),
+                    wasm_f32x4_add(wasm_f32x4_mul(wasm_v128_load(c + i), gainC),
+                        wasm_f32x4_mul(wasm_v128_load(d + i), gainD)));
+                wasm_v128_store(output + i, wasm_f32x4_add(wasm_v128_load(output + i), sample));
+            }
+#elif   INSOUND_ARM_NEON
+            const auto gainA = vdupq_n_f32(gains[0]);
+            const auto gainB = vdupq_n_f32(gains[1]);
+            const auto gainC = vdupq_n_f32(gains[2]);
+            const auto gainD = vdupq_n_f32(gains[3]);
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto sample = vaddq_f32(
+                    vaddq_f32(vmulq_f32(vld1q_f32(a + i), gainA), vmulq_f32(vld1q_f32(b + i), gainB)),
+                    vaddq_f32(vmulq_f32(vld1q_f32(c + i), gainC), vmulq_f32(vld1q_f32(d + i), gainD)));
+                vst1q_f32(output + i, vaddq_f32(vld1q_f32(output + i), sample));
+            }
+#endif
+            for (; i < count; ++i)
+                output[i] += (a[i] * gains[0] + b[i] * gains[1]) + (c[i] * gains[2] + d[i] * gains[3]);
+        }
+
+        void addScaledBase(const float *input, float *output, const uint32_t count, const float gain)
+        {
+            uint32_t i = 0;
+#if     INSOUND_SSE
+            const auto gains = _mm_set1_ps(gain);
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i),
+                    _mm_mul_ps(_mm_loadu_ps(input + i), gains)));
+            }
+#elif   INSOUND_WASM_SIMD
+            const auto gains = wasm_f32x4_splat(gain);
+            for (; i + 4 <= count; i += 4)
+            {
+                wasm_v128_store(output + i, wasm_f32x4_add(wasm_v128_load(output + i),
+                    wasm_f32x4_mul(wasm_v128_load(input + i), gains)));
+            }
+#elif   INSOUND_ARM_NEON
+            const auto gains = vdupq_n_f32(gain);
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(output + i, vaddq_f32(vld1q_f32(output + i), vmulq_f32(vld1q_f32(input + i), gains)));
+#endif
+            for (; i < count; ++i)
+                output[i] += input[i] * gain;
+        }
+
+        void gainBase(const float *input, float *output, const uint32_t count, const float gain)
+        {
+            uint32_t i = 0;
+#if     INSOUND_SSE
+            const auto gains = _mm_set1_ps(gain);
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto a = _mm_loadu_ps(input + i);
+                const auto b = _mm_loadu_ps(input + i + 4);
+                const auto c = _mm_loadu_ps(input + i + 8);
+                const auto d = _mm_loadu_ps(input + i + 12);
+                _mm_storeu_ps(output + i, _mm_mul_ps(a, gains));
+                _mm_storeu_ps(output + i + 4, _mm_mul_ps(b, gains));
+                _mm_storeu_ps(output + i + 8, _mm_mul_ps(c, gains));
+                _mm_storeu_ps(output + i + 12, _mm_mul_ps(d, gains));
+            }
+#elif   INSOUND_WASM_SIMD
+            const auto gains = wasm_f32x4_splat(gain);
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto a = wasm_v128_load(input + i);
+                const auto b = wasm_v128_load(input + i + 4);
+                const auto c = wasm_v128_load(input + i + 8);
+                const auto d = wasm_v128_load(input + i + 12);
+                wasm_v128_store(output + i, wasm_f32x4_mul(a, gains));
+                wasm_v128_store(output + i + 4, wasm_f32x4_mul(b, gains));
+                wasm_v128_store(output + i + 8, wasm_f32x4_mul(c, gains));
+                wasm_v128_store(output + i + 12, wasm_f32x4_mul(d, gains));
+            }
+#elif   INSOUND_ARM_NEON
+            const auto gains = vdupq_n_f32(gain);
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto a = vld1q_f32(input + i);
+                const auto b = vld1q_f32(input + i + 4);
+                const auto c = vld1q_f32(input + i + 8);
+                const auto d = vld1q_f32(input + i + 12);
+                vst1q_f32(output + i, vmulq_f32(a, gains));
+                vst1q_f32(output + i + 4, vmulq_f32(b, gains));
+                vst1q_f32(output + i + 8, vmulq_f32(c, gains));
+                vst1q_f32(output + i + 12, vmulq_f32(d, gains));
+            }
+#endif
+            for (; i < count; ++i)
+                output[i] = input[i] * gain;
+        }
+
+        void stereoRampBase(const float *input, float *output, const uint32_t frames, const float gain,
+            const float delta)
+        {
+            const auto count = frames * 2;
+            uint32_t i = 0;
+#if     INSOUND_SSE
+            auto gains = _mm_set_ps(gain + delta, gain + delta, gain, gain); // two frames per vector
+            const auto deltas = _mm_set1_ps(delta * 2.f);
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), gains));
+                gains = _mm_add_ps(gains, deltas);
+            }
+#elif   INSOUND_WASM_SIMD
+            auto gains = wasm_f32x4_make(gain, gain, gain + delta, gain + delta);
+            const auto deltas = wasm_f32x4_splat(delta * 2.f);
+            for (; i + 4 <= count; i += 4)
+            {
+                wasm_v128_store(output + i, wasm_f32x4_mul(wasm_v128_load(input + i), gains));
+                gains = wasm_f32x4_add(gains, deltas);
+            }
+#elif   INSOUND_ARM_NEON
+            float32x4_t gains {gain, gain, gain + delta, gain + delta};
+            const auto deltas = vdupq_n_f32(delta * 2.f);
+            for (; i + 4 <= count; i += 4)
+            {
+                vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), gains));
+                gains = vaddq_f32(gains, deltas);
+            }
+#endif
+            for (; i < count; i += 2)
+            {
+                const auto g = gain + delta * static_cast<float>(i / 2);
+                output[i] = input[i] * g;
+                output[i + 1] = input[i + 1] * g;
+            }
+        }
+
+        void delayBase(const float *input, float *output, float *line, const uint32_t count, const float dry,
+            const float wet, const float feedback)
+        {
+            uint32_t i = 0;
+#if     INSOUND_SSE
+            const auto dryVec = _mm_set1_ps(dry);
+            const auto wetVec = _mm_set1_ps(wet);
+            const auto feedbackVec = _mm_set1_ps(feedback);
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto line0 = _mm_loadu_ps(line + i);
+                const auto line1 = _mm_loadu_ps(line + i + 4);
+                const auto input0 = _mm_loadu_ps(input + i);
+                const auto input1 = _mm_loadu_ps(input + i + 4);
+                _mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(input0, dryVec), _mm_mul_ps(line0, wetVec)));
+                _mm_storeu_ps(output + i + 4, _mm_add_ps(_mm_mul_ps(input1, dryVec), _mm_mul_ps(line1, wetVec)));
+                _mm_storeu_ps(line + i, _mm_mul_ps(input0, feedbackVec));
+                _mm_storeu_ps(line + i + 4, _mm_mul_ps(input1, feedbackVec));
+            }
+#elif   INSOUND_WASM_SIMD
+            const auto dryVec = wasm_f32x4_splat(dry);
+            const auto wetVec = wasm_f32x4_splat(wet);
+            const auto feedbackVec = wasm_f32x4_splat(feedback);
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto line0 = wasm_v128_load(line + i);
+                const auto line1 = wasm_v128_load(line + i + 4);
+                const auto input0 = wasm_v128_load(input + i);
+                const auto input1 = wasm_v128_load(input + i + 4);
+                wasm_v128_store(output + i, wasm_f32x4_add(wasm_f32x4_mul(input0, dryVec),
+                    wasm_f32x4_mul(line0, wetVec)));
+                wasm_v128_store(output + i + 4, wasm_f32x4_add(wasm_f32x4_mul(input1, dryVec),
+                    wasm_f32x4_mul(line1, wetVec)));
+                wasm_v128_store(line + i, wasm_f32x4_mul(input0, feedbackVec));
+                wasm_v128_store(line + i + 4, wasm_f32x4_mul(input1, feedbackVec));
+            }
+#elif   INSOUND_ARM_NEON
+            const auto dryVec = vdupq_n_f32(dry);
+            const auto wetVec = vdupq_n_f32(wet);
+            const auto feedbackVec = vdupq_n_f32(feedback);
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto line0 = vld1q_f32(line + i);
+                const auto line1 = vld1q_f32(line + i + 4);
+                const auto input0 = vld1q_f32(input + i);
+                const auto input1 = vld1q_f32(input + i + 4);
+                vst1q_f32(output + i, vmlaq_f32(vmulq_f32(input0, dryVec), line0, wetVec));
+                vst1q_f32(output + i + 4, vmlaq_f32(vmulq_f32(input1, dryVec), line1, wetVec));
+                vst1q_f32(line + i, vmulq_f32(input0, feedbackVec));
+                vst1q_f32(line + i + 4, vmulq_f32(input1, feedbackVec));
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                const auto in = input[i];
+                output[i] = in * dry + line[i] * wet;
+                line[i] = in * feedback;
+            }
+        }
+
+        // ----- N-way sum, shared by every path --------------------------------------------------------------------
+
+        /// Samples of output summed at a time, a 512-frame stereo buffer. Small enough that the block stays in L1
+        /// cache while four inputs stream past it, so the output leaves the cache once per block, not once per input.
+        constexpr uint32_t SumBlockSamples = 1024;
+
+        template <auto Sum4, auto AddScaled>
+        void sumBlocked(const float *const *inputs, const float *gains, const uint32_t inputCount, float *output,
+            const uint32_t count)
+        {
+            static constexpr float Unity[4] = {1.f, 1.f, 1.f, 1.f};
+            for (uint32_t block = 0; block < count; block += SumBlockSamples)
+            {
+                const auto samples = std::min(SumBlockSamples, count - block);
+                uint32_t i = 0;
+                for (; i + 4 <= inputCount; i += 4)
+                {
+                    Sum4(inputs[i] + block, inputs[i + 1] + block, inputs[i + 2] + block, inputs[i + 3] + block,
+                        gains ? gains + i : Unity, output + block, samples);
+                }
+                for (; i < inputCount; ++i)
+                    AddScaled(inputs[i] + block, output + block, samples, gains ? gains[i] : 1.f);
+            }
+        }
+
+        constexpr MixKernels BaseKernels {addBase, sumBlocked<sum4Base, addScaledBase>, gainBase, stereoRampBase,
+            delayBase};
+
+#if     INSOUND_SSE
+        constexpr SimdPath BasePath = SimdPath::Sse;
+#elif   INSOUND_WASM_SIMD
+        constexpr SimdPath BasePath = SimdPath::WasmSimd;
+#elif   INSOUND_ARM_NEON
+        constexpr SimdPath BasePath = SimdPath::Neon;
+#else
+        constexpr SimdPath BasePath = SimdPath::Scalar;
+#endif
+
+#if     INSOUND_X86_DISPATCH
+        // ----- AVX2: 256-bit with FMA, remainders finish on the compile-time path -------------------------------
+        // The tail calls skip the compiler's vzeroupper, which leaves the upper registers dirty and slows the legacy
+        // SSE code after them down several times, so each kernel clears them explicitly before handing off.
+
+        INSOUND_TARGET("avx2,fma")
+        void addAvx2(const float *input, float *output, const uint32_t count)
+        {
+            uint32_t i = 0;
+            for (; i + 16 <= count; i += 16)
+            {
+                _mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_loadu_ps(output + i), _mm256_loadu_ps(input + i)));
+                _mm256_storeu_ps(output + i + 8, _mm256_add_ps(_mm256_loadu_ps(output + i + 8),
+                    _mm256_loadu_ps(input + i + 8)));
+            }
+            _mm256_zeroupper();
+            addBase(input + i, output + i, count - i);
+        }
+
+        INSOUND_TARGET("avx2,fma")
+        void sum4Avx2(const float *a, const float *b, const float *c, const float *d, const float *gains,
+            float *output, const uint32_t count)
+        {
+            uint32_t i = 0;
+            const auto gainA = _mm256_set1_ps(gains[0]);
+            const auto gainB = _mm256_set1_ps(gains[1]);
+            const auto gainC = _mm256_set1_ps(gains[2]);
+            const auto gainD = _mm256_set1_ps(gains[3]);
+            for (; i + 8 <= count; i += 8)
+            {
+                auto sample = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), gainA, _mm256_loadu_ps(output + i));
+                sample = _mm256_fmadd_ps(_mm256_loadu_ps(b + i), gainB, sample);
+                sample = _mm256_fmadd_ps(_mm256_loadu_ps(c + i), gainC, sample);
+                _mm256_storeu_ps(output + i, _mm256_fmadd_ps(_mm256_loadu_ps(d + i), gainD, sample));
+            }
+            _mm256_zeroupper();
+            sum4Base(a + i, b + i, c + i, d + i, gains, output + i, count - i);
+        }
+
+        INSOUND_TARGET("avx2,fma")
+        void addScaledAvx2(const float *input, float *output, const uint32_t count, const float gain)
+        {
+            uint32_t i = 0;
+            const auto gains = _mm256_set1_ps(gain);
+            for (; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_ps(output + i, _mm256_fmadd_ps(_mm256_loadu_ps(input + i), gains,
+                    _mm256_loadu_ps(output + i)));
+            }
+            _mm256_zeroupper();
+            addScaledBase(input + i, output + i, count - i, gain);
+        }
+
+        INSOUND_TARGET("avx2,fma")
+        void gainAvx2(const float *input, float *output, const uint32_t count, const float gain)
+        {
+            uint32_t i = 0;
+            const auto gains = _mm256_set1_ps(gain);
+            for (; i + 16 <= count; i += 16)
+            {
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_loadu_ps(input + i), gains));
+                _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_loadu_ps(input + i + 8), gains));
+            }
+            _mm256_zeroupper();
+            gainBase(input + i, output + i, count - i, gain);
+        }
+
+        INSOUND_TARGET("avx2,fma")
+        void stereoRampAvx2(const float *input, float *output, const uint32_t frames, const float gain,
+            const float delta)
+        {
+            uint32_t f = 0;
+            auto gains = _mm256_set_ps(gain + delta * 3.f, gain + delta * 3.f, gain + delta * 2.f,
+                gain + delta * 2.f, gain + delta, gain + delta, gain, gain); // four frames per vector
+            const auto deltas = _mm256_set1_ps(delta * 4.f);
+            for (; f + 4 <= frames; f += 4)
+            {
+                _mm256_storeu_ps(output + f * 2, _mm256_mul_ps(_mm256_loadu_ps(input + f * 2), gains));
+                gains = _mm256_add_ps(gains, deltas);
+            }
+            _mm256_zeroupper();
+            stereoRampBase(input + f * 2, output + f * 2, frames - f, gain + delta * static_cast<float>(f), delta);
+        }
+
+        INSOUND_TARGET("avx2,fma")
+        void delayAvx2(const float *input, float *output, float *line, const uint32_t count, const float dry,
+            const float wet, const float feedback)
+        {
+            uint32_t i = 0;
+            const auto dryVec = _mm256_set1_ps(dry);
+            const auto wetVec = _mm256_set1_ps(wet);
+            const auto feedbackVec = _mm256_set1_ps(feedback);
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto in = _mm256_loadu_ps(input + i);
+                const auto delayed = _mm256_loadu_ps(line + i);
+                _mm256_storeu_ps(output + i, _mm256_fmadd_ps(delayed, wetVec, _mm256_mul_ps(in, dryVec)));
+                _mm256_storeu_ps(line + i, _mm256_mul_ps(in, feedbackVec));
+            }
+            _mm256_zeroupper();
+            delayBase(input + i, output + i, line + i, count - i, dry, wet, feedback);
+        }
+
+        constexpr MixKernels Avx2Kernels {addAvx2, sumBlocked<sum4Avx2, addScaledAvx2>, gainAvx2, stereoRampAvx2,
+            delayAvx2};
+
+        // ----- AVX-512: 512-bit ---------------------------------------------------------------------------------
+
+        INSOUND_TARGET("avx512f")
+        void addAvx512(const float *input, float *output, const uint32_t count)
+        {
+            uint32_t i = 0;
+            for (; i + 16 <= count; i += 16)
+                _mm512_storeu_ps(output + i, _mm512_add_ps(_mm512_loadu_ps(output + i), _mm512_loadu_ps(input + i)));
+            _mm256_zeroupper();
+            addBase(input + i, output + i, count - i);
+        }
+
+        INSOUND_TARGET("avx512f")
+        void sum4Avx512(const float *a, const float *b, const float *c, const float *d, const float *gains,
+            float *output, const uint32_t count)
+        {
+            uint32_t i = 0;
+            const auto gainA = _mm512_set1_ps(gains[0]);
+            const auto gainB = _mm512_set1_ps(gains[1]);
+            const auto gainC = _mm512_set1_ps(gains[2]);
+            const auto gainD = _mm512_set1_ps(gains[3]);
+            for (; i + 16 <= count; i += 16)
+            {
+                auto sample = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), gainA, _mm512_loadu_ps(output + i));
+                sample = _mm512_fmadd_ps(_mm512_loadu_ps(b + i), gainB, sample);
+                sample = _mm512_fmadd_ps(_mm512_loadu_ps(c + i), gainC, sample);
+                _mm512_storeu_ps(output + i, _mm512_fmadd_ps(_mm512_loadu_ps(d + i), gainD, sample));
+            }
+            _mm256_zeroupper();
+            sum4Base(a + i, b + i, c + i, d + i, gains, output + i, count - i);
+        }
+
+        INSOUND_TARGET("avx512f")
+        void addScaledAvx512(const float *input, float *output, const uint32_t count, const float gain)
+        {
+            uint32_t i = 0;
+            const auto gains = _mm512_set1_ps(gain);
+            for (; i + 16 <= count; i += 16)
+            {
+                _mm512_storeu_ps(output + i, _mm512_fmadd_ps(_mm512_loadu_ps(input + i), gains,
+                    _mm512_loadu_ps(output + i)));
+            }
+            _mm256_zeroupper();
+            addScaledBase(input + i, output + i, count - i, gain);
+        }
+
+        INSOUND_TARGET("avx512f")
+        void gainAvx512(const float *input, float *output, const uint32_t count, const float gain)
+        {
+            uint32_t i = 0;
+            const auto gains = _mm512_set1_ps(gain);
+            for (; i + 16 <= count; i += 16)
+                _mm512_storeu_ps(output + i, _mm512_mul_ps(_mm512_loadu_ps(input + i), gains));
+            _mm256_zeroupper();
+            gainBase(input + i, output + i, count - i, gain);
+        }
+
+        INSOUND_TARGET("avx512f")
+        void stereoRampAvx512(const float *input, float *output, const uint32_t frames, const float gain,
+            const float delta)
+        {
+            float initial[16]; // eight frames per vector
+            for (int i = 0; i < 16; ++i)
+                initial[i] = gain + delta * static_cast<float>(i / 2);
+
+            uint32_t f = 0;
+            auto gains = _mm512_loadu_ps(initial);
+            const auto deltas = _mm512_set1_ps(delta * 8.f);
+            for (; f + 8 <= frames; f += 8)
+            {
+                _mm512_storeu_ps(output + f * 2, _mm512_mul_ps(_mm512_loadu_ps(input + f * 2), gains));
+                gains = _mm512_add_ps(gains, deltas);
+            }
+            _mm256_zeroupper();
+            stereoRampBase(input + f * 2, output + f * 2, frames - f, gain + delta * static_cast<float>(f), delta);
+        }
+
+        INSOUND_TARGET("avx512f")
+        void delayAvx512(const float *input, float *output, float *line, const uint32_t count, const float dry,
+            const float wet, const float feedback)
+        {
+            uint32_t i = 0;
+            const auto dryVec = _mm512_set1_ps(dry);
+            const auto wetVec = _mm512_set1_ps(wet);
+            const auto feedbackVec = _mm512_set1_ps(feedback);
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto in = _mm512_loadu_ps(input + i);
+                const auto delayed = _mm512_loadu_ps(line + i);
+                _mm512_storeu_ps(output + i, _mm512_fmadd_ps(delayed, wetVec, _mm512_mul_ps(in, dryVec)));
+                _mm512_storeu_ps(line + i, _mm512_mul_ps(in, feedbackVec));
+            }
+            _mm256_zeroupper();
+            delayBase(input + i, output + i, line + i, count - i, dry, wet, feedback);
+        }
+
+        constexpr MixKernels Avx512Kernels {addAvx512, sumBlocked<sum4Avx512, addScaledAvx512>, gainAvx512,
+            stereoRampAvx512, delayAvx512};
+#endif
+
+        /// Starts on the compile-time path, so kernels are valid even before the widest path is selected on load
+        MixKernels s_kernels = BaseKernels;
+        SimdPath s_path = BasePath;
+
+        SimdPath widestPath()
+        {
+            for (const auto path : {SimdPath::Avx512, SimdPath::Avx2})
+            {
+                if (isSimdPathSupported(path))
+                    return path;
+            }
+            return BasePath;
+        }
+
+        [[maybe_unused]]
+        const bool s_selected = setSimdPath(widestPath());
+    }
+
+    const MixKernels &mixKernels()
+    {
+        return s_kernels;
+    }
+
+    SimdPath simdPath()
+    {
+        return s_path;
+    }
+
+    bool isSimdPathSupported(const SimdPath path)
+    {
+        if (path == BasePath)
+            return true;
+#if     INSOUND_X86_DISPATCH
+        if (path == SimdPath::Avx2)
+            return cpuFeatures().avx2 && cpuFeatures().fma;
+        if (path == SimdPath::Avx512)
+            return cpuFeatures().avx512f;
+#endif
+        return false;
+    }
+
+    bool setSimdPath(const SimdPath path)
+    {
+        if (!isSimdPathSupported(path))
+            return false;
+
+        switch(path)
+        {
+#if     INSOUND_X86_DISPATCH
+            case SimdPath::Avx2: s_kernels = Avx2Kernels; break;
+            case SimdPath::Avx512: s_kernels = Avx512Kernels; break;
+#endif
+            default: s_kernels = BaseKernels; break;
+        }
+
+        s_path = path;
+        return true;
+    }
+}
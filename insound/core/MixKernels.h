@@ -0,0 +1,51 @@
+#pragma once
+#include "CpuFeatures.h"
+
+#include <cstdint>
+
+namespace insound {
+
+    /// Vectorized loops that the mixer and built-in effects spend most of their time in. The table is filled with
+    /// the widest implementation the build and the running CPU support, so one binary uses AVX2 or AVX-512 where
+    /// available and falls back to the path chosen at compile time elsewhere.
+    /// Pointers do not need to be aligned. Counts are in samples unless otherwise noted.
+    struct MixKernels {
+        /// Add `count` samples of `input` to `output`
+        void (*add)(const float *input, float *output, uint32_t count);
+
+        /// Add `count` samples of each of `inputCount` inputs to `output`, scaled by their entry in `gains`, or as-is
+        /// if `gains` is null. The output is summed in cache-sized blocks, so each block is read and written once
+        /// however many inputs there are.
+        void (*sum)(const float *const *inputs, const float *gains, uint32_t inputCount, float *output,
+            uint32_t count);
+
+        /// Multiply `count` samples by a constant gain, `input` may be `output`
+        void (*gain)(const float *input, float *output, uint32_t count, float gain);
+
+        /// Multiply interleaved stereo frames by a gain that changes by `delta` each frame, `input` may be `output`
+        void (*stereoRamp)(const float *input, float *output, uint32_t frames, float gain, float delta);
+
+        /// Mix `count` samples with a delay line, then write the input into the line:
+        /// `output = input * dry + line * wet`, `line = input * feedback`. `input` may be `output`.
+        void (*delay)(const float *input, float *output, float *line, uint32_t count, float dry, float wet,
+            float feedback);
+    };
+
+    /// Kernels of the current path
+    [[nodiscard]]
+    const MixKernels &mixKernels();
+
+    /// Path the kernels currently run on
+    [[nodiscard]]
+    SimdPath simdPath();
+
+    /// Whether the build and the running CPU can run a path
+    [[nodiscard]]
+    bool isSimdPathSupported(SimdPath path);
+
+    /// Switch the kernels to another path, e.g. to compare their throughput, or to rule out a wide path while
+    /// debugging. The mixer reads the kernels without synchronization, so only call while no Engine is open.
+    /// @param path path to switch to
+    /// @returns whether the path is supported, the current path is kept if it isn't
+    bool setSimdPath(SimdPath path);
+}
@@ -3,12 +3,10 @@
 #include "Handle.h"
 #include "Pool.h"
 
+#include <atomic>
 #include <cstdint>
 #include <exception>
-#include <map>
 #include <mutex>
-#include <typeindex>
-#include <unordered_map>
 
 
 namespace insound {
@@ -24,21 +22,30 @@ namespace insound {
     ///
     /// These two functions are the setup and cleanup functions for your pooled objects.
     /// Actual construction occurs during pool initialization and expansion when an allocation exceeds
-    /// the current size of a given pool and new elements are dynamically added.
+    /// the current size of a given pool and a new page of elements is added. Objects never move, so `reserve` is
+    /// only needed to keep allocations out of time-critical code.
     /// The actual destructor is called when the pool is deleted.
     ///
     /// For subclasses, make sure init and release calls its parent init and release if this is important.
     /// Whether they are virtual or not is up to you.
     ///
-    /// Pool contains its own mutex, so that it is safe to use with multiple threads.
+    /// Classes deriving from `PoolTyped` are stamped with their concrete type before `init`, for checked casts.
+    ///
+    /// Pools are stored in a flat table indexed by `poolTypeId<T>()`, so finding the pool for a type is an array
+    /// access. Pool contains its own mutex, so that it is safe to use with multiple threads. It is only held while
+    /// claiming or returning a slot, not during `init` or `release`, so poolable objects may allocate other pooled
+    /// objects from their `init`.
     class MultiPool {
     public:
-        MultiPool() = default;
+        /// Maximum number of distinct types that can be pooled, type ids are shared by all MultiPools
+        static constexpr size_t MaxTypes = 64;
+
+        MultiPool() : m_pools{}, m_mutex(), m_locked() { }
         ~MultiPool()
         {
-            for (auto &[type, pool] : m_pools)
+            for (auto &pool : m_pools)
             {
-                delete pool;
+                delete pool.load(std::memory_order_relaxed);
             }
         }
 
@@ -54,24 +61,34 @@ namespace insound {
         Handle<T> allocate(TArgs &&...args) noexcept
         {
             static_assert(!std::is_abstract_v<T>, "Cannot allocate an abstract class");
-            std::lock_guard lockGuard(m_mutex);
 
-            PoolBase *pool = &getPool<T>();
-            const auto elemSize = static_cast<uint32_t>(pool->elemSize());
+            PoolBase *pool = getPool<T>();
+            if (!pool)
+                return {};
 
             // Allocate new entity
-            PoolID id = pool->allocate();
+            PoolID id;
+            {
+                std::lock_guard lockGuard(m_mutex);
+                id = pool->allocate();
+            }
+
             try {
                 // Init the newly retrieved entity
-                ((T *)(pool->data() + id.index * elemSize))->init(std::forward<TArgs>(args)...); // `T` poolable must implement `init`
+                const auto object = (T *)pool->get(id);
+                if constexpr (std::is_base_of_v<PoolTyped, T>)
+                    static_cast<PoolTyped *>(object)->m_typeId = poolTypeId<T>();
+                object->init(std::forward<TArgs>(args)...); // `T` poolable must implement `init`
             }
             catch (const std::exception &err) { // init threw an exception, deallocate
                 INSOUND_PUSH_ERROR(Result::RuntimeErr, err.what());
+                std::lock_guard lockGuard(m_mutex);
                 pool->deallocate(id);
                 return {};
             }
             catch (...) {                       // unknown error thrown, deallocate
                 INSOUND_PUSH_ERROR(Result::RuntimeErr, "constructor threw unknown error");
+                std::lock_guard lockGuard(m_mutex);
                 pool->deallocate(id);
                 return {};
             }
@@ -88,14 +105,12 @@ namespace insound {
         template <typename T>
         bool deallocate(const Handle<T> &handle) noexcept
         {
-            std::lock_guard lockGuard(m_mutex);
-
             bool dtorThrew = false;
-            if (handle.isValid())
+            if (const auto object = handle.tryGet())
             {
                 try // catch any exception propagated from client `release()`
                 {
-                    handle->release();
+                    object->release();
                 }
                 catch (const std::exception &err)
                 {
@@ -114,7 +129,8 @@ namespace insound {
                 return false;
             }
 
-            handle.m_pool->deallocate(handle.m_id);
+            std::lock_guard lockGuard(m_mutex);
+            handle.pool()->deallocate(handle.id());
             return !dtorThrew;
         }
 
@@ -129,17 +145,21 @@ namespace insound {
         {
             static_assert(!std::is_abstract_v<T>, "Cannot find an abstract pool object");
 
-            std::lock_guard lockGuard(m_mutex);
             if (pointer == nullptr) return false;
 
-            auto &pool = getPool<T>();
+            const auto pool = getPool<T>();
+            if (!pool)
+                return false;
 
             PoolID id;
-            if (!pool.tryFind(pointer, &id))
-                return false;
+            {
+                std::lock_guard lockGuard(m_mutex);
+                if (!pool->tryFind(pointer, &id))
+                    return false;
+            }
 
             if (outHandle)
-                *outHandle = Handle<T>(id, &pool);
+                *outHandle = Handle<T>(id, pool);
             return true;
         }
 
@@ -150,69 +170,93 @@ namespace insound {
         {
             static_assert(!std::is_abstract_v<T>, "Cannot reserve space for an abstract class");
 
+            const auto pool = getPool<T>();
+            if (!pool)
+                return;
+
+            std::lock_guard lockGuard(m_mutex);
+            pool->reserve(size);
+        }
+
+        /// Lock every pool's pages into physical memory, including pools and pages created later, see
+        /// `PoolBase::setLocked`
+        /// @param value whether to lock, false unlocks them
+        /// @returns whether every page could be locked
+        bool setLocked(const bool value)
+        {
+            std::lock_guard lockGuard(m_mutex);
+            m_locked = value;
+
+            bool result = true;
+            for (auto &entry : m_pools)
+            {
+                if (const auto pool = entry.load(std::memory_order_relaxed); pool && !pool->setLocked(value))
+                    result = false;
+            }
+
+            return result;
+        }
+
+        /// Bytes of pool pages locked into physical memory
+        [[nodiscard]]
+        size_t lockedBytes() const
+        {
             std::lock_guard lockGuard(m_mutex);
-            getPool<T>(size).second.reserve(size);
+
+            size_t bytes = 0;
+            for (const auto &entry : m_pools)
+            {
+                if (const auto pool = entry.load(std::memory_order_relaxed))
+                    bytes += pool->lockedBytes();
+            }
+
+            return bytes;
         }
     private:
 
         /// Get an existing pool for type `T`, or it will create a new one if a pool for type T does not exist.
         /// @tparam T must be concrete, since allocations to the pool are like calling `new`.
-        /// @returns `Pool<T> &`, which can be cast to `PoolBase &` for generic storage.
+        /// @returns the pool, or `nullptr` if more than `MaxTypes` types are pooled; check `popError()` for details.
         template <typename T>
-        auto &getPool() const
+        Pool<T> *getPool() const
         {
             static_assert(!std::is_abstract_v<T>, "Cannot allocate an abstract class");
 
-            if (const auto it = m_indices.find(std::type_index(typeid(T)));
-                it != m_indices.end())
+            const auto typeId = poolTypeId<T>();
+            if (typeId >= MaxTypes)
             {
-                return *(Pool<T> *)m_poolPtrs[it->second];
+                INSOUND_PUSH_ERROR(Result::RangeErr, "MultiPool::MaxTypes exceeded");
+                return nullptr;
             }
 
-            auto newPool = new Pool<T>;
-            m_pools.emplace(typeid(T), newPool);
-            m_indices.emplace(
-                typeid(T),
-                static_cast<int>(m_poolPtrs.size()));
-            m_poolPtrs.emplace_back(newPool);
+            auto &entry = m_pools[typeId];
+            if (const auto pool = entry.load(std::memory_order_acquire))
+                return static_cast<Pool<T> *>(pool);
+
+            std::lock_guard lockGuard(m_mutex);
+            if (const auto pool = entry.load(std::memory_order_relaxed)) // created by another thread while waiting
+                return static_cast<Pool<T> *>(pool);
 
-            return *newPool;
+            const auto newPool = new Pool<T>;
+            if (m_locked)
+                newPool->setLocked(true);
+            entry.store(newPool, std::memory_order_release);
+            return newPool;
         }
 
         /// Much less efficient than `tryFind` as we need to query each pool,
         /// but written here in case if needed later.
         /// It gives you what you need to create a generic handle.
-        bool tryFindGeneric(void *ptr, PoolBase **outPool, PoolID *outID, std::type_index *outTypeIndex)
-        {
-            for (auto &[type, pool] : m_pools)
-            {
-                if (pool->tryFind(ptr, outID))
-                {
-                    if (outTypeIndex)
-                        *outTypeIndex = type;
-                    if (outPool)
-                        *outPool = pool;
-                    return true;
-                }
-            }
-
-            return false;
-        }
-
-        bool tryFindTypeIndex(void *ptr, std::type_index type, PoolBase **outPool, PoolID *outID)
+        bool tryFindGeneric(void *ptr, PoolBase **outPool, PoolID *outID, size_t *outTypeId)
         {
-            if (auto it = m_indices.find(type); it != m_indices.end())
+            std::lock_guard lockGuard(m_mutex);
+            for (size_t typeId = 0; typeId < MaxTypes; ++typeId)
             {
-                const auto index = it->second;
-                if (index >= m_poolPtrs.size()) // this would be an internal error, throw here?
-                    return false;
-
-                auto pool = m_poolPtrs[it->second];
-                if (pool == nullptr) // just in case
-                    return false;
-
-                if (pool->tryFind(ptr, outID))
+                const auto pool = m_pools[typeId].load(std::memory_order_relaxed);
+                if (pool && pool->tryFind(ptr, outID))
                 {
+                    if (outTypeId)
+                        *outTypeId = typeId;
                     if (outPool)
                         *outPool = pool;
                     return true;
@@ -223,13 +267,8 @@ namespace insound {
         }
 
     private: // Member variables
-        mutable std::map<std::type_index, PoolBase *> m_pools;      ///< the internal pools
-        mutable std::recursive_mutex m_mutex;                                 ///< for syncing pool state across multiple threads
-
-        // for optimized lookups of pools (may be negligable)
-        mutable std::unordered_map<std::type_index, int> m_indices; ///< index lookup table by type; use it to query m_poolPtrs
-        mutable std::vector<PoolBase *> m_poolPtrs;                 ///< reference to pools, queried quickly by type via `m_indices`
-
+        mutable std::atomic<PoolBase *> m_pools[MaxTypes]; ///< the internal pools, indexed by `poolTypeId<T>()`
+        mutable std::mutex m_mutex;                        ///< guards pool creation and slot bookkeeping
+        bool m_locked;                                     ///< whether pool pages are locked, guarded by `m_mutex`
     };
 }
-
@@ -1,13 +1,13 @@
 #include "PCMSource.h"
 
 #include "Command.h"
-#include "CpuIntrinsics.h"
 #include "Engine.h"
 #include "Error.h"
 #include "SoundBuffer.h"
 
+#include <algorithm>
 #include <cmath>
-#include <iostream>
+#include <cstring>
 
 namespace insound {
 
@@ -20,16 +20,22 @@ namespace insound {
     } } while(0)
 
 
+    /// Source frames gathered per interpolated block, so interpolation never wraps or bounds-checks per sample
+    static constexpr int WindowFrames = 2048;
+
     PCMSource::PCMSource() : Source(),
         m_buffer(), m_position(0), m_isLooping(),
-        m_isOneShot(), m_speed(1.f)
+        m_isOneShot(), m_speed(1.f), m_currentSpeed(1.f), m_interpolation(InterpolationMode::Linear),
+        m_loopIndex(-1), m_loopStart(), m_loopEnd(), m_crossfade(), m_crossfadeData(), m_wrapped()
     {
     }
 
     PCMSource::PCMSource(PCMSource &&other) noexcept : Source(std::move(other)),
         m_buffer(other.m_buffer),
         m_position(other.m_position), m_isLooping(other.m_isLooping), m_isOneShot(other.m_isOneShot),
-        m_speed(other.m_speed)
+        m_speed(other.m_speed), m_currentSpeed(other.m_currentSpeed), m_interpolation(other.m_interpolation),
+        m_loopIndex(other.m_loopIndex), m_loopStart(other.m_loopStart), m_loopEnd(other.m_loopEnd),
+        m_crossfade(other.m_crossfade), m_crossfadeData(other.m_crossfadeData), m_wrapped(other.m_wrapped)
     {
 
     }
@@ -43,10 +49,33 @@ namespace insound {
         m_isLooping = looping;
         m_position = 0;
         m_speed = 1.f;
+        m_currentSpeed = 1.f;
+        m_interpolation = InterpolationMode::Linear;
         m_isOneShot = oneShot;
+        setLoopRegionImpl(buffer->loopRegions().empty() ? -1 : 0);
         return true;
     }
 
+    void PCMSource::setLoopRegionImpl(int index)
+    {
+        m_loopIndex = index;
+        if (index < 0)
+        {
+            m_loopStart = 0;
+            m_loopEnd = m_buffer->frames();
+            m_crossfade = 0;
+            m_crossfadeData = nullptr;
+        }
+        else
+        {
+            const auto &region = m_buffer->loopRegions()[index];
+            m_loopStart = region.start;
+            m_loopEnd = region.end;
+            m_crossfade = region.crossfade;
+            m_crossfadeData = m_buffer->crossfadeData(index);
+        }
+    }
+
     bool PCMSource::setPosition(const float value)
     {
         HANDLE_GUARD();
@@ -73,6 +102,22 @@ namespace insound {
         return m_engine->pushCommand(Command::makePCMSourceSetSpeed(this, value));
     }
 
+    bool PCMSource::getInterpolation(InterpolationMode *outMode) const
+    {
+        HANDLE_GUARD();
+
+        if (outMode)
+            *outMode = m_interpolation;
+        return true;
+    }
+
+    bool PCMSource::setInterpolation(InterpolationMode mode)
+    {
+        HANDLE_GUARD();
+
+        return m_engine->pushCommand(Command::makePCMSourceSetInterpolation(this, mode));
+    }
+
     bool PCMSource::getLooping(bool *outLooping) const
     {
         HANDLE_GUARD();
@@ -89,6 +134,38 @@ namespace insound {
         return m_engine->pushCommand(Command::makePCMSourceSetLooping(this, value));
     }
 
+    bool PCMSource::getLoopRegion(int *outIndex) const
+    {
+        HANDLE_GUARD();
+
+        if (outIndex)
+            *outIndex = m_loopIndex;
+        return true;
+    }
+
+    bool PCMSource::setLoopRegion(int index)
+    {
+        HANDLE_GUARD();
+
+        // Resolve the region here, so the mix thread doesn't touch the buffer's containers
+        const auto &regions = m_buffer->loopRegions();
+        if (index < -1 || index >= (int)regions.size())
+        {
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "loop region index is out of range");
+            return false;
+        }
+
+        if (index < 0)
+        {
+            return m_engine->pushCommand(Command::makePCMSourceSetLoopRegion(this, index, 0, m_buffer->frames(), 0,
+                nullptr));
+        }
+
+        const auto &region = regions[index];
+        return m_engine->pushCommand(Command::makePCMSourceSetLoopRegion(this, index, region.start, region.end,
+            region.crossfade, m_buffer->crossfadeData(index)));
+    }
+
     bool PCMSource::getOneshot(bool *outOneshot) const
     {
         HANDLE_GUARD();
@@ -116,7 +193,7 @@ namespace insound {
 
             case PCMSourceCommand::SetSpeed:
             {
-                m_speed = command.setspeed.speed;
+                m_speed = std::min(std::max(command.setspeed.speed, 0.f), MaxSpeed);
             } break;
 
             case PCMSourceCommand::SetLooping:
@@ -129,6 +206,21 @@ namespace insound {
                 m_isOneShot = command.setoneshot.oneshot;
             } break;
 
+            case PCMSourceCommand::SetInterpolation:
+            {
+                m_interpolation = command.setinterpolation.mode;
+            } break;
+
+            case PCMSourceCommand::SetLoopRegion:
+            {
+                const auto &region = command.setloopregion;
+                m_loopIndex = region.index;
+                m_loopStart = region.start;
+                m_loopEnd = region.end;
+                m_crossfade = region.crossfade;
+                m_crossfadeData = region.crossfadeData;
+            } break;
+
             default:
             {
                 INSOUND_PUSH_ERROR(Result::InvalidArg, "Unknown pcm source command type");
@@ -136,291 +228,223 @@ namespace insound {
         }
     }
 
-    int PCMSource::readImpl(uint8_t *output, int length)
+    void PCMSource::readFrames(int64_t first, int count, float *output) const
     {
-        const auto buffer = (float *)m_buffer->data();
-        if (!buffer)
-            return 0;
+        if (m_isLooping)
+        {
+            const auto loopLength = m_loopEnd - m_loopStart;
+            const auto fadeStart = m_loopEnd - m_crossfade;
 
-        const auto sampleSize = m_buffer->size() / sizeof(float);
-        const auto frameSize = sampleSize / 2;
-        const auto sampleLength = length / sizeof(float);
-        const auto frameLength = sampleLength / 2;
+            if (first >= m_loopEnd)
+                first = m_loopStart + (first - m_loopStart) % loopLength;
+            else if (first < 0 && m_loopStart == 0) // a loop from the start is preceded by its own end
+                first = loopLength - 1 - (-first - 1) % loopLength;
 
-        if (sampleSize == 0) // prevent zero copy
-            return 0;
+            while (count > 0)
+            {
+                int toCopy;
+                if (first < 0) // silence before the start
+                {
+                    toCopy = static_cast<int>(std::min<int64_t>(count, -first));
+                    std::memset(output, 0, toCopy * 2 * sizeof(float));
+                }
+                else if (first < fadeStart)
+                {
+                    toCopy = static_cast<int>(std::min<int64_t>(count, fadeStart - first));
+                    m_buffer->readFloatStereo(static_cast<uint32_t>(first), toCopy, output);
+                }
+                else // crossfaded end of the loop
+                {
+                    toCopy = static_cast<int>(std::min<int64_t>(count, m_loopEnd - first));
+                    std::memcpy(output, m_crossfadeData + (first - fadeStart) * 2, toCopy * 2 * sizeof(float));
+                }
+
+                output += toCopy * 2;
+                count -= toCopy;
+                first += toCopy;
+                if (first == m_loopEnd)
+                    first = m_loopStart;
+            }
+        }
+        else
+        {
+            const auto frameSize = static_cast<int64_t>(m_buffer->frames());
+            if (first < 0) // silence before the start
+            {
+                const auto silent = static_cast<int>(std::min<int64_t>(count, -first));
+                std::memset(output, 0, silent * 2 * sizeof(float));
+                output += silent * 2;
+                count -= silent;
+                first = 0;
+            }
 
-        if (m_isLooping && m_position >= frameSize) // prevent accidentally reading past buffer, this read probably occurred before the engine could clean the sound up
-            return 0;
+            const auto toCopy = static_cast<int>(std::max<int64_t>(std::min<int64_t>(count, frameSize - first), 0));
+            if (toCopy > 0)
+                m_buffer->readFloatStereo(static_cast<uint32_t>(first), toCopy, output);
+            std::memset(output + toCopy * 2, 0, (count - toCopy) * 2 * sizeof(float));
+        }
+    }
 
-        const int framesToRead = m_isLooping ? (int)frameLength : std::min<int>((int)frameLength, (int)frameSize - (int)std::ceil(m_position));
+    double PCMSource::wrapPosition(double position) const
+    {
+        if (position < static_cast<double>(m_loopEnd))
+            return position;
 
-        // clear the write buffer
-        std::memset(output, 0, length);
+        const auto loopStart = static_cast<double>(m_loopStart);
+        return loopStart + std::fmod(position - loopStart, static_cast<double>(m_loopEnd - m_loopStart));
+    }
 
-        if (framesToRead <= 0)
-        {
-            return length;
-        }
+    int PCMSource::interpolate(float *output, const int frames)
+    {
+        alignas(16) float window[WindowFrames * 2];
+
+        const auto frameSize = static_cast<int64_t>(m_buffer->frames());
 
+        // Speed ramps linearly from the last block's speed to the target over this block
+        const auto stepDelta = (m_speed - m_currentSpeed) / static_cast<float>(frames);
+        const auto maxSpeed = std::max(m_currentSpeed, m_speed);
 
-//         if (m_speed != 1.f) // ========= Sample Interpolation ===================================
-//         {
-// #if INSOUND_SSE
-//             const auto oneVec = _mm_set1_ps(1.f);
-// #elif INSOUND_WASM_SIMD
-//             const auto oneVec = wasm_f32x4_splat(1.f);
-// #elif INSOUND_ARM_NEON
-//             const auto oneVec = vdupq_n_f32(1.f);
-// #endif
-//             const auto speed = m_speed;
-//             int i = 0;
-//             constexpr int UnrolledSize = 8;
-//             for (; i <= framesToRead - UnrolledSize; i += UnrolledSize) // visit each frame
-//             {
-//                 // Collect interpolated sample data and t parameter values
-//                 alignas(16) float vals[UnrolledSize * 2], nextVals[UnrolledSize * 2];
-//                 alignas(16) float ts[UnrolledSize * 2];
-//
-//                 // Whether this iteration contains the last frame of the buffer (when `i == UnrolledSize - 1`)
-//                 const bool touchesLastFrame = (i + UnrolledSize == framesToRead || (int)m_position + framesToRead + 1 >= frameSize);
-//
-//                 if (m_isLooping) // (accounts for wrapping around buffer)
-//                 {
-//                     float curFrame = fmodf((m_position + ((float)(i) * speed)), (float)frameSize);
-//                     for (int j = 0; j < UnrolledSize; ++j)
-//                     {
-//                         const auto baseSample = (int)curFrame * 2 % sampleSize;
-//                         const auto j2 = j * 2;
-//                         vals[j2] = buffer[baseSample];
-//                         vals[j2+1] = buffer[baseSample + 1];
-//                         nextVals[j2] = buffer[(baseSample + 2) % sampleSize];
-//                         nextVals[j2+1] = buffer[(baseSample + 3) % sampleSize];
-//                         ts[j2] = curFrame - floorf(curFrame);
-//                         ts[j2 + 1] = ts[j2];
-//
-//                         curFrame += speed;
-//                         if (curFrame > (float)frameSize)
-//                             curFrame = fmodf(curFrame, (float)frameSize);
-//                     }
-//                 }
-//                 else // non-looping (less need for bounds checks and modulo operations)
-//                 {
-//                     float curFrame = m_position + ((float)(i) * speed);
-//                     if (curFrame >= frameSize) // sound ended; TODO: solve miscalculation of the remaining frames?
-//                     {
-//                         i = framesToRead;
-//                         break;
-//                     }
-//
-//                     if (touchesLastFrame)
-//                     {
-//                         for (int j = 0; j < UnrolledSize-1 && curFrame < (float)frameSize - speed; ++j)
-//                         {
-//                             const auto baseSample = (int)curFrame * 2;
-//                             const auto j2 = j * 2;
-//                             vals[j2] = buffer[baseSample];
-//                             vals[j2+1] = buffer[baseSample + 1];
-//                             nextVals[j2] = buffer[baseSample + 2];
-//                             nextVals[j2+1] = buffer[baseSample + 3];
-//                             ts[j2] = curFrame - floorf(curFrame);
-//                             ts[j2 + 1] = ts[j2];
-//
-//                             curFrame += speed;
-//                         }
-//
-//                         // Manually assign the last buffer frame to our last calculated frame
-//                         vals[UnrolledSize * 2 - 2] = buffer[sampleSize - 2];
-//                         vals[UnrolledSize * 2 - 1] = buffer[sampleSize - 1];
-//                         nextVals[UnrolledSize * 2 - 2] = 0;
-//                         nextVals[UnrolledSize * 2 - 1] = 0;
-//                         ts[UnrolledSize - 2] = curFrame - floorf(curFrame);
-//                         ts[UnrolledSize - 1] = ts[UnrolledSize - 2];
-//                     }
-//                     else
-//                     {
-//                         for (int j = 0; j < UnrolledSize && (int)curFrame < frameSize; ++j)
-//                         {
-//                             const auto baseSample = (int)curFrame * 2;
-//                             const auto j2 = j * 2;
-//                             vals[j2] = buffer[baseSample];
-//                             vals[j2+1] = buffer[baseSample + 1];
-//                             nextVals[j2] = buffer[baseSample + 2];
-//                             nextVals[j2+1] = buffer[baseSample + 3];
-//                             ts[j2] = curFrame - floorf(curFrame);
-//                             ts[j2+ 1] = ts[j2];
-//
-//                             curFrame += speed;
-//                         }
-//                     }
-//                 }
-//
-// #if INSOUND_SSE
-//                 const auto tVec0 = _mm_load_ps(ts);
-//                 const auto tVec1 = _mm_load_ps(ts + 4);
-//                 const auto tVec2 = _mm_load_ps(ts + 8);
-//                 const auto tVec3 = _mm_load_ps(ts + 12);
-//                 const auto omtVec0 = _mm_sub_ps(oneVec, tVec0);
-//                 const auto omtVec1 = _mm_sub_ps(oneVec, tVec1);
-//                 const auto omtVec2 = _mm_sub_ps(oneVec, tVec2);
-//                 const auto omtVec3 = _mm_sub_ps(oneVec, tVec3);
-//
-//                 const auto bufferVec0 = _mm_load_ps(vals);
-//                 const auto bufferVec1 = _mm_load_ps(vals + 4);
-//                 const auto bufferVec2 = _mm_load_ps(vals + 8);
-//                 const auto bufferVec3 = _mm_load_ps(vals + 12);
-//                 const auto bufferNextVec0 = _mm_load_ps(nextVals);
-//                 const auto bufferNextVec1 = _mm_load_ps(nextVals + 4);
-//                 const auto bufferNextVec2 = _mm_load_ps(nextVals + 8);
-//                 const auto bufferNextVec3 = _mm_load_ps(nextVals + 12);
-//
-//                 const auto result0 = _mm_add_ps(_mm_mul_ps(bufferVec0, omtVec0), _mm_mul_ps(bufferNextVec0, tVec0));
-//                 const auto result1 = _mm_add_ps(_mm_mul_ps(bufferVec1, omtVec1), _mm_mul_ps(bufferNextVec1, tVec1));
-//                 const auto result2 = _mm_add_ps(_mm_mul_ps(bufferVec2, omtVec2), _mm_mul_ps(bufferNextVec2, tVec2));
-//                 const auto result3 = _mm_add_ps(_mm_mul_ps(bufferVec3, omtVec3), _mm_mul_ps(bufferNextVec3, tVec3));
-//
-//                 const auto i2 = i * 2;
-//                 _mm_store_ps((float *)output + i2, result0);
-//                 _mm_store_ps((float *)output + i2 + 4, result1);
-//                 _mm_store_ps((float *)output + i2 + 8, result2);
-//                 _mm_store_ps((float *)output + i2 + 12, result3);
-// #elif INSOUND_WASM_SIMD
-//                 const auto tVec0 = wasm_v128_load(ts);
-//                 const auto tVec1 = wasm_v128_load(ts + 4);
-//                 const auto tVec2 = wasm_v128_load(ts + 8);
-//                 const auto tVec3 = wasm_v128_load(ts + 12);
-//                 const auto omtVec0 = wasm_f32x4_sub(oneVec, tVec0);
-//                 const auto omtVec1 = wasm_f32x4_sub(oneVec, tVec1);
-//                 const auto omtVec2 = wasm_f32x4_sub(oneVec, tVec2);
-//                 const auto omtVec3 = wasm_f32x4_sub(oneVec, tVec3);
-//
-//                 const auto bufferVec0 = wasm_v128_load(vals);
-//                 const auto bufferVec1 = wasm_v128_load(vals + 4);
-//                 const auto bufferVec2 = wasm_v128_load(vals + 8);
-//                 const auto bufferVec3 = wasm_v128_load(vals + 12);
-//                 const auto bufferNextVec0 = wasm_v128_load(nextVals);
-//                 const auto bufferNextVec1 = wasm_v128_load(nextVals + 4);
-//                 const auto bufferNextVec2 = wasm_v128_load(nextVals + 8);
-//                 const auto bufferNextVec3 = wasm_v128_load(nextVals + 12);
-//
-//                 const auto result0 = wasm_f32x4_add(wasm_f32x4_mul(bufferVec0, omtVec0), wasm_f32x4_mul(bufferNextVec0, tVec0));
-//                 const auto result1 = wasm_f32x4_add(wasm_f32x4_mul(bufferVec1, omtVec1), wasm_f32x4_mul(bufferNextVec1, tVec1));
-//                 const auto result2 = wasm_f32x4_add(wasm_f32x4_mul(bufferVec2, omtVec2), wasm_f32x4_mul(bufferNextVec2, tVec2));
-//                 const auto result3 = wasm_f32x4_add(wasm_f32x4_mul(bufferVec3, omtVec3), wasm_f32x4_mul(bufferNextVec3, tVec3));
-//
-//                 const auto i2 = i * 2;
-//                 wasm_v128_store((float *)output + i2, result0);
-//                 wasm_v128_store((float *)output + i2 + 4, result1);
-//                 wasm_v128_store((float *)output + i2 + 8, result2);
-//                 wasm_v128_store((float *)output + i2 + 12, result3);
-// #elif INSOUND_ARM_NEON
-//                 const auto tVec0 = vld1q_f32(ts);
-//                 const auto tVec1 = vld1q_f32(ts + 4);
-//                 const auto tVec2 = vld1q_f32(ts + 8);
-//                 const auto tVec3 = vld1q_f32(ts + 12);
-//                 const auto omtVec0 = vsubq_f32(oneVec, tVec0);
-//                 const auto omtVec1 = vsubq_f32(oneVec, tVec1);
-//                 const auto omtVec2 = vsubq_f32(oneVec, tVec2);
-//                 const auto omtVec3 = vsubq_f32(oneVec, tVec3);
-//
-//                 const auto bufferVec0 = vld1q_f32(vals);
-//                 const auto bufferVec1 = vld1q_f32(vals + 4);
-//                 const auto bufferVec2 = vld1q_f32(vals + 8);
-//                 const auto bufferVec3 = vld1q_f32(vals + 12);
-//                 const auto bufferNextVec0 = vld1q_f32(nextVals);
-//                 const auto bufferNextVec1 = vld1q_f32(nextVals + 4);
-//                 const auto bufferNextVec2 = vld1q_f32(nextVals + 8);
-//                 const auto bufferNextVec3 = vld1q_f32(nextVals + 12);
-//
-//                 const auto result0 = vmlaq_f32(vmulq_f32(bufferVec0, omtVec0), bufferNextVec0, tVec0);
-//                 const auto result1 = vmlaq_f32(vmulq_f32(bufferVec1, omtVec1), bufferNextVec1, tVec1);
-//                 const auto result2 = vmlaq_f32(vmulq_f32(bufferVec2, omtVec2), bufferNextVec2, tVec2);
-//                 const auto result3 = vmlaq_f32(vmulq_f32(bufferVec3, omtVec3), bufferNextVec3, tVec3);
-//
-//                 const auto i2 = i * 2;
-//                 vst1q_f32((float *)output + i2, result0);
-//                 vst1q_f32((float *)output + i2 + 4, result1);
-//                 vst1q_f32((float *)output + i2 + 8, result2);
-//                 vst1q_f32((float *)output + i2 + 12, result3);
-//     #else
-//                 const auto i2 = i * 2;
-//                 ((float *)output)[i2] =     vals[0]  * (1.f-ts[0])  + nextVals[0]  * ts[0];
-//                 ((float *)output)[i2 + 1] = vals[1]  * (1.f-ts[1])  + nextVals[1]  * ts[1];
-//                 ((float *)output)[i2 + 2] = vals[2]  * (1.f-ts[2])  + nextVals[2]  * ts[2];
-//                 ((float *)output)[i2 + 3] = vals[3]  * (1.f-ts[3])  + nextVals[3]  * ts[3];
-//                 ((float *)output)[i2 + 4] = vals[4]  * (1.f-ts[4])  + nextVals[4]  * ts[4];
-//                 ((float *)output)[i2 + 5] = vals[5]  * (1.f-ts[5])  + nextVals[5]  * ts[5];
-//                 ((float *)output)[i2 + 6] = vals[6]  * (1.f-ts[6])  + nextVals[6]  * ts[6];
-//                 ((float *)output)[i2 + 7] = vals[7]  * (1.f-ts[7])  + nextVals[7]  * ts[7];
-//                 ((float *)output)[i2 + 8] = vals[8]  * (1.f-ts[8])  + nextVals[8]  * ts[8];
-//                 ((float *)output)[i2 + 9] = vals[9]  * (1.f-ts[9])  + nextVals[9]  * ts[9];
-//                 ((float *)output)[i2 +10] = vals[10] * (1.f-ts[10]) + nextVals[10] * ts[10];
-//                 ((float *)output)[i2 +11] = vals[11] * (1.f-ts[11]) + nextVals[11] * ts[11];
-//                 ((float *)output)[i2 +12] = vals[12] * (1.f-ts[12]) + nextVals[12] * ts[12];
-//                 ((float *)output)[i2 +13] = vals[13] * (1.f-ts[13]) + nextVals[13] * ts[13];
-//                 ((float *)output)[i2 +14] = vals[14] * (1.f-ts[14]) + nextVals[14] * ts[14];
-//                 ((float *)output)[i2 +15] = vals[15] * (1.f-ts[15]) + nextVals[15] * ts[15];
-//     #endif
-//
-//             }
-//
-//             for (; i < framesToRead; ++i) // catch leftovers
-//             {
-//                 // current sample position
-//                 const float framef = fmodf(((float)m_position + ((float)i * m_speed)), (float)frameSize);
-//                 const float t = framef - floorf(framef);
-//
-//                 const int indexL = (int)framef * 2; // left sample index
-//                 const int nextIndexL = (indexL + 2) % (int)sampleSize;
-//                 const int indexR = ((int)framef * 2 + 1); // right sample index
-//                 const int nextIndexR = (indexR + 2) % (int)sampleSize;
-//
-//                 const auto tMinus1 = 1.f-t;
-//
-//                 ((float *)output)[i * 2] = buffer[indexL] * (tMinus1) + buffer[nextIndexL] * (t);
-//                 ((float *)output)[i * 2 + 1] = buffer[indexR] * (tMinus1) + buffer[nextIndexR] * (t);
-//             }
-//         }
-//         else // ====== No interpolation =======================================================
+        // Number of frames whose source span fits within the window
+        constexpr auto WindowSpan = WindowFrames - InterpolationPadBefore - InterpolationPadAfter - 3;
+        const auto blockFrames = maxSpeed * static_cast<float>(frames) <= WindowSpan ? frames :
+            static_cast<int>(WindowSpan / maxSpeed) + 1;
+
+        auto position = m_position;
+        auto speed = m_currentSpeed;
+        int rendered = 0;
+        while (rendered < frames)
         {
-            // We just need to copy the bytes directly to the out buffer, accounting for loop mechanic
+            if (!m_isLooping && position >= static_cast<double>(frameSize))
+                break;
+
+            const auto count = std::min(blockFrames, frames - rendered);
+            const auto base = static_cast<int64_t>(position);
+            const auto offset = static_cast<float>(position - static_cast<double>(base));
+
+            // Gather the source frames this block reads from, including the kernel's padding
+            const auto span = static_cast<double>(offset) + static_cast<double>(count - 1) * speed +
+                static_cast<double>(stepDelta) * (count - 1) * (count - 2) * .5;
+            const auto windowCount = std::min(static_cast<int>(span) + 1 + InterpolationPadBefore +
+                InterpolationPadAfter + 1, WindowFrames);
+            readFrames(base - InterpolationPadBefore, windowCount, window);
+
+            interpolateStereo(m_interpolation, window + InterpolationPadBefore * 2, offset, speed, stepDelta,
+                output + rendered * 2, count);
+
+            const auto advance = static_cast<double>(count) * speed +
+                static_cast<double>(stepDelta) * count * (count - 1) * .5;
+            if (!m_isLooping && position + advance >= static_cast<double>(frameSize))
+            {
+                // Ends within this block, count frames that read from within the buffer
+                int i = 0;
+                for (; i < count; ++i)
+                {
+                    if (position + static_cast<double>(i) * speed +
+                        static_cast<double>(stepDelta) * i * (i - 1) * .5 >= static_cast<double>(frameSize))
+                        break;
+                }
+
+                rendered += i;
+                position = static_cast<double>(frameSize);
+                break;
+            }
 
-            const auto bufferSize  = static_cast<int64_t>(m_buffer->size());
-            const auto baseBytePos = static_cast<int64_t>(m_position) * 2LL * static_cast<int64_t>(sizeof(float));
+            position += advance;
+            if (m_isLooping && position >= static_cast<double>(m_loopEnd)) // wrap once per block, not per sample
+            {
+                position = wrapPosition(position);
+                m_wrapped = true;
+            }
 
-            int64_t bytesRead = 0;
-            while(bytesRead < length) {
-                auto bufferBytePos = (baseBytePos + bytesRead) % bufferSize;
-                auto bytesToRead = std::min(bufferSize - bufferBytePos, static_cast<int64_t>(length) - bytesRead);
+            speed += stepDelta * static_cast<float>(count);
+            rendered += count;
+        }
 
-                // Copy from here until end of requested length, or the end of the buffer
-                std::memcpy(output + bytesRead, m_buffer->data() + bufferBytePos, bytesToRead);
+        m_position = position;
+        m_currentSpeed = m_speed;
+        return rendered;
+    }
 
-                bytesRead += bytesToRead;
+    int PCMSource::readImpl(uint8_t *output, int length)
+    {
+        if (!m_buffer->data())
+            return 0;
 
-                if (!m_isLooping)
-                    break;
-            }
+        const auto frameSize = static_cast<int64_t>(m_buffer->frames());
+        const auto frameLength = length / (int)(2 * sizeof(float));
+
+        if (frameSize == 0) // prevent zero copy
+            return 0;
+
+        // clear the write buffer
+        std::memset(output, 0, length);
+
+        if (!m_isLooping && m_position >= (double)frameSize) // sound ended, fill with silence
+        {
+            return length;
         }
 
-        // Update buffer position head
-        if (m_isLooping)
+        const auto startPosition = m_position;
+        m_wrapped = false;
+
+        int framesRead;
+        if (m_speed != 1.f || m_currentSpeed != 1.f || m_position != std::floor(m_position))
         {
-            m_position = fmodf(m_position + (float)framesToRead * m_speed, (float)frameSize);
+            framesRead = interpolate((float *)output, frameLength);
         }
-        else
+        else // ====== No interpolation =======================================================
         {
-            m_position += (float)framesToRead * m_speed;
+            // Convert the frames directly into the out buffer, accounting for loop mechanic
+            const auto position = (int64_t)m_position;
+            const auto framesToRead = m_isLooping ? (int64_t)frameLength :
+                std::min<int64_t>((int64_t)frameLength, frameSize - position);
 
-            // Release sound if it ended and is a oneshot
-            if (m_isOneShot && m_position >= (float)frameSize)
+            readFrames(position, (int)framesToRead, (float *)output);
+
+            // Update buffer position head
+            m_position = (double)(position + framesToRead);
+            if (m_isLooping && m_position >= (double)m_loopEnd)
             {
-                close();
+                m_position = wrapPosition(m_position);
+                m_wrapped = true;
             }
+            framesRead = (int)framesToRead;
+        }
+
+        if (eventsEnabled())
+            pushPlaybackEvents(startPosition, frameSize);
+
+        // Release sound if it ended and is a oneshot
+        if (!m_isLooping && m_isOneShot && m_position >= (double)frameSize)
+        {
+            queueRelease();
         }
 
         // Report the number of bytes read
-        return (int)framesToRead * (int)sizeof(float) * 2;
+        return framesRead * (int)sizeof(float) * 2;
+    }
+
+    void PCMSource::pushPlaybackEvents(const double from, const int64_t frameSize)
+    {
+        const auto to = m_position;
+        const auto &markers = m_buffer->markers();
+        for (int i = 0, count = static_cast<int>(markers.size()); i < count; ++i)
+        {
+            const auto position = static_cast<double>(markers[i].position);
+            const auto crossed = m_wrapped ?
+                (position >= from && position < static_cast<double>(m_loopEnd)) ||
+                    (position >= static_cast<double>(m_loopStart) && position < to) :
+                position >= from && position < to;
+
+            if (crossed)
+                pushEvent(SourceEvent::MarkerCrossed, i);
+        }
+
+        if (m_wrapped)
+            pushEvent(SourceEvent::Looped);
+
+        if (!m_isLooping && from < static_cast<double>(frameSize) && to >= static_cast<double>(frameSize))
+            pushEvent(SourceEvent::Ended);
     }
 
     bool PCMSource::getEnded(bool *outEnded) const
@@ -428,7 +452,7 @@ namespace insound {
         HANDLE_GUARD();
 
         if (outEnded)
-            *outEnded = m_position >= (float)m_buffer->size() / (sizeof(float) * 2.f);
+            *outEnded = m_position >= (double)m_buffer->frames();
         return true;
     }
 
@@ -437,7 +461,7 @@ namespace insound {
         HANDLE_GUARD();
 
         if (outPosition)
-            *outPosition = m_position;
+            *outPosition = (float)m_position;
 
         return true;
     }
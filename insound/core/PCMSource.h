@@ -1,4 +1,5 @@
 #pragma once
+#include "Interpolation.h"
 #include "Source.h"
 
 #include <cstdint>
@@ -21,14 +22,44 @@ namespace insound {
         bool setPosition(float value);
 
         bool getSpeed(float *outSpeed) const;
+
+        /// Set the playback speed, which also shifts pitch. The change ramps in over the next rendered block, so
+        /// it is free of clicks when modulated continuously.
+        /// @param value  speed multiplier, where 1 is the original speed; clamped to [0, `MaxSpeed`]
+        /// @returns whether function succeeded; check `popError()` for details.
         bool setSpeed(float value);
 
+        /// Get the interpolation used when playing at a speed other than 1
+        /// @param outMode  pointer to receive the interpolation mode
+        /// @returns whether function succeeded; check `popError()` for details.
+        bool getInterpolation(InterpolationMode *outMode) const;
+
+        /// Set the interpolation used when playing at a speed other than 1. Default: `InterpolationMode::Linear`
+        /// @param mode  interpolation mode to set
+        /// @returns whether function succeeded; check `popError()` for details.
+        bool setInterpolation(InterpolationMode mode);
+
         bool getLooping(bool *outLooping) const;
         bool setLooping(bool value);
 
+        /// Get the loop region played while looping
+        /// @param outIndex  pointer to receive the index of the region in the buffer's `loopRegions()`, or -1 when
+        ///                  looping the whole buffer
+        /// @returns whether function succeeded; check `popError()` for details.
+        bool getLoopRegion(int *outIndex) const;
+
+        /// Set the loop region played while looping. Frames before the region play once, frames after it only
+        /// play when not looping. Default: the buffer's first loop region, or the whole buffer if it has none.
+        /// @param index  index of the region in the buffer's `loopRegions()`, or -1 to loop the whole buffer
+        /// @returns whether function succeeded; check `popError()` for details.
+        bool setLoopRegion(int index);
+
         bool getOneshot(bool *outOneshot) const;
         bool setOneshot(bool value);
 
+        /// Maximum playback speed
+        static constexpr float MaxSpeed = 256.f;
+
     private:
         friend class Engine;
         void applyCommand(const struct PCMSourceCommand &command);
@@ -36,10 +67,38 @@ namespace insound {
         /// Get the current pointer position
         /// @returns the amount of bytes available or length arg, whichever is smaller
         int readImpl(uint8_t *output, int length) override;
+
+        /// Render `frames` of interpolated output, advancing the position
+        /// @returns number of frames rendered before the end of a non-looping buffer
+        int interpolate(float *output, int frames);
+
+        /// Read `count` frames starting at frame `first` into float32 stereo `output`. While looping, reads past the
+        /// loop end continue from the loop start and the crossfade replaces the end of the loop; otherwise frames
+        /// outside of the buffer are silent.
+        void readFrames(int64_t first, int count, float *output) const;
+
+        /// Wrap a position at or past the loop end back into the loop region
+        double wrapPosition(double position) const;
+
+        /// Point loop state at a region of the current buffer, -1 for the whole buffer
+        void setLoopRegionImpl(int index);
+
+        /// Queue events for what playback passed over while moving from `from` to the current position
+        void pushPlaybackEvents(double from, int64_t frameSize);
+
         const SoundBuffer *m_buffer;
-        float m_position;
+        double m_position;      ///< in frames, double to stay sample-accurate in long buffers
         bool m_isLooping;
         bool m_isOneShot;
-        float m_speed;
+        float m_speed;          ///< target speed
+        float m_currentSpeed;   ///< speed at the end of the last rendered block, ramps toward `m_speed`
+        InterpolationMode m_interpolation;
+
+        int m_loopIndex;        ///< index of the buffer's loop region, -1 for the whole buffer
+        int64_t m_loopStart;    ///< first frame of the loop
+        int64_t m_loopEnd;      ///< frame after the last frame of the loop
+        int64_t m_crossfade;    ///< number of frames at the loop end read from `m_crossfadeData`
+        const float *m_crossfadeData;
+        bool m_wrapped;         ///< whether the last read wrapped from the loop end to the loop start
     };
 }
@@ -1,56 +1,112 @@
 #include "Pool.h"
+#include "RealtimeThread.h"
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <new>
 
 namespace insound {
 
-PoolID::PoolID(): index(SIZE_MAX), id(SIZE_MAX)
+PoolBase *detail::poolRegistry[detail::PoolTagCount];
+
+size_t detail::nextPoolTypeId()
+{
+    static std::atomic<size_t> counter(0);
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Guards registration, lookups by tag do not lock
+static std::mutex s_registryMutex;
+static uint32_t s_nextTag = 1;
+
+/// @returns a free registry tag now pointing to `pool`, or 0 if the registry is full
+static uint32_t registerPool(PoolBase *pool)
+{
+    std::lock_guard lockGuard(s_registryMutex);
+
+    // Tags are handed out round-robin, so a destroyed pool's tag isn't reused right away by a new one
+    for (uint32_t i = 1; i < detail::PoolTagCount; ++i)
+    {
+        const auto tag = s_nextTag;
+        s_nextTag = s_nextTag % (detail::PoolTagCount - 1) + 1;
+
+        if (detail::poolRegistry[tag] == nullptr)
+        {
+            detail::poolRegistry[tag] = pool;
+            return tag;
+        }
+    }
+
+    INSOUND_PUSH_ERROR(Result::RangeErr, "Too many pools exist at once, handles to this pool will be invalid");
+    return 0;
+}
+
+static void unregisterPool(const uint32_t tag)
+{
+    if (tag != 0)
+    {
+        std::lock_guard lockGuard(s_registryMutex);
+        detail::poolRegistry[tag] = nullptr;
+    }
+}
+
+PoolID::PoolID(): index(UINT32_MAX), generation(0)
 { }
 
 PoolID::operator bool() const
 {
-    return id != SIZE_MAX;
+    return generation != 0;
 }
 
 
 PoolBase::PoolBase(const size_t elemSize) :
-           m_memory(), m_meta(), m_size(), m_nextFree(),
+           m_pages(), m_size(), m_nextFree(NullIndex), m_tag(registerPool(this)),
            m_elemSize(elemSize), // match byte alignment
-           m_idCounter()
+           m_locked(), m_lockedBytes()
 {
-    m_nextFree = SIZE_MAX;
 }
 
-PoolBase::PoolBase(PoolBase &&other) noexcept : m_memory(other.m_memory), m_meta(other.m_meta), m_size(other.m_size),
-    m_nextFree(other.m_nextFree), m_elemSize(other.m_elemSize), m_idCounter(other.m_idCounter)
+PoolBase::PoolBase(PoolBase &&other) noexcept : m_pages(std::move(other.m_pages)), m_size(other.m_size),
+    m_nextFree(other.m_nextFree), m_tag(other.m_tag), m_elemSize(other.m_elemSize), m_locked(other.m_locked),
+    m_lockedBytes(other.m_lockedBytes)
 {
-    other.m_memory = nullptr;
-    other.m_meta = nullptr;
+    if (m_tag != 0)
+        detail::poolRegistry[m_tag] = this;
+
+    other.m_pages.clear();
     other.m_size = 0;
+    other.m_nextFree = NullIndex;
+    other.m_tag = 0;
+    other.m_lockedBytes = 0;
 }
 
 PoolBase &PoolBase::operator=(PoolBase &&other) noexcept
 {
     if (this != &other)
     {
-        // clean up existing memory
-        std::free(m_memory);
-        std::free(m_meta);
+        // clean up existing memory, handles into it become invalid
+        freePages();
+        unregisterPool(m_tag);
 
-        m_memory = other.m_memory;
-        m_meta = other.m_meta;
+        m_pages = std::move(other.m_pages);
         m_size = other.m_size;
         m_nextFree = other.m_nextFree;
+        m_tag = other.m_tag;
         m_elemSize = other.m_elemSize;
-        m_idCounter = other.m_idCounter;
+        m_locked = other.m_locked;
+        m_lockedBytes = other.m_lockedBytes;
+        if (m_tag != 0)
+            detail::poolRegistry[m_tag] = this;
 
-        other.m_memory = nullptr;
-        other.m_meta = nullptr;
+        other.m_pages.clear();
         other.m_size = 0;
+        other.m_nextFree = NullIndex;
+        other.m_tag = 0;
+        other.m_lockedBytes = 0;
     }
 
     return *this;
@@ -58,33 +114,63 @@ PoolBase &PoolBase::operator=(PoolBase &&other) noexcept
 
 PoolBase::~PoolBase()
 {
-    std::free(m_memory);
-    std::free(m_meta);
+    unregisterPool(m_tag);
+    freePages();
 }
 
 PoolID PoolBase::allocate()
 {
     if (isFull())
-    {
-        const auto lastSize = m_size;
-        expand(lastSize * 2 + 1);
+        addPage();
+
+    const auto index = m_nextFree;
+    auto &slot = meta(index);
+    m_nextFree = slot.nextFree;
+    slot.generation = (slot.generation + 1) & PoolID::GenerationMask; // becomes odd: in use
+
+    return {index, slot.generation};
+}
 
-        m_nextFree = lastSize;
+void PoolBase::reserve(size_t size)
+{
+    while (m_size < size)
+        addPage();
+}
+
+void PoolBase::addPage()
+{
+    if (m_size + PageSize > MaxSize)
+        throw std::bad_alloc();
+
+    // Meta data follows the slots; slot bytes are a multiple of PageSize, so meta stays 8-byte aligned
+    const auto slotBytes = PageSize * m_elemSize;
+    const auto memory = (char *)std::malloc(pageBytes());
+    if (!memory)
+        throw std::bad_alloc();
+
+    Page page{memory, (Meta *)(memory + slotBytes)};
+    constructElements(page.memory, PageSize);
+
+    // New slots go in front of the free list, in index order
+    const auto first = static_cast<uint32_t>(m_size);
+    for (uint32_t i = 0; i < PageSize; ++i)
+    {
+        new (page.meta + i) Meta(0, first + i + 1);
     }
+    page.meta[PageSize - 1].nextFree = m_nextFree;
 
-    auto &meta = m_meta[m_nextFree];
-    m_nextFree = meta.nextFree;
-    meta.id.id = m_idCounter++;
+    m_pages.emplace_back(page);
+    m_nextFree = first;
+    m_size += PageSize;
 
-    return meta.id;
+    if (m_locked && detail::lockMemory(memory, pageBytes()))
+        m_lockedBytes += pageBytes();
 }
 
-void PoolBase::reserve(size_t size)
+void PoolBase::destroyAll()
 {
-    const auto lastSize = m_size;
-    expand(size);
-    if (m_nextFree == SIZE_MAX)
-        m_nextFree = lastSize;
+    for (auto &page : m_pages)
+        destroyElements(page.memory, PageSize);
 }
 
 void PoolBase::deallocate(const PoolID &id)
@@ -92,39 +178,80 @@ void PoolBase::deallocate(const PoolID &id)
     if (!isValid(id))
         return;
 
-    auto &meta = m_meta[id.index];
-    meta.nextFree = m_nextFree;
-    meta.id.id = SIZE_MAX;
+    auto &slot = meta(id.index);
+    slot.nextFree = m_nextFree;
+    slot.generation = (slot.generation + 1) & PoolID::GenerationMask; // becomes even: free
     m_nextFree = id.index;
 }
 
 bool PoolBase::tryFind(void *ptr, PoolID *outID)
 {
-    if (ptr < m_memory || ptr >= m_memory + m_elemSize * m_size)
-        return false;
-    const auto index = ((char *)ptr - m_memory) / m_elemSize;
+    const auto slotBytes = PageSize * m_elemSize;
+    for (size_t p = 0, count = m_pages.size(); p < count; ++p)
+    {
+        const auto &page = m_pages[p];
+        if (ptr < page.memory || ptr >= page.memory + slotBytes)
+            continue;
 
-    if (outID)
-        *outID = m_meta[index].id;
-    return true;
+        const auto offset = ((char *)ptr - page.memory) / m_elemSize;
+        if (outID)
+            *outID = PoolID(static_cast<uint32_t>(p * PageSize + offset), page.meta[offset].generation);
+        return true;
+    }
+
+    return false;
 }
 
 void PoolBase::clear()
 {
-    const auto size = m_size;
+    const auto size = static_cast<uint32_t>(m_size);
     if (size == 0) return;
 
-    for (size_t i = 0; i < size; ++i)
+    for (uint32_t i = 0; i < size; ++i)
     {
-        auto &meta = m_meta[i];
-        meta.id.id = SIZE_MAX;
-        meta.nextFree = i + 1;
+        auto &slot = meta(i);
+        if (slot.generation & 1u) // in-use slots advance, invalidating their ids
+            slot.generation = (slot.generation + 1) & PoolID::GenerationMask;
+        slot.nextFree = i + 1;
     }
 
-    m_meta[size - 1].nextFree = SIZE_MAX;
+    meta(size - 1).nextFree = NullIndex;
     m_nextFree = 0;
 }
 
-bool PoolBase::isFull() const { return m_nextFree == SIZE_MAX; }
+bool PoolBase::setLocked(const bool value)
+{
+    m_locked = value;
+    for (const auto &page : m_pages)
+        detail::unlockMemory(page.memory, pageBytes());
+    m_lockedBytes = 0;
+
+    if (!value)
+        return true;
+
+    bool result = true;
+    for (const auto &page : m_pages)
+    {
+        if (detail::lockMemory(page.memory, pageBytes()))
+            m_lockedBytes += pageBytes();
+        else
+            result = false;
+    }
+
+    return result;
+}
+
+void PoolBase::freePages()
+{
+    for (auto &page : m_pages)
+    {
+        if (m_lockedBytes > 0)
+            detail::unlockMemory(page.memory, pageBytes());
+        std::free(page.memory);
+    }
+    m_lockedBytes = 0;
+}
+
+bool PoolBase::isFull() const { return m_nextFree == NullIndex; }
 
 }
@@ -1,19 +1,30 @@
 #pragma once
 #include "Error.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
-#include <unordered_map>
+#include <new>
+#include <type_traits>
+#include <vector>
 
 namespace insound {
 
+/// Identifies a pool slot: its index, and the generation of the slot when it was allocated. Generations are odd
+/// while a slot is in use and advance on every allocation and deallocation, so ids of freed slots never validate.
 struct PoolID {
-    PoolID(const size_t index, const size_t id) : index(index), id(id) { }
+    /// Number of bits of a pool slot index, see `PoolBase::MaxSize`
+    static constexpr uint32_t IndexBits = 24;
+    /// Number of bits of a slot generation, generations wrap around at `GenerationMask`
+    static constexpr uint32_t GenerationBits = 28;
+    static constexpr uint32_t GenerationMask = (1u << GenerationBits) - 1u;
+
+    PoolID(const uint32_t index, const uint32_t generation) : index(index), generation(generation) { }
     PoolID(); // null id
-    size_t index, id;
+    uint32_t index, generation;
 
     explicit operator bool() const;
 
@@ -21,7 +32,7 @@ struct PoolID {
     struct Hasher {
         [[nodiscard]]
         size_t operator()(const PoolID &id) const noexcept {
-            return id.id;
+            return static_cast<size_t>(id.generation) << PoolID::IndexBits | id.index;
         }
     };
 
@@ -30,17 +41,91 @@ struct PoolID {
         [[nodiscard]]
         bool operator()(const PoolID &a, const PoolID &b) const noexcept
         {
-            return a.id == b.id;
+            return a.index == b.index && a.generation == b.generation;
         }
     };
 };
 
+class PoolBase;
+
+namespace detail {
+    /// Number of pools that can exist at once, tag 0 is reserved for null handles
+    constexpr uint32_t PoolTagBits = 12;
+    constexpr uint32_t PoolTagCount = 1u << PoolTagBits;
+
+    /// Live pools by tag, so a handle can find its pool from a few bits instead of storing a pointer.
+    /// Entries are written under a lock when pools are created, moved or destroyed, and read without one: a tag is
+    /// only written while no valid handle refers to it.
+    extern PoolBase *poolRegistry[PoolTagCount];
+}
+
+namespace detail {
+    /// @returns a new process-wide pool type id, counting up from 0
+    size_t nextPoolTypeId();
+}
+
+/// Index of a pooled type, assigned on first use and stable for the rest of the process.
+/// Used to index pool tables directly instead of looking them up by `std::type_index`.
+template <typename T>
+size_t poolTypeId()
+{
+    static const size_t id = detail::nextPoolTypeId();
+    return id;
+}
+
+/// Base for pooled class hierarchies that need checked downcasts without RTTI. `MultiPool` stamps each object it
+/// allocates with the id of its concrete type, see `poolTypeId`.
+class PoolTyped {
+public:
+    /// Id of this object's concrete type, see `poolTypeId`
+    [[nodiscard]]
+    size_t typeId() const { return m_typeId; }
+
+    /// @returns whether this object's concrete type is `U`
+    template <typename U>
+    [[nodiscard]]
+    bool isType() const { return m_typeId == poolTypeId<std::remove_cv_t<U>>(); }
+
+protected:
+    PoolTyped() : m_typeId(SIZE_MAX) { }
+
+private:
+    friend class MultiPool;
+    size_t m_typeId;
+};
+
+/// Checked downcast of a pooled object to its concrete type, a `static_cast` guarded by `PoolTyped::isType`.
+/// Casts to base classes always succeed.
+/// @returns `ptr` as `U *`, or `nullptr` if `ptr` is null or `U` is not its concrete type or one of its bases
+template <typename U, typename T>
+U *poolCast(T *ptr)
+{
+    if constexpr (std::is_base_of_v<std::remove_cv_t<U>, std::remove_cv_t<T>>)
+    {
+        return ptr;
+    }
+    else
+    {
+        static_assert(std::is_base_of_v<PoolTyped, std::remove_cv_t<T>> && std::is_base_of_v<T, U>,
+            "poolCast can only downcast within a PoolTyped hierarchy");
+        return ptr && ptr->template isType<U>() ? static_cast<U *>(ptr) : nullptr;
+    }
+}
+
 /// Abstract class.
-/// Stores fixed blocks of memory, expanding when full capacity is reached.
+/// Stores fixed blocks of memory in pages of `PageSize` slots, adding a page when full capacity is reached.
+/// Pages are never reallocated, so pooled objects keep their address for the lifetime of the pool, and raw
+/// pointers held by the mix thread stay valid while another thread allocates.
 /// This class is intended to be a generic base to group pools under.
 /// @note Use Pool<T> for type-safe pools.
 class PoolBase {
 public:
+    /// Number of slots per page, a power of two
+    static constexpr size_t PageSize = 64;
+
+    /// Maximum number of slots in a pool, limited by the bits a handle has for an index
+    static constexpr size_t MaxSize = size_t(1) << PoolID::IndexBits;
+
     /// @param elemSize size of one slot in bytes
     explicit PoolBase(size_t elemSize);
     virtual ~PoolBase();
@@ -49,14 +134,15 @@ public:
     PoolBase(const PoolBase &) = delete;
     PoolBase &operator=(const PoolBase &) = delete;
 
-    // Movable
+    // Movable, handles follow the pool to its new location
     PoolBase(PoolBase &&other) noexcept;
     PoolBase &operator=(PoolBase &&other) noexcept;
 
-    /// Get a slot of pool data. Pool may expand if it is full.
+    /// Get a slot of pool data. Pool adds a page if it is full, existing slots do not move.
     PoolID allocate();
 
-    /// Allocate data slots ahead of time to prevent dynamic resizes
+    /// Allocate data slots ahead of time, so that `allocate` does not allocate memory until `size` slots are used
+    /// @param size  number of slots to reserve, rounded up to a multiple of `PageSize`
     void reserve(size_t size);
 
     /// Returns memory ownership back to the pool.
@@ -68,20 +154,39 @@ public:
     /// Check if an id returned from `allocate` is valid. Does not differentiate between ids from other pools,
     /// so user must make sure that PoolID is from the correct pool.
     [[nodiscard]]
-    bool isValid(const PoolID &id) const { return id.index < m_size && m_meta[id.index].id.id == id.id; }
+    bool isValid(const PoolID &id) const
+    {
+        return (id.index < m_size) & (id.generation & 1u) && meta(id.index).generation == id.generation;
+    }
 
-    /// Users of the pool should access memory via this function instead of caching pointers long-term
-    /// as memory resizing can cause pointers to become invalidated should the pool be dynamically resized.
-    /// Returns `nullptr` if id is invalid
+    /// Get the memory of a slot. Does not check validity, see `isValid`. Addresses remain stable until the pool is
+    /// destroyed.
     void *get(const PoolID &id)
     {
-        return m_memory + id.index * m_elemSize;
+        return m_pages[id.index / PageSize].memory + (id.index % PageSize) * m_elemSize;
+    }
+
+    /// Get the memory of a slot if `id` is valid, resolving the page once for both the check and the access
+    /// @returns slot memory, or `nullptr` if id is invalid
+    [[nodiscard]]
+    void *tryGet(const PoolID &id)
+    {
+        if (id.index >= m_size)
+            return nullptr;
+        const auto &page = m_pages[id.index / PageSize];
+        const auto slot = id.index % PageSize;
+        return (page.meta[slot].generation == id.generation) & (id.generation & 1u) ?
+            page.memory + slot * m_elemSize : nullptr;
     }
 
     bool tryFind(void *ptr, PoolID *outID);
 
+    /// Returns `nullptr` if id is invalid
     [[nodiscard]]
-    const void *get(const PoolID &id) const { return isValid(id) ? m_memory + id.index * m_elemSize : nullptr; }
+    const void *get(const PoolID &id) const
+    {
+        return isValid(id) ? m_pages[id.index / PageSize].memory + (id.index % PageSize) * m_elemSize : nullptr;
+    }
 
     [[nodiscard]]
     size_t maxSize() const { return m_size; }
@@ -90,44 +195,73 @@ public:
     [[nodiscard]]
     size_t elemSize() const { return m_elemSize; }
 
-    /// Deallocate all memory.
+    /// Registry tag of this pool, 0 if the registry was full when it was created
+    [[nodiscard]]
+    uint32_t tag() const { return m_tag; }
+
+    /// Mark all slots as free, keeping the pages.
     /// Does not run any cleanup logic, though - please make sure to clean up memory before calling clear.
     void clear();
 
-    /// Raw memory
-    [[nodiscard]]
-    char *data() { return m_memory; }
-    /// Raw memory
-    [[nodiscard]]
-    const char *data() const { return m_memory; }
+    /// Lock the pages into physical memory, and each page added later, so the mixer never page-faults on a slot
+    /// @param value whether to lock, false unlocks them
+    /// @returns whether every page could be locked, see `detail::lockMemory`
+    bool setLocked(bool value);
 
-    // /// DO NOT USE. All handles become invalidated, and there is no solution yet.
-    // /// @param newSize    size to shrink to; if less than `aliveCount()`, it will use the alive count.
-    // /// @param outIndices map containing inner id keys to their updated indices. (optional)
-    // /// @returns whether shrink occurred. If current size is <= `newSize`, `false` will be returned.
-    // bool shrink(size_t newSize, std::unordered_map<size_t, size_t> *outIndices = nullptr);
+    /// Bytes of pages currently locked into physical memory
+    [[nodiscard]]
+    size_t lockedBytes() const { return m_lockedBytes; }
 
 protected:
     struct Meta {
-        Meta(const PoolID id, const size_t nextFree) : id(id), nextFree(nextFree) { }
-        PoolID id;
-        size_t nextFree;
+        Meta(const uint32_t generation, const uint32_t nextFree) : generation(generation), nextFree(nextFree) { }
+        uint32_t generation; ///< odd while in use
+        uint32_t nextFree;
+    };
+
+    /// End of the free list
+    static constexpr uint32_t NullIndex = UINT32_MAX;
+
+    /// One block of `PageSize` slots followed by their meta data, allocated at once
+    struct Page {
+        char *memory;
+        Meta *meta;
     };
 
+    [[nodiscard]] Meta &meta(size_t index) { return m_pages[index / PageSize].meta[index % PageSize]; }
+    [[nodiscard]] const Meta &meta(size_t index) const { return m_pages[index / PageSize].meta[index % PageSize]; }
+
     /// Check if pool is currently filled to maximum capacity
     [[nodiscard]] bool isFull() const;
 
-    virtual void expand(size_t newSize) = 0;
+    /// Allocate a page and push its slots onto the free list
+    void addPage();
+
+    /// Size of one page's allocation in bytes, its slots followed by their meta data
+    [[nodiscard]] size_t pageBytes() const { return PageSize * (m_elemSize + sizeof(Meta)); }
 
-    char *m_memory;               ///< pointer to storage
-    Meta *m_meta;                 ///< contains information on a slot of memory
+    /// Unlock and free every page, without destructing elements
+    void freePages();
+
+    /// Default-construct `count` elements in raw page memory
+    virtual void constructElements(char *memory, size_t count) = 0;
+
+    /// Destruct all elements in every page
+    void destroyAll();
+
+    /// Destruct `count` elements in page memory
+    virtual void destroyElements(char *memory, size_t count) = 0;
+
+    std::vector<Page> m_pages;    ///< page table, only the table itself moves when it grows
     size_t m_size;                ///< current pool size
-    size_t m_nextFree;            ///< next free pool index
+    uint32_t m_nextFree;          ///< next free pool index
+    uint32_t m_tag;               ///< index in `detail::poolRegistry`
     size_t m_elemSize;            ///< size of each memory block
-    size_t m_idCounter;           ///< next id to set on `allocate`
+    bool m_locked;                ///< whether pages are locked into physical memory as they're added
+    size_t m_lockedBytes;         ///< bytes of pages locked
 };
 
-// Implements type safety for non-trivial data types by calling move constructor on memory reallocation
+// Implements type safety for non-trivial data types by constructing and destructing elements in pool pages
 template <typename T>
 class Pool final : public PoolBase {
 public:
@@ -142,64 +276,30 @@ public:
     {
         if (this != &other)
         {
-            cleanup(); // destruct all pool elements before freeing
+            destroyAll(); // destruct all pool elements before freeing
             PoolBase::operator=(std::move(other));
         }
 
-        return this;
+        return *this;
     }
 
     ~Pool() override
     {
-        cleanup();
+        destroyAll();
     }
 
-    void expand(size_t newSize) override
+private:
+    void constructElements(char *memory, size_t count) override
     {
-        const auto lastSize = m_size;
-        if (lastSize >= newSize) // no need to expand if new size isn't greater
-            return;
-
-        if (m_memory == nullptr)
-        {
-            m_memory = (char *)std::malloc(newSize * sizeof(T));
-            m_meta = (Meta *)std::malloc(newSize * sizeof(Meta));
-        }
-        else
+        for (auto ptr = (T *)memory, end = (T *)memory + count; ptr != end; ++ptr)
         {
-            auto temp = (char *)std::malloc(newSize * sizeof(T));
-
-            for (T *ptr = (T *)m_memory, *end = (T *)m_memory + lastSize, *target = (T *)temp; ptr != end; ++ptr, ++target)
-            {
-                new (target) T(std::move(*ptr));
-                ptr->~T();
-            }
-
-            std::free(m_memory);
-            m_memory = temp;
-
-            auto metaTemp = (Meta *)std::malloc(newSize * sizeof(Meta));
-            std::memcpy(metaTemp, m_meta, lastSize * sizeof(Meta));
-            std::free(m_meta);
-            m_meta = metaTemp;
-        }
-
-        // TODO: unroll these loops?
-        // Initialize objects in new indices
-        for (size_t i = lastSize; i < newSize; ++i)
-        {
-            new (m_meta + i) Meta(PoolID(i, SIZE_MAX), i+1);
-            new ((T *)m_memory + i) T();
+            new (ptr) T();
         }
-
-        m_meta[newSize - 1].nextFree = SIZE_MAX;
-        m_size = newSize;
     }
 
-private:
-    void cleanup()
+    void destroyElements(char *memory, size_t count) override
     {
-        for (auto ptr = (T *)m_memory, end = (T *)m_memory + m_size; ptr != end; ++ptr)
+        for (auto ptr = (T *)memory, end = (T *)memory + count; ptr != end; ++ptr)
         {
             ptr->~T();
         }
@@ -0,0 +1,226 @@
+#include "RealtimeCheck.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if INSOUND_RT_CHECKS
+#   if __has_include(<execinfo.h>)
+#       include <execinfo.h>
+#       define INSOUND_RT_BACKTRACE 1
+#   endif
+#   if defined(__GLIBC__)
+#       include <cerrno>
+#       include <dlfcn.h>
+#       include <pthread.h>
+#       define INSOUND_RT_MUTEX_HOOK 1
+#       define INSOUND_RT_MALLOC_HOOK 1
+#   endif
+#   if defined(_WIN32)
+#       include <malloc.h>
+#   endif
+#endif
+
+#ifndef INSOUND_RT_BACKTRACE
+#   define INSOUND_RT_BACKTRACE 0
+#endif
+#ifndef INSOUND_RT_MUTEX_HOOK
+#   define INSOUND_RT_MUTEX_HOOK 0
+#endif
+#ifndef INSOUND_RT_MALLOC_HOOK
+#   define INSOUND_RT_MALLOC_HOOK 0
+#endif
+
+namespace insound {
+    thread_local static bool t_isAudioThread;
+    thread_local static bool t_isReporting; ///< prevents reporting the allocations made while reporting
+    static std::atomic<size_t> s_violations;
+    static std::atomic<bool> s_logging(true);
+
+    size_t getRealtimeViolations()
+    {
+        return s_violations.load(std::memory_order_relaxed);
+    }
+
+    void resetRealtimeViolations()
+    {
+        s_violations.store(0, std::memory_order_relaxed);
+    }
+
+    void setRealtimeViolationLogging(const bool value)
+    {
+        s_logging.store(value, std::memory_order_relaxed);
+    }
+
+    bool detail::isAudioThread()
+    {
+        return t_isAudioThread;
+    }
+
+    void detail::checkRealtime([[maybe_unused]] const char *what)
+    {
+#if INSOUND_RT_CHECKS
+        if (!t_isAudioThread || t_isReporting)
+            return;
+
+        t_isReporting = true;
+        s_violations.fetch_add(1, std::memory_order_relaxed);
+
+        if (s_logging.load(std::memory_order_relaxed))
+        {
+            std::fprintf(stderr, "INSOUND RT VIOLATION: %s on the audio thread\n", what);
+#if INSOUND_RT_BACKTRACE
+            void *frames[32];
+            const auto count = backtrace(frames, 32);
+            backtrace_symbols_fd(frames + 1, count - 1, 2); // skip this function
+#endif
+        }
+
+        t_isReporting = false;
+#endif
+    }
+
+    detail::AudioThreadScope::AudioThreadScope() : m_wasAudioThread(t_isAudioThread)
+    {
+        t_isAudioThread = true;
+    }
+
+    detail::AudioThreadScope::~AudioThreadScope()
+    {
+        t_isAudioThread = m_wasAudioThread;
+    }
+}
+
+#if INSOUND_RT_CHECKS && INSOUND_RT_MALLOC_HOOK
+// ===== C allocation hooks ===================================================
+// Replacing the C allocator catches every allocation, including C++'s, which goes through malloc, and C libraries'
+// like miniaudio's decoders. glibc exports its allocator under `__libc_` names to forward to.
+
+extern "C" {
+    void *__libc_malloc(std::size_t size);
+    void *__libc_calloc(std::size_t count, std::size_t size);
+    void *__libc_realloc(void *ptr, std::size_t size);
+    void *__libc_memalign(std::size_t alignment, std::size_t size);
+    void __libc_free(void *ptr);
+
+    void *malloc(const std::size_t size)
+    {
+        insound::detail::checkRealtime("allocation");
+        return __libc_malloc(size);
+    }
+
+    void *calloc(const std::size_t count, const std::size_t size)
+    {
+        insound::detail::checkRealtime("allocation");
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, const std::size_t size)
+    {
+        insound::detail::checkRealtime("reallocation");
+        return __libc_realloc(ptr, size);
+    }
+
+    int posix_memalign(void **outPtr, const std::size_t alignment, const std::size_t size)
+    {
+        if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        insound::detail::checkRealtime("allocation");
+        const auto ptr = __libc_memalign(alignment, size);
+        if (!ptr)
+            return ENOMEM;
+        *outPtr = ptr;
+        return 0;
+    }
+
+    void *aligned_alloc(const std::size_t alignment, const std::size_t size)
+    {
+        insound::detail::checkRealtime("allocation");
+        return __libc_memalign(alignment, size);
+    }
+
+    void free(void *ptr)
+    {
+        if (ptr)
+            insound::detail::checkRealtime("deallocation");
+        __libc_free(ptr);
+    }
+}
+
+#elif INSOUND_RT_CHECKS
+// ===== Global allocation hooks ==============================================
+// Without a replaceable C allocator, only C++ allocations are checked. The array, sized and nothrow forms of the
+// standard library forward to these.
+
+void *operator new(const std::size_t size)
+{
+    insound::detail::checkRealtime("allocation");
+    if (const auto ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr)
+        insound::detail::checkRealtime("deallocation");
+    std::free(ptr);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    insound::detail::checkRealtime("allocation");
+    const auto align = static_cast<std::size_t>(alignment) < sizeof(void *) ?
+        sizeof(void *) : static_cast<std::size_t>(alignment);
+#if defined(_WIN32)
+    if (const auto ptr = _aligned_malloc(size ? size : 1, align))
+        return ptr;
+#else
+    void *ptr;
+    if (posix_memalign(&ptr, align, size ? size : 1) == 0)
+        return ptr;
+#endif
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    if (ptr)
+        insound::detail::checkRealtime("deallocation");
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+#endif
+
+#if INSOUND_RT_CHECKS && INSOUND_RT_MUTEX_HOOK
+// ===== Mutex hook ===========================================================
+// Only locks that would block are reported, an uncontended lock, e.g. of the mix mutex, doesn't wait.
+
+using MutexLockFn = int (*)(pthread_mutex_t *);
+static std::atomic<MutexLockFn> s_mutexLock;
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex)
+{
+    auto lock = s_mutexLock.load(std::memory_order_relaxed);
+    if (!lock)
+    {
+        lock = reinterpret_cast<MutexLockFn>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        s_mutexLock.store(lock, std::memory_order_relaxed);
+    }
+
+    if (insound::detail::isAudioThread())
+    {
+        const auto result = pthread_mutex_trylock(mutex);
+        if (result != EBUSY)
+            return result;
+        insound::detail::checkRealtime("blocking mutex lock");
+    }
+
+    return lock(mutex);
+}
+#endif
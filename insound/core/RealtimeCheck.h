@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+/// Debug mode that catches real-time safety violations in the mixer: memory allocations, deallocations, and mutex
+/// locks that would block, made while inside the engine's audio callback. Each one is counted and reported to
+/// stderr with a backtrace. Enable via the `INSOUND_RT_CHECKS` CMake option; it replaces the allocator of the whole
+/// program, so leave it off in shipping builds.
+/// On Linux with glibc, `malloc`, `calloc`, `realloc`, `free` and the aligned forms are replaced, which covers C++
+/// and C libraries alike, and blocking mutex locks are intercepted. Elsewhere only the global `operator new` and
+/// `operator delete` are replaced, so only C++ allocations are checked.
+#ifndef INSOUND_RT_CHECKS
+#   define INSOUND_RT_CHECKS 0
+#endif
+
+namespace insound {
+    /// Get the number of real-time violations made on the audio thread since the last reset.
+    /// Always zero unless built with `INSOUND_RT_CHECKS`.
+    size_t getRealtimeViolations();
+
+    /// Reset the real-time violation count to zero, e.g. once the mix graph has warmed up
+    void resetRealtimeViolations();
+
+    /// Set whether each violation is printed to stderr with a backtrace of its call site, on by default
+    void setRealtimeViolationLogging(bool value);
+
+    namespace detail {
+        /// Whether the calling thread is currently inside the engine's audio callback
+        [[nodiscard]]
+        bool isAudioThread();
+
+        /// Count and report a real-time violation if called on the audio thread
+        /// @param what description of the offending call, e.g. "allocation"
+        void checkRealtime(const char *what);
+
+        /// Flags the current thread as the audio thread for the lifetime of this object
+        class AudioThreadScope {
+        public:
+            AudioThreadScope();
+            ~AudioThreadScope();
+
+            AudioThreadScope(const AudioThreadScope &) = delete;
+            AudioThreadScope &operator=(const AudioThreadScope &) = delete;
+        private:
+            bool m_wasAudioThread;
+        };
+    }
+}
@@ -0,0 +1,192 @@
+#include "RealtimeThread.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(__EMSCRIPTEN__)
+#define INSOUND_MXCSR 1
+#include <xmmintrin.h>
+#elif (defined(__aarch64__) || defined(__arm__)) && (defined(__GNUC__) || defined(__clang__))
+#define INSOUND_FPCR 1
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#define INSOUND_POSIX_THREADS 1
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace insound::detail {
+#if INSOUND_MXCSR
+    static constexpr uint32_t FlushDenormalBits = 0x8040; // flush-to-zero and denormals-are-zero
+
+    static uint32_t getControlWord() { return _mm_getcsr(); }
+    static void setControlWord(const uint32_t value) { _mm_setcsr(value); }
+#elif INSOUND_FPCR
+    static constexpr uint32_t FlushDenormalBits = 1u << 24; // flush-to-zero, also applies to inputs
+
+    static uint32_t getControlWord()
+    {
+#if defined(__aarch64__)
+        uint64_t value;
+        __asm__ volatile("mrs %0, fpcr" : "=r"(value));
+        return static_cast<uint32_t>(value);
+#else
+        uint32_t value;
+        __asm__ volatile("vmrs %0, fpscr" : "=r"(value));
+        return value;
+#endif
+    }
+
+    static void setControlWord(const uint32_t value)
+    {
+#if defined(__aarch64__)
+        __asm__ volatile("msr fpcr, %0" : : "r"(static_cast<uint64_t>(value)));
+#else
+        __asm__ volatile("vmsr fpscr, %0" : : "r"(value));
+#endif
+    }
+#endif
+
+    bool canFlushDenormals()
+    {
+#if INSOUND_MXCSR || INSOUND_FPCR
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    DenormalScope::DenormalScope(const bool enable) : m_previous(), m_enabled(enable && canFlushDenormals())
+    {
+#if INSOUND_MXCSR || INSOUND_FPCR
+        if (m_enabled)
+        {
+            m_previous = getControlWord();
+            setControlWord(m_previous | FlushDenormalBits);
+        }
+#endif
+    }
+
+    DenormalScope::~DenormalScope()
+    {
+#if INSOUND_MXCSR || INSOUND_FPCR
+        if (m_enabled)
+            setControlWord(m_previous);
+#endif
+    }
+
+    bool setThreadRealtimePriority(const int priority)
+    {
+#if defined(_WIN32)
+        const auto level = priority > 66 ? THREAD_PRIORITY_TIME_CRITICAL :
+            priority > 33 ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_ABOVE_NORMAL;
+        return SetThreadPriority(GetCurrentThread(), level) != 0;
+#elif INSOUND_POSIX_THREADS
+        sched_param param{};
+        param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO),
+            sched_get_priority_max(SCHED_FIFO));
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+        (void)priority;
+        return false;
+#endif
+    }
+
+    bool setThreadAffinity(const int core)
+    {
+        if (core < 0)
+            return false;
+#if defined(_WIN32)
+        if (core >= static_cast<int>(sizeof(DWORD_PTR) * 8))
+            return false;
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif INSOUND_POSIX_THREADS && defined(__linux__)
+        if (core >= CPU_SETSIZE)
+            return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0; // 0 is the calling thread
+#else
+        return false;
+#endif
+    }
+
+    bool ThreadSettings::save()
+    {
+#if defined(_WIN32)
+        m_priority = GetThreadPriority(GetCurrentThread());
+        m_saved = m_priority != THREAD_PRIORITY_ERROR_RETURN;
+#elif INSOUND_POSIX_THREADS
+        sched_param param{};
+        m_saved = pthread_getschedparam(pthread_self(), &m_policy, &param) == 0;
+        m_priority = param.sched_priority;
+#if defined(__linux__)
+        static_assert(sizeof(cpu_set_t) <= sizeof(m_affinity), "ThreadSettings can't hold a cpu_set_t");
+        m_saved = m_saved && sched_getaffinity(0, sizeof(cpu_set_t), reinterpret_cast<cpu_set_t *>(m_affinity)) == 0;
+#endif
+#else
+        m_saved = false;
+#endif
+        return m_saved;
+    }
+
+    bool ThreadSettings::restorePriority() const
+    {
+        if (!m_saved)
+            return false;
+#if defined(_WIN32)
+        return SetThreadPriority(GetCurrentThread(), m_priority) != 0;
+#elif INSOUND_POSIX_THREADS
+        sched_param param{};
+        param.sched_priority = m_priority;
+        return pthread_setschedparam(pthread_self(), m_policy, &param) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool ThreadSettings::restoreAffinity() const
+    {
+        if (!m_saved)
+            return false;
+#if defined(_WIN32)
+        DWORD_PTR process, system;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system))
+            return false;
+        return SetThreadAffinityMask(GetCurrentThread(), process) != 0;
+#elif INSOUND_POSIX_THREADS && defined(__linux__)
+        return sched_setaffinity(0, sizeof(cpu_set_t), reinterpret_cast<const cpu_set_t *>(m_affinity)) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool lockMemory(const void *data, const size_t size)
+    {
+        if (!data || size == 0)
+            return false;
+#if defined(_WIN32)
+        return VirtualLock(const_cast<void *>(data), size) != 0;
+#elif INSOUND_POSIX_THREADS
+        return mlock(data, size) == 0;
+#else
+        return false;
+#endif
+    }
+
+    void unlockMemory(const void *data, const size_t size)
+    {
+        if (!data || size == 0)
+            return;
+#if defined(_WIN32)
+        VirtualUnlock(const_cast<void *>(data), size);
+#elif INSOUND_POSIX_THREADS
+        munlock(data, size);
+#endif
+    }
+}
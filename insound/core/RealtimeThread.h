@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// Platform calls that prepare the thread the mixer runs on, see `Engine::setRealtimeOptions`. Each returns false
+/// where the platform has no such control, or the process lacks permission for it.
+namespace insound::detail {
+    /// Whether the CPU can flush denormal floats to zero, see `DenormalScope`
+    [[nodiscard]]
+    bool canFlushDenormals();
+
+    /// Flushes denormal floats to zero on the current thread for the lifetime of this object (FTZ and DAZ on x86,
+    /// FZ on ARM), then restores the thread's previous mode. Decaying feedback, e.g. a delay tail, otherwise
+    /// produces denormals that are many times slower to compute.
+    class DenormalScope {
+    public:
+        /// @param enable whether to flush, a disabled scope leaves the mode as is
+        explicit DenormalScope(bool enable);
+        ~DenormalScope();
+
+        DenormalScope(const DenormalScope &) = delete;
+        DenormalScope &operator=(const DenormalScope &) = delete;
+    private:
+        uint32_t m_previous; ///< floating-point control word to restore
+        bool m_enabled;
+    };
+
+    /// Raise the current thread to a real-time priority: SCHED_FIFO on POSIX. Windows has no real-time priorities
+    /// for a thread, so 1 to 33 map to above normal, 34 to 66 to highest, and 67 to 99 to time critical.
+    /// @param priority SCHED_FIFO priority from 1 to 99, clamped to the range the system allows
+    bool setThreadRealtimePriority(int priority);
+
+    /// Pin the current thread to one CPU core. Not supported on Apple platforms, which don't expose affinity.
+    /// @param core index of the core
+    bool setThreadAffinity(int core);
+
+    /// A thread's scheduling and core affinity, saved before `setThreadRealtimePriority` or `setThreadAffinity`
+    /// changes them, to restore afterward. Only applies to the thread that saved it.
+    class ThreadSettings {
+    public:
+        ThreadSettings() : m_policy(), m_priority(), m_affinity(), m_saved() { }
+
+        /// Save the current thread's settings
+        /// @returns whether they could be read, restoring fails otherwise
+        bool save();
+
+        /// Restore the saved scheduling policy and priority to the current thread
+        bool restorePriority() const;
+
+        /// Restore the saved affinity to the current thread. Windows can't read a thread's affinity, so it's
+        /// restored to the process's, which threads start with.
+        bool restoreAffinity() const;
+
+    private:
+        int m_policy;
+        int m_priority;
+        uint64_t m_affinity[16]; ///< mask of cores, up to 1024
+        bool m_saved;
+    };
+
+    /// Lock memory into physical memory so accessing it never page-faults. Subject to the process's lock limit,
+    /// e.g. `RLIMIT_MEMLOCK` on Linux.
+    bool lockMemory(const void *data, size_t size);
+
+    /// Unlock memory locked with `lockMemory`, before it's freed. Locks apply to whole pages, so this also unlocks
+    /// locked memory that shares a page with it.
+    void unlockMemory(const void *data, size_t size);
+}
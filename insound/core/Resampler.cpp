@@ -0,0 +1,489 @@
+#include "Resampler.h"
+
+#include "AlignedVector.h"
+#include "CpuIntrinsics.h"
+#include "Error.h"
+#include "SampleConversion.h"
+
+#include "external/miniaudio_resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <numeric>
+
+namespace insound {
+    static constexpr double Pi = 3.14159265358979323846;
+
+    /// Maximum number of filter phases. Common rate pairs (e.g. 44100 <-> 48000 => 160 phases) reduce to fewer
+    /// than this, and are exact; unusual ratios snap to the nearest of `MaxPhases` sub-sample offsets.
+    static constexpr uint32_t MaxPhases = 1024;
+    static constexpr int MaxTaps = 512;
+
+    /// Number of input frames buffered per channel, in addition to the filter length
+    static constexpr uint64_t BlockFrames = 1024;
+
+    struct FilterParams {
+        int taps;       ///< taps per phase at a 1:1 ratio, scaled up when downsampling
+        double beta;    ///< Kaiser window shape, higher values trade transition width for stopband attenuation
+        double rolloff; ///< cutoff relative to the lower Nyquist frequency
+    };
+
+    static FilterParams getFilterParams(const ResampleQuality quality)
+    {
+        switch(quality)
+        {
+            case ResampleQuality::Low:    return {8,  5.0, .85};
+            case ResampleQuality::Medium: return {16, 6.5, .90};
+            case ResampleQuality::High:   return {32, 8.6, .94};
+            case ResampleQuality::Best:   return {64, 10.5, .96};
+            default:                      return {16, 6.5, .90};
+        }
+    }
+
+    /// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+    static double besselI0(const double x)
+    {
+        const auto q = x * x * .25;
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 64; ++k)
+        {
+            term *= q / (static_cast<double>(k) * k);
+            sum += term;
+            if (term < sum * 1e-17)
+                break;
+        }
+
+        return sum;
+    }
+
+    static double sinc(const double x)
+    {
+        if (std::abs(x) < 1e-12)
+            return 1.0;
+        const auto px = Pi * x;
+        return std::sin(px) / px;
+    }
+
+    /// Dot product of a phase's coefficients with input history
+    /// @param coefs  16-byte aligned coefficients
+    /// @param input  input samples, no alignment required
+    /// @param count  number of taps, must be a multiple of 4
+    static float dot(const float *coefs, const float *input, const int count)
+    {
+        int i = 0;
+#if     INSOUND_AVX
+        auto acc0 = _mm256_setzero_ps();
+        auto acc1 = _mm256_setzero_ps();
+        for (; i <= count - 16; i += 16)
+        {
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(coefs + i), _mm256_loadu_ps(input + i)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(coefs + i + 8), _mm256_loadu_ps(input + i + 8)));
+        }
+
+        const auto acc = _mm256_add_ps(acc0, acc1);
+        auto sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        for (; i <= count - 4; i += 4)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(coefs + i), _mm_loadu_ps(input + i)));
+        }
+
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(sum);
+#elif   INSOUND_SSE
+        auto acc0 = _mm_setzero_ps();
+        auto acc1 = _mm_setzero_ps();
+        auto acc2 = _mm_setzero_ps();
+        auto acc3 = _mm_setzero_ps();
+        for (; i <= count - 16; i += 16)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_load_ps(coefs + i), _mm_loadu_ps(input + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_load_ps(coefs + i + 4), _mm_loadu_ps(input + i + 4)));
+            acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_load_ps(coefs + i + 8), _mm_loadu_ps(input + i + 8)));
+            acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_load_ps(coefs + i + 12), _mm_loadu_ps(input + i + 12)));
+        }
+        for (; i <= count - 4; i += 4)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_load_ps(coefs + i), _mm_loadu_ps(input + i)));
+        }
+
+        auto sum = _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(sum);
+#elif   INSOUND_WASM_SIMD
+        auto acc0 = wasm_f32x4_splat(0);
+        auto acc1 = wasm_f32x4_splat(0);
+        auto acc2 = wasm_f32x4_splat(0);
+        auto acc3 = wasm_f32x4_splat(0);
+        for (; i <= count - 16; i += 16)
+        {
+            acc0 = wasm_f32x4_add(acc0, wasm_f32x4_mul(wasm_v128_load(coefs + i), wasm_v128_load(input + i)));
+            acc1 = wasm_f32x4_add(acc1, wasm_f32x4_mul(wasm_v128_load(coefs + i + 4), wasm_v128_load(input + i + 4)));
+            acc2 = wasm_f32x4_add(acc2, wasm_f32x4_mul(wasm_v128_load(coefs + i + 8), wasm_v128_load(input + i + 8)));
+            acc3 = wasm_f32x4_add(acc3, wasm_f32x4_mul(wasm_v128_load(coefs + i + 12), wasm_v128_load(input + i + 12)));
+        }
+        for (; i <= count - 4; i += 4)
+        {
+            acc0 = wasm_f32x4_add(acc0, wasm_f32x4_mul(wasm_v128_load(coefs + i), wasm_v128_load(input + i)));
+        }
+
+        const auto sum = wasm_f32x4_add(wasm_f32x4_add(acc0, acc1), wasm_f32x4_add(acc2, acc3));
+        return wasm_f32x4_extract_lane(sum, 0) + wasm_f32x4_extract_lane(sum, 1) +
+            wasm_f32x4_extract_lane(sum, 2) + wasm_f32x4_extract_lane(sum, 3);
+#elif   INSOUND_ARM_NEON
+        auto acc0 = vdupq_n_f32(0);
+        auto acc1 = vdupq_n_f32(0);
+        auto acc2 = vdupq_n_f32(0);
+        auto acc3 = vdupq_n_f32(0);
+        for (; i <= count - 16; i += 16)
+        {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(coefs + i), vld1q_f32(input + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(coefs + i + 4), vld1q_f32(input + i + 4));
+            acc2 = vmlaq_f32(acc2, vld1q_f32(coefs + i + 8), vld1q_f32(input + i + 8));
+            acc3 = vmlaq_f32(acc3, vld1q_f32(coefs + i + 12), vld1q_f32(input + i + 12));
+        }
+        for (; i <= count - 4; i += 4)
+        {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(coefs + i), vld1q_f32(input + i));
+        }
+
+        const auto sum = vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3));
+        const auto pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#else
+        float sum = 0;
+        for (; i < count; ++i)
+        {
+            sum += coefs[i] * input[i];
+        }
+        return sum;
+#endif
+    }
+
+    struct Resampler::Impl {
+        int channels{}, inFreq{}, outFreq{}, taps{};
+        uint32_t up{};       ///< reduced ratio numerator: number of output phases per `down` input frames
+        uint32_t down{};     ///< reduced ratio denominator: input frames advanced per `up` output frames
+        uint32_t phases{};   ///< number of rows in the filter bank
+        uint32_t phase{};    ///< current output phase, in [0, up)
+
+        AlignedVector<float, 16> coefs;   ///< filter bank, `phases` rows of `taps` coefficients
+        AlignedVector<float, 16> history; ///< planar input history, `capacity` frames per channel
+        uint64_t capacity{};  ///< frames per channel in history
+        uint64_t buffered{};  ///< frames per channel filled in history
+        uint64_t pos{};       ///< start of the next output's filter window in history
+
+        [[nodiscard]]
+        const float *row(const uint32_t outPhase) const
+        {
+            return coefs.data() + static_cast<uint64_t>(outPhase) * phases / up * taps;
+        }
+
+        void append(const float *input, const uint64_t frames)
+        {
+            const auto data = history.data();
+            if (!input)
+            {
+                for (int c = 0; c < channels; ++c)
+                    std::memset(data + c * capacity + buffered, 0, frames * sizeof(float));
+            }
+            else if (channels == 2)
+            {
+                deinterleaveStereo(input, data + buffered, data + capacity + buffered, frames);
+            }
+            else if (channels == 1)
+            {
+                std::memcpy(data + buffered, input, frames * sizeof(float));
+            }
+            else
+            {
+                for (int c = 0; c < channels; ++c)
+                {
+                    auto dest = data + c * capacity + buffered;
+                    for (uint64_t i = 0; i < frames; ++i)
+                        dest[i] = input[i * channels + c];
+                }
+            }
+
+            buffered += frames;
+        }
+
+        /// Drop history before the current filter window, skipping input frames if the window lies beyond it
+        /// @returns number of input frames skipped
+        uint64_t compact(const uint64_t inputAvailable)
+        {
+            if (pos >= buffered)
+            {
+                const auto skip = std::min(pos - buffered, inputAvailable);
+                pos -= buffered + skip;
+                buffered = 0;
+                return skip;
+            }
+
+            if (pos > 0)
+            {
+                const auto remaining = buffered - pos;
+                const auto data = history.data();
+                for (int c = 0; c < channels; ++c)
+                    std::memmove(data + c * capacity, data + c * capacity + pos, remaining * sizeof(float));
+                buffered = remaining;
+                pos = 0;
+            }
+
+            return 0;
+        }
+    };
+
+    Resampler::Resampler() : m(new Impl)
+    {
+    }
+
+    Resampler::~Resampler()
+    {
+        delete m;
+    }
+
+    bool Resampler::init(const int channels, const int inFreq, const int outFreq, const ResampleQuality quality)
+    {
+        if (channels <= 0 || inFreq <= 0 || outFreq <= 0)
+        {
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "channels and sample rates must be greater than 0");
+            return false;
+        }
+
+        const auto divisor = std::gcd(inFreq, outFreq);
+        const auto params = getFilterParams(quality);
+
+        // When downsampling, the cutoff moves down to the output's Nyquist frequency, so the filter widens to keep
+        // the same transition band relative to it.
+        const auto ratio = std::min(1.0, static_cast<double>(outFreq) / inFreq);
+        auto taps = static_cast<int>(std::ceil(params.taps / ratio));
+        taps = std::min((taps + 3) & ~3, MaxTaps); // multiple of 4 for the vectorized dot product
+
+        m->channels = channels;
+        m->inFreq = inFreq;
+        m->outFreq = outFreq;
+        m->taps = taps;
+        m->up = static_cast<uint32_t>(outFreq / divisor);
+        m->down = static_cast<uint32_t>(inFreq / divisor);
+        m->phases = std::min(m->up, MaxPhases);
+
+        // Build a Kaiser-windowed sinc filter bank, one row per fractional offset, each normalized to unity DC gain
+        const auto cutoff = params.rolloff * ratio;
+        const auto halfTaps = taps / 2;
+        const auto windowNorm = 1.0 / besselI0(params.beta);
+        m->coefs.resize(static_cast<size_t>(m->phases) * taps);
+        for (uint32_t p = 0; p < m->phases; ++p)
+        {
+            const auto frac = static_cast<double>(p) / m->phases;
+            const auto row = m->coefs.data() + static_cast<size_t>(p) * taps;
+
+            double sum = 0;
+            for (int k = 0; k < taps; ++k)
+            {
+                const auto t = k - (halfTaps - 1) - frac;
+                const auto x = t / halfTaps;
+                const auto window = (x > -1.0 && x < 1.0) ?
+                    besselI0(params.beta * std::sqrt(1.0 - x * x)) * windowNorm : 0.0;
+                const auto h = cutoff * sinc(cutoff * t) * window;
+                row[k] = static_cast<float>(h);
+                sum += h;
+            }
+
+            const auto norm = static_cast<float>(1.0 / sum);
+            for (int k = 0; k < taps; ++k)
+                row[k] *= norm;
+        }
+
+        m->capacity = taps + BlockFrames;
+        m->history.resize(m->capacity * channels);
+        reset();
+        return true;
+    }
+
+    void Resampler::reset()
+    {
+        std::fill(m->history.begin(), m->history.end(), 0.f);
+
+        // Pre-roll silence so that the first output frame is centered on the first input frame
+        m->buffered = m->taps / 2 - 1;
+        m->pos = 0;
+        m->phase = 0;
+    }
+
+    void Resampler::process(const float *input, uint64_t *inFrames, float *output, uint64_t *outFrames)
+    {
+        const auto inCount = *inFrames;
+        const auto outCount = *outFrames;
+        const auto channels = m->channels;
+        const auto taps = m->taps;
+
+        uint64_t inUsed = 0, outDone = 0;
+        while (true)
+        {
+            // Produce every output frame whose filter window is fully buffered
+            const auto history = m->history.data();
+            while (outDone < outCount && m->pos + taps <= m->buffered)
+            {
+                const auto coefs = m->row(m->phase);
+                const auto out = output + outDone * channels;
+                for (int c = 0; c < channels; ++c)
+                    out[c] = dot(coefs, history + c * m->capacity + m->pos, taps);
+
+                m->phase += m->down;
+                m->pos += m->phase / m->up;
+                m->phase %= m->up;
+                ++outDone;
+            }
+
+            if (outDone == outCount || inUsed == inCount)
+                break;
+
+            // Refill history with more input
+            inUsed += m->compact(inCount - inUsed);
+            const auto count = std::min(m->capacity - m->buffered, inCount - inUsed);
+            m->append(input ? input + inUsed * channels : nullptr, count);
+            inUsed += count;
+        }
+
+        *inFrames = inUsed;
+        *outFrames = outDone;
+    }
+
+    uint64_t Resampler::requiredInputFrames(const uint64_t outFrames) const
+    {
+        if (outFrames == 0)
+            return 0;
+
+        const auto end = m->pos + (m->phase + (outFrames - 1) * m->down) / m->up + m->taps;
+        return end > m->buffered ? end - m->buffered : 0;
+    }
+
+    uint64_t Resampler::expectedOutputFrames(const uint64_t inFrames) const
+    {
+        const auto total = m->buffered + inFrames;
+        if (total < m->pos + m->taps)
+            return 0;
+
+        // count output frames k where the window start `pos + (phase + k * down) / up` is at most `available`
+        const auto available = total - m->taps - m->pos;
+        return ((available + 1) * m->up - m->phase + m->down - 1) / m->down;
+    }
+
+    uint64_t Resampler::inputLatency() const
+    {
+        return m->taps / 2;
+    }
+
+    int Resampler::taps() const
+    {
+        return m->taps;
+    }
+
+    int Resampler::channels() const
+    {
+        return m->channels;
+    }
+
+    int Resampler::inFreq() const
+    {
+        return m->inFreq;
+    }
+
+    int Resampler::outFreq() const
+    {
+        return m->outFreq;
+    }
+}
+
+// ===== miniaudio resampling backend =========================================
+
+static ma_result insound_ma_resampler_get_heap_size(void *userData, const ma_resampler_config *config,
+    size_t *outHeapSize)
+{
+    *outHeapSize = sizeof(insound::Resampler);
+    return MA_SUCCESS;
+}
+
+static ma_result insound_ma_resampler_init(void *userData, const ma_resampler_config *config, void *heap,
+    ma_resampling_backend **outBackend)
+{
+    if (config->format != ma_format_f32)
+        return MA_FORMAT_NOT_SUPPORTED;
+
+    const auto resampler = new (heap) insound::Resampler;
+    if (!resampler->init(static_cast<int>(config->channels), static_cast<int>(config->sampleRateIn),
+        static_cast<int>(config->sampleRateOut),
+        static_cast<insound::ResampleQuality>(reinterpret_cast<intptr_t>(userData))))
+    {
+        resampler->~Resampler();
+        return MA_INVALID_ARGS;
+    }
+
+    *outBackend = resampler;
+    return MA_SUCCESS;
+}
+
+static void insound_ma_resampler_uninit(void *userData, ma_resampling_backend *backend,
+    const ma_allocation_callbacks *allocationCallbacks)
+{
+    static_cast<insound::Resampler *>(backend)->~Resampler(); // heap is freed by miniaudio
+}
+
+static ma_result insound_ma_resampler_process(void *userData, ma_resampling_backend *backend,
+    const void *framesIn, ma_uint64 *frameCountIn, void *framesOut, ma_uint64 *frameCountOut)
+{
+    uint64_t inFrames = *frameCountIn, outFrames = *frameCountOut;
+    static_cast<insound::Resampler *>(backend)->process(static_cast<const float *>(framesIn), &inFrames,
+        static_cast<float *>(framesOut), &outFrames);
+    *frameCountIn = inFrames;
+    *frameCountOut = outFrames;
+    return MA_SUCCESS;
+}
+
+static ma_uint64 insound_ma_resampler_get_input_latency(void *userData, const ma_resampling_backend *backend)
+{
+    return static_cast<const insound::Resampler *>(backend)->inputLatency();
+}
+
+static ma_uint64 insound_ma_resampler_get_output_latency(void *userData, const ma_resampling_backend *backend)
+{
+    const auto resampler = static_cast<const insound::Resampler *>(backend);
+    return resampler->inputLatency() * resampler->outFreq() / resampler->inFreq();
+}
+
+static ma_result insound_ma_resampler_get_required_input_frame_count(void *userData,
+    const ma_resampling_backend *backend, ma_uint64 outputFrameCount, ma_uint64 *inputFrameCount)
+{
+    *inputFrameCount = static_cast<const insound::Resampler *>(backend)->requiredInputFrames(outputFrameCount);
+    return MA_SUCCESS;
+}
+
+static ma_result insound_ma_resampler_get_expected_output_frame_count(void *userData,
+    const ma_resampling_backend *backend, ma_uint64 inputFrameCount, ma_uint64 *outputFrameCount)
+{
+    *outputFrameCount = static_cast<const insound::Resampler *>(backend)->expectedOutputFrames(inputFrameCount);
+    return MA_SUCCESS;
+}
+
+static ma_result insound_ma_resampler_reset(void *userData, ma_resampling_backend *backend)
+{
+    static_cast<insound::Resampler *>(backend)->reset();
+    return MA_SUCCESS;
+}
+
+ma_resampling_backend_vtable g_ma_resampling_backend_vtable_insound = {
+    insound_ma_resampler_get_heap_size,
+    insound_ma_resampler_init,
+    insound_ma_resampler_uninit,
+    insound_ma_resampler_process,
+    nullptr, // onSetRate: rate changes are not supported
+    insound_ma_resampler_get_input_latency,
+    insound_ma_resampler_get_output_latency,
+    insound_ma_resampler_get_required_input_frame_count,
+    insound_ma_resampler_get_expected_output_frame_count,
+    insound_ma_resampler_reset,
+};
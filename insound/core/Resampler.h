@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+namespace insound {
+
+    /// Quality tiers of the polyphase resampler. Higher tiers use longer filters, with a flatter passband,
+    /// narrower transition band and stronger stopband attenuation, at a proportionally higher cost per frame.
+    enum class ResampleQuality {
+        Low,    ///<  8 taps per phase, cheapest, for many simultaneous real-time voices
+        Medium, ///< 16 taps per phase, default for real-time streaming
+        High,   ///< 32 taps per phase, default for offline asset conversion
+        Best,   ///< 64 taps per phase, for mastering-grade offline conversion
+    };
+
+    /// Polyphase windowed-sinc sample rate converter for interleaved float32 data.
+    /// Filter coefficients for each phase of the rational rate ratio are precomputed on `init`, so processing only
+    /// performs vectorized dot products between one phase's coefficients and the input history.
+    /// Output frame `n` is aligned to input time `n * inFreq / outFreq`, so the filter delays output by
+    /// `inputLatency()` frames of lookahead; pass `nullptr` input to `process` to flush the tail with silence.
+    class Resampler {
+    public:
+        Resampler();
+        ~Resampler();
+
+        Resampler(const Resampler &) = delete;
+        Resampler &operator=(const Resampler &) = delete;
+
+        /// Initialize the resampler, building its filter bank. Allocates; call off of the audio thread.
+        /// @param channels  number of interleaved channels
+        /// @param inFreq    input sample rate
+        /// @param outFreq   output sample rate
+        /// @param quality   filter quality tier
+        /// @returns whether operation succeeded, check `popError()` for details on `false`
+        bool init(int channels, int inFreq, int outFreq, ResampleQuality quality = ResampleQuality::Medium);
+
+        /// Clear the input history and phase, e.g. after seeking the source
+        void reset();
+
+        /// Resample a block of frames. Does not allocate.
+        /// @param input      interleaved input frames, or nullptr to feed silence
+        /// @param inFrames   [in/out] frames available in `input`, receives the number of frames consumed
+        /// @param output     buffer to write interleaved output frames to
+        /// @param outFrames  [in/out] capacity of `output` in frames, receives the number of frames written
+        void process(const float *input, uint64_t *inFrames, float *output, uint64_t *outFrames);
+
+        /// @returns number of input frames required to produce `outFrames` output frames from the current state
+        [[nodiscard]] uint64_t requiredInputFrames(uint64_t outFrames) const;
+
+        /// @returns number of output frames that `inFrames` more input frames would produce from the current state
+        [[nodiscard]] uint64_t expectedOutputFrames(uint64_t inFrames) const;
+
+        /// @returns number of input frames of lookahead the filter needs before output is aligned to input
+        [[nodiscard]] uint64_t inputLatency() const;
+
+        /// @returns the filter length in taps
+        [[nodiscard]] int taps() const;
+
+        [[nodiscard]] int channels() const;
+        [[nodiscard]] int inFreq() const;
+        [[nodiscard]] int outFreq() const;
+    private:
+        struct Impl;
+        Impl *m;
+    };
+}
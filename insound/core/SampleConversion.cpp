@@ -0,0 +1,539 @@
+#include "SampleConversion.h"
+
+#include "CpuIntrinsics.h"
+
+#include <cstring>
+
+// Scaling constants match miniaudio's conversion routines, so that results are identical to its generic path
+static constexpr float U8Scale  = 0.00784313725490196078f;    // 0..255 to 0..2
+static constexpr float S16Scale = 0.000030517578125f;         // 1 / 32768
+static constexpr float S24Scale = 0.00000011920928955078125f; // 1 / 8388608
+static constexpr float S32Scale = 0.0000000004656612873077392578125f; // 1 / 2147483648
+
+namespace insound {
+    void convertU8ToF32(const uint8_t *input, float *output, const size_t count)
+    {
+        size_t i = 0;
+#if     INSOUND_AVX2
+        const auto scale = _mm256_set1_ps(U8Scale);
+        const auto one = _mm256_set1_ps(1.f);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto a = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i *>(input + i))));
+            const auto b = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i *>(input + i + 8))));
+            _mm256_storeu_ps(output + i, _mm256_sub_ps(_mm256_mul_ps(a, scale), one));
+            _mm256_storeu_ps(output + i + 8, _mm256_sub_ps(_mm256_mul_ps(b, scale), one));
+        }
+#elif   INSOUND_SSE2
+        const auto zero = _mm_setzero_si128();
+        const auto scale = _mm_set1_ps(U8Scale);
+        const auto one = _mm_set1_ps(1.f);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+            const auto lo = _mm_unpacklo_epi8(bytes, zero);
+            const auto hi = _mm_unpackhi_epi8(bytes, zero);
+            const auto a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+            const auto b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+            const auto c = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+            const auto d = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+            _mm_storeu_ps(output + i, _mm_sub_ps(_mm_mul_ps(a, scale), one));
+            _mm_storeu_ps(output + i + 4, _mm_sub_ps(_mm_mul_ps(b, scale), one));
+            _mm_storeu_ps(output + i + 8, _mm_sub_ps(_mm_mul_ps(c, scale), one));
+            _mm_storeu_ps(output + i + 12, _mm_sub_ps(_mm_mul_ps(d, scale), one));
+        }
+#elif   INSOUND_WASM_SIMD
+        const auto scale = wasm_f32x4_splat(U8Scale);
+        const auto one = wasm_f32x4_splat(1.f);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto bytes = wasm_v128_load(input + i);
+            const auto lo = wasm_u16x8_extend_low_u8x16(bytes);
+            const auto hi = wasm_u16x8_extend_high_u8x16(bytes);
+            const auto a = wasm_f32x4_convert_u32x4(wasm_u32x4_extend_low_u16x8(lo));
+            const auto b = wasm_f32x4_convert_u32x4(wasm_u32x4_extend_high_u16x8(lo));
+            const auto c = wasm_f32x4_convert_u32x4(wasm_u32x4_extend_low_u16x8(hi));
+            const auto d = wasm_f32x4_convert_u32x4(wasm_u32x4_extend_high_u16x8(hi));
+            wasm_v128_store(output + i, wasm_f32x4_sub(wasm_f32x4_mul(a, scale), one));
+            wasm_v128_store(output + i + 4, wasm_f32x4_sub(wasm_f32x4_mul(b, scale), one));
+            wasm_v128_store(output + i + 8, wasm_f32x4_sub(wasm_f32x4_mul(c, scale), one));
+            wasm_v128_store(output + i + 12, wasm_f32x4_sub(wasm_f32x4_mul(d, scale), one));
+        }
+#elif   INSOUND_ARM_NEON
+        const auto scale = vdupq_n_f32(U8Scale);
+        const auto one = vdupq_n_f32(1.f);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto bytes = vld1q_u8(input + i);
+            const auto lo = vmovl_u8(vget_low_u8(bytes));
+            const auto hi = vmovl_u8(vget_high_u8(bytes));
+            const auto a = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo)));
+            const auto b = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo)));
+            const auto c = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi)));
+            const auto d = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)));
+            vst1q_f32(output + i, vsubq_f32(vmulq_f32(a, scale), one));
+            vst1q_f32(output + i + 4, vsubq_f32(vmulq_f32(b, scale), one));
+            vst1q_f32(output + i + 8, vsubq_f32(vmulq_f32(c, scale), one));
+            vst1q_f32(output + i + 12, vsubq_f32(vmulq_f32(d, scale), one));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            output[i] = static_cast<float>(input[i]) * U8Scale - 1.f;
+        }
+    }
+
+    void convertS16ToF32(const int16_t *input, float *output, const size_t count)
+    {
+        size_t i = 0;
+#if     INSOUND_AVX2
+        const auto scale = _mm256_set1_ps(S16Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i))));
+            const auto b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 8))));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(a, scale));
+            _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(b, scale));
+        }
+#elif   INSOUND_SSE2
+        const auto scale = _mm_set1_ps(S16Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+            const auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 8));
+
+            // sign-extend by placing each sample in the upper half of a 32-bit lane, then shifting it back down
+            const auto a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v0, v0), 16));
+            const auto b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v0, v0), 16));
+            const auto c = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v1, v1), 16));
+            const auto d = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v1, v1), 16));
+            _mm_storeu_ps(output + i, _mm_mul_ps(a, scale));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(b, scale));
+            _mm_storeu_ps(output + i + 8, _mm_mul_ps(c, scale));
+            _mm_storeu_ps(output + i + 12, _mm_mul_ps(d, scale));
+        }
+#elif   INSOUND_WASM_SIMD
+        const auto scale = wasm_f32x4_splat(S16Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto v0 = wasm_v128_load(input + i);
+            const auto v1 = wasm_v128_load(input + i + 8);
+            const auto a = wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(v0));
+            const auto b = wasm_f32x4_convert_i32x4(wasm_i32x4_extend_high_i16x8(v0));
+            const auto c = wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(v1));
+            const auto d = wasm_f32x4_convert_i32x4(wasm_i32x4_extend_high_i16x8(v1));
+            wasm_v128_store(output + i, wasm_f32x4_mul(a, scale));
+            wasm_v128_store(output + i + 4, wasm_f32x4_mul(b, scale));
+            wasm_v128_store(output + i + 8, wasm_f32x4_mul(c, scale));
+            wasm_v128_store(output + i + 12, wasm_f32x4_mul(d, scale));
+        }
+#elif   INSOUND_ARM_NEON
+        const auto scale = vdupq_n_f32(S16Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto v0 = vld1q_s16(input + i);
+            const auto v1 = vld1q_s16(input + i + 8);
+            const auto a = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v0)));
+            const auto b = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v0)));
+            const auto c = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v1)));
+            const auto d = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v1)));
+            vst1q_f32(output + i, vmulq_f32(a, scale));
+            vst1q_f32(output + i + 4, vmulq_f32(b, scale));
+            vst1q_f32(output + i + 8, vmulq_f32(c, scale));
+            vst1q_f32(output + i + 12, vmulq_f32(d, scale));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            output[i] = static_cast<float>(input[i]) * S16Scale;
+        }
+    }
+
+    /// Assemble a packed 24-bit sample into the upper bits of an int32, then arithmetic-shift for sign extension
+    static int32_t readS24(const uint8_t *sample)
+    {
+        return static_cast<int32_t>(
+            (static_cast<uint32_t>(sample[0]) << 8) |
+            (static_cast<uint32_t>(sample[1]) << 16) |
+            (static_cast<uint32_t>(sample[2]) << 24)) >> 8;
+    }
+
+    void convertS24ToF32(const uint8_t *input, float *output, const size_t count)
+    {
+        size_t i = 0;
+#if     INSOUND_SSSE3
+        // Moves each 3-byte sample into the top three bytes of a 32-bit lane
+        const auto shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const auto scale = _mm_set1_ps(S24Scale);
+
+        // each 16-byte load consumes 12 bytes, so keep a little headroom to avoid reading past the end of input
+        for (; i + 16 + 2 <= count; i += 16)
+        {
+            const auto src = input + i * 3;
+            const auto a = _mm_srai_epi32(_mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)), shuffle), 8);
+            const auto b = _mm_srai_epi32(_mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 12)), shuffle), 8);
+            const auto c = _mm_srai_epi32(_mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 24)), shuffle), 8);
+            const auto d = _mm_srai_epi32(_mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 36)), shuffle), 8);
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+            _mm_storeu_ps(output + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(c), scale));
+            _mm_storeu_ps(output + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(d), scale));
+        }
+#elif   INSOUND_SSE2
+        // no byte shuffle available: byte-shift each sample to the bottom of the register, gather the low lanes
+        const auto scale = _mm_set1_ps(S24Scale);
+        const auto gather = [](const uint8_t *src) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+            const auto ab = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+            const auto cd = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+            return _mm_srai_epi32(_mm_slli_epi32(_mm_unpacklo_epi64(ab, cd), 8), 8);
+        };
+
+        // each 16-byte load consumes 12 bytes, so keep a little headroom to avoid reading past the end of input
+        for (; i + 16 + 2 <= count; i += 16)
+        {
+            const auto src = input + i * 3;
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(gather(src)), scale));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(gather(src + 12)), scale));
+            _mm_storeu_ps(output + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(gather(src + 24)), scale));
+            _mm_storeu_ps(output + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(gather(src + 36)), scale));
+        }
+#elif   INSOUND_WASM_SIMD
+        const auto scale = wasm_f32x4_splat(S24Scale);
+        const auto shuffle = wasm_i8x16_make(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        for (; i + 16 + 2 <= count; i += 16)
+        {
+            const auto src = input + i * 3;
+            const auto a = wasm_i32x4_shr(wasm_i8x16_swizzle(wasm_v128_load(src), shuffle), 8);
+            const auto b = wasm_i32x4_shr(wasm_i8x16_swizzle(wasm_v128_load(src + 12), shuffle), 8);
+            const auto c = wasm_i32x4_shr(wasm_i8x16_swizzle(wasm_v128_load(src + 24), shuffle), 8);
+            const auto d = wasm_i32x4_shr(wasm_i8x16_swizzle(wasm_v128_load(src + 36), shuffle), 8);
+            wasm_v128_store(output + i, wasm_f32x4_mul(wasm_f32x4_convert_i32x4(a), scale));
+            wasm_v128_store(output + i + 4, wasm_f32x4_mul(wasm_f32x4_convert_i32x4(b), scale));
+            wasm_v128_store(output + i + 8, wasm_f32x4_mul(wasm_f32x4_convert_i32x4(c), scale));
+            wasm_v128_store(output + i + 12, wasm_f32x4_mul(wasm_f32x4_convert_i32x4(d), scale));
+        }
+#elif   INSOUND_ARM_NEON
+        const auto scale = vdupq_n_f32(S24Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            // de-interleave the low, middle and high bytes of 16 samples
+            const auto bytes = vld3q_u8(input + i * 3);
+
+            const auto loLow = vorrq_u16(vmovl_u8(vget_low_u8(bytes.val[0])),
+                vshlq_n_u16(vmovl_u8(vget_low_u8(bytes.val[1])), 8));
+            const auto loHigh = vorrq_u16(vmovl_u8(vget_high_u8(bytes.val[0])),
+                vshlq_n_u16(vmovl_u8(vget_high_u8(bytes.val[1])), 8));
+            const auto hi = vreinterpretq_s8_u8(bytes.val[2]);
+            const auto hiLow = vmovl_s8(vget_low_s8(hi));
+            const auto hiHigh = vmovl_s8(vget_high_s8(hi));
+
+            const auto a = vorrq_s32(vshll_n_s16(vget_low_s16(hiLow), 16),
+                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(loLow))));
+            const auto b = vorrq_s32(vshll_n_s16(vget_high_s16(hiLow), 16),
+                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(loLow))));
+            const auto c = vorrq_s32(vshll_n_s16(vget_low_s16(hiHigh), 16),
+                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(loHigh))));
+            const auto d = vorrq_s32(vshll_n_s16(vget_high_s16(hiHigh), 16),
+                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(loHigh))));
+
+            vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(a), scale));
+            vst1q_f32(output + i + 4, vmulq_f32(vcvtq_f32_s32(b), scale));
+            vst1q_f32(output + i + 8, vmulq_f32(vcvtq_f32_s32(c), scale));
+            vst1q_f32(output + i + 12, vmulq_f32(vcvtq_f32_s32(d), scale));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            output[i] = static_cast<float>(readS24(input + i * 3)) * S24Scale;
+        }
+    }
+
+    void convertS32ToF32(const int32_t *input, float *output, const size_t count)
+    {
+        size_t i = 0;
+#if     INSOUND_AVX2
+        const auto scale = _mm256_set1_ps(S32Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto a = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i)));
+            const auto b = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i + 8)));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(a, scale));
+            _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(b, scale));
+        }
+#elif   INSOUND_SSE2
+        const auto scale = _mm_set1_ps(S32Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto a = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)));
+            const auto b = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 4)));
+            const auto c = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 8)));
+            const auto d = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 12)));
+            _mm_storeu_ps(output + i, _mm_mul_ps(a, scale));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(b, scale));
+            _mm_storeu_ps(output + i + 8, _mm_mul_ps(c, scale));
+            _mm_storeu_ps(output + i + 12, _mm_mul_ps(d, scale));
+        }
+#elif   INSOUND_WASM_SIMD
+        const auto scale = wasm_f32x4_splat(S32Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto a = wasm_f32x4_convert_i32x4(wasm_v128_load(input + i));
+            const auto b = wasm_f32x4_convert_i32x4(wasm_v128_load(input + i + 4));
+            const auto c = wasm_f32x4_convert_i32x4(wasm_v128_load(input + i + 8));
+            const auto d = wasm_f32x4_convert_i32x4(wasm_v128_load(input + i + 12));
+            wasm_v128_store(output + i, wasm_f32x4_mul(a, scale));
+            wasm_v128_store(output + i + 4, wasm_f32x4_mul(b, scale));
+            wasm_v128_store(output + i + 8, wasm_f32x4_mul(c, scale));
+            wasm_v128_store(output + i + 12, wasm_f32x4_mul(d, scale));
+        }
+#elif   INSOUND_ARM_NEON
+        const auto scale = vdupq_n_f32(S32Scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto a = vcvtq_f32_s32(vld1q_s32(input + i));
+            const auto b = vcvtq_f32_s32(vld1q_s32(input + i + 4));
+            const auto c = vcvtq_f32_s32(vld1q_s32(input + i + 8));
+            const auto d = vcvtq_f32_s32(vld1q_s32(input + i + 12));
+            vst1q_f32(output + i, vmulq_f32(a, scale));
+            vst1q_f32(output + i + 4, vmulq_f32(b, scale));
+            vst1q_f32(output + i + 8, vmulq_f32(c, scale));
+            vst1q_f32(output + i + 12, vmulq_f32(d, scale));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            output[i] = static_cast<float>(input[i]) * S32Scale;
+        }
+    }
+
+    void monoToStereo(const float *input, float *output, const size_t frames)
+    {
+        size_t i = 0;
+#if     INSOUND_SSE
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = _mm_loadu_ps(input + i);
+            const auto b = _mm_loadu_ps(input + i + 4);
+            _mm_storeu_ps(output + i * 2, _mm_unpacklo_ps(a, a));
+            _mm_storeu_ps(output + i * 2 + 4, _mm_unpackhi_ps(a, a));
+            _mm_storeu_ps(output + i * 2 + 8, _mm_unpacklo_ps(b, b));
+            _mm_storeu_ps(output + i * 2 + 12, _mm_unpackhi_ps(b, b));
+        }
+#elif   INSOUND_WASM_SIMD
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = wasm_v128_load(input + i);
+            const auto b = wasm_v128_load(input + i + 4);
+            wasm_v128_store(output + i * 2, wasm_i32x4_shuffle(a, a, 0, 4, 1, 5));
+            wasm_v128_store(output + i * 2 + 4, wasm_i32x4_shuffle(a, a, 2, 6, 3, 7));
+            wasm_v128_store(output + i * 2 + 8, wasm_i32x4_shuffle(b, b, 0, 4, 1, 5));
+            wasm_v128_store(output + i * 2 + 12, wasm_i32x4_shuffle(b, b, 2, 6, 3, 7));
+        }
+#elif   INSOUND_ARM_NEON
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = vld1q_f32(input + i);
+            const auto b = vld1q_f32(input + i + 4);
+            vst2q_f32(output + i * 2, (float32x4x2_t{a, a}));
+            vst2q_f32(output + i * 2 + 8, (float32x4x2_t{b, b}));
+        }
+#endif
+        for (; i < frames; ++i)
+        {
+            output[i * 2] = input[i];
+            output[i * 2 + 1] = input[i];
+        }
+    }
+
+    void stereoToMono(const float *input, float *output, const size_t frames)
+    {
+        size_t i = 0;
+#if     INSOUND_SSE
+        const auto half = _mm_set1_ps(.5f);
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = _mm_loadu_ps(input + i * 2);
+            const auto b = _mm_loadu_ps(input + i * 2 + 4);
+            const auto c = _mm_loadu_ps(input + i * 2 + 8);
+            const auto d = _mm_loadu_ps(input + i * 2 + 12);
+            const auto sum0 = _mm_add_ps(
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            const auto sum1 = _mm_add_ps(
+                _mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1)));
+            _mm_storeu_ps(output + i, _mm_mul_ps(sum0, half));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(sum1, half));
+        }
+#elif   INSOUND_WASM_SIMD
+        const auto half = wasm_f32x4_splat(.5f);
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = wasm_v128_load(input + i * 2);
+            const auto b = wasm_v128_load(input + i * 2 + 4);
+            const auto c = wasm_v128_load(input + i * 2 + 8);
+            const auto d = wasm_v128_load(input + i * 2 + 12);
+            const auto sum0 = wasm_f32x4_add(
+                wasm_i32x4_shuffle(a, b, 0, 2, 4, 6),
+                wasm_i32x4_shuffle(a, b, 1, 3, 5, 7));
+            const auto sum1 = wasm_f32x4_add(
+                wasm_i32x4_shuffle(c, d, 0, 2, 4, 6),
+                wasm_i32x4_shuffle(c, d, 1, 3, 5, 7));
+            wasm_v128_store(output + i, wasm_f32x4_mul(sum0, half));
+            wasm_v128_store(output + i + 4, wasm_f32x4_mul(sum1, half));
+        }
+#elif   INSOUND_ARM_NEON
+        const auto half = vdupq_n_f32(.5f);
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = vld2q_f32(input + i * 2);
+            const auto b = vld2q_f32(input + i * 2 + 8);
+            vst1q_f32(output + i, vmulq_f32(vaddq_f32(a.val[0], a.val[1]), half));
+            vst1q_f32(output + i + 4, vmulq_f32(vaddq_f32(b.val[0], b.val[1]), half));
+        }
+#endif
+        for (; i < frames; ++i)
+        {
+            output[i] = (input[i * 2] + input[i * 2 + 1]) * .5f;
+        }
+    }
+
+    void interleaveStereo(const float *left, const float *right, float *output, const size_t frames)
+    {
+        size_t i = 0;
+#if     INSOUND_SSE
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto l0 = _mm_loadu_ps(left + i);
+            const auto l1 = _mm_loadu_ps(left + i + 4);
+            const auto r0 = _mm_loadu_ps(right + i);
+            const auto r1 = _mm_loadu_ps(right + i + 4);
+            _mm_storeu_ps(output + i * 2, _mm_unpacklo_ps(l0, r0));
+            _mm_storeu_ps(output + i * 2 + 4, _mm_unpackhi_ps(l0, r0));
+            _mm_storeu_ps(output + i * 2 + 8, _mm_unpacklo_ps(l1, r1));
+            _mm_storeu_ps(output + i * 2 + 12, _mm_unpackhi_ps(l1, r1));
+        }
+#elif   INSOUND_WASM_SIMD
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto l0 = wasm_v128_load(left + i);
+            const auto l1 = wasm_v128_load(left + i + 4);
+            const auto r0 = wasm_v128_load(right + i);
+            const auto r1 = wasm_v128_load(right + i + 4);
+            wasm_v128_store(output + i * 2, wasm_i32x4_shuffle(l0, r0, 0, 4, 1, 5));
+            wasm_v128_store(output + i * 2 + 4, wasm_i32x4_shuffle(l0, r0, 2, 6, 3, 7));
+            wasm_v128_store(output + i * 2 + 8, wasm_i32x4_shuffle(l1, r1, 0, 4, 1, 5));
+            wasm_v128_store(output + i * 2 + 12, wasm_i32x4_shuffle(l1, r1, 2, 6, 3, 7));
+        }
+#elif   INSOUND_ARM_NEON
+        for (; i + 8 <= frames; i += 8)
+        {
+            vst2q_f32(output + i * 2, (float32x4x2_t{vld1q_f32(left + i), vld1q_f32(right + i)}));
+            vst2q_f32(output + i * 2 + 8, (float32x4x2_t{vld1q_f32(left + i + 4), vld1q_f32(right + i + 4)}));
+        }
+#endif
+        for (; i < frames; ++i)
+        {
+            output[i * 2] = left[i];
+            output[i * 2 + 1] = right[i];
+        }
+    }
+
+    void deinterleaveStereo(const float *input, float *left, float *right, const size_t frames)
+    {
+        size_t i = 0;
+#if     INSOUND_SSE
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = _mm_loadu_ps(input + i * 2);
+            const auto b = _mm_loadu_ps(input + i * 2 + 4);
+            const auto c = _mm_loadu_ps(input + i * 2 + 8);
+            const auto d = _mm_loadu_ps(input + i * 2 + 12);
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            _mm_storeu_ps(left + i + 4, _mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i + 4, _mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#elif   INSOUND_WASM_SIMD
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = wasm_v128_load(input + i * 2);
+            const auto b = wasm_v128_load(input + i * 2 + 4);
+            const auto c = wasm_v128_load(input + i * 2 + 8);
+            const auto d = wasm_v128_load(input + i * 2 + 12);
+            wasm_v128_store(left + i, wasm_i32x4_shuffle(a, b, 0, 2, 4, 6));
+            wasm_v128_store(right + i, wasm_i32x4_shuffle(a, b, 1, 3, 5, 7));
+            wasm_v128_store(left + i + 4, wasm_i32x4_shuffle(c, d, 0, 2, 4, 6));
+            wasm_v128_store(right + i + 4, wasm_i32x4_shuffle(c, d, 1, 3, 5, 7));
+        }
+#elif   INSOUND_ARM_NEON
+        for (; i + 8 <= frames; i += 8)
+        {
+            const auto a = vld2q_f32(input + i * 2);
+            const auto b = vld2q_f32(input + i * 2 + 8);
+            vst1q_f32(left + i, a.val[0]);
+            vst1q_f32(right + i, a.val[1]);
+            vst1q_f32(left + i + 4, b.val[0]);
+            vst1q_f32(right + i + 4, b.val[1]);
+        }
+#endif
+        for (; i < frames; ++i)
+        {
+            left[i] = input[i * 2];
+            right[i] = input[i * 2 + 1];
+        }
+    }
+
+    void interleave(const float *const *planes, const int channels, float *output, const size_t frames)
+    {
+        if (channels == 1)
+        {
+            std::memcpy(output, planes[0], frames * sizeof(float));
+            return;
+        }
+
+        if (channels == 2)
+        {
+            interleaveStereo(planes[0], planes[1], output, frames);
+            return;
+        }
+
+        for (int c = 0; c < channels; ++c)
+        {
+            const auto plane = planes[c];
+            for (size_t i = 0; i < frames; ++i)
+                output[i * channels + c] = plane[i];
+        }
+    }
+
+    void deinterleave(const float *input, const int channels, float *const *planes, const size_t frames)
+    {
+        if (channels == 1)
+        {
+            std::memcpy(planes[0], input, frames * sizeof(float));
+            return;
+        }
+
+        if (channels == 2)
+        {
+            deinterleaveStereo(input, planes[0], planes[1], frames);
+            return;
+        }
+
+        for (int c = 0; c < channels; ++c)
+        {
+            const auto plane = planes[c];
+            for (size_t i = 0; i < frames; ++i)
+                plane[i] = input[i * channels + c];
+        }
+    }
+}
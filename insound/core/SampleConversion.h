@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// Vectorized sample format and channel layout conversion kernels.
+/// Input and output pointers do not need to be aligned. Unless otherwise noted, input and output must not overlap.
+namespace insound {
+    /// Convert unsigned 8-bit samples to float32 in the range of [-1, 1]
+    /// @param input  samples to convert
+    /// @param output buffer to receive `count` float samples
+    /// @param count  number of samples (not frames) to convert
+    void convertU8ToF32(const uint8_t *input, float *output, size_t count);
+
+    /// Convert signed 16-bit samples to float32 in the range of [-1, 1)
+    void convertS16ToF32(const int16_t *input, float *output, size_t count);
+
+    /// Convert packed, little-endian signed 24-bit samples (3 bytes each) to float32 in the range of [-1, 1)
+    void convertS24ToF32(const uint8_t *input, float *output, size_t count);
+
+    /// Convert signed 32-bit samples to float32 in the range of [-1, 1)
+    void convertS32ToF32(const int32_t *input, float *output, size_t count);
+
+    /// Duplicate each mono sample into an interleaved stereo frame
+    /// @param input  mono samples
+    /// @param output buffer to receive `frames * 2` samples
+    /// @param frames number of frames to convert
+    void monoToStereo(const float *input, float *output, size_t frames);
+
+    /// Average each interleaved stereo frame into a mono sample
+    /// @param input  interleaved stereo samples
+    /// @param output buffer to receive `frames` samples
+    /// @param frames number of frames to convert
+    void stereoToMono(const float *input, float *output, size_t frames);
+
+    /// Interleave two planar channels into stereo frames
+    /// @param left   left channel samples
+    /// @param right  right channel samples
+    /// @param output buffer to receive `frames * 2` interleaved samples
+    /// @param frames number of frames to interleave
+    void interleaveStereo(const float *left, const float *right, float *output, size_t frames);
+
+    /// Split interleaved stereo frames into two planar channels
+    /// @param input  interleaved stereo samples
+    /// @param left   buffer to receive `frames` left channel samples
+    /// @param right  buffer to receive `frames` right channel samples
+    /// @param frames number of frames to deinterleave
+    void deinterleaveStereo(const float *input, float *left, float *right, size_t frames);
+
+    /// Interleave any number of planar channels into frames
+    /// @param planes   one pointer per channel, each to `frames` samples
+    /// @param channels number of channels in `planes`
+    /// @param output   buffer to receive `frames * channels` interleaved samples
+    /// @param frames   number of frames to interleave
+    void interleave(const float *const *planes, int channels, float *output, size_t frames);
+
+    /// Split interleaved frames of any number of channels into planar channels
+    /// @param input    interleaved samples
+    /// @param channels number of channels in each frame
+    /// @param planes   one pointer per channel, each to receive `frames` samples
+    /// @param frames   number of frames to deinterleave
+    void deinterleave(const float *input, int channels, float *const *planes, size_t frames);
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "AlignedVector.h"
+#include "RealtimeThread.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace insound {
+
+    /// Stack of device-sized sample buffers that the mixer hands out to Sources while they read, so a Source only
+    /// holds memory for the duration of its parent's mix. Each level of the mix graph keeps a few buffers in use
+    /// at once, so the arena grows with the depth of the graph rather than with the number of Sources.
+    ///
+    /// Buffers start on a cache line, even when their size isn't a multiple of one, e.g. an odd number of frames, so
+    /// the mix kernels' aligned loads hold for each of them.
+    ///
+    /// `acquire` and `release` are for the mix thread only. `reserve` reallocates, so it must be called while the
+    /// mixer is locked and holds no buffers.
+    class ScratchArena {
+    public:
+        /// Alignment of each buffer in bytes
+        static constexpr size_t Alignment = 64;
+
+        ScratchArena() : m_data(), m_silence(), m_bufferSize(), m_stride(), m_capacity(), m_top(), m_peak(0),
+            m_locked(), m_lockedBytes() { }
+        ~ScratchArena() { unlock(); }
+
+        ScratchArena(const ScratchArena &) = delete;
+        ScratchArena &operator=(const ScratchArena &) = delete;
+
+        /// Size the arena, allocates if it grows
+        /// @param buffers    number of buffers that may be held at once
+        /// @param bufferSize size of each buffer in bytes
+        void reserve(const size_t buffers, const size_t bufferSize)
+        {
+            if (buffers == m_capacity && bufferSize == m_bufferSize)
+                return;
+
+            unlock();
+            m_stride = (bufferSize + Alignment - 1) / Alignment * Alignment;
+            m_data.resize(buffers * m_stride);
+            m_silence.assign(bufferSize, 0);
+            m_bufferSize = bufferSize;
+            m_capacity = buffers;
+            m_top = 0;
+            if (m_locked)
+                lock();
+        }
+
+        /// Lock the buffers into physical memory, and relock them each time `reserve` reallocates
+        /// @param value whether to lock, false unlocks them
+        /// @returns whether the buffers could be locked, see `detail::lockMemory`
+        bool setLocked(const bool value)
+        {
+            m_locked = value;
+            unlock();
+            return !value || lock();
+        }
+
+        /// Bytes of buffers currently locked into physical memory
+        [[nodiscard]]
+        size_t lockedBytes() const { return m_lockedBytes; }
+
+        /// Take the next buffer, its contents are undefined
+        /// @returns the buffer, or `nullptr` if all buffers are held
+        [[nodiscard]]
+        uint8_t *acquire()
+        {
+            if (m_top >= m_capacity)
+                return nullptr;
+
+            const auto buffer = m_data.data() + m_top * m_stride;
+            if (++m_top > m_peak.load(std::memory_order_relaxed))
+                m_peak.store(m_top, std::memory_order_relaxed);
+            return buffer;
+        }
+
+        /// Position to return to with `release`, taken before acquiring
+        [[nodiscard]]
+        size_t mark() const { return m_top; }
+
+        /// Return every buffer acquired since `mark` was taken
+        void release(const size_t mark) { m_top = mark; }
+
+        /// Buffer of zeros, for a Source to output when no buffer is available
+        [[nodiscard]]
+        const uint8_t *silence() const { return m_silence.data(); }
+
+        /// Size of each buffer in bytes
+        [[nodiscard]]
+        size_t bufferSize() const { return m_bufferSize; }
+
+        /// Number of buffers that can be held at once
+        [[nodiscard]]
+        size_t capacity() const { return m_capacity; }
+
+        /// Most buffers held at once since the arena was created
+        [[nodiscard]]
+        size_t peak() const { return m_peak.load(std::memory_order_relaxed); }
+
+        /// Total bytes allocated by the arena
+        [[nodiscard]]
+        size_t bytes() const { return m_data.size() + m_silence.size(); }
+
+    private:
+        bool lock()
+        {
+            const auto data = m_data.empty() || detail::lockMemory(m_data.data(), m_data.size());
+            const auto silence = m_silence.empty() || detail::lockMemory(m_silence.data(), m_silence.size());
+            m_lockedBytes = (data ? m_data.size() : 0) + (silence ? m_silence.size() : 0);
+            return data && silence;
+        }
+
+        void unlock()
+        {
+            if (m_lockedBytes == 0)
+                return;
+            detail::unlockMemory(m_data.data(), m_data.size());
+            detail::unlockMemory(m_silence.data(), m_silence.size());
+            m_lockedBytes = 0;
+        }
+
+        AlignedVector<uint8_t, Alignment> m_data;    ///< `m_capacity` buffers, `m_stride` bytes apart
+        AlignedVector<uint8_t, Alignment> m_silence; ///< one buffer of zeros
+        size_t m_bufferSize;
+        size_t m_stride;                             ///< `m_bufferSize` rounded up to `Alignment`
+        size_t m_capacity;
+        size_t m_top;                                ///< number of buffers held, mix thread only
+        std::atomic<size_t> m_peak;                  ///< written by the mix thread, read by stats
+        bool m_locked;                               ///< whether buffers are locked into memory as they're sized
+        size_t m_lockedBytes;
+    };
+}
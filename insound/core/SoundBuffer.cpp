@@ -1,7 +1,15 @@
 #include "SoundBuffer.h"
 #include "AudioSpec.h"
+#include "Error.h"
+#include "util.h"
+#include "SampleConversion.h"
 #include "io/loadAudio.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
 namespace insound {
     SoundBuffer::SoundBuffer() : m_bufferSize(), m_buffer(), m_spec()
     {
@@ -19,7 +27,9 @@ namespace insound {
     }
 
     SoundBuffer::SoundBuffer(SoundBuffer &&other) noexcept :
-        m_bufferSize(other.m_bufferSize), m_buffer(other.m_buffer.load()), m_spec(other.m_spec)
+        m_bufferSize(other.m_bufferSize), m_buffer(other.m_buffer.load()), m_spec(other.m_spec),
+        m_markers(std::move(other.m_markers)), m_loops(std::move(other.m_loops)),
+        m_crossfades(std::move(other.m_crossfades))
     {
         other.m_spec = {};
         other.m_bufferSize = 0;
@@ -36,9 +46,12 @@ namespace insound {
             // Move other SoundBuffer data over here
             m_spec = other.m_spec;
             m_bufferSize = other.m_bufferSize;
-            other.m_buffer.store(
+            m_buffer.store(
                 other.m_buffer.load(std::memory_order_acquire),
                 std::memory_order_release);
+            m_markers = std::move(other.m_markers);
+            m_loops = std::move(other.m_loops);
+            m_crossfades = std::move(other.m_crossfades);
 
             // Invalidate other SoundBuffer
             other.m_spec = {};
@@ -53,15 +66,141 @@ namespace insound {
     {
         uint8_t *buffer;
         uint32_t byteLength;
-        if (!loadAudio(filepath, targetSpec, &buffer, &byteLength, nullptr))
+        AudioSpec spec;
+        std::vector<Marker> markers;
+        std::vector<LoopRegion> loops;
+        if (!loadAudio(filepath, targetSpec, &buffer, &byteLength, &markers, &spec, &loops))
+        {
+            return false;
+        }
+
+        // Native layouts that can't be played directly are converted to the nearest playable one
+        auto playableSpec = spec;
+        if (spec.channels > 2)
+            playableSpec.channels = 2;
+        if (!isPlayableSpec(playableSpec))
+            playableSpec.format = SampleFormat(32, true, false, true);
+
+        if (playableSpec.channels != spec.channels || playableSpec.format.flags() != spec.format.flags())
+        {
+            if (!convertAudio(buffer, byteLength, spec, playableSpec, &buffer, &byteLength))
+                return false;
+        }
+
+        if (!isPlayableSpec(playableSpec))
+        {
+            std::free(buffer);
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "SoundBuffer target spec must have 1 or 2 channels");
+            return false;
+        }
+
+        emplace(buffer, byteLength, playableSpec);
+        m_markers.swap(markers);
+        for (const auto &loop : loops)
+        {
+            if (!addLoopRegion(loop.start, loop.end))
+                return false;
+        }
+
+        return true;
+    }
+
+    const float *SoundBuffer::crossfadeData(int index) const
+    {
+        if (index < 0 || index >= (int)m_crossfades.size() || m_crossfades[index].empty())
+            return nullptr;
+        return m_crossfades[index].data();
+    }
+
+    bool SoundBuffer::addLoopRegion(uint32_t start, uint32_t end, uint32_t crossfade, int *outIndex)
+    {
+        if (!isLoaded())
+        {
+            INSOUND_PUSH_ERROR(Result::InvalidSoundBuffer, "SoundBuffer must be loaded to add a loop region");
+            return false;
+        }
+
+        if (start >= end || end > frames())
         {
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "loop region must have start < end <= frames");
             return false;
         }
 
-        emplace(buffer, byteLength, targetSpec);
+        if (crossfade > start || crossfade > end - start)
+        {
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "loop crossfade must not exceed the loop start or its length");
+            return false;
+        }
+
+        // Blend the loop's tail into the frames that lead up to its start, with equal-power gains: the last
+        // crossfade frame then flows into `start` as the frame before it would
+        std::vector<float> tail(crossfade * 2);
+        if (crossfade > 0)
+        {
+            std::vector<float> lead(crossfade * 2);
+            readFloatStereo(end - crossfade, crossfade, tail.data());
+            readFloatStereo(start - crossfade, crossfade, lead.data());
+
+            constexpr auto HalfPi = 1.57079632679489661923;
+            for (uint32_t i = 0; i < crossfade; ++i)
+            {
+                const auto t = ((double)i + .5) / (double)crossfade * HalfPi;
+                const auto fadeOut = (float)std::cos(t), fadeIn = (float)std::sin(t);
+                tail[i * 2] = tail[i * 2] * fadeOut + lead[i * 2] * fadeIn;
+                tail[i * 2 + 1] = tail[i * 2 + 1] * fadeOut + lead[i * 2 + 1] * fadeIn;
+            }
+        }
+
+        m_loops.emplace_back(start, end, crossfade);
+        m_crossfades.emplace_back(std::move(tail));
+
+        if (outIndex)
+            *outIndex = (int)m_loops.size() - 1;
         return true;
     }
 
+    void SoundBuffer::readFloatStereo(uint32_t frame, uint32_t count, float *output) const
+    {
+        const auto input = data() + (size_t)frame * m_spec.bytesPerFrame();
+        const auto frameCount = (int)count;
+
+        if (m_spec.format.isFloat())
+        {
+            if (m_spec.channels == 2)
+                std::memcpy(output, input, (size_t)count * 2 * sizeof(float));
+            else
+                monoToStereo(reinterpret_cast<const float *>(input), output, frameCount);
+        }
+        else if (m_spec.channels == 2)
+        {
+            convertS16ToF32(reinterpret_cast<const int16_t *>(input), output, frameCount * 2);
+        }
+        else // int16 mono converts in chunks that stay in cache
+        {
+            constexpr int ChunkFrames = 512;
+            alignas(16) float chunk[ChunkFrames];
+
+            const auto samples = reinterpret_cast<const int16_t *>(input);
+            for (int i = 0; i < frameCount; i += ChunkFrames)
+            {
+                const auto chunkCount = std::min(ChunkFrames, frameCount - i);
+                convertS16ToF32(samples + i, chunk, chunkCount);
+                monoToStereo(chunk, output + i * 2, chunkCount);
+            }
+        }
+    }
+
+    bool SoundBuffer::isPlayableSpec(const AudioSpec &spec)
+    {
+        if (spec.channels != 1 && spec.channels != 2)
+            return false;
+        if (spec.format.bits() > 8 && spec.format.isBigEndian() != (endian::native == endian::big))
+            return false;
+
+        return spec.format.bits() == 32 ? spec.format.isFloat() :
+            spec.format.bits() == 16 && spec.format.isSigned() && !spec.format.isFloat();
+    }
+
     void SoundBuffer::unload()
     {
         if (isLoaded())
@@ -72,12 +211,19 @@ namespace insound {
             m_bufferSize = 0;
             std::free(oldBuffer);
         }
+
+        m_markers.clear();
+        m_loops.clear();
+        m_crossfades.clear();
     }
 
     void SoundBuffer::emplace(uint8_t *buffer, uint32_t bufferSize, const AudioSpec &spec)
     {
         std::swap(m_bufferSize, bufferSize);
         m_spec = spec;
+        m_markers.clear();
+        m_loops.clear();
+        m_crossfades.clear();
 
         auto oldBuffer = m_buffer.load(std::memory_order_relaxed);
         while(!m_buffer.compare_exchange_weak(oldBuffer, buffer)) { }
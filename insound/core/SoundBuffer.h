@@ -1,10 +1,12 @@
 #pragma once
 
 #include "AudioSpec.h"
+#include "Marker.h"
 
 #include <atomic>
 
 #include <string>
+#include <vector>
 
 namespace insound {
 
@@ -18,12 +20,19 @@ namespace insound {
         SoundBuffer(SoundBuffer &&other) noexcept;
         SoundBuffer &operator=(SoundBuffer &&other) noexcept;
 
-        /// Load sound and convert to target specification
+        /// Load sound and convert to target specification. Markers and loop regions stored in the file are retained,
+        /// loop regions are loaded without crossfade.
         /// @param filepath    path to the sound file (only WAV supported for now)
-        /// @param targetSpec  the specification to convert this buffer to on load, usually of the opened audio device
-        ///                    to match the output type
+        /// @param targetSpec  the specification to convert this buffer to on load. Its sample rate should match the
+        ///                    opened audio device. Float32 or int16 samples in 1 or 2 channels are supported, where
+        ///                    compact layouts convert to float32 stereo during playback for 2-4x less memory:
+        ///                    a format of 0 keeps int16 sources as int16, channels of 0 keep mono sources as mono.
+        /// @returns whether operation succeeded, check `popError()` for details on `false`
         bool load(const std::string &filepath, const AudioSpec &targetSpec);
 
+        /// @returns whether a buffer in this spec can be played by a PCMSource
+        static bool isPlayableSpec(const AudioSpec &spec);
+
         /// Free sound buffer resources
         void unload();
 
@@ -46,12 +55,51 @@ namespace insound {
         [[nodiscard]]
         const AudioSpec &spec() const { return m_spec; }
 
-        // Replace current buffer with a new one
+        /// Number of sample frames in the buffer
+        [[nodiscard]]
+        uint32_t frames() const { return m_spec.channels ? m_bufferSize / m_spec.bytesPerFrame() : 0; }
+
+        /// Markers loaded with the sound, positions are in frames
+        [[nodiscard]]
+        const std::vector<Marker> &markers() const { return m_markers; }
+
+        /// Loop regions loaded with the sound or added via `addLoopRegion`
+        [[nodiscard]]
+        const std::vector<LoopRegion> &loopRegions() const { return m_loops; }
+
+        /// Precomputed float32 stereo frames that replace the last `crossfade` frames of a loop region while looping
+        /// @param index  index of the loop region
+        /// @returns crossfade frames, or `nullptr` if the region has no crossfade or the index is out of range
+        [[nodiscard]]
+        const float *crossfadeData(int index) const;
+
+        /// Add a loop region, precomputing an equal-power crossfade between the end of the loop and the frames
+        /// leading up to its start, so the loop point is free of clicks without extra work during playback.
+        /// Not thread-safe: add regions before playing the buffer.
+        /// @param start      first frame of the loop
+        /// @param end        frame after the last frame of the loop, must be greater than `start` and within the buffer
+        /// @param crossfade  number of frames to crossfade, must not exceed `start` or the length of the loop
+        /// @param outIndex   [out] optional, receives the index of the new region
+        /// @returns whether operation succeeded, check `popError()` for details on `false`
+        bool addLoopRegion(uint32_t start, uint32_t end, uint32_t crossfade = 0, int *outIndex = nullptr);
+
+        /// Read frames converted to float32 stereo, regardless of the storage layout
+        /// @param frame   first frame to read
+        /// @param count   number of frames to read, `frame + count` must not exceed `frames()`
+        /// @param output  buffer to receive `count` interleaved stereo frames
+        void readFloatStereo(uint32_t frame, uint32_t count, float *output) const;
+
+        // Replace current buffer with a new one, `spec` must be playable, see `isPlayableSpec`. Clears markers and
+        // loop regions.
         void emplace(uint8_t *buffer, uint32_t bufferSize, const AudioSpec &spec);
     private:
         uint32_t  m_bufferSize;
         std::atomic<uint8_t *> m_buffer;
         AudioSpec m_spec;
+
+        std::vector<Marker> m_markers;
+        std::vector<LoopRegion> m_loops;
+        std::vector<std::vector<float>> m_crossfades; ///< one per loop region, empty for hard loops
     };
 
 }
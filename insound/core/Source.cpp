@@ -5,6 +5,8 @@
 #include "Effect.h"
 #include "Engine.h"
 #include "Error.h"
+#include "SampleConversion.h"
+#include "ScratchArena.h"
 
 #include "effects/PanEffect.h"
 #include "effects/VolumeEffect.h"
@@ -18,28 +20,29 @@ namespace insound {
 } } while(0)
 
     Source::Source() :
-        m_engine(),
+        m_engine(), m_handle(),
         m_panner(),
         m_volume(), m_effects(),
-        m_outBuffer(), m_inBuffer(),
-        m_fadePoints(), m_fadeValue(1.f), m_clock(0),
+        m_fade(), m_layout(ChannelLayout::Stereo), m_clock(0),
         m_parentClock(0), m_paused(),
         m_pauseClock(-1), m_unpauseClock(-1), m_releaseOnPauseClock(false),
-        m_shouldDiscard(false)
+        m_shouldDiscard(false), m_releaseQueued(false)
     {
 
     }
 
-    bool Source::init(Engine *engine, const uint32_t parentClock, const bool paused)
+    bool Source::init(Engine *engine, const uint32_t parentClock, const bool paused, const ChannelLayout layout)
     {
         m_engine = engine;
+        m_layout = layout;
         m_clock = 0;
         m_parentClock = parentClock;
         m_paused = paused;
         m_pauseClock = -1;
         m_unpauseClock = -1;
         m_shouldDiscard = false;
-        m_fadeValue = 1.f;
+        m_releaseQueued = false;
+        m_fade.clear();
 
         m_panner = engine->getObjectPool().allocate<PanEffect>();
         m_volume = engine->getObjectPool().allocate<VolumeEffect>();
@@ -48,10 +51,6 @@ namespace insound {
         applyAddEffect(m_panner.cast<Effect>(), 0);
         applyAddEffect(m_volume.cast<Effect>(), 1);
 
-        // Initialize buffers
-        // m_outBuffer.resize(64 * 2 * sizeof(float), 0);
-        // m_inBuffer.resize(64 * 2 * sizeof(float), 0);
-
         return true;
     }
 
@@ -86,11 +85,10 @@ namespace insound {
     {
         HANDLE_GUARD();
 
-        // clean up logic here
+        // clean up logic here, effects are released when the engine deallocates them
         for (auto &effect : m_effects)
         {
-            effect->release();
-            m_engine->getObjectPool().deallocate(effect);
+            m_engine->destroyEffect(effect);
         }
         m_effects.clear();
 
@@ -99,46 +97,187 @@ namespace insound {
     }
 
 
-    /// Find starting fade point index, if there is no fade, e.g. < 2 points available, or the last fadepoint clock time
-    /// was surpassed, -1 is returned.
-    /// @param points list of points to check, must be sorted by clock time, low to high
-    /// @param clock  current clock point to check
-    /// @param outIndex [out] index to retrieve - this value is the last fadepoint that is less than `clock`, thus the
-    ///                       first of two points to interpolate the resulting fade value.
-    /// @returns whether there is a next available fade at the index after `outIndex`. Since there must be a second
-    ///          fade point to interpolate between, this also means whether to perform the fade or not.
-    static bool findFadePointIndex(const std::vector<FadePoint> &points, const uint32_t clock, int *outIndex)
-    {
-        int res = -1;
-        size_t size = points.size();
-        for (size_t i = 0; i < size; ++i)
+    /// Volume and pan levels of a default effect chain over one buffer, each ramping linearly
+    struct DefaultChain {
+        float *samples;
+        float volume, volumeDelta;
+        float left, leftDelta, right, rightDelta;
+        bool panned; ///< whether the pan levels are anything other than 1, which passes both channels through
+    };
+
+    /// Apply fade, volume, and pan to interleaved stereo frames in one pass. Each gain changes by its delta per frame.
+    /// `samples` need not be aligned, the fade calls this for each of its runs, which start at any frame.
+    static void applyDefaultChain(float *samples, const uint32_t frames, const float fade, const float fadeDelta,
+        const float volume, const float volumeDelta, const float left, const float leftDelta, const float right,
+        const float rightDelta, const bool panned)
+    {
+        const auto count = frames * 2;
+        uint32_t i = 0;
+#if     INSOUND_SSE
+        // two frames per vector, `b` scales each channel's own input, `a` the opposite channel's
+        auto fades = _mm_set_ps(fade + fadeDelta, fade + fadeDelta, fade, fade);
+        auto volumes = _mm_set_ps(volume + volumeDelta, volume + volumeDelta, volume, volume);
+        const auto fadeStep = _mm_set1_ps(fadeDelta * 2.f);
+        const auto volumeStep = _mm_set1_ps(volumeDelta * 2.f);
+        if (panned)
+        {
+            auto b = _mm_set_ps(right + rightDelta, left + leftDelta, right, left);
+            auto a = _mm_sub_ps(_mm_set1_ps(1.f), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)));
+            const auto bStep = _mm_set_ps(rightDelta * 2.f, leftDelta * 2.f, rightDelta * 2.f, leftDelta * 2.f);
+            const auto aStep = _mm_sub_ps(_mm_setzero_ps(), _mm_shuffle_ps(bStep, bStep, _MM_SHUFFLE(2, 3, 0, 1)));
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto in = _mm_loadu_ps(samples + i);
+                const auto swapped = _mm_shuffle_ps(in, in, _MM_SHUFFLE(2, 3, 0, 1));
+                const auto mixed = _mm_add_ps(_mm_mul_ps(swapped, a), _mm_mul_ps(in, b));
+                _mm_storeu_ps(samples + i, _mm_mul_ps(mixed, _mm_mul_ps(fades, volumes)));
+                a = _mm_add_ps(a, aStep);
+                b = _mm_add_ps(b, bStep);
+                fades = _mm_add_ps(fades, fadeStep);
+                volumes = _mm_add_ps(volumes, volumeStep);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_mul_ps(fades, volumes)));
+                fades = _mm_add_ps(fades, fadeStep);
+                volumes = _mm_add_ps(volumes, volumeStep);
+            }
+        }
+#elif   INSOUND_WASM_SIMD
+        auto fades = wasm_f32x4_make(fade, fade, fade + fadeDelta, fade + fadeDelta);
+        auto volumes = wasm_f32x4_make(volume, volume, volume + volumeDelta, volume + volumeDelta);
+        const auto fadeStep = wasm_f32x4_splat(fadeDelta * 2.f);
+        const auto volumeStep = wasm_f32x4_splat(volumeDelta * 2.f);
+        if (panned)
+        {
+            auto b = wasm_f32x4_make(left, right, left + leftDelta, right + rightDelta);
+            auto a = wasm_f32x4_sub(wasm_f32x4_splat(1.f), wasm_i32x4_shuffle(b, b, 1, 0, 3, 2));
+            const auto bStep = wasm_f32x4_make(leftDelta * 2.f, rightDelta * 2.f, leftDelta * 2.f, rightDelta * 2.f);
+            const auto aStep = wasm_f32x4_neg(wasm_i32x4_shuffle(bStep, bStep, 1, 0, 3, 2));
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto in = wasm_v128_load(samples + i);
+                const auto swapped = wasm_i32x4_shuffle(in, in, 1, 0, 3, 2);
+                const auto mixed = wasm_f32x4_add(wasm_f32x4_mul(swapped, a), wasm_f32x4_mul(in, b));
+                wasm_v128_store(samples + i, wasm_f32x4_mul(mixed, wasm_f32x4_mul(fades, volumes)));
+                a = wasm_f32x4_add(a, aStep);
+                b = wasm_f32x4_add(b, bStep);
+                fades = wasm_f32x4_add(fades, fadeStep);
+                volumes = wasm_f32x4_add(volumes, volumeStep);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                wasm_v128_store(samples + i,
+                    wasm_f32x4_mul(wasm_v128_load(samples + i), wasm_f32x4_mul(fades, volumes)));
+                fades = wasm_f32x4_add(fades, fadeStep);
+                volumes = wasm_f32x4_add(volumes, volumeStep);
+            }
+        }
+#elif   INSOUND_ARM_NEON
+        float32x4_t fades {fade, fade, fade + fadeDelta, fade + fadeDelta};
+        float32x4_t volumes {volume, volume, volume + volumeDelta, volume + volumeDelta};
+        const auto fadeStep = vdupq_n_f32(fadeDelta * 2.f);
+        const auto volumeStep = vdupq_n_f32(volumeDelta * 2.f);
+        if (panned)
         {
-            if (points[i].clock > clock)
+            float32x4_t b {left, right, left + leftDelta, right + rightDelta};
+            auto a = vsubq_f32(vdupq_n_f32(1.f), vrev64q_f32(b));
+            const float32x4_t bStep {leftDelta * 2.f, rightDelta * 2.f, leftDelta * 2.f, rightDelta * 2.f};
+            const auto aStep = vnegq_f32(vrev64q_f32(bStep));
+            for (; i + 4 <= count; i += 4)
             {
-                break;
+                const auto in = vld1q_f32(samples + i);
+                const auto mixed = vmlaq_f32(vmulq_f32(vrev64q_f32(in), a), in, b);
+                vst1q_f32(samples + i, vmulq_f32(mixed, vmulq_f32(fades, volumes)));
+                a = vaddq_f32(a, aStep);
+                b = vaddq_f32(b, bStep);
+                fades = vaddq_f32(fades, fadeStep);
+                volumes = vaddq_f32(volumes, volumeStep);
             }
+        }
+        else
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), vmulq_f32(fades, volumes)));
+                fades = vaddq_f32(fades, fadeStep);
+                volumes = vaddq_f32(volumes, volumeStep);
+            }
+        }
+#endif
+        for (; i < count; i += 2)
+        {
+            const auto frame = static_cast<float>(i / 2);
+            const auto gain = (fade + fadeDelta * frame) * (volume + volumeDelta * frame);
+            const auto l = left + leftDelta * frame;
+            const auto r = right + rightDelta * frame;
+            const auto inLeft = samples[i], inRight = samples[i + 1];
+            samples[i] = (inRight * (1.f - r) + inLeft * l) * gain;
+            samples[i + 1] = (inLeft * (1.f - l) + inRight * r) * gain;
+        }
+    }
+
+    bool Source::processDefaultChain(float *samples, const uint32_t frames)
+    {
+        if (m_layout != ChannelLayout::Stereo ||
+            m_effects.size() != 2 || m_effects[0] != m_panner || m_effects[1] != m_volume)
+            return false;
 
-            ++res;
+        // Take this buffer's levels, processed from here instead of by the effects
+        float volumeFrom, volumeTo;
+        if (!m_volume->takeLinearRamp(&volumeFrom, &volumeTo))
+            return false;
+        float leftFrom, rightFrom, leftTo, rightTo;
+        m_panner->takeRamp(&leftFrom, &rightFrom, &leftTo, &rightTo);
+
+        const auto length = static_cast<float>(frames);
+        DefaultChain chain{samples, volumeFrom, (volumeTo - volumeFrom) / length,
+            leftFrom, (leftTo - leftFrom) / length, rightFrom, (rightTo - rightFrom) / length,
+            leftFrom != 1.f || rightFrom != 1.f || leftTo != 1.f || rightTo != 1.f};
+
+        if (chain.volume == 1.f && chain.volumeDelta == 0 && !chain.panned) // only the fade applies
+        {
+            m_fade.process(samples, m_parentClock, frames);
+            return true;
         }
 
-        *outIndex = res;
+        m_fade.process(m_parentClock, frames, [](const uint32_t frame, const uint32_t count, const float gain,
+            const float delta, void *userdata) {
+            const auto &chain = *static_cast<DefaultChain *>(userdata);
+            const auto offset = static_cast<float>(frame);
+            applyDefaultChain(chain.samples + frame * 2, count, gain, delta,
+                chain.volume + chain.volumeDelta * offset, chain.volumeDelta,
+                chain.left + chain.leftDelta * offset, chain.leftDelta,
+                chain.right + chain.rightDelta * offset, chain.rightDelta, chain.panned);
+        }, &chain);
 
-        return res + 1 < size;
+        return true;
     }
 
     int Source::read(const uint8_t **pcmPtr, int length)
     {
-        if (m_inBuffer.size() != length)
-        {
-            m_inBuffer.resize(length, 0);
-        }
+        const auto channels = channelCount(m_layout);
+        const auto frameSize = channels * sizeof(float);
 
-        if (m_outBuffer.size() != length)
+        // Scratch buffers are held until the caller has consumed the output, and returned by the caller
+        auto &scratch = m_engine->getScratchArena();
+        auto output = static_cast<size_t>(length) <= scratch.bufferSize() ? scratch.acquire() : nullptr;
+        if (!output)
         {
-            m_outBuffer.resize(length, 0);
+            INSOUND_PUSH_ERROR(Result::OutOfMemory, "Source::read: mixer scratch buffers exhausted");
+            if (pcmPtr)
+                *pcmPtr = scratch.silence();
+            m_clock += length / frameSize;
+            return length;
         }
 
-        std::memset(m_outBuffer.data(), 0, m_outBuffer.size());
+        std::memset(output, 0, length);
 
         int64_t unpauseClock = (int64_t)m_unpauseClock - (int64_t)m_parentClock;
         int64_t pauseClock = (int64_t)m_pauseClock - (int64_t)m_parentClock;
@@ -148,7 +287,7 @@ namespace insound {
             if (m_paused)
             {
                 // Next unpause occurs within this chunk
-                if (unpauseClock < (length - i) / (2 * sizeof(float)) && unpauseClock > -1)
+                if (unpauseClock < (length - i) / frameSize && unpauseClock > -1)
                 {
                     i += (int)unpauseClock;
 
@@ -171,13 +310,13 @@ namespace insound {
             else
             {
                 // Check if there is a pause clock ahead to see how many samples to read until then
-                const bool pauseThisFrame = (pauseClock < (length - i) / (2 * sizeof(float)) && pauseClock > -1);
-                const int bytesToRead = pauseThisFrame ? (int)pauseClock * 2 * sizeof(float) : length - i;
+                const bool pauseThisFrame = (pauseClock < (length - i) / frameSize && pauseClock > -1);
+                const int bytesToRead = pauseThisFrame ? (int)pauseClock * frameSize : length - i;
 
                 int bytesRead = 0;
                 // read bytes here
                 if (bytesToRead > 0)
-                    bytesRead = readImpl(m_outBuffer.data() + i, bytesToRead);
+                    bytesRead = readImpl(output + i, bytesToRead);
 
                 i += bytesRead;
 
@@ -194,243 +333,102 @@ namespace insound {
 
                     if (m_releaseOnPauseClock)
                     {
-                        close();
+                        queueRelease();
                         break;
                     }
                 }
 
                 if (pauseClock > -1)
-                    pauseClock -= bytesToRead / (2 * sizeof(float)); // 2 for each channel
+                    pauseClock -= bytesToRead / frameSize;
                 if (unpauseClock > -1)
-                    unpauseClock -= bytesToRead / (2 * sizeof(float)); // 2 for each channel
+                    unpauseClock -= bytesToRead / frameSize;
             }
         }
 
         const auto sampleCount = length / sizeof(float);
-        for (auto &effect : m_effects)
-        {
-            if (effect->process((float *)m_outBuffer.data(), (float *)m_inBuffer.data(), (int)sampleCount))
-            {
-                std::swap(m_outBuffer, m_inBuffer);
-
-                // clear inBuffer to 0
-                std::memset(m_inBuffer.data(), 0, m_inBuffer.size());
-            }
-
-        }
-
-        // Apply fade points
-        int fadeIndex = -1;
-        uint32_t fadeClock = m_parentClock;
-
-        for (auto sample = (float *)m_outBuffer.data(), end = (float *)(m_outBuffer.data() + m_outBuffer.size());
-            sample < end;
-            )
+        const auto frames = static_cast<uint32_t>(sampleCount / channels);
+        auto samples = reinterpret_cast<float *>(output);
+        if (!processDefaultChain(samples, frames))
         {
-            if (findFadePointIndex(m_fadePoints, fadeClock, &fadeIndex)) // returns whether we are currently in a fade
+            // Taken on the first out-of-place or planar effect. Holds the planar block, or receives an out-of-place
+            // effect's output, after which it's swapped with `samples`.
+            float *spare = nullptr;
+            float *planes[MaxChannels];
+            bool planar = false;        // whether the block is in `planes`
+            bool planarChanged = false; // whether `samples` is behind `planes`
+
+            for (auto &effect : m_effects)
             {
-                // Get fadepoint data
-                const auto clock0 = m_fadePoints[fadeIndex].clock; // starting clock
-                const auto value0 = m_fadePoints[fadeIndex].value; // starting value
-
-                const auto clock1 = m_fadePoints[fadeIndex + 1].clock; // end clock
-                const auto value1 = m_fadePoints[fadeIndex + 1].value; // end value
-
-                // Perform fade until end or clock1, whichever comes first
-                const auto fadeEnd = std::min<uint32_t>(static_cast<uint32_t>(end - sample) / 2U, clock1 + 1 - fadeClock);
-                const auto clockDiff = clock1 - clock0;
-                const auto valueDiff = value1 - value0;
-
-                uint32_t f = 0;
-#if INSOUND_SSE
-                const auto clockDiffVec = _mm_set1_ps(static_cast<float>(clockDiff));
-                const auto valueDiffVec = _mm_set1_ps(valueDiff);
-                const auto value0Vec = _mm_set1_ps(value0);
-                for (; f <= fadeEnd - 16; f += 16)
-                {
-                    const auto clockOffsetVec = _mm_set1_ps(
-                        static_cast<float>(fadeClock) - static_cast<float>(clock0));
-
-                    const auto amounts0 = _mm_div_ps(_mm_add_ps(_mm_set_ps(1, 1, 0, 0), clockOffsetVec), clockDiffVec);
-                    const auto amounts1 = _mm_div_ps(_mm_add_ps(_mm_set_ps(3, 3, 2, 2), clockOffsetVec), clockDiffVec);
-                    const auto amounts2 = _mm_div_ps(_mm_add_ps(_mm_set_ps(5, 5, 4, 4), clockOffsetVec), clockDiffVec);
-                    const auto amounts3 = _mm_div_ps(_mm_add_ps(_mm_set_ps(7, 7, 6, 6), clockOffsetVec), clockDiffVec);
-                    const auto amounts4 = _mm_div_ps(_mm_add_ps(_mm_set_ps(9, 9, 8, 8), clockOffsetVec), clockDiffVec);
-                    const auto amounts5 = _mm_div_ps(_mm_add_ps(_mm_set_ps(11, 11, 10, 10), clockOffsetVec), clockDiffVec);
-                    const auto amounts6 = _mm_div_ps(_mm_add_ps(_mm_set_ps(13, 13, 12, 12), clockOffsetVec), clockDiffVec);
-                    const auto amounts7 = _mm_div_ps(_mm_add_ps(_mm_set_ps(15, 15, 14, 14), clockOffsetVec), clockDiffVec);
-                    const auto result0 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts0), value0Vec);
-                    const auto result1 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts1), value0Vec);
-                    const auto result2 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts2), value0Vec);
-                    const auto result3 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts3), value0Vec);
-                    const auto result4 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts4), value0Vec);
-                    const auto result5 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts5), value0Vec);
-                    const auto result6 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts6), value0Vec);
-                    const auto result7 = _mm_add_ps(_mm_mul_ps(valueDiffVec, amounts7), value0Vec);
-                    _mm_store_ps(sample, _mm_mul_ps(_mm_load_ps(sample), result0));
-                    _mm_store_ps(sample + 4, _mm_mul_ps(_mm_load_ps(sample + 4), result1));
-                    _mm_store_ps(sample + 8, _mm_mul_ps(_mm_load_ps(sample + 8), result2));
-                    _mm_store_ps(sample + 12, _mm_mul_ps(_mm_load_ps(sample + 12), result3));
-                    _mm_store_ps(sample + 16, _mm_mul_ps(_mm_load_ps(sample + 16), result4));
-                    _mm_store_ps(sample + 20, _mm_mul_ps(_mm_load_ps(sample + 20), result5));
-                    _mm_store_ps(sample + 24, _mm_mul_ps(_mm_load_ps(sample + 24), result6));
-                    _mm_store_ps(sample + 28, _mm_mul_ps(_mm_load_ps(sample + 28), result7));
-
-                    fadeClock += 16;
-                    sample += 32;
-                }
-#elif INSOUND_WASM_SIMD
-                const auto clockDiffVec = wasm_f32x4_splat(static_cast<float>(clockDiff));
-                const auto valueDiffVec = wasm_f32x4_splat(valueDiff);
-                const auto value0Vec = wasm_f32x4_splat(value0);
-                for (; f <= fadeEnd - 16; f += 16)
+                const auto order = effect->sampleOrder();
+                const auto runPlanar = order == SampleOrder::Planar || (order == SampleOrder::Either && planar);
+                if (runPlanar || !effect->processesInPlace())
                 {
-                    const auto clockOffsetVec = wasm_f32x4_splat(static_cast<float>(fadeClock) - static_cast<float>(clock0));
-                    const auto amounts0 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(0, 0, 1, 1), clockOffsetVec), clockDiffVec);
-                    const auto amounts1 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(2, 2, 3, 3), clockOffsetVec), clockDiffVec);
-                    const auto amounts2 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(4, 4, 5, 5), clockOffsetVec), clockDiffVec);
-                    const auto amounts3 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(6, 6, 7, 7), clockOffsetVec), clockDiffVec);
-                    const auto amounts4 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(8, 8, 9, 9), clockOffsetVec), clockDiffVec);
-                    const auto amounts5 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(10, 10, 11, 11), clockOffsetVec), clockDiffVec);
-                    const auto amounts6 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(12, 12, 13, 13), clockOffsetVec), clockDiffVec);
-                    const auto amounts7 = wasm_f32x4_div(wasm_f32x4_add(wasm_f32x4_make(14, 14, 15, 15), clockOffsetVec), clockDiffVec);
-
-                    const auto results0 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts0), value0Vec);
-                    const auto results1 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts1), value0Vec);
-                    const auto results2 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts2), value0Vec);
-                    const auto results3 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts3), value0Vec);
-                    const auto results4 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts4), value0Vec);
-                    const auto results5 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts5), value0Vec);
-                    const auto results6 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts6), value0Vec);
-                    const auto results7 = wasm_f32x4_add(wasm_f32x4_mul(valueDiffVec, amounts7), value0Vec);
-
-                    wasm_v128_store(sample, wasm_f32x4_mul(wasm_v128_load(sample), results0));
-                    wasm_v128_store(sample + 4, wasm_f32x4_mul(wasm_v128_load(sample + 4), results1));
-                    wasm_v128_store(sample + 8, wasm_f32x4_mul(wasm_v128_load(sample + 8), results2));
-                    wasm_v128_store(sample + 12, wasm_f32x4_mul(wasm_v128_load(sample + 12), results3));
-                    wasm_v128_store(sample + 16, wasm_f32x4_mul(wasm_v128_load(sample + 16), results4));
-                    wasm_v128_store(sample + 20, wasm_f32x4_mul(wasm_v128_load(sample + 20), results5));
-                    wasm_v128_store(sample + 24, wasm_f32x4_mul(wasm_v128_load(sample + 24), results6));
-                    wasm_v128_store(sample + 28, wasm_f32x4_mul(wasm_v128_load(sample + 28), results7));
-
-                    fadeClock += 16;
-                    sample += 32;
-                }
-#elif INSOUND_ARM_NEON
-                const auto clockDiffVec = vdupq_n_f32(static_cast<float>(clockDiff));
-                const auto valueDiffVec = vdupq_n_f32(static_cast<float>(valueDiff));
-                const auto value0Vec = vdupq_n_f32(static_cast<float>(value0));
-                for (; f < fadeEnd - 16; f += 16)
-                {
-                    const auto clockOffsetVec = vdupq_n_f32(static_cast<float>(fadeClock) - static_cast<float>(clock0));
-                    const auto amounts0 = vdivq_f32(vaddq_f32(float32x4_t{0, 0, 1, 1}, clockOffsetVec), clockDiffVec);
-                    const auto amounts1 = vdivq_f32(vaddq_f32(float32x4_t{2, 2, 3, 3}, clockOffsetVec), clockDiffVec);
-                    const auto amounts2 = vdivq_f32(vaddq_f32(float32x4_t{4, 4, 5, 5}, clockOffsetVec), clockDiffVec);
-                    const auto amounts3 = vdivq_f32(vaddq_f32(float32x4_t{6, 6, 7, 7}, clockOffsetVec), clockDiffVec);
-                    const auto amounts4 = vdivq_f32(vaddq_f32(float32x4_t{8, 8, 9, 9}, clockOffsetVec), clockDiffVec);
-                    const auto amounts5 = vdivq_f32(vaddq_f32(float32x4_t{10, 10, 11, 11}, clockOffsetVec), clockDiffVec);
-                    const auto amounts6 = vdivq_f32(vaddq_f32(float32x4_t{12, 12, 13, 13}, clockOffsetVec), clockDiffVec);
-                    const auto amounts7 = vdivq_f32(vaddq_f32(float32x4_t{14, 14, 15, 15}, clockOffsetVec), clockDiffVec);
-
-                    const auto results0 = vaddq_f32(vmulq_f32(valueDiffVec, amounts0), value0Vec);
-                    const auto results1 = vaddq_f32(vmulq_f32(valueDiffVec, amounts1), value0Vec);
-                    const auto results2 = vaddq_f32(vmulq_f32(valueDiffVec, amounts2), value0Vec);
-                    const auto results3 = vaddq_f32(vmulq_f32(valueDiffVec, amounts3), value0Vec);
-                    const auto results4 = vaddq_f32(vmulq_f32(valueDiffVec, amounts4), value0Vec);
-                    const auto results5 = vaddq_f32(vmulq_f32(valueDiffVec, amounts5), value0Vec);
-                    const auto results6 = vaddq_f32(vmulq_f32(valueDiffVec, amounts6), value0Vec);
-                    const auto results7 = vaddq_f32(vmulq_f32(valueDiffVec, amounts7), value0Vec);
-
-                    vst1q_f32(sample, vmulq_f32(vld1q_f32(sample), results0));
-                    vst1q_f32(sample + 4, vmulq_f32(vld1q_f32(sample + 4), results1));
-                    vst1q_f32(sample + 8, vmulq_f32(vld1q_f32(sample + 8), results2));
-                    vst1q_f32(sample + 12, vmulq_f32(vld1q_f32(sample + 12), results3));
-                    vst1q_f32(sample + 16, vmulq_f32(vld1q_f32(sample + 16), results4));
-                    vst1q_f32(sample + 20, vmulq_f32(vld1q_f32(sample + 20), results5));
-                    vst1q_f32(sample + 24, vmulq_f32(vld1q_f32(sample + 24), results6));
-                    vst1q_f32(sample + 28, vmulq_f32(vld1q_f32(sample + 28), results7));
-
-                    sample += 32;
-                    fadeClock += 16;
-                }
-#else
-                for (; f <= fadeEnd - 4; f += 4)
-                {
-                    const auto clockOffset = fadeClock - clock0; // current offset from clock0
-                    const float amount0 = (float)(clockOffset) / (float)(clockDiff);
-                    const float amount1 = (float)(clockOffset + 1) / (float)(clockDiff);
-                    const float amount2 = (float)(clockOffset + 2) / (float)(clockDiff);
-                    const float amount3 = (float)(clockOffset + 3) / (float)(clockDiff);
-                    const auto result0 = valueDiff * amount0 + value0;
-                    const auto result1 = valueDiff * amount1 + value0;
-                    const auto result2 = valueDiff * amount2 + value0;
-                    const auto result3 = valueDiff * amount3 + value0;
-                    sample[0] *= result0;
-                    sample[1] *= result0;
-                    sample[2] *= result1;
-                    sample[3] *= result1;
-                    sample[4] *= result2;
-                    sample[5] *= result2;
-                    sample[6] *= result3;
-                    sample[7] *= result3;
-
-                    fadeClock += 4;
-                    sample += 8;
+                    if (!spare)
+                    {
+                        spare = reinterpret_cast<float *>(scratch.acquire());
+                        if (!spare)
+                        {
+                            INSOUND_PUSH_ERROR(Result::OutOfMemory, "Source::read: mixer scratch buffers exhausted");
+                            break;
+                        }
+                    }
                 }
-#endif
-                for (;f < fadeEnd; ++f)
+
+                if (runPlanar)
                 {
-                    const float amount = (float)(fadeClock - clock0) / (float)(clockDiff);
-                    const auto result = valueDiff * amount + value0;
-                    *sample++ *= result;
-                    *sample++ *= result;
-                    ++fadeClock;
+                    if (!planar)
+                    {
+                        for (int c = 0; c < channels; ++c)
+                            planes[c] = spare + c * frames;
+                        deinterleave(samples, channels, planes, frames);
+                        planar = true;
+                    }
+
+                    planarChanged |= effect->processPlanar(planes, (int)frames);
+                    continue;
                 }
 
-                m_fadeValue = value1;
-            }
-            else
-            {
-                // find end point
-                uint32_t endIndex;
-                if (fadeIndex + 1 < m_fadePoints.size()) // there's next fadepoint
+                if (planar)
                 {
-                    endIndex = std::min<uint32_t>(m_fadePoints[fadeIndex + 1].clock - fadeClock, static_cast<uint32_t>(end - sample));
+                    if (planarChanged)
+                        interleave(planes, channels, samples, frames);
+                    planar = false;
+                    planarChanged = false;
                 }
-                else
+
+                if (effect->processesInPlace())
                 {
-                    endIndex = static_cast<uint32_t>(end - sample);
+                    effect->process(samples, samples, (int)sampleCount);
+                    continue;
                 }
 
-                if (m_fadeValue == 1.f) // fade of 1 has no effect, just move the sample ptr
-                    sample += endIndex;
-                else                    // perform fade multiplier on all samples until endIndex
+                if (effect->process(samples, spare, (int)sampleCount))
                 {
-                    for (uint32_t i = 0; i < endIndex; ++i)
-                        *sample++ *= m_fadeValue;
+                    std::swap(samples, spare);
                 }
             }
 
-        }
+            if (planarChanged)
+                interleave(planes, channels, samples, frames);
 
-        // Remove all fade points that have been passed
-        if (fadeIndex > 0)
-            m_fadePoints.erase(m_fadePoints.begin(), m_fadePoints.begin() + (fadeIndex - 1));
+            // Apply fade points
+            m_fade.process(samples, m_parentClock, frames, channels);
+        }
 
         if (pcmPtr)
-            *pcmPtr = m_outBuffer.data();
+            *pcmPtr = reinterpret_cast<const uint8_t *>(samples);
 
-        m_clock += length / (2 * sizeof(float));
+        m_clock += length / frameSize;
         return length;
     }
 
-    Source::Source(Source &&other) noexcept : m_engine(other.m_engine),
+    Source::Source(Source &&other) noexcept : PoolTyped(other), m_engine(other.m_engine), m_handle(other.m_handle),
         m_panner(other.m_panner), m_volume(other.m_volume), m_effects(std::move(other.m_effects)),
-        m_outBuffer(std::move(other.m_outBuffer)), m_inBuffer(std::move(other.m_inBuffer)),
-        m_fadePoints(std::move(other.m_fadePoints)), m_fadeValue(other.m_fadeValue),
+        m_fade(std::move(other.m_fade)), m_layout(other.m_layout),
         m_clock(other.m_clock), m_parentClock(other.m_parentClock),
         m_paused(other.m_paused), m_pauseClock(other.m_pauseClock), m_unpauseClock(other.m_unpauseClock),
-        m_releaseOnPauseClock(other.m_releaseOnPauseClock), m_shouldDiscard(other.m_shouldDiscard)
+        m_releaseOnPauseClock(other.m_releaseOnPauseClock), m_shouldDiscard(other.m_shouldDiscard),
+        m_releaseQueued(other.m_releaseQueued)
     {}
 
     bool Source::getPaused(bool *outPaused) const
@@ -607,21 +605,21 @@ namespace insound {
         return true;
     }
 
-    bool Source::addFadePoint(const uint32_t clock, const float value)
+    bool Source::addFadePoint(const uint32_t clock, const float value, const FadeCurve curve)
     {
         HANDLE_GUARD();
 
         // Push immediately for sample clock accuracy
-        m_engine->pushImmediateCommand(Command::makeSourceAddFadePoint(this, clock, value));
+        m_engine->pushImmediateCommand(Command::makeSourceAddFadePoint(this, clock, value, curve));
         return true;
     }
 
-    bool Source::fadeTo(const float value, const uint32_t length)
+    bool Source::fadeTo(const float value, const uint32_t length, const FadeCurve curve)
     {
         HANDLE_GUARD();
 
         // Push immediately for sample clock accuracy
-        m_engine->pushImmediateCommand(Command::makeSourceAddFadeTo(this, m_parentClock + length, value));
+        m_engine->pushImmediateCommand(Command::makeSourceAddFadeTo(this, m_parentClock + length, value, curve));
         return true;
     }
 
@@ -639,7 +637,16 @@ namespace insound {
         HANDLE_GUARD();
 
         if (outValue)
-            *outValue = m_fadeValue;
+            *outValue = m_fade.value();
+        return true;
+    }
+
+    bool Source::getLayout(ChannelLayout *outLayout) const
+    {
+        HANDLE_GUARD();
+
+        if (outLayout)
+            *outLayout = m_layout;
         return true;
     }
 
@@ -648,12 +655,20 @@ namespace insound {
         return m_shouldDiscard;
     }
 
-    bool Source::swapBuffers(AlignedVector<uint8_t, 16> *buffer)
+    void Source::queueRelease()
     {
-        HANDLE_GUARD();
+        if (!m_releaseQueued && !m_shouldDiscard)
+            m_releaseQueued = m_engine->queueRelease(this);
+    }
 
-        m_outBuffer.swap(*buffer);
-        return true;
+    bool Source::eventsEnabled() const
+    {
+        return m_engine->eventsEnabled();
+    }
+
+    void Source::pushEvent(const SourceEvent::Type type, const int index)
+    {
+        m_engine->pushEvent(SourceEvent(type, m_handle, index, m_parentClock));
     }
 
 
@@ -709,7 +724,7 @@ namespace insound {
             {
                 const auto clock = command.addfadepoint.clock;
                 const auto value = command.addfadepoint.value;
-                applyAddFadePoint(clock, value);
+                m_fade.addPoint(clock, value, command.addfadepoint.curve);
             } break;
 
             case SourceCommand::AddFadeTo:
@@ -718,20 +733,20 @@ namespace insound {
                 const auto value = command.addfadepoint.value;
 
                 // Remove fade points between now and the fade value
-                applyRemoveFadePoint(m_parentClock, clock);
+                m_fade.removePoints(m_parentClock, clock);
 
                 // Set current fade point
-                applyAddFadePoint(m_parentClock, m_fadeValue);
+                m_fade.addPoint(m_parentClock, m_fade.value());
 
                 // Set target fade point
-                applyAddFadePoint(clock, value);
+                m_fade.addPoint(clock, value, command.addfadepoint.curve);
             } break;
 
             case SourceCommand::RemoveFadePoint:
             {
                 const auto start = command.removefadepoint.begin;
                 const auto end = command.removefadepoint.end;
-                applyRemoveFadePoint(start, end);
+                m_fade.removePoints(start, end);
             } break;
 
             default:
@@ -740,45 +755,12 @@ namespace insound {
         }
     }
 
-    void Source::applyAddFadePoint(const uint32_t clock, const float value)
-    {
-        bool didInsert = false;
-        for (auto it = m_fadePoints.begin(); it != m_fadePoints.end(); ++it)
-        {
-            if (clock == it->clock) // replace the value
-            {
-                it->value = value;
-                didInsert = true;
-                break;
-            }
-
-            if (clock < it->clock)
-            {
-                m_fadePoints.insert(it, FadePoint(clock, value));
-                didInsert = true;
-                break;
-            }
-        }
-
-        if (!didInsert)
-        {
-            m_fadePoints.emplace_back(clock, value);
-        }
-    }
-
-    void Source::applyRemoveFadePoint(const uint32_t startClock, const uint32_t endClock)
-    {
-        // remove-erase idiom on all fadepoints that match criteria
-        m_fadePoints.erase(std::remove_if(m_fadePoints.begin(), m_fadePoints.end(), [startClock, endClock](const FadePoint &point) {
-            return point.clock >= startClock && point.clock < endClock;
-        }), m_fadePoints.end());
-    }
-
     void Source::applyAddEffect(const Handle<Effect> &effect, int position)
     {
         const auto it = m_effects.begin() + position;
 
         effect->m_engine = m_engine; // provide engine to effect
+        effect->m_channels = channelCount(m_layout);
 
         m_effects.insert(it, effect);
     }
@@ -1,9 +1,11 @@
 #pragma once
 #include "effects/PanEffect.h"
 #include "effects/VolumeEffect.h"
+#include "ChannelLayout.h"
+#include "Envelope.h"
 #include "Error.h"
-#include "AlignedVector.h"
 #include "Engine.h"
+#include "SourceEvent.h"
 
 #include <cstdint>
 #include <vector>
@@ -16,18 +18,11 @@ namespace insound {
     class Engine;
     class Effect;
 
-    struct FadePoint {
-        FadePoint() : clock(), value() { }
-        FadePoint(uint32_t clock, float value) : clock(clock), value(value) { }
-        uint32_t clock;
-        float value;
-    };
-
     /// Base class for a source that generates an audio signal.
     /// Includes an effects chain, ability to pause/unpause, linear fade points, etc.
     /// To release resources and remove from the mix graph, call `release()`
     ///
-    class Source {
+    class Source : public PoolTyped {
     public:
         virtual ~Source() = default;
         Source(Source &&other) noexcept;
@@ -145,17 +140,19 @@ namespace insound {
         /// @returns whether function succeeded; check `popError` for details.
         bool setVolume(float value);
 
-        /// Add a linear fade point. Two must exist for it to be applied.
+        /// Add a fade point. The fade value holds once a point is passed, until the segment to the next one.
         /// @param clock parent clock time (samples)
         /// @param value value to fade to
+        /// @param curve shape of the segment from the previous fade point to this one
         /// @returns whether function succeeded; check `popError` for details.
-        bool addFadePoint(uint32_t clock, float value);
+        bool addFadePoint(uint32_t clock, float value, FadeCurve curve = FadeCurve::Linear);
 
         /// Fade from current value to a target value
         /// @param value  value to fade to
         /// @param length fade time in samples
+        /// @param curve  shape of the fade
         /// @returns whether function succeeded; check `popError` for details.
-        bool fadeTo(float value, uint32_t length);
+        bool fadeTo(float value, uint32_t length, FadeCurve curve = FadeCurve::Linear);
 
         /// Remove fade points between start (inclusive) and end (exclusive), in parent clock cycles
         /// @param start starting point at which to remove fadepoints (inclusive)
@@ -166,8 +163,10 @@ namespace insound {
 
         bool getFadeValue(float *outValue) const;
 
-        /// Swap out this sound source's internal output buffer
-        bool swapBuffers(AlignedVector<uint8_t, 16> *buffer);
+        /// Get the channel layout of this Source's output. Sounds and streams are stereo, buses choose theirs.
+        /// @param outLayout pointer to receive the layout
+        /// @returns whether function succeeded; check `popError` for details.
+        bool getLayout(ChannelLayout *outLayout) const;
 
         /// Calls release on this through the engine.
         /// @param recursive if a sound has child sound Sources, such as a bus, this will call close/release on every
@@ -181,7 +180,22 @@ namespace insound {
     protected:
         Source();
         /// All child classes must implement an init function, and call it's parent's init
-        bool init(Engine *engine , uint32_t parentClock, bool paused);
+        bool init(Engine *engine , uint32_t parentClock, bool paused, ChannelLayout layout = ChannelLayout::Stereo);
+
+        /// Like `close`, but for use in the mix thread, e.g. when a oneshot ends. Does not lock or allocate: the
+        /// Source is queued for the engine to release on the next `Engine::update`. Safe to call every buffer, if the
+        /// queue is full it is retried on the next call.
+        void queueRelease();
+
+        /// For use in the mix thread, whether the engine has an event callback to send events to
+        [[nodiscard]]
+        bool eventsEnabled() const;
+
+        /// For use in the mix thread, queue an event about this Source for the engine's event callback.
+        /// Check `eventsEnabled` first to skip the work of detecting events nobody listens to.
+        /// @param type  event type
+        /// @param index marker index for `SourceEvent::MarkerCrossed`
+        void pushEvent(SourceEvent::Type type, int index = -1);
     private: // private + friend functionality
         /// Clean up logic before Source's pool memory is deallocated, do not call directly
         virtual bool release();
@@ -199,18 +213,24 @@ namespace insound {
         void applyCommand(const SourceCommand &command);
         /// Abstracted into a function for constructor where we immediately add default Pan & Volume to the Source
         void applyAddEffect(const Handle<Effect> &effect, int position);
-        void applyAddFadePoint(uint32_t clock, float value);
-        void applyRemoveFadePoint(uint32_t startClock, uint32_t endClock);
 
         /// Engine calls this in the mixer thread to update clock values (called recursively from master bus)
         virtual bool updateParentClock(uint32_t parentClock);
 
-        /// Cause the sound source to populate its output buffer. Optionally get the current pointer position.
+        /// Cause the sound source to populate an output buffer taken from the engine's scratch arena. The buffers
+        /// stay held until the caller releases them back to a mark it took before reading, see `ScratchArena`.
         /// @param pcmPtr      pointer to receive pointer to data, may be nullptr
         /// @param length      requested bytes
         /// @returns the amount of bytes available or length arg, whichever is smaller
         int read(const uint8_t **pcmPtr, int length);
 
+        /// Apply the default pan and volume effects and the fade points in a single pass, if the effect chain holds
+        /// only the defaults
+        /// @param samples interleaved stereo samples to process in-place
+        /// @param frames  number of frames in `samples`
+        /// @returns false without processing if the chain must run effect by effect
+        bool processDefaultChain(float *samples, uint32_t frames);
+
         /// Implementation for getting PCM data from the Source
         /// TODO: we only support 32-bit float stereo format, so we may not need to pass units in bytes
         /// @param output pointer to the buffer to fill
@@ -220,21 +240,22 @@ namespace insound {
     protected:
         // Cached for convenience
         Engine *m_engine;                ///< Reference to the engine for synchronization with the audio thread
+        Handle<Source> m_handle;         ///< This source's own handle, set by the engine when allocated
         Handle<PanEffect> m_panner;      ///< Default stereo pan effect, second to last in the effect chain
         Handle<VolumeEffect> m_volume;   ///< Default volume effect, last in the effect chain
 
     private: // member variables
         // Data
-        std::vector<Handle<Effect>>m_effects;               ///< Owned audio effects to apply to this source's output
-        AlignedVector<uint8_t, 16> m_outBuffer, m_inBuffer; ///< Temporary buffers to store sound data
-        std::vector<FadePoint> m_fadePoints;                ///< Fade points to apply
+        std::vector<Handle<Effect>>m_effects; ///< Owned audio effects to apply to this source's output
+        Envelope m_fade;                      ///< Fade points, multiplied against output (separate from volume)
+        ChannelLayout m_layout;               ///< Layout of the output, fixed at init
 
         // State
-        float m_fadeValue;                  ///< Current fade value, multiplied against output (separate from volume)
         uint32_t m_clock, m_parentClock;    ///< Current time in samples since Source and parent was added to the mix graph (check engine spec for sample rate)
         bool m_paused;                      ///< Current pause state, when true, no sound will be output
         int m_pauseClock, m_unpauseClock;   ///< Clock times in samples for timed pauses (check engine spec for sample rate)
         bool m_releaseOnPauseClock;         ///< When `m_pauseClock` activates, also mark this sound for deletion
         bool m_shouldDiscard;               ///< discard flag, signals the mix graph to remove this object
+        bool m_releaseQueued;               ///< whether `queueRelease` succeeded, mix thread only
     };
 }
@@ -0,0 +1,33 @@
+#pragma once
+#include "Handle.h"
+
+#include <cstdint>
+
+namespace insound {
+    class Source;
+
+    /// Notification from the mixer about a Source's playback. The mixer queues these without locking, and
+    /// `Engine::update` delivers them in a batch to the callback set with `Engine::setEventCallback`.
+    struct SourceEvent {
+        enum Type : uint8_t {
+            Ended,         ///< a non-looping source played to its end
+            Looped,        ///< playback wrapped from the loop end back to the loop start
+            MarkerCrossed, ///< playback crossed a marker, `index` is its index in the SoundBuffer's `markers()`
+            Underrun,      ///< a stream's decoder couldn't provide enough frames, the rest of the buffer was silent
+        };
+
+        SourceEvent() : type(), source(), index(-1), clock() { }
+        SourceEvent(Type type, const Handle<Source> &source, int index, uint32_t clock) :
+            type(type), source(source), index(index), clock(clock) { }
+
+        Type type;
+        Handle<Source> source; ///< source the event occurred on, may be invalid by delivery if it was released
+        int index;             ///< marker index for `MarkerCrossed`, otherwise -1
+        uint32_t clock;        ///< parent clock at the start of the mixed buffer the event occurred in
+    };
+
+    /// Receives events in `Engine::update`
+    /// @param event    the event
+    /// @param userdata custom data passed to `Engine::setEventCallback`
+    using SourceEventCallback = void (*)(const SourceEvent &event, void *userdata);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace insound {
+    /// Fixed-capacity, lock-free, single-producer single-consumer ring buffer.
+    /// Neither `tryPush` nor `tryPop` allocate or block, so one end may safely be used from the audio thread.
+    /// @tparam T trivially copyable element type
+    template <typename T>
+    class SpscQueue {
+    public:
+        /// @param capacity maximum number of elements held at once, rounded up to a power of two
+        explicit SpscQueue(size_t capacity) : m_buffer(), m_mask(), m_head(0), m_tail(0)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+
+            m_buffer.resize(size);
+            m_mask = size - 1;
+        }
+
+        /// Producer side: append an element
+        /// @returns whether the element was added, false if the queue is full
+        bool tryPush(const T &value)
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+                return false;
+
+            m_buffer[tail & m_mask] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Consumer side: remove the oldest element
+        /// @param outValue pointer to receive the element
+        /// @returns whether an element was removed, false if the queue is empty
+        bool tryPop(T *outValue)
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+                return false;
+
+            if (outValue)
+                *outValue = m_buffer[head & m_mask];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Number of queued elements, only exact when called from either end while the other is idle
+        [[nodiscard]]
+        size_t size() const
+        {
+            const auto head = m_head.load(std::memory_order_acquire);
+            return m_tail.load(std::memory_order_acquire) - head;
+        }
+
+        [[nodiscard]]
+        size_t capacity() const { return m_buffer.size(); }
+
+    private:
+        std::vector<T> m_buffer;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_head; ///< next element to pop, written by the consumer
+        alignas(64) std::atomic<size_t> m_tail; ///< next slot to push, written by the producer
+    };
+}
@@ -25,6 +25,7 @@ namespace insound {
 
         AudioDecoder decoder{};
         bool looping{}, isOneShot{};
+        bool wasEnded{}; ///< ended state of the last read, to send an `Ended` event once
         int bytesPerFrame{};
     };
 
@@ -122,7 +123,7 @@ namespace insound {
         // Error check
         if (framesRead < 0)
         {
-            close();
+            queueRelease();
             std::memset(output, 0, length);
             return length;
         }
@@ -134,7 +135,6 @@ namespace insound {
             std::memset(output + bytesRead, 0, length - bytesRead);
         }
 
-        // Auto-release on end of oneshot
         bool looping;
         if (!m->decoder.getLooping(&looping))
         {
@@ -142,13 +142,23 @@ namespace insound {
             return 0; // shouldn't happen, but just in case
         }
 
-        if (m->isOneShot && !looping)
+        bool ended = false;
+        if (!looping && !m->decoder.isEnded(&ended))
+            ended = false;
+
+        if (eventsEnabled())
+        {
+            if (ended && !m->wasEnded)
+                pushEvent(SourceEvent::Ended);
+            else if (!ended && framesRead < framesToRead)
+                pushEvent(SourceEvent::Underrun);
+        }
+        m->wasEnded = ended;
+
+        // Auto-release on end of oneshot
+        if (m->isOneShot && ended)
         {
-            bool ended;
-            if (m->decoder.isEnded(&ended) && ended)
-            {
-                close();
-            }
+            queueRelease();
         }
 
         return length;
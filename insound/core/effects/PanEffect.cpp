@@ -8,30 +8,28 @@
 
 namespace insound {
     PanEffect::PanEffect(PanEffect &&other) noexcept : Effect(std::move(other)),
-        m_left(other.m_left), m_right(other.m_right)
+        m_left(other.m_left), m_right(other.m_right), m_currentLeft(other.m_currentLeft),
+        m_currentRight(other.m_currentRight), m_hasProcessed(other.m_hasProcessed)
     {
     }
 
-    bool PanEffect::process(const float *input, float *output, const int count)
+    /// Apply constant left and right pan levels
+    static void applyPan(const float *input, float *output, const int count, const float left, const float right)
     {
-        if (m_left == 1.f && m_right == 1.f)
-            return false;
-
-        const auto left = m_left, right = m_right;
         int i = 0;
 #if INSOUND_SSE
         auto a =  _mm_set_ps(1.f - left, 1.f - right, 1.f - left, 1.f - right); // _mm_set_ps requires reverse order
         auto b = _mm_set_ps(right, left, right, left);
         for(; i <= count - 16; i += 16)
         {
-            auto inputVecA0 = _mm_set_ps(input[i+2], input[i+3], input[i],  input[i + 1]);
-            auto inputVecA1 = _mm_set_ps(input[i + 2 + 4], input[i + 3 + 4], input[i + 4],  input[i + 1 + 4]);
-            auto inputVecA2 = _mm_set_ps(input[i + 2 + 8], input[i + 3 + 8], input[i + 8],  input[i + 1 + 8]);
-            auto inputVecA3 = _mm_set_ps(input[i + 2 + 12], input[i + 3 + 12], input[i + 12], input[i + 1 + 12]);
             auto inputVecB0 = _mm_load_ps(input + i);
             auto inputVecB1 = _mm_load_ps(input + i + 4);
             auto inputVecB2 = _mm_load_ps(input + i + 8);
             auto inputVecB3 = _mm_load_ps(input + i + 12);
+            auto inputVecA0 = _mm_shuffle_ps(inputVecB0, inputVecB0, _MM_SHUFFLE(2, 3, 0, 1)); // swap channels
+            auto inputVecA1 = _mm_shuffle_ps(inputVecB1, inputVecB1, _MM_SHUFFLE(2, 3, 0, 1));
+            auto inputVecA2 = _mm_shuffle_ps(inputVecB2, inputVecB2, _MM_SHUFFLE(2, 3, 0, 1));
+            auto inputVecA3 = _mm_shuffle_ps(inputVecB3, inputVecB3, _MM_SHUFFLE(2, 3, 0, 1));
             auto result0 = _mm_add_ps(_mm_mul_ps(inputVecA0, a), _mm_mul_ps(inputVecB0, b));
             auto result1 = _mm_add_ps(_mm_mul_ps(inputVecA1, a), _mm_mul_ps(inputVecB1, b));
             auto result2 = _mm_add_ps(_mm_mul_ps(inputVecA2, a), _mm_mul_ps(inputVecB2, b));
@@ -46,14 +44,14 @@ namespace insound {
         auto b = wasm_f32x4_make(left, right, left, right);
         for (; i <= count - 16; i += 16)
         {
-            auto inputVecA0 = wasm_f32x4_make(input[i + 1], input[i], input[i + 3], input[i + 2]);
-            auto inputVecA1 = wasm_f32x4_make(input[i + 1 + 4], input[i + 4], input[i + 3 + 4], input[i + 2 + 4]);
-            auto inputVecA2 = wasm_f32x4_make(input[i + 1 + 8], input[i + 8], input[i + 3 + 8], input[i + 2 + 8]);
-            auto inputVecA3 = wasm_f32x4_make(input[i + 1 + 12], input[i + 12], input[i + 3 + 12], input[i + 2 + 12]);
             auto inputVecB0 = wasm_v128_load(input + i);
             auto inputVecB1 = wasm_v128_load(input + i + 4);
             auto inputVecB2 = wasm_v128_load(input + i + 8);
             auto inputVecB3 = wasm_v128_load(input + i + 12);
+            auto inputVecA0 = wasm_i32x4_shuffle(inputVecB0, inputVecB0, 1, 0, 3, 2); // swap channels
+            auto inputVecA1 = wasm_i32x4_shuffle(inputVecB1, inputVecB1, 1, 0, 3, 2);
+            auto inputVecA2 = wasm_i32x4_shuffle(inputVecB2, inputVecB2, 1, 0, 3, 2);
+            auto inputVecA3 = wasm_i32x4_shuffle(inputVecB3, inputVecB3, 1, 0, 3, 2);
             auto result0 = wasm_f32x4_add(wasm_f32x4_mul(inputVecA0, a), wasm_f32x4_mul(inputVecB0, b));
             auto result1 = wasm_f32x4_add(wasm_f32x4_mul(inputVecA1, a), wasm_f32x4_mul(inputVecB1, b));
             auto result2 = wasm_f32x4_add(wasm_f32x4_mul(inputVecA2, a), wasm_f32x4_mul(inputVecB2, b));
@@ -64,20 +62,20 @@ namespace insound {
             wasm_v128_store(output + i + 12, result3);
         }
 #elif INSOUND_ARM_NEON
-        float32x4_t a {1.f - m_right, 1.f - m_left, 1.f - m_right, 1.f - m_left};
-        float32x4_t b { m_left, m_right, m_left, m_right };
+        float32x4_t a {1.f - right, 1.f - left, 1.f - right, 1.f - left};
+        float32x4_t b { left, right, left, right };
         for (; i <= count - 16; i += 16)
         {
-            const auto inputVecA0 = float32x4_t{input[i + 1], input[i], input[i + 3], input[i + 2]};
-            const auto inputVecA1 = float32x4_t{input[i + 1 + 4], input[i + 4], input[i + 3 + 4], input[i + 2 + 4]};
-            const auto inputVecA2 = float32x4_t{input[i + 1 + 8], input[i + 8], input[i + 3 + 8], input[i + 2 + 8]};
-            const auto inputVecA3 = float32x4_t{input[i + 1 + 12], input[i + 12], input[i + 3 + 12], input[i + 2 + 12]};
-
             const auto inputVecB0 = vld1q_f32(input + i);
             const auto inputVecB1 = vld1q_f32(input + i + 4);
             const auto inputVecB2 = vld1q_f32(input + i + 8);
             const auto inputVecB3 = vld1q_f32(input + i + 12);
 
+            const auto inputVecA0 = vrev64q_f32(inputVecB0); // swap channels
+            const auto inputVecA1 = vrev64q_f32(inputVecB1);
+            const auto inputVecA2 = vrev64q_f32(inputVecB2);
+            const auto inputVecA3 = vrev64q_f32(inputVecB3);
+
             const auto result0 = vmlaq_f32(vmulq_f32(inputVecA0, a), inputVecB0, b);
             const auto result1 = vmlaq_f32(vmulq_f32(inputVecA1, a), inputVecB1, b);
             const auto result2 = vmlaq_f32(vmulq_f32(inputVecA2, a), inputVecB2, b);
@@ -91,7 +89,7 @@ namespace insound {
         for (; i + 1 <= count - 8; i += 8)
         {
             const auto leftChan0  = (input[i + 1] * (1.f - right)) + (input[i] * left);
-            const auto rightChan0 = (input[i] * (1.f - left)) + (input[i + 1] * m_right);
+            const auto rightChan0 = (input[i] * (1.f - left)) + (input[i + 1] * right);
             const auto leftChan1  = (input[i + 3] * (1.f - right)) + (input[i + 2] * left);
             const auto rightChan1 = (input[i + 2] * (1.f - left)) + (input[i + 3] * right);
             const auto leftChan2  = (input[i + 5] * (1.f - right)) + (input[i + 4] * left);
@@ -111,16 +109,213 @@ namespace insound {
 #endif
         for (; i < count; i += 2)
         {
-            const auto leftChan  = (input[i + 1] * (1.f - m_right)) + (input[i] * m_left);
-            const auto rightChan = (input[i] * (1.f - m_left)) + (input[i + 1] * m_right);
+            const auto leftChan  = (input[i + 1] * (1.f - right)) + (input[i] * left);
+            const auto rightChan = (input[i] * (1.f - left)) + (input[i + 1] * right);
 
             output[i] = leftChan;
             output[i + 1] = rightChan;
         }
+    }
 
+    /// Apply pan levels that change by `leftStep` and `rightStep` each frame. The buffers need not be aligned.
+    static void applyPanRamp(const float *input, float *output, const int count, const float left,
+        const float right, const float leftStep, const float rightStep)
+    {
+        int i = 0;
+#if INSOUND_SSE
+        // two frames per vector, `b` scales each channel's own input, `a` the opposite channel's
+        auto b = _mm_set_ps(right + rightStep, left + leftStep, right, left);
+        auto a = _mm_sub_ps(_mm_set1_ps(1.f), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)));
+        const auto bStep = _mm_set_ps(rightStep * 2.f, leftStep * 2.f, rightStep * 2.f, leftStep * 2.f);
+        const auto aStep = _mm_sub_ps(_mm_setzero_ps(), _mm_shuffle_ps(bStep, bStep, _MM_SHUFFLE(2, 3, 0, 1)));
+        for (; i <= count - 4; i += 4)
+        {
+            const auto in = _mm_loadu_ps(input + i);
+            const auto swapped = _mm_shuffle_ps(in, in, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(swapped, a), _mm_mul_ps(in, b)));
+            a = _mm_add_ps(a, aStep);
+            b = _mm_add_ps(b, bStep);
+        }
+#elif INSOUND_WASM_SIMD
+        auto b = wasm_f32x4_make(left, right, left + leftStep, right + rightStep);
+        auto a = wasm_f32x4_sub(wasm_f32x4_splat(1.f), wasm_i32x4_shuffle(b, b, 1, 0, 3, 2));
+        const auto bStep = wasm_f32x4_make(leftStep * 2.f, rightStep * 2.f, leftStep * 2.f, rightStep * 2.f);
+        const auto aStep = wasm_f32x4_neg(wasm_i32x4_shuffle(bStep, bStep, 1, 0, 3, 2));
+        for (; i <= count - 4; i += 4)
+        {
+            const auto in = wasm_v128_load(input + i);
+            const auto swapped = wasm_i32x4_shuffle(in, in, 1, 0, 3, 2);
+            wasm_v128_store(output + i, wasm_f32x4_add(wasm_f32x4_mul(swapped, a), wasm_f32x4_mul(in, b)));
+            a = wasm_f32x4_add(a, aStep);
+            b = wasm_f32x4_add(b, bStep);
+        }
+#elif INSOUND_ARM_NEON
+        float32x4_t b {left, right, left + leftStep, right + rightStep};
+        auto a = vsubq_f32(vdupq_n_f32(1.f), vrev64q_f32(b));
+        const float32x4_t bStep {leftStep * 2.f, rightStep * 2.f, leftStep * 2.f, rightStep * 2.f};
+        const auto aStep = vnegq_f32(vrev64q_f32(bStep));
+        for (; i <= count - 4; i += 4)
+        {
+            const auto in = vld1q_f32(input + i);
+            vst1q_f32(output + i, vmlaq_f32(vmulq_f32(vrev64q_f32(in), a), in, b));
+            a = vaddq_f32(a, aStep);
+            b = vaddq_f32(b, bStep);
+        }
+#endif
+        for (; i < count; i += 2)
+        {
+            const auto frame = static_cast<float>(i / 2);
+            const auto l = left + leftStep * frame;
+            const auto r = right + rightStep * frame;
+            const auto leftChan  = (input[i + 1] * (1.f - r)) + (input[i] * l);
+            const auto rightChan = (input[i] * (1.f - l)) + (input[i + 1] * r);
+
+            output[i] = leftChan;
+            output[i + 1] = rightChan;
+        }
+    }
+
+    /// Apply pan levels to planar left and right channels in-place, each level changing by its step per frame.
+    /// Both channels line up in their own vectors, so unlike interleaved frames there's nothing to swap.
+    static void applyPlanarPan(float *leftChannel, float *rightChannel, const int frames, const float left,
+        const float right, const float leftStep, const float rightStep)
+    {
+        int i = 0;
+#if INSOUND_SSE
+        auto l = _mm_set_ps(left + leftStep * 3.f, left + leftStep * 2.f, left + leftStep, left);
+        auto r = _mm_set_ps(right + rightStep * 3.f, right + rightStep * 2.f, right + rightStep, right);
+        const auto lStep = _mm_set1_ps(leftStep * 4.f);
+        const auto rStep = _mm_set1_ps(rightStep * 4.f);
+        const auto one = _mm_set1_ps(1.f);
+        for (; i <= frames - 4; i += 4)
+        {
+            const auto inLeft = _mm_loadu_ps(leftChannel + i);
+            const auto inRight = _mm_loadu_ps(rightChannel + i);
+            _mm_storeu_ps(leftChannel + i,
+                _mm_add_ps(_mm_mul_ps(inLeft, l), _mm_mul_ps(inRight, _mm_sub_ps(one, r))));
+            _mm_storeu_ps(rightChannel + i,
+                _mm_add_ps(_mm_mul_ps(inRight, r), _mm_mul_ps(inLeft, _mm_sub_ps(one, l))));
+            l = _mm_add_ps(l, lStep);
+            r = _mm_add_ps(r, rStep);
+        }
+#elif INSOUND_WASM_SIMD
+        auto l = wasm_f32x4_make(left, left + leftStep, left + leftStep * 2.f, left + leftStep * 3.f);
+        auto r = wasm_f32x4_make(right, right + rightStep, right + rightStep * 2.f, right + rightStep * 3.f);
+        const auto lStep = wasm_f32x4_splat(leftStep * 4.f);
+        const auto rStep = wasm_f32x4_splat(rightStep * 4.f);
+        const auto one = wasm_f32x4_splat(1.f);
+        for (; i <= frames - 4; i += 4)
+        {
+            const auto inLeft = wasm_v128_load(leftChannel + i);
+            const auto inRight = wasm_v128_load(rightChannel + i);
+            wasm_v128_store(leftChannel + i, wasm_f32x4_add(wasm_f32x4_mul(inLeft, l),
+                wasm_f32x4_mul(inRight, wasm_f32x4_sub(one, r))));
+            wasm_v128_store(rightChannel + i, wasm_f32x4_add(wasm_f32x4_mul(inRight, r),
+                wasm_f32x4_mul(inLeft, wasm_f32x4_sub(one, l))));
+            l = wasm_f32x4_add(l, lStep);
+            r = wasm_f32x4_add(r, rStep);
+        }
+#elif INSOUND_ARM_NEON
+        float32x4_t l {left, left + leftStep, left + leftStep * 2.f, left + leftStep * 3.f};
+        float32x4_t r {right, right + rightStep, right + rightStep * 2.f, right + rightStep * 3.f};
+        const auto lStep = vdupq_n_f32(leftStep * 4.f);
+        const auto rStep = vdupq_n_f32(rightStep * 4.f);
+        const auto one = vdupq_n_f32(1.f);
+        for (; i <= frames - 4; i += 4)
+        {
+            const auto inLeft = vld1q_f32(leftChannel + i);
+            const auto inRight = vld1q_f32(rightChannel + i);
+            vst1q_f32(leftChannel + i, vmlaq_f32(vmulq_f32(inLeft, l), inRight, vsubq_f32(one, r)));
+            vst1q_f32(rightChannel + i, vmlaq_f32(vmulq_f32(inRight, r), inLeft, vsubq_f32(one, l)));
+            l = vaddq_f32(l, lStep);
+            r = vaddq_f32(r, rStep);
+        }
+#endif
+        for (; i < frames; ++i)
+        {
+            const auto frame = static_cast<float>(i);
+            const auto lv = left + leftStep * frame;
+            const auto rv = right + rightStep * frame;
+            const auto inLeft = leftChannel[i], inRight = rightChannel[i];
+            leftChannel[i] = (inRight * (1.f - rv)) + (inLeft * lv);
+            rightChannel[i] = (inLeft * (1.f - lv)) + (inRight * rv);
+        }
+    }
+
+    bool PanEffect::process(const float *input, float *output, const int count)
+    {
+        if (channels() != 2) // balances a left and right pair only
+            return false;
+
+        const auto left = m_left, right = m_right;
+        if (!m_hasProcessed)
+        {
+            m_currentLeft = left;
+            m_currentRight = right;
+            m_hasProcessed = true;
+        }
+
+        const auto fromLeft = m_currentLeft, fromRight = m_currentRight;
+        if (fromLeft == left && fromRight == right)
+        {
+            if (left == 1.f && right == 1.f)
+                return false;
+
+            applyPan(input, output, count, left, right);
+            return true;
+        }
+
+        // Ramp linearly from the last buffer's levels to the new ones across this buffer
+        m_currentLeft = left;
+        m_currentRight = right;
+        const auto frames = static_cast<float>(count / 2);
+        applyPanRamp(input, output, count, fromLeft, fromRight, (left - fromLeft) / frames,
+            (right - fromRight) / frames);
+
+        return true;
+    }
+
+    bool PanEffect::processPlanar(float *const *planes, const int frames)
+    {
+        if (channels() != 2)
+            return false;
+
+        float fromLeft, fromRight, left, right;
+        takeRamp(&fromLeft, &fromRight, &left, &right);
+        if (fromLeft == left && fromRight == right)
+        {
+            if (left == 1.f && right == 1.f)
+                return false;
+
+            applyPlanarPan(planes[0], planes[1], frames, left, right, 0, 0);
+            return true;
+        }
+
+        // Ramp linearly from the last buffer's levels to the new ones across this buffer
+        const auto length = static_cast<float>(frames);
+        applyPlanarPan(planes[0], planes[1], frames, fromLeft, fromRight, (left - fromLeft) / length,
+            (right - fromRight) / length);
         return true;
     }
 
+    void PanEffect::takeRamp(float *outFromLeft, float *outFromRight, float *outToLeft, float *outToRight)
+    {
+        const auto left = m_left, right = m_right;
+        if (!m_hasProcessed)
+        {
+            m_currentLeft = left;
+            m_currentRight = right;
+            m_hasProcessed = true;
+        }
+
+        *outFromLeft = m_currentLeft;
+        *outFromRight = m_currentRight;
+        *outToLeft = left;
+        *outToRight = right;
+        m_currentLeft = left;
+        m_currentRight = right;
+    }
+
     void PanEffect::receiveFloat(int index, float value)
     {
         switch(index)
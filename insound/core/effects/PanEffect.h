@@ -3,18 +3,29 @@
 
 namespace insound {
 
+    /// Stereo balance, as levels for the left and right channel. Sources in other layouts pass through unchanged.
     class PanEffect : public Effect {
     public:
-        PanEffect() : m_left(1.f), m_right(1.f) { }
-        PanEffect(float left, float right) : m_left(left), m_right(right) { }
+        PanEffect() : m_left(1.f), m_right(1.f), m_currentLeft(1.f), m_currentRight(1.f), m_hasProcessed(false) { }
+        PanEffect(float left, float right) : m_left(left), m_right(right), m_currentLeft(left),
+            m_currentRight(right), m_hasProcessed(false) { }
         PanEffect(PanEffect &&other) noexcept;
 
         bool process(const float *input, float *output, int count) override;
+        [[nodiscard]]
+        bool processesInPlace() const override { return true; }
+
+        bool processPlanar(float *const *planes, int frames) override;
+        [[nodiscard]]
+        SampleOrder sampleOrder() const override { return SampleOrder::Either; }
 
         bool init()
         {
             m_left = 1.f;
             m_right = 1.f;
+            m_currentLeft = 1.f;
+            m_currentRight = 1.f;
+            m_hasProcessed = false;
 
             return true;
         }
@@ -31,6 +42,11 @@ namespace insound {
         auto right() const { return m_right; }
 
     private:
+        friend class Source;
+        /// Advance the levels by one buffer without processing, for a Source applying them in a fused pass.
+        /// Levels ramp linearly from the start to the end of the buffer.
+        void takeRamp(float *outFromLeft, float *outFromRight, float *outToLeft, float *outToRight);
+
         struct Param {
             enum Enum {
                 Left,
@@ -40,7 +56,9 @@ namespace insound {
 
         void receiveFloat(int index, float value) override;
 
-        float m_left, m_right;
+        float m_left, m_right;               ///< target levels
+        float m_currentLeft, m_currentRight; ///< levels reached at the end of the last processed buffer
+        bool m_hasProcessed;                 ///< levels set before the first buffer apply immediately, without a ramp
     };
 
 } // insound
@@ -2,104 +2,137 @@
 
 #include "../CpuIntrinsics.h"
 #include "../Error.h"
+#include "../MixKernels.h"
 
+#include <cmath>
 #include <utility>
 
 namespace insound {
     VolumeEffect::VolumeEffect(VolumeEffect &&other) noexcept : Effect(std::move(other)),
-        m_volume(other.m_volume)
+        m_volume(other.m_volume), m_current(other.m_current), m_ramp(other.m_ramp),
+        m_hasProcessed(other.m_hasProcessed)
     {
     }
 
-    bool VolumeEffect::process(const float *input, float *output, int count)
+    /// Multiply samples by a volume that changes by `step` each frame, starting from `from`
+    static void applyLinearRamp(const float *input, float *output, const int count, const int channels,
+        const float from, const float step)
     {
-        const auto volume = m_volume;
+        if (channels != 2)
+        {
+            for (int i = 0; i < count; i += channels)
+            {
+                const auto gain = from + step * static_cast<float>(i / channels);
+                for (int c = i; c < i + channels; ++c)
+                    output[c] = input[c] * gain;
+            }
+            return;
+        }
 
-        if (volume == 1.f)
-            return false;
+        mixKernels().stereoRamp(input, output, static_cast<uint32_t>(count / 2), from, step);
+    }
 
-#if     INSOUND_SSE
-        int i = 0;
-        const auto volumes = _mm_set1_ps(volume);
-        for(; i <= count - 16; i += 16)
+    /// Multiply samples by a volume that changes by a factor of `ratio` each frame, starting from `from`. The
+    /// buffers need not be aligned, callers may pass a block that starts partway into a buffer.
+    static void applyExponentialRamp(const float *input, float *output, const int count, const int channels,
+        const float from, const float ratio)
+    {
+        if (channels != 2)
         {
-            auto a = _mm_load_ps(input + i);
-            auto b = _mm_load_ps(input + i + 4);
-            auto c = _mm_load_ps(input + i + 8);
-            auto d = _mm_load_ps(input + i + 12);
-            auto resultA = _mm_mul_ps(a, volumes);
-            auto resultB = _mm_mul_ps(b, volumes);
-            auto resultC = _mm_mul_ps(c, volumes);
-            auto resultD = _mm_mul_ps(d, volumes);
-            _mm_store_ps(output + i, resultA);
-            _mm_store_ps(output + i + 4, resultB);
-            _mm_store_ps(output + i + 8, resultC);
-            _mm_store_ps(output + i + 12, resultD);
+            auto gain = from;
+            for (int i = 0; i < count; i += channels)
+            {
+                for (int c = i; c < i + channels; ++c)
+                    output[c] = input[c] * gain;
+                gain *= ratio;
+            }
+            return;
         }
 
-#elif   INSOUND_WASM_SIMD
         int i = 0;
-        const auto volumes = wasm_f32x4_splat(m_volume);
-        for(; i <= count - 16; i += 16)
+        auto gain = from;
+#if     INSOUND_SSE
+        auto gains = _mm_set_ps(from * ratio, from * ratio, from, from);
+        const auto ratios = _mm_set1_ps(ratio * ratio);
+        for (; i <= count - 4; i += 4)
         {
-            auto a = wasm_v128_load(input + i);
-            auto b = wasm_v128_load(input + i + 4);
-            auto c = wasm_v128_load(input + i + 8);
-            auto d = wasm_v128_load(input + i + 12);
-            auto resultA = wasm_f32x4_mul(a, volumes);
-            auto resultB = wasm_f32x4_mul(b, volumes);
-            auto resultC = wasm_f32x4_mul(c, volumes);
-            auto resultD = wasm_f32x4_mul(d, volumes);
-            wasm_v128_store(output + i, resultA);
-            wasm_v128_store(output + i + 4, resultB);
-            wasm_v128_store(output + i + 8, resultC);
-            wasm_v128_store(output + i + 12, resultD);
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), gains));
+            gains = _mm_mul_ps(gains, ratios);
         }
-#elif INSOUND_ARM_NEON
-        int i = 0;
-        float32x4_t volumes = vdupq_n_f32(volume);
-        for (; i <= count - 16; i += 16)
+        gain = _mm_cvtss_f32(gains);
+#elif   INSOUND_WASM_SIMD
+        auto gains = wasm_f32x4_make(from, from, from * ratio, from * ratio);
+        const auto ratios = wasm_f32x4_splat(ratio * ratio);
+        for (; i <= count - 4; i += 4)
         {
-            float32x4_t a = vld1q_f32(input + i);
-            float32x4_t b = vld1q_f32(input + i + 4);
-            float32x4_t c = vld1q_f32(input + i + 8);
-            float32x4_t d = vld1q_f32(input + i + 12);
-            float32x4_t resultA = vmulq_f32(a, volumes);
-            float32x4_t resultB = vmulq_f32(b, volumes);
-            float32x4_t resultC = vmulq_f32(c, volumes);
-            float32x4_t resultD = vmulq_f32(d, volumes);
-            vst1q_f32(output + i, resultA);
-            vst1q_f32(output + i + 4, resultB);
-            vst1q_f32(output + i + 8, resultC);
-            vst1q_f32(output + i + 12, resultD);
+            wasm_v128_store(output + i, wasm_f32x4_mul(wasm_v128_load(input + i), gains));
+            gains = wasm_f32x4_mul(gains, ratios);
         }
-#else
-        int i = 0;
-        for (; i <= count - 16; i += 16)
+        gain = wasm_f32x4_extract_lane(gains, 0);
+#elif   INSOUND_ARM_NEON
+        float32x4_t gains {from, from, from * ratio, from * ratio};
+        const auto ratios = vdupq_n_f32(ratio * ratio);
+        for (; i <= count - 4; i += 4)
         {
-            output[i] = input[i] * volume;
-            output[i+1] = input[i+1] * volume;
-            output[i+2] = input[i+2] * volume;
-            output[i+3] = input[i+3] * volume;
-            output[i+4] = input[i+4] * volume;
-            output[i+5] = input[i+5] * volume;
-            output[i+6] = input[i+6] * volume;
-            output[i+7] = input[i+7] * volume;
-            output[i+8] = input[i+8] * volume;
-            output[i+9] = input[i+9] * volume;
-            output[i+10] = input[i+10] * volume;
-            output[i+11] = input[i+11] * volume;
-            output[i+12] = input[i+12] * volume;
-            output[i+13] = input[i+13] * volume;
-            output[i+14] = input[i+14] * volume;
-            output[i+15] = input[i+15] * volume;
+            vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), gains));
+            gains = vmulq_f32(gains, ratios);
         }
+        gain = vgetq_lane_f32(gains, 0);
 #endif
-        for (; i < count; ++i)
+        for (; i < count; i += 2)
+        {
+            output[i] = input[i] * gain;
+            output[i + 1] = input[i + 1] * gain;
+            gain *= ratio;
+        }
+    }
+
+    bool VolumeEffect::process(const float *input, float *output, int count)
+    {
+        const auto volume = m_volume;
+        if (!m_hasProcessed)
+        {
+            m_current = volume;
+            m_hasProcessed = true;
+        }
+
+        const auto from = m_current;
+        if (from == volume)
+        {
+            if (volume == 1.f)
+                return false;
+
+            mixKernels().gain(input, output, static_cast<uint32_t>(count), volume);
+            return true;
+        }
+
+        // Ramp from the last buffer's volume to the new one across this buffer
+        m_current = volume;
+        const auto frames = static_cast<float>(count / channels());
+        if (m_ramp == Ramp::Exponential && from > 0 && volume > 0)
+            applyExponentialRamp(input, output, count, channels(), from, std::pow(volume / from, 1.f / frames));
+        else
+            applyLinearRamp(input, output, count, channels(), from, (volume - from) / frames);
+
+        return true;
+    }
+
+    bool VolumeEffect::takeLinearRamp(float *outFrom, float *outTo)
+    {
+        const auto volume = m_volume;
+        if (!m_hasProcessed)
         {
-            output[i] = input[i] * volume;
+            m_current = volume;
+            m_hasProcessed = true;
         }
 
+        const auto from = m_current;
+        if (from != volume && m_ramp == Ramp::Exponential && from > 0 && volume > 0)
+            return false;
+
+        m_current = volume;
+        *outFrom = from;
+        *outTo = volume;
         return true;
     }
 
@@ -119,8 +152,29 @@ namespace insound {
         }
     }
 
+    void VolumeEffect::receiveInt(int index, int value)
+    {
+        switch(index)
+        {
+            case Param::Ramp:
+            {
+                m_ramp = static_cast<Ramp>(value);
+            } break;
+
+            default:
+            {
+                INSOUND_PUSH_ERROR(Result::InvalidArg, "Unknown parameter index");
+            } break;
+        }
+    }
+
     void VolumeEffect::volume(float value)
     {
         sendFloat(Param::Volume, value);
     }
+
+    void VolumeEffect::ramp(Ramp value)
+    {
+        sendInt(Param::Ramp, static_cast<int>(value));
+    }
 }
@@ -4,8 +4,15 @@
 namespace insound {
     class VolumeEffect : public Effect {
     public:
+        /// Curve followed by the gain when the volume changes. The change is spread across one buffer to avoid
+        /// zipper noise.
+        enum class Ramp {
+            Linear,      ///< constant step per frame
+            Exponential, ///< constant ratio per frame, even in decibels; falls back to linear to or from zero
+        };
+
         VolumeEffect()
-            : m_volume(1.f)
+            : m_volume(1.f), m_current(1.f), m_ramp(Ramp::Linear), m_hasProcessed(false)
         {
         }
 
@@ -14,27 +21,48 @@ namespace insound {
         bool init(float volume = 1.f)
         {
             m_volume = volume;
+            m_current = volume;
+            m_ramp = Ramp::Linear;
+            m_hasProcessed = false;
 
             return true;
         }
 
-        explicit VolumeEffect(float volume) : m_volume(volume) { }
+        explicit VolumeEffect(float volume) : m_volume(volume), m_current(volume), m_ramp(Ramp::Linear),
+            m_hasProcessed(false) { }
 
         bool process(const float *input, float *output, int count) override;
+        [[nodiscard]]
+        bool processesInPlace() const override { return true; }
 
         [[nodiscard]]
         float volume() const { return m_volume; }
         void volume(float value);
 
+        [[nodiscard]]
+        Ramp ramp() const { return m_ramp; }
+        void ramp(Ramp value);
+
     private:
+        friend class Source;
+        /// Advance the volume by one buffer without processing, for a Source applying it in a fused pass
+        /// @param outFrom [out] volume at the start of the buffer
+        /// @param outTo   [out] volume at the end, ramped linearly from `outFrom`
+        /// @returns false without advancing if the buffer needs an exponential ramp
+        bool takeLinearRamp(float *outFrom, float *outTo);
+
         void receiveFloat(int index, float value) override;
+        void receiveInt(int index, int value) override;
 
         struct Param {
             enum Enum {
                 Volume,
+                Ramp,
             };
         };
-        float m_volume;
+        float m_volume;      ///< target volume
+        float m_current;     ///< volume reached at the end of the last processed buffer
+        Ramp m_ramp;
+        bool m_hasProcessed; ///< volumes set before the first buffer apply immediately, without a ramp
     };
 }
-
@@ -59,7 +59,8 @@ static ma_bool32 dr_wav_seek_callback(void* pUserData, int offset, ma_dr_wav_see
     return streamable->seek(offset);
 }
 
-bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<insound::Marker> *outMarkers)
+bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<insound::Marker> *outMarkers,
+    std::vector<insound::LoopRegion> *outLoops)
 {
     insound::Rstream stream;
     if (!stream.openFile(filepath))
@@ -85,6 +86,7 @@ bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<inso
 
     // Collect marker metadata
     std::map<uint32_t, insound::Marker> markers;
+    std::vector<insound::LoopRegion> loops;
     try
     {
         const auto bytesPerFrame = wav.channels * (wav.bitsPerSample / CHAR_BIT);
@@ -112,6 +114,18 @@ bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<inso
                     markers[cuePointId].label = std::string(pString, stringLength);
                 } break;
 
+                case ma_dr_wav_metadata_type_smpl:
+                {
+                    // Loop points are sample frame offsets, the last one is inclusive
+                    const auto count = meta->data.smpl.sampleLoopCount;
+                    for (auto loop = meta->data.smpl.pLoops, loopEnd = loop + (loop ? count : 0);
+                        loop != loopEnd; ++loop)
+                    {
+                        if (loop->lastSampleByteOffset >= loop->firstSampleByteOffset)
+                            loops.emplace_back(loop->firstSampleByteOffset, loop->lastSampleByteOffset + 1);
+                    }
+                } break;
+
                 default:
                     break;
             }
@@ -144,6 +158,11 @@ bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<inso
         }
     }
 
+    if (outLoops)
+    {
+        outLoops->swap(loops);
+    }
+
     return true;
 }
 
@@ -6,4 +6,8 @@
 #include <vector>
 
 /// Get marker data from a WAV file
-bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<insound::Marker> *outMarkers);
+/// @param filepath    path to the WAV file
+/// @param outMarkers  [out] receives cue point markers
+/// @param outLoops    [out] optional, receives loop regions from the sampler (smpl) chunk
+bool insound_ma_dr_wav_get_markers(const std::string &filepath, std::vector<insound::Marker> *outMarkers,
+    std::vector<insound::LoopRegion> *outLoops = nullptr);
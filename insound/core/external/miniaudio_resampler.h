@@ -0,0 +1,20 @@
+#pragma once
+#include "miniaudio.h"
+
+#include <insound/core/Resampler.h>
+
+#include <cstdint>
+
+/// Custom miniaudio resampling backend running insound's polyphase Resampler.
+/// Backend user data holds the `insound::ResampleQuality`, use `insound_ma_use_polyphase_resampler` to set both.
+extern ma_resampling_backend_vtable g_ma_resampling_backend_vtable_insound;
+
+/// Configure a miniaudio resampling config to use the polyphase backend
+/// @param config  `resampling` member of a decoder or data converter config
+/// @param quality filter quality tier
+inline void insound_ma_use_polyphase_resampler(ma_resampler_config *config, insound::ResampleQuality quality)
+{
+    config->algorithm = ma_resample_algorithm_custom;
+    config->pBackendVTable = &g_ma_resampling_backend_vtable_insound;
+    config->pBackendUserData = reinterpret_cast<void *>(static_cast<intptr_t>(quality));
+}
@@ -3,6 +3,7 @@
 #include <insound/core/AudioDecoder.h>
 
 #include "../AudioSpec.h"
+#include "../DataConverter.h"
 #include "../Error.h"
 #include "../Marker.h"
 #include "../path.h"
@@ -10,11 +11,16 @@
 #include <insound/core/external/miniaudio.h>
 #include <insound/core/external/miniaudio_ext.h>
 
-bool insound::loadAudio(const std::string &path, const AudioSpec &targetSpec, uint8_t **outBuffer, uint32_t *outLength, std::vector<Marker> *outMarkers)
+bool insound::loadAudio(const std::string &path, const AudioSpec &targetSpec, uint8_t **outBuffer, uint32_t *outLength, std::vector<Marker> *outMarkers, AudioSpec *outSpec,
+    std::vector<LoopRegion> *outLoops)
 {
-    // Open audio decoder to read PCM data
+    // Open audio decoder to read PCM data in its native format, conversion is done in bulk afterward
     AudioDecoder decoder;
-    if (!decoder.open(path, targetSpec))
+    if (!decoder.open(path, AudioSpec{}))
+        return false;
+
+    AudioSpec spec;
+    if (!decoder.getSpec(&spec))
         return false;
 
     uint64_t pcmFrameLength;
@@ -22,8 +28,12 @@ bool insound::loadAudio(const std::string &path, const AudioSpec &targetSpec, ui
         return false;
 
     // Allocate buffer to store frames
-    uint64_t bufferSize = pcmFrameLength * targetSpec.bytesPerFrame();
-    auto buffer = (uint8_t *)std::malloc(bufferSize);
+    auto buffer = (uint8_t *)std::malloc(pcmFrameLength * spec.bytesPerFrame());
+    if (!buffer)
+    {
+        INSOUND_PUSH_ERROR(Result::OutOfMemory, "Failed to allocate sample buffer");
+        return false;
+    }
 
     // Get the PCM data
     if (!decoder.readFrames(static_cast<int>(pcmFrameLength), buffer))
@@ -32,10 +42,28 @@ bool insound::loadAudio(const std::string &path, const AudioSpec &targetSpec, ui
         return false;
     }
 
-    // Collect and return markers if out value provided
-    if (outMarkers)
+    // Zero-ed target fields keep the native values
+    auto finalSpec = targetSpec;
+    if (finalSpec.freq == 0)
+        finalSpec.freq = spec.freq;
+    if (finalSpec.channels == 0)
+        finalSpec.channels = spec.channels;
+    if (finalSpec.format.flags() == 0)
+        finalSpec.format = spec.format;
+
+    // Convert to the target format
+    DataConverter converter;
+    if (!converter.setSpecs(spec, finalSpec, ResampleQuality::High) || !converter.convert(&buffer, pcmFrameLength, &pcmFrameLength))
+    {
+        std::free(buffer);
+        return false;
+    }
+
+    // Collect and return markers and loop regions if out values provided
+    if (outMarkers || outLoops)
     {
         std::vector<Marker> markers;
+        std::vector<LoopRegion> loops;
 
         // Uppercase extension for uniform check
         const auto extView = path::extension(path);
@@ -47,31 +75,42 @@ bool insound::loadAudio(const std::string &path, const AudioSpec &targetSpec, ui
 
         if (ext == ".WAV") // for now only .WAV files are supported
         {
-            if (!insound_ma_dr_wav_get_markers(path, &markers))
+            if (!insound_ma_dr_wav_get_markers(path, &markers, &loops))
             {
                 std::free(buffer);
                 return false;
             }
         }
 
-        // Adjust marker positions to new samplerate, if necessary
-        AudioSpec spec;
-        if (!decoder.getSpec(&spec))
-        {
-            std::free(buffer);
-            return false;
-        }
-
-        if (targetSpec.freq != spec.freq)
+        // Adjust marker and loop positions to new samplerate, if necessary
+        if (finalSpec.freq != spec.freq)
         {
-            const auto sizeFactor = (float)targetSpec.freq / (float)spec.freq;
+            const auto sizeFactor = (double)finalSpec.freq / (double)spec.freq;
             for (auto &marker : markers)
             {
-                marker.position = (uint32_t)std::round((float)marker.position * sizeFactor);
+                marker.position = (uint32_t)std::round((double)marker.position * sizeFactor);
+            }
+
+            for (auto &loop : loops)
+            {
+                loop.start = (uint32_t)std::round((double)loop.start * sizeFactor);
+                loop.end = (uint32_t)std::round((double)loop.end * sizeFactor);
             }
         }
 
-        outMarkers->swap(markers);
+        // Drop loops that fall outside of the converted data
+        for (auto it = loops.begin(); it != loops.end();)
+        {
+            if (it->start >= it->end || it->end > pcmFrameLength)
+                it = loops.erase(it);
+            else
+                ++it;
+        }
+
+        if (outMarkers)
+            outMarkers->swap(markers);
+        if (outLoops)
+            outLoops->swap(loops);
     }
 
     // Done, return the other out-values
@@ -81,7 +120,10 @@ bool insound::loadAudio(const std::string &path, const AudioSpec &targetSpec, ui
         std::free(buffer);
 
     if (outLength) // return the total byte length of the buffer
-        *outLength = pcmFrameLength * targetSpec.bytesPerFrame();
+        *outLength = pcmFrameLength * finalSpec.bytesPerFrame();
+
+    if (outSpec)
+        *outSpec = finalSpec;
 
     return true;
 }
@@ -105,6 +147,7 @@ bool insound::convertAudio(uint8_t *audioData, const uint32_t length, const Audi
     if (cvtResult < 0)
     {
         INSOUND_PUSH_ERROR(Result::SdlErr, SDL_GetError());
+        std::free(audioData);
         return false;
     }
 
@@ -122,7 +165,20 @@ bool insound::convertAudio(uint8_t *audioData, const uint32_t length, const Audi
     // Convert audio
     cvt.len = (int)length;
     cvt.buf = (uint8_t *)std::realloc(audioData, cvt.len * cvt.len_mult);
+    if (!cvt.buf)
+    {
+        INSOUND_PUSH_ERROR(Result::OutOfMemory, "convertAudio: failed to grow the buffer for conversion");
+        std::free(audioData); // realloc leaves the original allocation intact on failure
+        return false;
+    }
+
     cvtResult = SDL_ConvertAudio(&cvt);
+    if (cvtResult != 0)
+    {
+        INSOUND_PUSH_ERROR(Result::SdlErr, SDL_GetError());
+        std::free(cvt.buf);
+        return false;
+    }
 
     if (outLength)
         *outLength = cvt.len_cvt;
@@ -132,10 +188,7 @@ bool insound::convertAudio(uint8_t *audioData, const uint32_t length, const Audi
     else
         std::free(cvt.buf);
 
-    if (cvtResult != 0)
-        INSOUND_PUSH_ERROR(Result::SdlErr, SDL_GetError());
-
-    return cvtResult == 0;
+    return true;
 }
 
 
@@ -156,8 +209,11 @@ bool insound::convertAudio(uint8_t *audioData, const uint32_t length, const Audi
     outSpec.freq = targetSpec.freq;
     outSpec.format = targetSpec.format.flags();
 
+    uint8_t *converted;
     int outLengthTemp;
-    if (SDL_ConvertAudioSamples(&inSpec, audioData, length, &outSpec, outBuffer, &outLengthTemp) != 0)
+    const auto result = SDL_ConvertAudioSamples(&inSpec, audioData, length, &outSpec, &converted, &outLengthTemp);
+    std::free(audioData); // SDL converts into a new allocation, the source is no longer needed either way
+    if (result != 0)
     {
         INSOUND_PUSH_ERROR(Result::SdlErr, SDL_GetError());
         return false;
@@ -168,60 +224,42 @@ bool insound::convertAudio(uint8_t *audioData, const uint32_t length, const Audi
         *outLength = static_cast<uint32_t>(outLengthTemp);
     }
 
+    if (outBuffer)
+        *outBuffer = converted;
+    else
+        SDL_free(converted);
+
     return true;
 }
 
 #else
-#include <insound/core/external/miniaudio.h>
-#include <insound/core/SampleFormat.h>
 
-/// Default miniaudio conversion, which requires an additional buffer allocation
+/// Default conversion via DataConverter, which requires an additional buffer allocation
 bool insound::convertAudio(uint8_t *audioData, const uint32_t length, const AudioSpec &dataSpec,
                            const AudioSpec &targetSpec, uint8_t **outBuffer, uint32_t *outLength)
 {
-    const auto config = ma_data_converter_config_init(
-        (ma_format)toMaFormat(dataSpec.format), (ma_format)toMaFormat(targetSpec.format),
-        dataSpec.channels, targetSpec.channels, dataSpec.freq, targetSpec.freq);
-    ma_data_converter converter;
-    if (ma_data_converter_init(&config, nullptr, &converter) != MA_SUCCESS)
+    DataConverter converter;
+    if (!converter.setSpecs(dataSpec, targetSpec, ResampleQuality::High))
     {
-        INSOUND_PUSH_ERROR(Result::RuntimeErr, "Failed to initialize ma_data_converter");
+        std::free(audioData);
         return false;
     }
 
-    ma_uint64 inFrames = length / (dataSpec.channels * (dataSpec.format.bits() / CHAR_BIT));
-    ma_uint64 outFrames;
-    if (ma_data_converter_get_expected_output_frame_count(&converter, inFrames, &outFrames) != MA_SUCCESS)
+    uint64_t frames;
+    if (!converter.convert(&audioData, length / dataSpec.bytesPerFrame(), &frames))
     {
-        INSOUND_PUSH_ERROR(Result::RuntimeErr, "Failed to get expected output frame count");
-        ma_data_converter_uninit(&converter, nullptr);
-        return false;
-    }
-
-    size_t outSize = outFrames * targetSpec.channels * (targetSpec.format.bits() / CHAR_BIT);
-
-    auto outMem = (uint8_t *)std::malloc(outSize);
-    if (ma_data_converter_process_pcm_frames(&converter, audioData, &inFrames, outMem, &outFrames) != MA_SUCCESS)
-    {
-        INSOUND_PUSH_ERROR(Result::RuntimeErr, "Failed to process pcm frames");
-        ma_data_converter_uninit(&converter, nullptr);
+        std::free(audioData);
         return false;
     }
 
     if (outLength)
-        *outLength = static_cast<uint32_t>(outSize);
+        *outLength = static_cast<uint32_t>(frames * targetSpec.bytesPerFrame());
 
     if (outBuffer)
-    {
-        *outBuffer = outMem;
-    }
+        *outBuffer = audioData;
     else
-    {
-        std::free(outMem);
-    }
+        std::free(audioData);
 
-    ma_data_converter_uninit(&converter, nullptr);
-    std::free(audioData);
     return true;
 }
 
@@ -12,9 +12,12 @@ namespace insound {
     ///
     /// @param path        path to the file to load. On html5 platform, you may load from an http URL if this function is run
     ///                    in another thread. AudioLoader implements this, as an example.
-    /// @param targetSpec  specification to convert this audio format to.
+    /// @param targetSpec  specification to convert this audio format to, any zero-ed fields keep the file's native values
+    /// @param outSpec     [out] optional, receives the spec of the resulting buffer, with zero-ed fields resolved
+    /// @param outLoops    [out] optional, receives loop regions, for now only parsed from WAV sampler chunks
     bool loadAudio(const std::string &path, const AudioSpec &targetSpec,
-        uint8_t **outBuffer, uint32_t *outLength, std::vector<Marker> *outMarkers);
+        uint8_t **outBuffer, uint32_t *outLength, std::vector<Marker> *outMarkers, AudioSpec *outSpec = nullptr,
+        std::vector<LoopRegion> *outLoops = nullptr);
 
     /// Convert audio from one format to another. Intended for single use.
     /// @param audioData  sample data pointer; function takes ownership, and it is no longer valid, retrieve resultant pointer in `outBuffer`
@@ -247,9 +247,10 @@ namespace insound {
         delete m;
     }
 
-    bool EmAudioDevice::open(const int frequency, const int sampleFrameBufferSize,
+    bool EmAudioDevice::open(const int frequency, int channels, const int sampleFrameBufferSize,
         AudioCallback audioCallback, void *userdata)
     {
+        // Web Audio worklet output is stereo, the engine mixes down to the opened spec
         return m->open(frequency, sampleFrameBufferSize, audioCallback, userdata);
     }
 
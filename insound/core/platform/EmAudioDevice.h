@@ -11,6 +11,7 @@ namespace insound {
         ~EmAudioDevice() override;
 
         bool open(int frequency,
+            int channels,
             int sampleFrameBufferSize,
             AudioCallback audioCallback,
             void *userdata) override;
@@ -0,0 +1,88 @@
+#include "NullAudioDevice.h"
+
+#include <insound/core/util.h>
+
+#include <climits>
+#include <cstring>
+
+namespace insound {
+    NullAudioDevice::NullAudioDevice() : m_callback(), m_userdata(), m_buffer(), m_spec(), m_isOpen(),
+        m_isRunning()
+    { }
+
+    NullAudioDevice::~NullAudioDevice()
+    {
+        close();
+    }
+
+    bool NullAudioDevice::open(const int frequency, const int channels, const int sampleFrameBufferSize,
+        const AudioCallback engineCallback, void *userdata)
+    {
+        m_spec.channels = channels;
+        m_spec.freq = frequency ? frequency : getDefaultSampleRate();
+        m_spec.format = SampleFormat(sizeof(float) * CHAR_BIT, true, endian::native == endian::big, true);
+        m_callback = engineCallback;
+        m_userdata = userdata;
+        m_buffer.resize(sampleFrameBufferSize * sizeof(float) * channels);
+        m_isOpen = true;
+        m_isRunning = true;
+        return true;
+    }
+
+    void NullAudioDevice::close()
+    {
+        m_isOpen = false;
+        m_isRunning = false;
+    }
+
+    void NullAudioDevice::suspend()
+    {
+        m_isRunning = false;
+    }
+
+    void NullAudioDevice::resume()
+    {
+        if (m_isOpen)
+            m_isRunning = true;
+    }
+
+    const AlignedVector<uint8_t, 16> &NullAudioDevice::process()
+    {
+        if (m_isRunning && m_callback)
+            m_callback(m_userdata, &m_buffer);
+        else
+            std::memset(m_buffer.data(), 0, m_buffer.size());
+
+        return m_buffer;
+    }
+
+    bool NullAudioDevice::isOpen() const
+    {
+        return m_isOpen;
+    }
+
+    bool NullAudioDevice::isRunning() const
+    {
+        return m_isRunning;
+    }
+
+    uint32_t NullAudioDevice::id() const
+    {
+        return m_isOpen ? 1 : 0;
+    }
+
+    const AudioSpec &NullAudioDevice::spec() const
+    {
+        return m_spec;
+    }
+
+    int NullAudioDevice::bufferSize() const
+    {
+        return static_cast<int>(m_buffer.size());
+    }
+
+    int NullAudioDevice::getDefaultSampleRate() const
+    {
+        return 48000;
+    }
+}
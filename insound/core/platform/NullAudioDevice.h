@@ -0,0 +1,42 @@
+#pragma once
+#include <insound/core/AudioDevice.h>
+
+namespace insound {
+
+    /// Device with no audio output, the audio callback only runs when `process` is called.
+    /// Use it to run the mixer deterministically in tests and tools, or for offline rendering.
+    /// Pass it to `Engine(AudioDevice *)`, which takes ownership.
+    class NullAudioDevice : public AudioDevice {
+    public:
+        NullAudioDevice();
+        ~NullAudioDevice() override;
+
+        bool open(int frequency,
+            int channels,
+            int sampleFrameBufferSize,
+            AudioCallback engineCallback,
+            void *userdata) override;
+        void close() override;
+        void suspend() override;
+        void resume() override;
+
+        /// Mix one buffer by calling the audio callback on the current thread, as a hardware device would.
+        /// Does nothing if the device is closed or suspended.
+        /// @returns the mixed interleaved stereo float samples, valid until the next call
+        const AlignedVector<uint8_t, 16> &process();
+
+        [[nodiscard]] bool isOpen() const override;
+        [[nodiscard]] bool isRunning() const override;
+        [[nodiscard]] uint32_t id() const override;
+        [[nodiscard]] const AudioSpec &spec() const override;
+        [[nodiscard]] int bufferSize() const override;
+        [[nodiscard]] int getDefaultSampleRate() const override;
+    private:
+        AudioCallback m_callback;
+        void *m_userdata;
+        AlignedVector<uint8_t, 16> m_buffer;
+        AudioSpec m_spec;
+        bool m_isOpen, m_isRunning;
+    };
+
+} // insound
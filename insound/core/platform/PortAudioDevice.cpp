@@ -157,11 +157,12 @@ namespace insound {
             }
 
             return open(Pa_GetDefaultOutputDevice(),
-                spec.freq, static_cast<int>(requestedBufferFrames),
+                spec.freq, spec.channels, static_cast<int>(requestedBufferFrames),
                 callback, userdata);
         }
 
-        bool open(PaDeviceIndex devId, int frequency, int sampleFrameBufferSize, AudioCallback engineCallback, void *userdata)
+        bool open(PaDeviceIndex devId, int frequency, int channels, int sampleFrameBufferSize,
+            AudioCallback engineCallback, void *userdata)
         {
             std::unique_lock lockGuard(this->mutex);
 
@@ -169,7 +170,7 @@ namespace insound {
             PaStream *stream;
             PaStreamParameters outParams{};
             outParams.device = devId;
-            outParams.channelCount = 2;
+            outParams.channelCount = channels;
             outParams.sampleFormat = paFloat32;
             outParams.suggestedLatency = 0;
             outParams.hostApiSpecificStreamInfo = nullptr;
@@ -195,13 +196,13 @@ namespace insound {
             lockGuard.lock();
 
             this->requestedBufferFrames = sampleFrameBufferSize;
-            this->spec.channels = 2;
+            this->spec.channels = channels;
             this->spec.freq = frequency;
             this->spec.format = SampleFormat(sizeof(float) * CHAR_BIT, true, endian::native == endian::big, true);
             this->callback = engineCallback;
             this->userdata = userdata;
             this->stream = stream;
-            this->buffer.resize(sampleFrameBufferSize * sizeof(float) * 2);
+            this->buffer.resize(sampleFrameBufferSize * sizeof(float) * channels);
             this->id = id;
 
 #if INSOUND_TARGET_APPLE
@@ -262,7 +263,7 @@ namespace insound {
             }
 
             try {
-               const auto bufferByteSize = framesPerBuffer * sizeof(float) * 2;
+               const auto bufferByteSize = framesPerBuffer * sizeof(float) * dev->spec.channels;
 
                 if (dev->buffer.size() != bufferByteSize)
                     dev->buffer.resize(bufferByteSize);
@@ -289,9 +290,11 @@ namespace insound {
         delete m;
     }
 
-    bool PortAudioDevice::open(int frequency, int sampleFrameBufferSize, AudioCallback engineCallback, void *userdata)
+    bool PortAudioDevice::open(int frequency, int channels, int sampleFrameBufferSize, AudioCallback engineCallback,
+        void *userdata)
     {
-        return m->open(Pa_GetDefaultOutputDevice(), frequency, sampleFrameBufferSize, engineCallback, userdata);
+        return m->open(Pa_GetDefaultOutputDevice(), frequency, channels, sampleFrameBufferSize, engineCallback,
+            userdata);
     }
 
     void PortAudioDevice::close()
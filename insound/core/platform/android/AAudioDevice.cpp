@@ -15,7 +15,7 @@ namespace insound {
         AlignedVector<uint8_t, 16> m_buffer{};
         mutable std::recursive_mutex m_mutex{};
 
-        bool open(int frequency, int sampleFrameBufferSize, AudioCallback audioCallback,
+        bool open(int frequency, int channels, int sampleFrameBufferSize, AudioCallback audioCallback,
              void *userdata)
         {
             std::lock_guard lockGuard(m_mutex);
@@ -35,15 +35,16 @@ namespace insound {
                                                           sampleFrameBufferSize == 0 ? 512 : sampleFrameBufferSize);
             AAudioStreamBuilder_setSharingMode(builder, AAUDIO_SHARING_MODE_SHARED); // low latency
             AAudioStreamBuilder_setDirection(builder, AAUDIO_DIRECTION_OUTPUT);
-            AAudioStreamBuilder_setChannelCount(builder, 2);
+            AAudioStreamBuilder_setChannelCount(builder, channels);
 #if __ANDROID_MIN_SDK_VERSION__ >= 32 // channel mask only available in 32+
-            AAudioStreamBuilder_setChannelMask(builder, AAUDIO_CHANNEL_STEREO);
+            if (channels == 2)
+                AAudioStreamBuilder_setChannelMask(builder, AAUDIO_CHANNEL_STEREO);
 #endif
             AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_FLOAT);
             AAudioStreamBuilder_setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
             AAudioStreamBuilder_setDataCallback(builder, aaudioCallback, this);
 
-            m_spec.channels = 2;
+            m_spec.channels = channels;
             m_spec.freq = frequency;
             m_spec.format = SampleFormat(sizeof(float) * CHAR_BIT, true, false, true);
             m_userData = userdata;
@@ -139,7 +140,7 @@ namespace insound {
                 return AAUDIO_CALLBACK_RESULT_CONTINUE;
             }
 
-            const auto byteSize = nFrames * sizeof(float) * 2;
+            const auto byteSize = nFrames * sizeof(float) * device->m_spec.channels;
             if (device->m_buffer.size() != byteSize)
                 device->m_buffer.resize(byteSize);
 
@@ -159,10 +160,10 @@ namespace insound {
     }
 
 
-    bool AAudioDevice::open(int frequency, int sampleFrameBufferSize,
+    bool AAudioDevice::open(int frequency, int channels, int sampleFrameBufferSize,
                             insound::AudioCallback audioCallback, void *userdata)
     {
-        return m->open(frequency, sampleFrameBufferSize, audioCallback, userdata);
+        return m->open(frequency, channels, sampleFrameBufferSize, audioCallback, userdata);
     }
 
     void AAudioDevice::suspend()
@@ -126,9 +126,10 @@ namespace insound {
         delete m;
     }
 
-    bool iOSAudioDevice::open(int frequency, int sampleFrameBufferSize,
+    bool iOSAudioDevice::open(int frequency, int channels, int sampleFrameBufferSize,
                               AudioCallback audioCallback, void *userdata)
     {
+        // Remote IO output is opened in stereo, the engine mixes down to the opened spec
 //        m->thread = std::thread([this, audioCallback, userdata, frequency, sampleFrameBufferSize]() {
 //            const auto samplerate = frequency ? frequency : getDefaultSampleRate();
 //            const int bufferBytes = sampleFrameBufferSize * 2 * sizeof(float);
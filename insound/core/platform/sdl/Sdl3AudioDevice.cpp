@@ -20,13 +20,13 @@ struct insound::Sdl3AudioDevice::Impl {
         dev->callback(dev->userData, &dev->buffer);
         SDL_PutAudioStreamData(stream, dev->buffer.data(), dev->buffer.size());
     }
-    bool open(int frequency, int sampleFrameBufferSize,
+    bool open(int frequency, int channels, int sampleFrameBufferSize,
               AudioCallback audioCallback,
               void *userdata)
     {
         // Set audio spec configuration
         SDL_AudioSpec desired{};
-        desired.channels = 2;
+        desired.channels = channels;
         desired.format = SDL_AUDIO_F32;
         desired.freq = frequency > 0 ? frequency : getDefaultSampleRate();
         if (desired.freq == -1)
@@ -75,7 +75,7 @@ struct insound::Sdl3AudioDevice::Impl {
             SDL_AUDIO_ISBIGENDIAN(desired.format), SDL_AUDIO_ISSIGNED(desired.format)
         );
 
-        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * 2; // target buffer size
+        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * spec.channels; // target buffer size
         buffer.resize(bufferSize /*128 * 2 * sizeof(float)*/, 0);                   // size of our local buffer (matches web audio)
 
         //id = deviceID;
@@ -173,14 +173,14 @@ struct insound::Sdl3AudioDevice::Impl {
     AudioSpec spec{};
 
     /// Open the SDL audio device, setting up the audio callback
-    bool open(int frequency, int sampleFrameBufferSize,
+    bool open(int frequency, int channels, int sampleFrameBufferSize,
               AudioCallback engineCallback,
               void *userdata)
     {
         // Setup configurations
         SDL_AudioSpec desired, obtained;
         SDL_memset(&desired, 0, sizeof(desired));
-        desired.channels = 2;
+        desired.channels = channels;
         desired.format = AUDIO_F32;
         desired.freq = frequency > 0 ? frequency : getDefaultSampleRate();
         if (desired.freq == -1)
@@ -208,7 +208,7 @@ struct insound::Sdl3AudioDevice::Impl {
             SDL_AUDIO_ISBIGENDIAN(obtained.format), SDL_AUDIO_ISSIGNED(obtained.format)
         );
 
-        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * 2; // target buffer size
+        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * spec.channels; // target buffer size
         buffer.resize(bufferSize, 0);                   // TODO: this can potentially result in all buffers being quite large
 
         id = deviceID;
@@ -258,10 +258,10 @@ namespace insound {
         delete m;
     }
 
-    bool Sdl3AudioDevice::open(int frequency, int sampleFrameBufferSize,
+    bool Sdl3AudioDevice::open(int frequency, int channels, int sampleFrameBufferSize,
                               AudioCallback engineCallback, void *userdata)
     {
-        return m->open(frequency, sampleFrameBufferSize, engineCallback, userdata);
+        return m->open(frequency, channels, sampleFrameBufferSize, engineCallback, userdata);
     }
 
     void Sdl3AudioDevice::close()
@@ -12,13 +12,13 @@
 struct insound::SdlAudioDevice::Impl {
     explicit Impl() : { }
 
-    bool open(int frequency, int sampleFrameBufferSize,
+    bool open(int frequency, int channels, int sampleFrameBufferSize,
               AudioCallback audioCallback,
               void *userdata)
     {
         // Set audio spec configuration
         SDL_AudioSpec desired{};
-        desired.channels = 2;
+        desired.channels = channels;
         desired.format = AUDIO_F32;
         desired.freq = frequency > 0 ? frequency : getDefaultSampleRate();
         if (desired.freq == -1)
@@ -45,7 +45,7 @@ struct insound::SdlAudioDevice::Impl {
             SDL_AUDIO_ISBIGENDIAN(obtained.format), SDL_AUDIO_ISSIGNED(obtained.format)
         );
 
-        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * 2; // target buffer size
+        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * obtained.channels; // target buffer size
         buffer.resize(bufferSize /*128 * 2 * sizeof(float)*/, 0);                   // size of our local buffer (matches web audio)
 
         id.store(deviceID, std::memory_order_release);
@@ -146,14 +146,14 @@ struct insound::SdlAudioDevice::Impl {
     AudioSpec spec{};
 
     /// Open the SDL audio device, setting up the audio callback
-    bool open(int frequency, int sampleFrameBufferSize,
+    bool open(int frequency, int channels, int sampleFrameBufferSize,
               AudioCallback engineCallback,
               void *userdata)
     {
         // Setup configurations
         SDL_AudioSpec desired, obtained;
         SDL_memset(&desired, 0, sizeof(desired));
-        desired.channels = 2;
+        desired.channels = channels;
         desired.format = AUDIO_F32;
         desired.freq = frequency > 0 ? frequency : getDefaultSampleRate();
         if (desired.freq == -1)
@@ -181,7 +181,7 @@ struct insound::SdlAudioDevice::Impl {
             SDL_AUDIO_ISBIGENDIAN(obtained.format), SDL_AUDIO_ISSIGNED(obtained.format)
         );
 
-        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * 2; // target buffer size
+        bufferSize = sampleFrameBufferSize * (int)sizeof(float) * obtained.channels; // target buffer size
         buffer.resize(bufferSize, 0);                   // TODO: this can potentially result in all buffers being quite large
 
         id = deviceID;
@@ -231,10 +231,10 @@ namespace insound {
         delete m;
     }
 
-    bool SdlAudioDevice::open(int frequency, int sampleFrameBufferSize,
+    bool SdlAudioDevice::open(int frequency, int channels, int sampleFrameBufferSize,
                               AudioCallback engineCallback, void *userdata)
     {
-        return m->open(frequency, sampleFrameBufferSize, engineCallback, userdata);
+        return m->open(frequency, channels, sampleFrameBufferSize, engineCallback, userdata);
     }
 
     void SdlAudioDevice::close()
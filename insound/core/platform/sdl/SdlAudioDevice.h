@@ -10,6 +10,7 @@ namespace insound {
         ~SdlAudioDevice() override;
 
         bool open(int frequency,
+            int channels,
             int sampleFrameBufferSize,
             AudioCallback engineCallback,
             void *userdata) override;
@@ -0,0 +1,64 @@
+#include "perf.h"
+
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace insound;
+
+static constexpr uint64_t FrameCount = 48000 * 10;
+static constexpr int Iterations = 20;
+
+/// Time conversion through DataConverter's kernels against a miniaudio data converter with identical specs
+static void compare(const char *name, const AudioSpec &inSpec, const AudioSpec &outSpec)
+{
+    std::vector<uint8_t> input(FrameCount * inSpec.bytesPerFrame());
+    for (auto &byte : input)
+        byte = static_cast<uint8_t>(std::rand());
+    std::vector<uint8_t> output(FrameCount * outSpec.bytesPerFrame());
+
+    DataConverter converter(inSpec, outSpec);
+
+    PerfTimer::start();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        uint64_t frames = FrameCount;
+        uint64_t inFrames = FrameCount;
+        converter.process(input.data(), &inFrames, output.data(), &frames);
+    }
+    const auto kernelTime = PerfTimer::stop();
+
+    const auto config = ma_data_converter_config_init(
+        (ma_format)toMaFormat(inSpec.format), (ma_format)toMaFormat(outSpec.format),
+        inSpec.channels, outSpec.channels, inSpec.freq, outSpec.freq);
+    ma_data_converter maConverter;
+    ma_data_converter_init(&config, nullptr, &maConverter);
+
+    PerfTimer::start();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        ma_uint64 inFrames = FrameCount, outFrames = FrameCount;
+        ma_data_converter_process_pcm_frames(&maConverter, input.data(), &inFrames, output.data(), &outFrames);
+    }
+    const auto maTime = PerfTimer::stop();
+    ma_data_converter_uninit(&maConverter, nullptr);
+
+    std::printf("DataConverter %-18s kernels: %10llu ns, miniaudio: %10llu ns (%.2fx)%s\n", name,
+        kernelTime, maTime, (double)maTime / (double)kernelTime,
+        converter.isFastPath() ? "" : " [fallback]");
+}
+
+void perfDataConverter()
+{
+    const auto f32 = SampleFormat(32, true, false, true);
+    const auto out = AudioSpec(48000, 2, f32);
+
+    compare("u8 stereo", AudioSpec(48000, 2, SampleFormat(8, false, false, false)), out);
+    compare("s16 stereo", AudioSpec(48000, 2, SampleFormat(16, false, false, true)), out);
+    compare("s16 mono->stereo", AudioSpec(48000, 1, SampleFormat(16, false, false, true)), out);
+    compare("s24 stereo", AudioSpec(48000, 2, SampleFormat(24, false, false, true)), out);
+    compare("s32 stereo", AudioSpec(48000, 2, SampleFormat(32, false, false, true)), out);
+    compare("f32 stereo->mono", out, AudioSpec(48000, 1, f32));
+}
@@ -0,0 +1,35 @@
+#include "perf.h"
+
+#include <insound/core.h>
+
+#include <vector>
+
+using namespace insound;
+
+static constexpr int BlockFrames = 512;
+static constexpr int Blocks = 20000;
+
+/// Render blocks through an envelope of back-to-back segments, as for a long automated session
+static void render(const char *name, const FadeCurve curve)
+{
+    Envelope envelope;
+    for (uint32_t i = 0; i <= Blocks; ++i)
+        envelope.addPoint(i * BlockFrames * 2, static_cast<float>(i % 2) * .5f + .25f, curve);
+
+    std::vector<float> samples(BlockFrames * 2, 1.f);
+    PerfTimer::start();
+    for (uint32_t block = 0; block < Blocks; ++block)
+        envelope.process(samples.data(), block * BlockFrames, BlockFrames);
+    const auto time = PerfTimer::stop();
+
+    std::printf("Envelope %-11s %d blocks x %d frames: %10llu ns (%.1f ns per block)\n", name, Blocks,
+        BlockFrames, time, static_cast<double>(time) / Blocks);
+}
+
+void perfEnvelope()
+{
+    render("Linear", FadeCurve::Linear);
+    render("Exponential", FadeCurve::Exponential);
+    render("EqualPower", FadeCurve::EqualPower);
+    render("SCurve", FadeCurve::SCurve);
+}
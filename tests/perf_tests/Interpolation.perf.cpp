@@ -0,0 +1,46 @@
+#include "perf.h"
+
+#include <insound/core.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace insound;
+
+static constexpr int SourceFrames = 48000;
+static constexpr int BlockFrames = 512;
+static constexpr int Voices = 2000;
+
+/// Render one block for each of many pitched voices, as for a large pool of sound effects
+static void render(const char *name, const InterpolationMode mode, std::vector<float> &source)
+{
+    std::vector<float> output(BlockFrames * 2);
+    const auto frames = source.data() + InterpolationPadBefore * 2;
+
+    PerfTimer::start();
+    for (int voice = 0; voice < Voices; ++voice)
+    {
+        const auto speed = .5f + static_cast<float>(voice % 100) * .015f; // .5 to ~2
+        const auto position = static_cast<float>(voice * 13 % (SourceFrames - BlockFrames * 3));
+        interpolateStereo(mode, frames, position, speed, .0001f, output.data(), BlockFrames);
+    }
+    const auto time = PerfTimer::stop();
+
+    // Block duration at 48kHz, to show how much of the real-time budget the voices take
+    const auto budget = static_cast<double>(BlockFrames) / 48000.0 * 1e9;
+    std::printf("Interpolation %-8s %d voices x %d frames: %10llu ns (%.1f%% of real-time)\n", name, Voices,
+        BlockFrames, time, static_cast<double>(time) / budget * 100.0);
+}
+
+void perfInterpolation()
+{
+    std::vector<float> source((SourceFrames + InterpolationPadBefore + InterpolationPadAfter) * 2);
+    for (auto &sample : source)
+        sample = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.f - 1.f;
+
+    render("Nearest", InterpolationMode::Nearest, source);
+    render("Linear", InterpolationMode::Linear, source);
+    render("Cubic", InterpolationMode::Cubic, source);
+    render("Sinc", InterpolationMode::Sinc, source);
+}
@@ -0,0 +1,95 @@
+#include "perf.h"
+
+#include <insound/core.h>
+
+#include <vector>
+
+using namespace insound;
+
+static constexpr uint32_t BlockFrames = 512;
+static constexpr uint32_t BlockSamples = BlockFrames * 2;
+static constexpr int Blocks = 50000;
+
+static void print(const char *kernel, const SimdPath path, const unsigned long long time)
+{
+    std::printf("MixKernels %-10s %-8s %d blocks x %u frames: %10llu ns (%.1f ns per block)\n", kernel,
+        simdPathName(path), Blocks, BlockFrames, time, static_cast<double>(time) / Blocks);
+}
+
+/// Time summing a bus's children: in passes of four over the output, as buses used to, in one blocked pass, and in
+/// one blocked pass with a gain per child
+static void runSum(const SimdPath path, const uint32_t children)
+{
+    const auto &kernels = mixKernels();
+    const auto blocks = Blocks * 4 / static_cast<int>(children);
+    std::vector<float> samples(children * BlockSamples, .25f), gains(children, .5f), output(BlockSamples);
+    std::vector<const float *> inputs(children);
+    for (uint32_t i = 0; i < children; ++i)
+        inputs[i] = samples.data() + i * BlockSamples;
+
+    unsigned long long times[3];
+    PerfTimer::start();
+    for (int block = 0; block < blocks; ++block)
+    {
+        for (uint32_t i = 0; i < children; i += 4)
+            kernels.sum(inputs.data() + i, nullptr, 4, output.data(), BlockSamples);
+    }
+    times[0] = PerfTimer::stop();
+
+    PerfTimer::start();
+    for (int block = 0; block < blocks; ++block)
+        kernels.sum(inputs.data(), nullptr, children, output.data(), BlockSamples);
+    times[1] = PerfTimer::stop();
+
+    PerfTimer::start();
+    for (int block = 0; block < blocks; ++block)
+        kernels.sum(inputs.data(), gains.data(), children, output.data(), BlockSamples);
+    times[2] = PerfTimer::stop();
+
+    std::printf("MixKernels sum %4u children %-8s ns per block: fours %9.1f, blocked %9.1f, with gains %9.1f\n",
+        children, simdPathName(path), static_cast<double>(times[0]) / blocks,
+        static_cast<double>(times[1]) / blocks, static_cast<double>(times[2]) / blocks);
+}
+
+/// Time each kernel on one path
+static void run(const SimdPath path)
+{
+    const auto &kernels = mixKernels();
+    std::vector<float> a(BlockSamples, .25f);
+    std::vector<float> output(BlockSamples), line(BlockSamples);
+
+    for (const auto children : {4u, 32u, 256u, 1024u})
+        runSum(path, children);
+
+    PerfTimer::start();
+    for (int block = 0; block < Blocks; ++block)
+        kernels.gain(a.data(), output.data(), BlockSamples, .5f);
+    print("gain", path, PerfTimer::stop());
+
+    PerfTimer::start();
+    for (int block = 0; block < Blocks; ++block)
+        kernels.stereoRamp(a.data(), output.data(), BlockFrames, .5f, 1e-6f);
+    print("stereoRamp", path, PerfTimer::stop());
+
+    PerfTimer::start();
+    for (int block = 0; block < Blocks; ++block)
+        kernels.delay(a.data(), output.data(), line.data(), BlockSamples, .5f, .5f, .5f);
+    print("delay", path, PerfTimer::stop());
+}
+
+void perfMixKernels()
+{
+    const auto selected = simdPath();
+    const auto &features = cpuFeatures();
+    std::printf("MixKernels selected %s (CPU: sse2 %d, avx %d, avx2 %d, fma %d, avx512f %d)\n",
+        simdPathName(selected), features.sse2, features.avx, features.avx2, features.fma, features.avx512f);
+
+    for (const auto path : {SimdPath::Scalar, SimdPath::Neon, SimdPath::WasmSimd, SimdPath::Sse, SimdPath::Avx2,
+        SimdPath::Avx512})
+    {
+        if (setSimdPath(path))
+            run(path);
+    }
+
+    setSimdPath(selected);
+}
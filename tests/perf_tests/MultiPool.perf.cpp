@@ -0,0 +1,79 @@
+#include "perf.h"
+
+#include <insound/core.h>
+
+#include <cstdio>
+#include <vector>
+
+using namespace insound;
+
+static constexpr int Cycles = 100000;
+
+/// Allocate and deallocate the default effects every Source creates, as when spawning a voice
+static void spawnEffects()
+{
+    MultiPool pool;
+    pool.reserve<PanEffect>(16);
+    pool.reserve<VolumeEffect>(16);
+
+    PerfTimer::start();
+    for (int i = 0; i < Cycles; ++i)
+    {
+        const auto panner = pool.allocate<PanEffect>();
+        const auto volume = pool.allocate<VolumeEffect>();
+        pool.deallocate(volume);
+        pool.deallocate(panner);
+    }
+    const auto time = PerfTimer::stop();
+
+    std::printf("MultiPool %d x allocate/deallocate Pan+Volume: %10llu ns (%.1f ns per object)\n", Cycles, time,
+        static_cast<double>(time) / (Cycles * 2));
+}
+
+/// Validate and dereference a large array of handles, as buses and command processing do each block
+static void resolveHandles()
+{
+    constexpr int Count = 4096, Passes = 100;
+
+    MultiPool pool;
+    std::vector<Handle<VolumeEffect>> handles;
+    handles.reserve(Count);
+    for (int i = 0; i < Count; ++i)
+        handles.emplace_back(pool.allocate<VolumeEffect>());
+
+    size_t valid = 0;
+    PerfTimer::start();
+    for (int pass = 0; pass < Passes; ++pass)
+    {
+        for (const auto &handle : handles)
+        {
+            if (handle.isValid())
+                valid += handle.get() != nullptr;
+        }
+    }
+    auto time = PerfTimer::stop();
+
+    std::printf("MultiPool %d x validate+get of %d handles (%zu bytes each): %10llu ns (%.2f ns per handle)\n", Passes,
+        Count, sizeof(Handle<VolumeEffect>), time, static_cast<double>(time) / (static_cast<double>(valid)));
+
+    valid = 0;
+    PerfTimer::start();
+    for (int pass = 0; pass < Passes; ++pass)
+    {
+        for (const auto &handle : handles)
+            valid += handle.tryGet() != nullptr;
+    }
+    time = PerfTimer::stop();
+
+    std::printf("MultiPool %d x tryGet of %d handles:                      %10llu ns (%.2f ns per handle)\n", Passes,
+        Count, time, static_cast<double>(time) / (static_cast<double>(valid)));
+
+    for (const auto &handle : handles)
+        pool.deallocate(handle);
+}
+
+void perfMultiPool()
+{
+    spawnEffects();
+    resolveHandles();
+}
@@ -0,0 +1,125 @@
+#include "perf.h"
+
+#include <insound/core.h>
+
+#include <vector>
+
+using namespace insound;
+
+static constexpr int BlockFrames = 512;
+static constexpr int Blocks = 20000;
+static constexpr int SumInputs = 8;
+
+/// One-pole low-pass over interleaved stereo frames
+static void filterInterleaved(float *samples, const int frames, const float coefficient, float *state)
+{
+    auto left = state[0], right = state[1];
+    for (int i = 0; i < frames; ++i)
+    {
+        left += coefficient * (samples[i * 2] - left);
+        right += coefficient * (samples[i * 2 + 1] - right);
+        samples[i * 2] = left;
+        samples[i * 2 + 1] = right;
+    }
+    state[0] = left;
+    state[1] = right;
+}
+
+/// One-pole low-pass over one planar channel
+static void filterPlane(float *samples, const int frames, const float coefficient, float *state)
+{
+    auto value = *state;
+    for (int i = 0; i < frames; ++i)
+    {
+        value += coefficient * (samples[i] - value);
+        samples[i] = value;
+    }
+    *state = value;
+}
+
+static void print(const char *name, const char *layout, const unsigned long long time)
+{
+    std::printf("Planar %-7s %-11s %d blocks x %d frames: %10llu ns (%.1f ns per block)\n", name, layout, Blocks,
+        BlockFrames, time, static_cast<double>(time) / Blocks);
+}
+
+/// Compare effect and mixing throughput on interleaved and planar stereo blocks
+void perfPlanar()
+{
+    std::vector<float> interleaved(BlockFrames * 2);
+    for (size_t i = 0; i < interleaved.size(); ++i)
+        interleaved[i] = static_cast<float>(i % 64) / 64.f - .5f;
+    std::vector<float> planar(BlockFrames * 2);
+    float *planes[2] = {planar.data(), planar.data() + BlockFrames};
+    deinterleave(interleaved.data(), 2, planes, BlockFrames);
+
+    // Pan, whose interleaved kernel swaps channels within each vector
+    {
+        PanEffect pan(.3f, .8f);
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+            pan.process(interleaved.data(), interleaved.data(), BlockFrames * 2);
+        print("pan", "interleaved", PerfTimer::stop());
+
+        PanEffect planarPan(.3f, .8f);
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+            planarPan.processPlanar(planes, BlockFrames);
+        print("pan", "planar", PerfTimer::stop());
+    }
+
+    // Recursive filter, serial over frames in either layout
+    {
+        float state[2] = {};
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+            filterInterleaved(interleaved.data(), BlockFrames, .1f, state);
+        print("filter", "interleaved", PerfTimer::stop());
+
+        float planarState[2] = {};
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+        {
+            filterPlane(planes[0], BlockFrames, .1f, &planarState[0]);
+            filterPlane(planes[1], BlockFrames, .1f, &planarState[1]);
+        }
+        print("filter", "planar", PerfTimer::stop());
+    }
+
+    // Summing children with the bus kernel, the same element-wise work in either layout
+    {
+        const std::vector<std::vector<float>> inputs(SumInputs, interleaved);
+        std::vector<float> output(BlockFrames * 2);
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+        {
+            for (const auto &input : inputs)
+                mixChannels(input.data(), ChannelLayout::Stereo, output.data(), ChannelLayout::Stereo,
+                    BlockFrames);
+        }
+        print("sum", "interleaved", PerfTimer::stop());
+
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+        {
+            for (const auto &input : inputs) // planes of each input lie back to back
+            {
+                mixChannels(input.data(), ChannelLayout::Mono, output.data(), ChannelLayout::Mono, BlockFrames);
+                mixChannels(input.data() + BlockFrames, ChannelLayout::Mono, output.data() + BlockFrames,
+                    ChannelLayout::Mono, BlockFrames);
+            }
+        }
+        print("sum", "planar", PerfTimer::stop());
+    }
+
+    // The cost a Source pays to run a planar effect in an interleaved chain
+    {
+        PerfTimer::start();
+        for (int block = 0; block < Blocks; ++block)
+        {
+            deinterleave(interleaved.data(), 2, planes, BlockFrames);
+            interleave(planes, 2, interleaved.data(), BlockFrames);
+        }
+        print("convert", "round trip", PerfTimer::stop());
+    }
+}
@@ -0,0 +1,39 @@
+#include "perf.h"
+
+#include <insound/core.h>
+
+#include <cstdio>
+#include <vector>
+
+using namespace insound;
+
+static constexpr int BufferSamples = 1024;
+static constexpr int Blocks = 20000;
+
+/// Time a delay over a tail that has decayed into denormal range, with and without flushing denormals
+static unsigned long long runDelay(const bool flush)
+{
+    const detail::DenormalScope denormalScope(flush);
+
+    DelayEffect effect;
+    effect.init(BufferSamples * 4, .5f, .5f);
+    std::vector<float> buffer(BufferSamples);
+
+    PerfTimer::start();
+    for (int block = 0; block < Blocks; ++block)
+    {
+        for (auto &sample : buffer)
+            sample = 1e-40f; // a feedback tail, long after the sound ended
+        effect.process(buffer.data(), buffer.data(), BufferSamples);
+    }
+    return PerfTimer::stop();
+}
+
+void perfRealtime()
+{
+    const auto normal = runDelay(false);
+    const auto flushed = runDelay(true);
+    std::printf("Realtime DelayEffect on a denormal tail, %d blocks x %d samples: %llu ns, flushed to zero %llu ns "
+        "(%.1fx)%s\n", Blocks, BufferSamples, normal, flushed, static_cast<double>(normal) / flushed,
+        detail::canFlushDenormals() ? "" : ", no flush-to-zero mode on this CPU");
+}
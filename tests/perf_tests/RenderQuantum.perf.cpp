@@ -0,0 +1,158 @@
+#include "perf.h"
+
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace insound;
+
+static constexpr int Buses = 8;
+static constexpr int VoicesPerBus = 32;
+static constexpr int BufferFrames = 4096;
+static constexpr int Blocks = 50;
+static constexpr int SoundFrames = 48000;
+
+/// Counts the calling thread's last-level cache misses, where the OS exposes hardware counters
+class CacheMissCounter {
+public:
+    CacheMissCounter() : m_fd(-1)
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if (m_fd >= 0)
+            close(m_fd);
+#endif
+    }
+
+    [[nodiscard]]
+    bool isAvailable() const { return m_fd >= 0; }
+
+    void start()
+    {
+#ifdef __linux__
+        if (m_fd < 0)
+            return;
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    /// @returns misses since `start`, or 0 if unavailable
+    unsigned long long stop()
+    {
+        unsigned long long count = 0;
+#ifdef __linux__
+        if (m_fd < 0)
+            return 0;
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+            return 0;
+#endif
+        return count;
+    }
+
+private:
+    int m_fd;
+};
+
+static std::string writeSound()
+{
+    const auto path = std::string("render_quantum.perf.wav");
+    const auto config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, 2, 48000);
+    ma_encoder encoder;
+    ma_encoder_init_file(path.c_str(), &config, &encoder);
+    std::vector<int16_t> samples(SoundFrames * 2);
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i] = static_cast<int16_t>((i * 37) % 2000 - 1000);
+    ma_encoder_write_pcm_frames(&encoder, samples.data(), SoundFrames, nullptr);
+    ma_encoder_uninit(&encoder);
+    return path;
+}
+
+/// Mix a scene of panned voices through sub-buses into a large device buffer, rendered in quanta of `quantum`
+static void mix(const SoundBuffer &buffer, const int quantum, CacheMissCounter &counter)
+{
+    const auto device = new NullAudioDevice();
+    Engine engine(device);
+    engine.open(48000, BufferFrames);
+    engine.setRenderQuantum(quantum);
+
+    for (int b = 0; b < Buses; ++b)
+    {
+        Handle<Bus> bus;
+        engine.createBus(false, &bus);
+        device->process(); // appends the bus
+
+        for (int v = 0; v < VoicesPerBus; ++v)
+        {
+            Handle<PCMSource> source;
+            engine.playSound(&buffer, false, true, false, bus, &source);
+            source->setVolume(.5f);
+            Handle<PanEffect> panner;
+            source->getPanner(&panner);
+            panner->left(.25f);
+        }
+    }
+    engine.update();
+    for (int i = 0; i < 5; ++i) // warm up
+        device->process();
+
+    counter.start();
+    PerfTimer::start();
+    for (int i = 0; i < Blocks; ++i)
+        device->process();
+    const auto time = PerfTimer::stop();
+    const auto misses = counter.stop();
+
+    MemoryStats stats;
+    engine.getMemoryStats(&stats);
+
+    std::printf("RenderQuantum %4d frames, %d voices x %d frame buffers: %8.1f us per buffer, scratch %7.1f KB",
+        quantum, Buses * VoicesPerBus, BufferFrames, static_cast<double>(time) / Blocks / 1e3,
+        static_cast<double>(stats.scratchBytes) / 1e3);
+    if (counter.isAvailable())
+        std::printf(", %llu cache misses per buffer\n", misses / Blocks);
+    else
+        std::printf(", cache misses n/a\n");
+
+    engine.close();
+}
+
+void perfRenderQuantum()
+{
+    const auto path = writeSound();
+    SoundBuffer buffer;
+    buffer.load(path, AudioSpec(48000, 2, SampleFormat(32, true, false, true)));
+
+    CacheMissCounter counter;
+    for (const auto quantum : {0, 1024, 512, 256, 128, 64})
+        mix(buffer, quantum, counter);
+
+    buffer.unload();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,59 @@
+#include "perf.h"
+
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace insound;
+
+static constexpr uint64_t FrameCount = 44100 * 10;
+static constexpr int Iterations = 5;
+
+/// Time stereo 44.1kHz -> 48kHz resampling in one quality tier against miniaudio's linear resampler
+static void compare(const char *name, const ResampleQuality quality, const std::vector<float> &input,
+                    std::vector<float> &output)
+{
+    Resampler resampler;
+    resampler.init(2, 44100, 48000, quality);
+
+    PerfTimer::start();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        resampler.reset();
+        uint64_t inFrames = FrameCount, outFrames = output.size() / 2;
+        resampler.process(input.data(), &inFrames, output.data(), &outFrames);
+    }
+    const auto polyphaseTime = PerfTimer::stop();
+
+    const auto config = ma_resampler_config_init(ma_format_f32, 2, 44100, 48000, ma_resample_algorithm_linear);
+    ma_resampler maResampler;
+    ma_resampler_init(&config, nullptr, &maResampler);
+
+    PerfTimer::start();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        ma_resampler_reset(&maResampler);
+        ma_uint64 inFrames = FrameCount, outFrames = output.size() / 2;
+        ma_resampler_process_pcm_frames(&maResampler, input.data(), &inFrames, output.data(), &outFrames);
+    }
+    const auto maTime = PerfTimer::stop();
+    ma_resampler_uninit(&maResampler, nullptr);
+
+    std::printf("Resampler %-6s (%2d taps): %10llu ns, miniaudio linear: %10llu ns (%.2fx)\n", name,
+        resampler.taps(), polyphaseTime, maTime, (double)maTime / (double)polyphaseTime);
+}
+
+void perfResampler()
+{
+    std::vector<float> input(FrameCount * 2);
+    for (auto &sample : input)
+        sample = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.f - 1.f;
+    std::vector<float> output(FrameCount * 2 * 48000 / 44100 + 64);
+
+    compare("Low", ResampleQuality::Low, input, output);
+    compare("Medium", ResampleQuality::Medium, input, output);
+    compare("High", ResampleQuality::High, input, output);
+    compare("Best", ResampleQuality::Best, input, output);
+}
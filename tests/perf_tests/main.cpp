@@ -1,7 +1,9 @@
+#include "perf.h"
+
 #include <insound/core.h>
 using namespace insound;
 
-int main()
+static void perfDelayEffect()
 {
     auto effect = DelayEffect();
     effect.init(44100, .5, .5);
@@ -13,5 +15,20 @@ int main()
         effect.process(buffer, buffer, 1024);
 
     const auto time = PerfTimer::stop();
-    std::printf("Time: %llu ns\n", time);
+    std::printf("DelayEffect: %llu ns\n", time);
+}
+
+int main()
+{
+    perfDelayEffect();
+    perfDataConverter();
+    perfEnvelope();
+    perfInterpolation();
+    perfMixKernels();
+    perfMultiPool();
+    perfPlanar();
+    perfRealtime();
+    perfRenderQuantum();
+    perfResampler();
+    perfSource();
 }
@@ -0,0 +1,13 @@
+#pragma once
+
+/// Benchmarks for the perf test runner, each prints its own results to stdout
+void perfDataConverter();
+void perfEnvelope();
+void perfInterpolation();
+void perfMixKernels();
+void perfMultiPool();
+void perfPlanar();
+void perfRealtime();
+void perfRenderQuantum();
+void perfResampler();
+void perfSource();
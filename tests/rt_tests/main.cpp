@@ -0,0 +1,133 @@
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace insound;
+
+static constexpr int BufferFrames = 512;
+static constexpr int SoundFrames = 48000;
+
+/// Write a 16-bit stereo WAV file for a stream to decode while mixing, returning its path
+static std::string writeStreamWav()
+{
+    const auto path = std::string("rt_stream.wav");
+    const auto config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, 2, 48000);
+    ma_encoder encoder;
+    if (ma_encoder_init_file(path.c_str(), &config, &encoder) != MA_SUCCESS)
+        return {};
+    std::vector<int16_t> samples(SoundFrames * 2);
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i] = static_cast<int16_t>((i * 37) % 2000 - 1000);
+    ma_encoder_write_pcm_frames(&encoder, samples.data(), SoundFrames, nullptr);
+    ma_encoder_uninit(&encoder);
+    return path;
+}
+
+static void countEvent(const SourceEvent &, void *userdata)
+{
+    ++*static_cast<size_t *>(userdata);
+}
+
+/// Play a mix graph with buses, effects, looping sounds, a looping stream decoded from file, and oneshots that end
+/// while mixing.
+/// After warming up, no buffer may allocate, free, or block on the audio thread.
+int main()
+{
+    const auto device = new NullAudioDevice();
+    Engine engine(device);
+    if (!engine.open(48000, BufferFrames))
+    {
+        std::fprintf(stderr, "failed to open engine\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t eventCount = 0;
+    engine.setEventCallback(countEvent, &eventCount);
+
+    const auto data = static_cast<float *>(std::malloc(SoundFrames * 2 * sizeof(float)));
+    for (int i = 0; i < SoundFrames * 2; ++i)
+        data[i] = static_cast<float>(i % 200) / 100.f - 1.f;
+
+    SoundBuffer buffer;
+    buffer.emplace(reinterpret_cast<uint8_t *>(data), SoundFrames * 2 * sizeof(float),
+        AudioSpec(48000, 2, SampleFormat(32, true, false, true)));
+
+    Handle<Bus> bus;
+    engine.createBus(false, &bus);
+    bus->addEffect<DelayEffect>(0, 48000 / 4, .5f, .5f);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        Handle<PCMSource> source;
+        engine.playSound(&buffer, false, true, false, bus, &source);
+        source->setSpeed(.5f + static_cast<float>(i) * .1f);
+        source->fadeTo(.5f, 4800);
+    }
+
+    // decoded by miniaudio on the audio thread, looping several times during the measured buffers
+    const auto streamPath = writeStreamWav();
+    Handle<StreamSource> stream;
+    if (streamPath.empty() || !engine.playStream(streamPath, false, true, false, false, bus, &stream))
+    {
+        std::fprintf(stderr, "failed to play the stream\n");
+        return EXIT_FAILURE;
+    }
+
+    // staggered oneshots that end during the measured buffers
+    for (int i = 0; i < 32; ++i)
+    {
+        Handle<PCMSource> source;
+        engine.playSound(&buffer, false, false, true, &source);
+        source->setPosition(static_cast<float>(SoundFrames - BufferFrames * (8 + i * 2)));
+    }
+
+    // warm up: apply the commands above and let the graph settle, changing the graph may allocate
+    setRealtimeViolationLogging(false);
+    for (int i = 0; i < 4; ++i)
+    {
+        engine.update();
+        device->process();
+    }
+
+    setRealtimeViolationLogging(true);
+    resetRealtimeViolations();
+    for (int i = 0; i < 200; ++i)
+    {
+        device->process();
+        if (i % 4 == 0)
+            engine.update(); // not on the audio thread, may allocate
+    }
+    const auto violations = getRealtimeViolations();
+
+    GarbageStats stats;
+    engine.getGarbageStats(&stats);
+    engine.close();
+    buffer.unload();
+    std::remove(streamPath.c_str());
+
+    if (stats.collected == 0)
+    {
+        std::fprintf(stderr, "FAILED: no oneshots ended during the test\n");
+        return EXIT_FAILURE;
+    }
+
+    if (eventCount == 0)
+    {
+        std::fprintf(stderr, "FAILED: no events were delivered\n");
+        return EXIT_FAILURE;
+    }
+
+    if (violations > 0)
+    {
+        std::fprintf(stderr, "FAILED: %zu real-time violations in steady-state mixing\n", violations);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Passed: no real-time violations in %d buffers\n", 200);
+    return EXIT_SUCCESS;
+}
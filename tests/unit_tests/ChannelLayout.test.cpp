@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core/ChannelLayout.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace insound;
+
+static constexpr ChannelLayout Layouts[] = {
+    ChannelLayout::Mono, ChannelLayout::Stereo, ChannelLayout::Quad, ChannelLayout::Surround51,
+    ChannelLayout::Surround71,
+};
+
+static constexpr float FoldGain = 0.70710678f;
+
+static bool near(const float a, const float b)
+{
+    return std::abs(a - b) < 1e-5f;
+}
+
+TEST_CASE("ChannelLayout")
+{
+    SECTION("Layouts are found by channel count")
+    {
+        for (const auto layout : Layouts)
+        {
+            ChannelLayout found;
+            REQUIRE(layoutFromChannels(channelCount(layout), &found));
+            REQUIRE(found == layout);
+        }
+
+        REQUIRE(!layoutFromChannels(3, nullptr));
+        REQUIRE(!layoutFromChannels(0, nullptr));
+    }
+
+    SECTION("Matching layouts pass each channel through")
+    {
+        for (const auto layout : Layouts)
+        {
+            for (int o = 0; o < channelCount(layout); ++o)
+            {
+                for (int i = 0; i < channelCount(layout); ++i)
+                    REQUIRE(channelGain(layout, i, layout, o) == (i == o ? 1.f : 0.f));
+            }
+        }
+    }
+
+    SECTION("Stereo upmixes into the front pair only")
+    {
+        for (const auto output : {ChannelLayout::Quad, ChannelLayout::Surround51, ChannelLayout::Surround71})
+        {
+            REQUIRE(channelGain(ChannelLayout::Stereo, 0, output, 0) == 1.f);
+            REQUIRE(channelGain(ChannelLayout::Stereo, 1, output, 1) == 1.f);
+            for (int o = 2; o < channelCount(output); ++o)
+            {
+                REQUIRE(channelGain(ChannelLayout::Stereo, 0, output, o) == 0);
+                REQUIRE(channelGain(ChannelLayout::Stereo, 1, output, o) == 0);
+            }
+        }
+    }
+
+    SECTION("Mono spreads into the front pair at equal power")
+    {
+        REQUIRE(near(channelGain(ChannelLayout::Mono, 0, ChannelLayout::Stereo, 0), FoldGain));
+        REQUIRE(near(channelGain(ChannelLayout::Mono, 0, ChannelLayout::Stereo, 1), FoldGain));
+        REQUIRE(channelGain(ChannelLayout::Mono, 0, ChannelLayout::Surround51, 2) == 1.f);
+        REQUIRE(channelGain(ChannelLayout::Mono, 0, ChannelLayout::Surround51, 0) == 0);
+    }
+
+    SECTION("5.1 downmixes to stereo, folding center and back, dropping LFE")
+    {
+        constexpr auto In = ChannelLayout::Surround51;
+        constexpr auto Out = ChannelLayout::Stereo;
+        REQUIRE(channelGain(In, 0, Out, 0) == 1.f);
+        REQUIRE(channelGain(In, 0, Out, 1) == 0);
+        REQUIRE(near(channelGain(In, 2, Out, 0), FoldGain));
+        REQUIRE(near(channelGain(In, 2, Out, 1), FoldGain));
+        REQUIRE(channelGain(In, 3, Out, 0) == 0);
+        REQUIRE(channelGain(In, 3, Out, 1) == 0);
+        REQUIRE(near(channelGain(In, 4, Out, 0), FoldGain));
+        REQUIRE(near(channelGain(In, 5, Out, 1), FoldGain));
+    }
+
+    SECTION("7.1 sides stand in for 5.1 backs")
+    {
+        REQUIRE(channelGain(ChannelLayout::Surround71, 6, ChannelLayout::Surround51, 4) == 1.f);
+        REQUIRE(channelGain(ChannelLayout::Surround71, 7, ChannelLayout::Surround51, 5) == 1.f);
+        REQUIRE(channelGain(ChannelLayout::Surround71, 6, ChannelLayout::Surround51, 5) == 0);
+    }
+
+    SECTION("Out of range channels have no gain")
+    {
+        REQUIRE(channelGain(ChannelLayout::Stereo, 2, ChannelLayout::Stereo, 0) == 0);
+        REQUIRE(channelGain(ChannelLayout::Stereo, 0, ChannelLayout::Mono, 1) == 0);
+        REQUIRE(channelGain(ChannelLayout::Stereo, -1, ChannelLayout::Stereo, 0) == 0);
+    }
+
+    SECTION("Mixing matches the gain matrix for every pair of layouts")
+    {
+        constexpr uint32_t Frames = 67; // leaves a tail after each vector width
+
+        for (const auto input : Layouts)
+        {
+            for (const auto output : Layouts)
+            {
+                const auto inChannels = channelCount(input);
+                const auto outChannels = channelCount(output);
+
+                std::vector<float> in(Frames * inChannels);
+                for (size_t i = 0; i < in.size(); ++i)
+                    in[i] = std::sin(static_cast<float>(i) * .37f);
+
+                std::vector<float> expected(Frames * outChannels);
+                for (size_t i = 0; i < expected.size(); ++i)
+                    expected[i] = static_cast<float>(i % 7) * .1f;
+                auto mixed = expected;
+
+                for (uint32_t f = 0; f < Frames; ++f)
+                {
+                    for (int o = 0; o < outChannels; ++o)
+                    {
+                        for (int i = 0; i < inChannels; ++i)
+                            expected[f * outChannels + o] += in[f * inChannels + i] * channelGain(input, i, output, o);
+                    }
+                }
+
+                mixChannels(in.data(), input, mixed.data(), output, Frames);
+                for (size_t i = 0; i < mixed.size(); ++i)
+                    REQUIRE(near(mixed[i], expected[i]));
+            }
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace insound;
+
+/// Convert random data through DataConverter and a miniaudio data converter, checking that results match
+static void checkAgainstMiniaudio(const AudioSpec &inSpec, const AudioSpec &outSpec, uint64_t frameCount)
+{
+    std::vector<uint8_t> input(frameCount * inSpec.bytesPerFrame());
+    for (auto &byte : input)
+        byte = static_cast<uint8_t>(std::rand());
+
+    DataConverter converter(inSpec, outSpec);
+    REQUIRE(converter.isFastPath());
+
+    std::vector<float> output(frameCount * outSpec.channels);
+    uint64_t outFrames = frameCount;
+    uint64_t inFrames = frameCount;
+    REQUIRE(converter.process(input.data(), &inFrames, reinterpret_cast<uint8_t *>(output.data()), &outFrames));
+    REQUIRE(inFrames == frameCount);
+    REQUIRE(outFrames == frameCount);
+
+    const auto config = ma_data_converter_config_init(
+        (ma_format)toMaFormat(inSpec.format), (ma_format)toMaFormat(outSpec.format),
+        inSpec.channels, outSpec.channels, inSpec.freq, outSpec.freq);
+    ma_data_converter maConverter;
+    REQUIRE(ma_data_converter_init(&config, nullptr, &maConverter) == MA_SUCCESS);
+
+    std::vector<float> expected(frameCount * outSpec.channels);
+    ma_uint64 maInFrames = frameCount, maOutFrames = frameCount;
+    ma_data_converter_process_pcm_frames(&maConverter, input.data(), &maInFrames, expected.data(), &maOutFrames);
+    ma_data_converter_uninit(&maConverter, nullptr);
+
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        const auto diff = output[i] - expected[i];
+        REQUIRE((diff < 1e-6f && diff > -1e-6f));
+    }
+}
+
+TEST_CASE("DataConverter kernels")
+{
+    const auto f32 = SampleFormat(32, true, false, true);
+
+    // odd frame counts exercise the leftover loops after the vectorized ones
+    SECTION("Sample formats to float32 match miniaudio")
+    {
+        checkAgainstMiniaudio({48000, 2, SampleFormat(8, false, false, false)}, {48000, 2, f32}, 1037);
+        checkAgainstMiniaudio({48000, 2, SampleFormat(16, false, false, true)}, {48000, 2, f32}, 1037);
+        checkAgainstMiniaudio({48000, 2, SampleFormat(24, false, false, true)}, {48000, 2, f32}, 1037);
+        checkAgainstMiniaudio({48000, 2, SampleFormat(32, false, false, true)}, {48000, 2, f32}, 1037);
+    }
+
+    SECTION("Channel up/down-mixing matches miniaudio")
+    {
+        checkAgainstMiniaudio({44100, 1, SampleFormat(16, false, false, true)}, {44100, 2, f32}, 1037);
+        checkAgainstMiniaudio({44100, 2, SampleFormat(16, false, false, true)}, {44100, 1, f32}, 1037);
+    }
+
+    SECTION("Interleave and deinterleave round trip")
+    {
+        constexpr size_t Frames = 67;
+        std::vector<float> left(Frames), right(Frames);
+        for (size_t i = 0; i < Frames; ++i)
+        {
+            left[i] = static_cast<float>(i);
+            right[i] = -static_cast<float>(i);
+        }
+
+        std::vector<float> interleaved(Frames * 2);
+        interleaveStereo(left.data(), right.data(), interleaved.data(), Frames);
+        for (size_t i = 0; i < Frames; ++i)
+        {
+            REQUIRE(interleaved[i * 2] == left[i]);
+            REQUIRE(interleaved[i * 2 + 1] == right[i]);
+        }
+
+        std::vector<float> left2(Frames), right2(Frames);
+        deinterleaveStereo(interleaved.data(), left2.data(), right2.data(), Frames);
+        REQUIRE(left2 == left);
+        REQUIRE(right2 == right);
+    }
+
+    SECTION("Interleave and deinterleave round trip for any channel count")
+    {
+        constexpr size_t Frames = 67;
+        for (const int channels : {1, 2, 6, 8})
+        {
+            std::vector<float> interleaved(Frames * channels);
+            for (size_t i = 0; i < interleaved.size(); ++i)
+                interleaved[i] = static_cast<float>(i);
+
+            std::vector<float> planar(Frames * channels);
+            float *planes[8];
+            for (int c = 0; c < channels; ++c)
+                planes[c] = planar.data() + c * Frames;
+
+            deinterleave(interleaved.data(), channels, planes, Frames);
+            for (int c = 0; c < channels; ++c)
+            {
+                for (size_t i = 0; i < Frames; ++i)
+                    REQUIRE(planes[c][i] == interleaved[i * channels + c]);
+            }
+
+            std::vector<float> result(Frames * channels);
+            interleave(planes, channels, result.data(), Frames);
+            REQUIRE(result == interleaved);
+        }
+    }
+
+    SECTION("Resampling stays on the fast path")
+    {
+        DataConverter converter({44100, 2, SampleFormat(16, false, false, true)}, {48000, 2, f32});
+        REQUIRE(converter.isFastPath());
+        REQUIRE(converter.toOutFrames(44100) > 44100);
+    }
+
+    SECTION("Whole-buffer conversion flushes the resampler tail")
+    {
+        constexpr uint64_t FrameCount = 44100;
+        const AudioSpec inSpec{44100, 1, SampleFormat(16, false, false, true)};
+        const AudioSpec outSpec{48000, 2, f32};
+
+        auto buffer = static_cast<uint8_t *>(std::malloc(FrameCount * inSpec.bytesPerFrame()));
+        auto samples = reinterpret_cast<int16_t *>(buffer);
+        for (uint64_t i = 0; i < FrameCount; ++i)
+            samples[i] = 16384;
+
+        DataConverter converter(inSpec, outSpec);
+        uint64_t outFrames = 0;
+        REQUIRE(converter.convert(&buffer, FrameCount, &outFrames));
+        REQUIRE(outFrames == 48000);
+
+        // constant input stays constant across the whole buffer, aside from the filter's ramp at the edges
+        const auto output = reinterpret_cast<const float *>(buffer);
+        for (uint64_t i = 100; i < outFrames - 100; ++i)
+        {
+            REQUIRE(std::abs(output[i * 2] - .5f) < .005f);
+            REQUIRE(output[i * 2 + 1] == output[i * 2]);
+        }
+
+        std::free(buffer);
+    }
+}
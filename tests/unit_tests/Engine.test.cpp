@@ -0,0 +1,808 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace insound;
+
+static constexpr int BufferFrames = 512;
+static constexpr int SoundFrames = 1000;
+
+/// Write a 16-bit stereo WAV file with cue markers at frame positions, returning its path
+static std::string writeMarkerWav(const char *name, const std::vector<uint32_t> &markers)
+{
+    const auto path = std::string(name) + ".test.wav";
+
+    const auto config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, 2, 48000);
+    ma_encoder encoder;
+    REQUIRE(ma_encoder_init_file(path.c_str(), &config, &encoder) == MA_SUCCESS);
+    std::vector<int16_t> samples(SoundFrames * 2, 1000);
+    REQUIRE(ma_encoder_write_pcm_frames(&encoder, samples.data(), SoundFrames, nullptr) == MA_SUCCESS);
+    ma_encoder_uninit(&encoder);
+
+    std::vector<char> file;
+    {
+        std::ifstream in(path, std::ios::binary);
+        file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    const auto put32 = [&file](const uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            file.push_back(static_cast<char>(value >> (i * 8) & 0xFF));
+    };
+
+    file.insert(file.end(), {'c', 'u', 'e', ' '});
+    put32(static_cast<uint32_t>(4 + markers.size() * 24));
+    put32(static_cast<uint32_t>(markers.size()));
+    for (size_t i = 0; i < markers.size(); ++i)
+    {
+        put32(static_cast<uint32_t>(i + 1)); // cue point id
+        put32(0);                            // play order position
+        file.insert(file.end(), {'d', 'a', 't', 'a'});
+        put32(0);                            // chunk start
+        put32(0);                            // block start
+        put32(markers[i] * 4);               // offset, read by the loader in bytes
+    }
+
+    const auto riffSize = static_cast<uint32_t>(file.size() - 8);
+    for (int i = 0; i < 4; ++i)
+        file[4 + i] = static_cast<char>(riffSize >> (i * 8) & 0xFF);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(file.data(), static_cast<std::streamsize>(file.size()));
+    return path;
+}
+
+/// A marker WAV loaded as float32 for playback, and deleted again when the test ends
+struct TestSound {
+    explicit TestSound(const char *name, const std::vector<uint32_t> &markers = {})
+        : path(writeMarkerWav(name, markers))
+    {
+        REQUIRE(buffer.load(path, AudioSpec(48000, 2, SampleFormat(32, true, false, true))));
+        level = reinterpret_cast<const float *>(buffer.data())[0];
+    }
+
+    ~TestSound()
+    {
+        buffer.unload();
+        std::remove(path.c_str());
+    }
+
+    std::string path;
+    SoundBuffer buffer;
+    float level; ///< value of every sample in the sound
+};
+
+/// An engine opened on a NullAudioDevice, closed when the test ends. Declare it after the sounds it plays.
+struct TestEngine {
+    explicit TestEngine(const int bufferFrames = BufferFrames, const ChannelLayout layout = ChannelLayout::Stereo)
+        : device(new NullAudioDevice()), engine(device)
+    {
+        REQUIRE(engine.open(48000, bufferFrames, layout));
+    }
+
+    ~TestEngine() { engine.close(); }
+
+    NullAudioDevice *device; ///< owned by the engine
+    Engine engine;
+};
+
+/// Effect that leaves the signal unchanged, but keeps a Source from running its default chain in one pass
+class BypassEffect : public Effect {
+public:
+    bool init() { return true; }
+    bool process(const float *, float *, int) override { return false; }
+};
+
+/// Effect that halves the left channel, processing either interleaved or planar blocks
+class HalveLeftEffect : public Effect {
+public:
+    bool init(const bool planar) { m_planar = planar; return true; }
+
+    bool process(const float *input, float *output, const int count) override
+    {
+        for (int i = 0; i < count; i += 2)
+        {
+            output[i] = input[i] * .5f;
+            output[i + 1] = input[i + 1];
+        }
+        return true;
+    }
+
+    bool processPlanar(float *const *planes, const int frames) override
+    {
+        for (int i = 0; i < frames; ++i)
+            planes[0][i] *= .5f;
+        return true;
+    }
+
+    [[nodiscard]]
+    SampleOrder sampleOrder() const override { return m_planar ? SampleOrder::Planar : SampleOrder::Interleaved; }
+
+private:
+    bool m_planar = false;
+};
+
+/// Effect that records whether denormals are flushed to zero while it processes
+class DenormalProbeEffect : public Effect {
+public:
+    bool init() { return true; }
+
+    bool process(const float *, float *, int) override
+    {
+        volatile float smallest = std::numeric_limits<float>::min();
+        flushed = smallest * .5f == 0;
+        return false;
+    }
+
+    bool flushed = false;
+};
+
+static void collectEvent(const SourceEvent &event, void *userdata)
+{
+    static_cast<std::vector<SourceEvent> *>(userdata)->emplace_back(event);
+}
+
+TEST_CASE("Engine events")
+{
+    const TestSound sound("events", {100, 600});
+    const auto &buffer = sound.buffer;
+    REQUIRE(buffer.markers().size() == 2);
+    TestEngine test;
+    auto &engine = test.engine;
+    const auto device = test.device;
+
+    std::vector<SourceEvent> events;
+    REQUIRE(engine.setEventCallback(collectEvent, &events));
+
+    SECTION("Oneshots report their end and are deallocated by update")
+    {
+        Handle<PCMSource> source;
+        REQUIRE(engine.playSound(&buffer, false, false, true, &source));
+
+        engine.update();
+        device->process();
+        device->process();
+
+        GarbageStats stats;
+        REQUIRE(engine.getGarbageStats(&stats));
+        REQUIRE(stats.pending == 1);
+        REQUIRE(source.isValid());
+
+        engine.update();
+        REQUIRE(engine.getGarbageStats(&stats));
+        REQUIRE(stats.pending == 0);
+        REQUIRE(stats.collected == 3); // the source and its default pan and volume effects
+        REQUIRE(!source.isValid());
+
+        REQUIRE(events.size() == 3);
+        REQUIRE(events[0].type == SourceEvent::MarkerCrossed);
+        REQUIRE(events[0].index == 0);
+        REQUIRE(events[1].type == SourceEvent::MarkerCrossed);
+        REQUIRE(events[1].index == 1);
+        REQUIRE(events[2].type == SourceEvent::Ended);
+        REQUIRE(events[2].source == source);
+    }
+
+    SECTION("Looping sounds report each loop and the markers crossed again")
+    {
+        Handle<PCMSource> source;
+        REQUIRE(engine.playSound(&buffer, false, true, false, &source));
+
+        engine.update();
+        for (int i = 0; i < 3; ++i) // frames [0, 1536) wrap once at 1000
+            device->process();
+        engine.update();
+
+        REQUIRE(events.size() == 4);
+        REQUIRE(events[0].type == SourceEvent::MarkerCrossed);
+        REQUIRE(events[0].index == 0);
+        REQUIRE(events[1].type == SourceEvent::MarkerCrossed);
+        REQUIRE(events[1].index == 1);
+        REQUIRE(events[2].type == SourceEvent::Looped);
+        REQUIRE(events[3].type == SourceEvent::MarkerCrossed);
+        REQUIRE(events[3].index == 0);
+        for (const auto &event : events)
+            REQUIRE(event.source == source);
+    }
+
+    SECTION("Events are not collected without a callback")
+    {
+        REQUIRE(engine.setEventCallback(nullptr));
+        REQUIRE(engine.playSound(&buffer, false, false, true, nullptr));
+
+        engine.update();
+        device->process();
+        device->process();
+        engine.update();
+
+        REQUIRE(events.empty());
+        size_t dropped;
+        REQUIRE(engine.getDroppedEvents(&dropped));
+        REQUIRE(dropped == 0);
+    }
+}
+
+TEST_CASE("Engine command coalescing")
+{
+    const TestSound sound("coalesce");
+    TestEngine test;
+    auto &engine = test.engine;
+
+    Handle<PCMSource> source;
+    REQUIRE(engine.playSound(&sound.buffer, true, true, false, &source));
+    engine.update();
+
+    Handle<PanEffect> panner;
+    REQUIRE(source->getPanner(&panner));
+
+    SECTION("Only the latest value of each parameter is queued")
+    {
+        for (int i = 1; i <= 100; ++i)
+        {
+            const auto value = static_cast<float>(i) / 100.f;
+            REQUIRE(source->setVolume(value));
+            REQUIRE(source->setSpeed(value * 2.f));
+            panner->left(1.f - value);
+            panner->right(value);
+        }
+
+        size_t pending;
+        REQUIRE(engine.getPendingCommands(&pending));
+        REQUIRE(pending == 4);
+
+        engine.update();
+        REQUIRE(engine.getPendingCommands(&pending));
+        REQUIRE(pending == 0);
+
+        float value;
+        REQUIRE(source->getVolume(&value));
+        REQUIRE(value == 1.f);
+        REQUIRE(source->getSpeed(&value));
+        REQUIRE(value == 2.f);
+        REQUIRE(panner->left() == 0);
+        REQUIRE(panner->right() == 1.f);
+    }
+
+    SECTION("Other commands keep their order and are not merged")
+    {
+        REQUIRE(source->setLooping(false));
+        REQUIRE(source->setVolume(.5f));
+        REQUIRE(source->setLooping(true));
+        REQUIRE(source->setVolume(.25f));
+
+        size_t pending;
+        REQUIRE(engine.getPendingCommands(&pending));
+        REQUIRE(pending == 3);
+
+        engine.update();
+
+        bool looping;
+        REQUIRE(source->getLooping(&looping));
+        REQUIRE(looping);
+        float volume;
+        REQUIRE(source->getVolume(&volume));
+        REQUIRE(volume == .25f);
+    }
+}
+
+TEST_CASE("Engine parameter ramps")
+{
+    const TestSound sound("ramps");
+    const auto &buffer = sound.buffer;
+    const auto level = sound.level;
+    TestEngine test;
+    auto &engine = test.engine;
+    const auto device = test.device;
+    REQUIRE(engine.setRenderQuantum(0)); // ramps span the whole buffer
+
+    Handle<PCMSource> source;
+    REQUIRE(engine.playSound(&buffer, true, true, false, &source));
+    REQUIRE(source->setVolume(.25f));
+    REQUIRE(source->setPaused(false));
+    engine.update();
+
+    // the first buffer uses the initial volume without ramping from the default
+    auto samples = reinterpret_cast<const float *>(device->process().data());
+    REQUIRE(samples[0] == .25f * level);
+    REQUIRE(samples[BufferFrames * 2 - 1] == .25f * level);
+
+    SECTION("Volume ramps linearly across one buffer, then holds")
+    {
+        REQUIRE(source->setVolume(1.f));
+        engine.update();
+
+        samples = reinterpret_cast<const float *>(device->process().data());
+        REQUIRE(samples[0] == .25f * level);
+        REQUIRE(std::abs(samples[BufferFrames] - .625f * level) < level * 1e-4f); // halfway frame
+        for (int i = 2; i < BufferFrames * 2; i += 2)
+        {
+            REQUIRE(samples[i] > samples[i - 2]);
+            REQUIRE(samples[i + 1] == samples[i]);
+        }
+
+        samples = reinterpret_cast<const float *>(device->process().data());
+        REQUIRE(samples[0] == level);
+        REQUIRE(samples[BufferFrames * 2 - 1] == level);
+    }
+
+    SECTION("Exponential volume ramps meet at the geometric mean")
+    {
+        Handle<VolumeEffect> volume;
+        REQUIRE(source->getVolumeEffect(&volume));
+        volume->ramp(VolumeEffect::Ramp::Exponential);
+        REQUIRE(source->setVolume(1.f));
+        engine.update();
+
+        samples = reinterpret_cast<const float *>(device->process().data());
+        REQUIRE(samples[0] == .25f * level);
+        REQUIRE(std::abs(samples[BufferFrames] - .5f * level) < level * 1e-4f);
+    }
+
+    SECTION("The fused default chain matches processing effect by effect")
+    {
+        // A second engine with a bypassed effect in the chain, which runs each effect separately
+        TestEngine separateTest;
+        auto &separateEngine = separateTest.engine;
+        const auto separateDevice = separateTest.device;
+        REQUIRE(separateEngine.setRenderQuantum(0));
+
+        Handle<PCMSource> separate;
+        REQUIRE(separateEngine.playSound(&buffer, true, true, false, &separate));
+        REQUIRE(separate->addEffect<BypassEffect>(0).isValid());
+        REQUIRE(separate->setVolume(.25f));
+        REQUIRE(separate->setPaused(false));
+        separateEngine.update();
+        separateDevice->process();
+
+        for (const auto source : {static_cast<Handle<PCMSource>>(source), separate})
+        {
+            Handle<PanEffect> panner;
+            REQUIRE(source->getPanner(&panner));
+            panner->left(.3f);
+            panner->right(.8f);
+            REQUIRE(source->setVolume(.6f));
+            REQUIRE(source->fadeTo(0, BufferFrames * 2, FadeCurve::SCurve));
+        }
+        engine.update();
+        separateEngine.update();
+
+        for (int block = 0; block < 3; ++block)
+        {
+            const auto fused = reinterpret_cast<const float *>(device->process().data());
+            const auto expected = reinterpret_cast<const float *>(separateDevice->process().data());
+            for (int i = 0; i < BufferFrames * 2; ++i)
+                REQUIRE(std::abs(fused[i] - expected[i]) < level * 1e-5f);
+        }
+    }
+
+    SECTION("A fade that ends partway into a buffer runs the default chain from an unaligned frame")
+    {
+        constexpr uint32_t FadeFrames = 101;
+        REQUIRE(source->setVolume(.5f));
+        REQUIRE(source->fadeTo(.3f, FadeFrames));
+        engine.update();
+
+        samples = reinterpret_cast<const float *>(device->process().data());
+        for (uint32_t f = FadeFrames; f < BufferFrames; ++f)
+        {
+            const auto volume = .25f + .25f * static_cast<float>(f) / BufferFrames;
+            REQUIRE(std::abs(samples[f * 2] - .3f * volume * level) < level * 1e-4f);
+            REQUIRE(samples[f * 2 + 1] == samples[f * 2]);
+        }
+
+        samples = reinterpret_cast<const float *>(device->process().data());
+        for (int i = 0; i < BufferFrames * 2; ++i)
+            REQUIRE(std::abs(samples[i] - .15f * level) < level * 1e-5f);
+    }
+
+    SECTION("Planar effects match processing interleaved")
+    {
+        // The panner follows the planar effect, so runs on the planar block too
+        TestEngine interleavedTest;
+        auto &interleavedEngine = interleavedTest.engine;
+        const auto interleavedDevice = interleavedTest.device;
+        REQUIRE(interleavedEngine.setRenderQuantum(0));
+
+        Handle<PCMSource> interleaved;
+        REQUIRE(interleavedEngine.playSound(&buffer, true, true, false, &interleaved));
+        REQUIRE(interleaved->addEffect<HalveLeftEffect>(0, false).isValid());
+        REQUIRE(interleaved->setVolume(.25f));
+        REQUIRE(interleaved->setPaused(false));
+        interleavedEngine.update();
+        interleavedDevice->process();
+
+        REQUIRE(source->addEffect<HalveLeftEffect>(0, true).isValid());
+        for (const auto source : {static_cast<Handle<PCMSource>>(source), interleaved})
+        {
+            Handle<PanEffect> panner;
+            REQUIRE(source->getPanner(&panner));
+            panner->left(.3f);
+            panner->right(.8f);
+            REQUIRE(source->setVolume(.6f));
+        }
+        engine.update();
+        interleavedEngine.update();
+
+        for (int block = 0; block < 3; ++block)
+        {
+            const auto planar = reinterpret_cast<const float *>(device->process().data());
+            const auto expected = reinterpret_cast<const float *>(interleavedDevice->process().data());
+            for (int i = 0; i < BufferFrames * 2; ++i)
+                REQUIRE(std::abs(planar[i] - expected[i]) < level * 1e-5f);
+        }
+    }
+
+    SECTION("Pan levels ramp linearly")
+    {
+        Handle<PanEffect> panner;
+        REQUIRE(source->getPanner(&panner));
+        panner->right(0);
+        engine.update();
+
+        // the right channel fades out while the left one takes in the right input
+        samples = reinterpret_cast<const float *>(device->process().data());
+        REQUIRE(samples[0] == .25f * level);
+        REQUIRE(samples[1] == .25f * level);
+        REQUIRE(std::abs(samples[BufferFrames] - .375f * level) < level * 1e-4f);
+        REQUIRE(std::abs(samples[BufferFrames + 1] - .125f * level) < level * 1e-4f);
+
+        samples = reinterpret_cast<const float *>(device->process().data());
+        REQUIRE(samples[0] == .5f * level);
+        REQUIRE(samples[1] == 0);
+    }
+}
+
+TEST_CASE("Engine scratch memory")
+{
+    const TestSound sound("scratch");
+    const auto &buffer = sound.buffer;
+    const auto level = sound.level;
+    TestEngine test;
+    auto &engine = test.engine;
+    const auto device = test.device;
+
+    MemoryStats initial;
+    REQUIRE(engine.getMemoryStats(&initial));
+    REQUIRE(initial.graphHeight == 1);
+    REQUIRE(initial.scratchBuffers > 0);
+    int quantum;
+    REQUIRE(engine.getRenderQuantum(&quantum));
+    REQUIRE(initial.scratchBytes >= initial.scratchBuffers * quantum * 2 * sizeof(float));
+
+    SECTION("Memory doesn't grow with the number of sources")
+    {
+        constexpr int SourceCount = 200;
+        for (int i = 0; i < SourceCount; ++i)
+        {
+            Handle<PCMSource> source;
+            REQUIRE(engine.playSound(&buffer, false, true, false, &source));
+            if (i % 3 == 0) // out-of-place effects take a second buffer
+                REQUIRE(source->addEffect<BypassEffect>(0).isValid());
+        }
+        engine.update();
+
+        const auto samples = reinterpret_cast<const float *>(device->process().data());
+        for (int i = 0; i < BufferFrames * 2; ++i)
+            REQUIRE(std::abs(samples[i] - SourceCount * level) < SourceCount * level * 1e-5f);
+
+        MemoryStats stats;
+        REQUIRE(engine.getMemoryStats(&stats));
+        REQUIRE(stats.scratchBytes == initial.scratchBytes);
+        REQUIRE(stats.peakScratchBuffers <= stats.scratchBuffers);
+    }
+
+    SECTION("Memory grows with the height of the graph, and covers a full mix at each level")
+    {
+        constexpr int Depth = 4;
+        constexpr int SourcesPerBus = Bus::SumBatchSize + 1;
+
+        std::vector<Handle<Bus>> buses(Depth);
+        for (auto &bus : buses)
+            REQUIRE(engine.createBus(false, &bus));
+        device->process(); // appends the buses
+
+        const auto playSources = [&](const int count) {
+            for (const auto &bus : buses)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    Handle<PCMSource> source;
+                    REQUIRE(engine.playSound(&buffer, false, true, false, bus, &source));
+                    REQUIRE(source->addEffect<BypassEffect>(0).isValid());
+                }
+            }
+            engine.update();
+            device->process(); // appends the sources
+        };
+
+        // Chain the buses so each is mixed last in a full batch, while the sources before it hold buffers
+        playSources(Bus::SumBatchSize - 1);
+        for (int depth = 1; depth < Depth; ++depth)
+            REQUIRE(Bus::connect(buses[depth - 1], buses[depth].cast<Source>()));
+        playSources(SourcesPerBus - (Bus::SumBatchSize - 1));
+
+        MemoryStats stats;
+        REQUIRE(engine.getMemoryStats(&stats));
+        REQUIRE(stats.graphHeight == Depth + 1);
+        REQUIRE(stats.scratchBuffers > initial.scratchBuffers);
+
+        const auto samples = reinterpret_cast<const float *>(device->process().data());
+        for (int i = 0; i < BufferFrames * 2; ++i)
+            REQUIRE(std::abs(samples[i] - Depth * SourcesPerBus * level) < Depth * SourcesPerBus * level * 1e-5f);
+
+        REQUIRE(engine.getMemoryStats(&stats));
+        REQUIRE(stats.peakScratchBuffers <= stats.scratchBuffers);
+        REQUIRE(stats.peakScratchBuffers > initial.scratchBuffers); // deeper levels were needed
+
+        engine.update(); // reports mixer errors
+        REQUIRE(popError().code == Result::Ok);
+    }
+}
+
+TEST_CASE("Engine odd buffer sizes")
+{
+    constexpr int OddFrames = 441; // 3528-byte buffers, every other one misaligned if packed back to back
+    const TestSound sound("odd");
+    TestEngine test(OddFrames);
+    auto &engine = test.engine;
+
+    // the master bus holds the first buffer, so the first source reads into the second, misaligned if packed
+    Handle<PCMSource> separate, fused;
+    REQUIRE(engine.playSound(&sound.buffer, false, true, false, &separate));
+    REQUIRE(engine.playSound(&sound.buffer, false, true, false, &fused));
+    REQUIRE(separate->addEffect<BypassEffect>(0).isValid());
+    for (const auto source : {fused, separate})
+    {
+        REQUIRE(source->setVolume(.5f));
+        Handle<PanEffect> panner;
+        REQUIRE(source->getPanner(&panner));
+        panner->left(.5f);
+    }
+    engine.update();
+
+    // the first buffer starts each source's levels, later ones hold them
+    test.device->process();
+    for (int block = 0; block < 3; ++block)
+    {
+        const auto samples = reinterpret_cast<const float *>(test.device->process().data());
+        for (int f = 0; f < OddFrames; ++f)
+        {
+            REQUIRE(std::abs(samples[f * 2] - .5f * sound.level) < sound.level * 1e-5f);
+            REQUIRE(std::abs(samples[f * 2 + 1] - 1.5f * sound.level) < sound.level * 1e-5f);
+        }
+    }
+}
+
+TEST_CASE("Engine render quantum")
+{
+    const TestSound sound("quantum");
+
+    /// Play the sound through once, with the sound ending partway through the second buffer
+    const auto render = [&sound](const int quantum, MemoryStats *outStats) {
+        TestEngine test;
+        REQUIRE(test.engine.setRenderQuantum(quantum));
+
+        Handle<PCMSource> source;
+        REQUIRE(test.engine.playSound(&sound.buffer, false, false, false, &source));
+        test.engine.update();
+
+        std::vector<float> output;
+        for (int i = 0; i < 3; ++i)
+        {
+            const auto samples = reinterpret_cast<const float *>(test.device->process().data());
+            output.insert(output.end(), samples, samples + BufferFrames * 2);
+        }
+
+        REQUIRE(test.engine.getMemoryStats(outStats));
+        return output;
+    };
+
+    Engine closed;
+    int quantum;
+    REQUIRE(closed.getRenderQuantum(&quantum));
+    REQUIRE(quantum == 512);
+    REQUIRE(!closed.setRenderQuantum(-1));
+    REQUIRE(popError().code == Result::InvalidArg);
+    REQUIRE(!closed.setRenderQuantum(101)); // not a multiple of 4
+    REQUIRE(popError().code == Result::InvalidArg);
+    REQUIRE(closed.getRenderQuantum(&quantum));
+    REQUIRE(quantum == 512);
+
+    MemoryStats wholeStats, quantumStats, unevenStats;
+    const auto whole = render(0, &wholeStats);
+    REQUIRE(whole[(SoundFrames - 1) * 2] != 0);
+    REQUIRE(whole[SoundFrames * 2] == 0);
+
+    SECTION("Quanta render the same output as the whole buffer, with smaller scratch buffers")
+    {
+        REQUIRE(render(128, &quantumStats) == whole);
+        REQUIRE(quantumStats.scratchBuffers == wholeStats.scratchBuffers);
+        REQUIRE(quantumStats.scratchBytes * 4 == wholeStats.scratchBytes);
+    }
+
+    SECTION("A quantum that doesn't divide the buffer renders a shorter last quantum")
+    {
+        REQUIRE(render(100, &unevenStats) == whole);
+    }
+
+    SECTION("A quantum larger than the buffer is clamped to it")
+    {
+        REQUIRE(render(BufferFrames * 4, &unevenStats) == whole);
+        REQUIRE(unevenStats.scratchBytes == wholeStats.scratchBytes);
+    }
+}
+
+TEST_CASE("Engine real-time options")
+{
+    const TestSound sound("realtime");
+    TestEngine test;
+    auto &engine = test.engine;
+    const auto device = test.device;
+
+    RealtimeOptions options;
+    REQUIRE(engine.getRealtimeOptions(&options));
+    REQUIRE(options.flushDenormals);
+    REQUIRE(options.priority == 0);
+    REQUIRE(options.core == -1);
+    REQUIRE(!options.lockMemory);
+
+    options.core = -2;
+    REQUIRE(!engine.setRealtimeOptions(options));
+    REQUIRE(popError().code == Result::InvalidArg);
+    options.core = -1;
+
+    Handle<PCMSource> source;
+    REQUIRE(engine.playSound(&sound.buffer, false, true, false, &source));
+    const auto probe = source->addEffect<DenormalProbeEffect>(0);
+    REQUIRE(probe.isValid());
+    engine.update();
+
+    SECTION("Denormals are flushed while mixing only, and the thread is set up once")
+    {
+        device->process();
+        REQUIRE(probe->flushed == detail::canFlushDenormals());
+        volatile float smallest = std::numeric_limits<float>::min();
+        REQUIRE(smallest * .5f != 0); // restored after the buffer
+
+        device->process();
+        RealtimeStats stats;
+        REQUIRE(engine.getRealtimeStats(&stats));
+        REQUIRE(stats.denormalsFlushed == detail::canFlushDenormals());
+        REQUIRE(stats.threadSetups == 1);
+        REQUIRE(!stats.priorityRaised);
+        REQUIRE(!stats.pinned);
+
+        options.flushDenormals = false;
+        REQUIRE(engine.setRealtimeOptions(options));
+        device->process();
+        REQUIRE(!probe->flushed);
+        REQUIRE(engine.getRealtimeStats(&stats));
+        REQUIRE(!stats.denormalsFlushed);
+        REQUIRE(stats.threadSetups == 2); // reapplied for the new options
+    }
+
+    SECTION("Unsetting priority and affinity restores the thread's own")
+    {
+        // Without permission the thread isn't raised, so there's nothing to restore
+        options.priority = 1;
+        options.core = 0;
+        REQUIRE(engine.setRealtimeOptions(options));
+        device->process();
+        engine.update(); // reports mixer errors
+        while (popError().code != Result::Ok) { }
+
+        options.priority = 0;
+        options.core = -1;
+        REQUIRE(engine.setRealtimeOptions(options));
+        device->process();
+        engine.update();
+        REQUIRE(popError().code == Result::Ok);
+
+        RealtimeStats stats;
+        REQUIRE(engine.getRealtimeStats(&stats));
+        REQUIRE(!stats.priorityRaised);
+        REQUIRE(!stats.pinned);
+        REQUIRE(stats.threadSetups == 2);
+    }
+
+    SECTION("Pools and mix buffers are locked into memory, unless over the process's limit")
+    {
+        options.lockMemory = true;
+        const auto locked = engine.setRealtimeOptions(options);
+
+        RealtimeStats stats;
+        REQUIRE(engine.getRealtimeStats(&stats));
+        if (locked)
+        {
+            MemoryStats memory;
+            REQUIRE(engine.getMemoryStats(&memory));
+            REQUIRE(stats.lockedBytes > memory.scratchBytes);
+
+            // Pages added later are locked too
+            engine.reserveObjects<PCMSource>(PoolBase::PageSize * 4);
+            RealtimeStats grown;
+            REQUIRE(engine.getRealtimeStats(&grown));
+            REQUIRE(grown.lockedBytes > stats.lockedBytes);
+        }
+        else
+        {
+            REQUIRE(popError().code == Result::RuntimeErr);
+        }
+
+        options.lockMemory = false;
+        REQUIRE(engine.setRealtimeOptions(options));
+        REQUIRE(engine.getRealtimeStats(&stats));
+        REQUIRE(stats.lockedBytes == 0);
+    }
+}
+
+TEST_CASE("Engine channel layouts")
+{
+    const TestSound sound("layouts");
+    const auto &buffer = sound.buffer;
+    const auto level = sound.level;
+
+    SECTION("A 5.1 output plays stereo sounds from the front pair")
+    {
+        TestEngine test(BufferFrames, ChannelLayout::Surround51);
+        auto &engine = test.engine;
+        const auto device = test.device;
+        REQUIRE(device->spec().channels == 6);
+
+        Handle<Bus> master;
+        REQUIRE(engine.getMasterBus(&master));
+        ChannelLayout layout;
+        REQUIRE(master->getLayout(&layout));
+        REQUIRE(layout == ChannelLayout::Surround51);
+
+        Handle<PCMSource> source;
+        REQUIRE(engine.playSound(&buffer, false, true, false, &source));
+        engine.update();
+
+        const auto &data = device->process();
+        REQUIRE(data.size() == BufferFrames * 6 * sizeof(float));
+        const auto samples = reinterpret_cast<const float *>(data.data());
+        for (int f = 0; f < BufferFrames; ++f)
+        {
+            REQUIRE(samples[f * 6] == level);
+            REQUIRE(samples[f * 6 + 1] == level);
+            for (int c = 2; c < 6; ++c)
+                REQUIRE(samples[f * 6 + c] == 0);
+        }
+    }
+
+    SECTION("A 5.1 bus is downmixed into a stereo master")
+    {
+        TestEngine test;
+        auto &engine = test.engine;
+        const auto device = test.device;
+
+        Handle<Bus> master, surround;
+        REQUIRE(engine.getMasterBus(&master));
+        REQUIRE(engine.createBus(false, master, ChannelLayout::Surround51, &surround));
+        device->process(); // appends the bus
+
+        Handle<PCMSource> source;
+        REQUIRE(engine.playSound(&buffer, false, true, false, surround, &source));
+        engine.update();
+        device->process(); // appends the source
+
+        // The stereo sound is upmixed to the front pair of the bus, which folds straight back into stereo
+        const auto samples = reinterpret_cast<const float *>(device->process().data());
+        for (int i = 0; i < BufferFrames * 2; ++i)
+            REQUIRE(std::abs(samples[i] - level) < level * 1e-5f);
+
+        engine.update(); // reports mixer errors
+        REQUIRE(popError().code == Result::Ok);
+    }
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core/Envelope.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using namespace insound;
+
+/// Run `frames` of ones through the envelope in blocks, returning the left channel, i.e. the gain per frame
+static std::vector<float> render(Envelope &envelope, const uint32_t frames, const uint32_t blockFrames = 64)
+{
+    std::vector<float> samples(frames * 2, 1.f);
+    for (uint32_t frame = 0; frame < frames; frame += blockFrames)
+        envelope.process(samples.data() + frame * 2, frame, std::min(blockFrames, frames - frame));
+
+    std::vector<float> gains(frames);
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        REQUIRE(samples[i * 2] == samples[i * 2 + 1]);
+        gains[i] = samples[i * 2];
+    }
+    return gains;
+}
+
+static bool near(const float a, const float b)
+{
+    return std::abs(a - b) < 1e-3f;
+}
+
+TEST_CASE("Envelope")
+{
+    Envelope envelope;
+
+    SECTION("No points leave samples unchanged")
+    {
+        const auto gains = render(envelope, 256);
+        for (const auto gain : gains)
+            REQUIRE(gain == 1.f);
+        REQUIRE(envelope.value() == 1.f);
+    }
+
+    SECTION("Linear segment, then the last value holds")
+    {
+        envelope.addPoint(100, 1.f);
+        envelope.addPoint(300, 0);
+
+        const auto gains = render(envelope, 512, 50);
+        REQUIRE(gains[0] == 1.f);
+        REQUIRE(gains[100] == 1.f);
+        REQUIRE(near(gains[150], .75f));
+        REQUIRE(near(gains[200], .5f));
+        REQUIRE(near(gains[299], 1.f / 200.f));
+        REQUIRE(gains[300] == 0);
+        REQUIRE(gains[511] == 0);
+        REQUIRE(envelope.value() == 0);
+    }
+
+    SECTION("Passed points are trimmed, keeping the start of the current segment")
+    {
+        for (uint32_t i = 0; i < 100; ++i)
+            envelope.addPoint(i * 10, static_cast<float>(i % 2));
+
+        std::vector<float> samples(128, 1.f);
+        for (uint32_t clock = 0; clock < 512; clock += 64)
+            envelope.process(samples.data(), clock, 64);
+        REQUIRE(envelope.points().size() == 49); // points at 510 and after
+        REQUIRE(envelope.points().front().clock == 510);
+
+        for (uint32_t clock = 512; clock < 1024; clock += 64)
+            envelope.process(samples.data(), clock, 64);
+        REQUIRE(envelope.points().empty());
+        REQUIRE(envelope.value() == 1.f); // last point, 990, had a value of 1
+    }
+
+    SECTION("Curves meet their midpoint values")
+    {
+        const auto midpoint = [&envelope](const FadeCurve curve, const float from, const float to) {
+            envelope.clear();
+            envelope.addPoint(0, from);
+            envelope.addPoint(1000, to, curve);
+            const auto gains = render(envelope, 1001, 128);
+            REQUIRE(near(gains[0], from));
+            REQUIRE(near(gains[1000], to));
+            return gains[500];
+        };
+
+        REQUIRE(near(midpoint(FadeCurve::Linear, .25f, 1.f), .625f));
+        REQUIRE(near(midpoint(FadeCurve::Exponential, .25f, 1.f), .5f));
+        REQUIRE(near(midpoint(FadeCurve::Exponential, 0, 1.f), .5f)); // falls back to linear from zero
+        REQUIRE(near(midpoint(FadeCurve::EqualPower, 0, 1.f), std::sqrt(.5f)));
+        REQUIRE(near(midpoint(FadeCurve::EqualPower, 1.f, 0), std::sqrt(.5f)));
+        REQUIRE(near(midpoint(FadeCurve::SCurve, 0, 1.f), .5f));
+
+        envelope.clear();
+        envelope.addPoint(0, 0);
+        envelope.addPoint(1000, 1.f, FadeCurve::SCurve);
+        const auto gains = render(envelope, 1001);
+        REQUIRE(gains[100] < .1f); // eases in
+        REQUIRE(gains[900] > .9f); // and out
+    }
+
+    SECTION("Equal power segments stay between their points")
+    {
+        for (const auto [from, to] : {std::pair(1.f, 1.f), std::pair(.5f, 1.f), std::pair(1.f, .5f),
+            std::pair(.2f, .8f)})
+        {
+            envelope.clear();
+            envelope.addPoint(0, from);
+            envelope.addPoint(1000, to, FadeCurve::EqualPower);
+            const auto gains = render(envelope, 1001, 100);
+            for (const auto gain : gains)
+            {
+                REQUIRE(gain >= std::min(from, to) - 1e-6f);
+                REQUIRE(gain <= std::max(from, to) + 1e-6f);
+            }
+            REQUIRE(near(gains[1000], to));
+        }
+    }
+
+    SECTION("Points added mid-segment apply from the current position")
+    {
+        envelope.addPoint(0, 0);
+        envelope.addPoint(1000, 1.f);
+
+        std::vector<float> samples(1024, 1.f);
+        envelope.process(samples.data(), 0, 500);
+        REQUIRE(near(envelope.value(), .5f));
+
+        // fade back down from the current value, as `Source::fadeTo` does
+        envelope.removePoints(500, 600);
+        envelope.addPoint(500, envelope.value());
+        envelope.addPoint(600, 0);
+        REQUIRE(envelope.points().size() == 4);
+
+        std::fill(samples.begin(), samples.end(), 1.f);
+        envelope.process(samples.data(), 500, 200);
+        REQUIRE(near(samples[0], .5f));
+        REQUIRE(near(samples[100], .25f)); // frame 550
+        REQUIRE(samples[200] == 0);        // frame 600
+        REQUIRE(samples[398] > 0);         // rising to the point at 1000 again
+        REQUIRE(envelope.points().size() == 2);
+    }
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core/Error.h>
+
+#include <cstring>
+
+using namespace insound;
+
+TEST_CASE("Error queue")
+{
+    while (hasError())
+        popError();
+
+    SECTION("Errors pushed in a queue scope are deferred until flushed")
+    {
+        detail::ErrorQueue queue(8);
+        {
+            const detail::ErrorQueueScope scope(&queue);
+            INSOUND_PUSH_ERROR(Result::InvalidArg, "first");
+            INSOUND_PUSH_ERROR(Result::LogicErr, "second");
+            REQUIRE(!hasError());
+        }
+
+        INSOUND_PUSH_ERROR(Result::RangeErr, "outside scope");
+        REQUIRE(popError().code == Result::RangeErr);
+        REQUIRE(!hasError());
+
+        REQUIRE(queue.flush() == 2);
+        const auto second = popError();
+        REQUIRE(second.code == Result::LogicErr);
+        REQUIRE(std::strcmp(second.message, "second") == 0);
+        REQUIRE(popError().code == Result::InvalidArg);
+        REQUIRE(!hasError());
+        REQUIRE(queue.dropped() == 0);
+    }
+
+    SECTION("Errors past capacity are counted as dropped")
+    {
+        detail::ErrorQueue queue(4);
+        {
+            const detail::ErrorQueueScope scope(&queue);
+            for (int i = 0; i < 10; ++i)
+                INSOUND_PUSH_ERROR(Result::RuntimeErr, "error");
+        }
+
+        REQUIRE(queue.dropped() == 6);
+        REQUIRE(queue.flush() == 4);
+        REQUIRE(queue.flush() == 0);
+        while (hasError())
+            popError();
+    }
+}
+
+TEST_CASE("System errors")
+{
+    while (detail::peekSystemError().code != Result::Ok)
+        detail::popSystemError();
+
+    SECTION("Errors pop in reverse order, with their messages")
+    {
+        detail::pushSystemError(Result::InvalidHandle);
+        detail::pushSystemError(Result::RuntimeErr, "second");
+        REQUIRE(detail::peekSystemError().code == Result::RuntimeErr);
+
+        const auto second = detail::popSystemError();
+        REQUIRE(second.code == Result::RuntimeErr);
+        REQUIRE(std::strcmp(second.message, "second") == 0);
+        const auto first = detail::popSystemError();
+        REQUIRE(first.code == Result::InvalidHandle);
+        REQUIRE(std::strcmp(first.message, "") == 0);
+        REQUIRE(detail::popSystemError().code == Result::Ok);
+    }
+
+    SECTION("The stack holds a fixed number of errors, and drops those pushed past it")
+    {
+        for (int i = 0; i < 100; ++i)
+            detail::pushSystemError(Result::InvalidHandle);
+
+        int count = 0;
+        while (detail::popSystemError().code != Result::Ok)
+            ++count;
+        REQUIRE(count == 32);
+    }
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace insound;
+
+static constexpr double Pi = 3.14159265358979323846;
+
+static constexpr InterpolationMode AllModes[] = {
+    InterpolationMode::Nearest,
+    InterpolationMode::Linear,
+    InterpolationMode::Cubic,
+    InterpolationMode::Sinc,
+};
+
+/// Stereo source frames with interpolation padding on both sides, `data()` points to the first frame
+struct PaddedFrames {
+    explicit PaddedFrames(const int frames) :
+        samples((frames + InterpolationPadBefore + InterpolationPadAfter + 1) * 2) { }
+
+    float *data() { return samples.data() + InterpolationPadBefore * 2; }
+
+    std::vector<float> samples;
+};
+
+/// @returns amplitude of the `freq` component in one channel of a stereo signal via the Goertzel algorithm
+static double toneAmplitude(const float *data, const int frames, const double freq)
+{
+    const auto coeff = 2.0 * std::cos(2.0 * Pi * freq);
+    double s1 = 0, s2 = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        const auto s0 = data[i * 2] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    return 2.0 * std::sqrt(std::max(s1 * s1 + s2 * s2 - coeff * s1 * s2, 0.0)) / frames;
+}
+
+TEST_CASE("Interpolation")
+{
+    SECTION("Unit speed at whole positions reproduces the source in every mode")
+    {
+        constexpr int Frames = 67;
+        PaddedFrames source(Frames + 8);
+        for (int i = 0; i < (Frames + 8) * 2; ++i)
+            source.data()[i] = std::sin(static_cast<float>(i) * .37f);
+
+        std::vector<float> output(Frames * 2);
+        for (const auto mode : AllModes)
+        {
+            interpolateStereo(mode, source.data(), 3.f, 1.f, 0, output.data(), Frames);
+            for (int i = 0; i < Frames * 2; ++i)
+                REQUIRE(std::abs(output[i] - source.data()[i + 6]) < 1e-6f);
+        }
+    }
+
+    SECTION("Linear interpolation at half speed produces midpoints")
+    {
+        constexpr int Frames = 31;
+        PaddedFrames source(Frames);
+        for (int i = 0; i < Frames; ++i)
+        {
+            source.data()[i * 2] = static_cast<float>(i);
+            source.data()[i * 2 + 1] = -static_cast<float>(i);
+        }
+
+        std::vector<float> output(Frames * 2);
+        interpolateStereo(InterpolationMode::Linear, source.data(), 0, .5f, 0, output.data(), Frames);
+        for (int i = 0; i < Frames; ++i)
+        {
+            REQUIRE(output[i * 2] == static_cast<float>(i) * .5f);
+            REQUIRE(output[i * 2 + 1] == -static_cast<float>(i) * .5f);
+        }
+    }
+
+    SECTION("Speed ramps advance the read position by a changing step")
+    {
+        constexpr int Frames = 41;
+        constexpr float Step = 1.f, StepDelta = .05f;
+        PaddedFrames source(200);
+        for (int i = 0; i < 200; ++i)
+        {
+            source.data()[i * 2] = static_cast<float>(i);
+            source.data()[i * 2 + 1] = static_cast<float>(i);
+        }
+
+        // linear interpolation of a ramp reads back the read position itself
+        std::vector<float> output(Frames * 2);
+        interpolateStereo(InterpolationMode::Linear, source.data(), .25f, Step, StepDelta, output.data(), Frames);
+
+        float expected = .25f, step = Step;
+        for (int i = 0; i < Frames; ++i)
+        {
+            REQUIRE(std::abs(output[i * 2] - expected) < 1e-3f);
+            REQUIRE(output[i * 2 + 1] == output[i * 2]);
+            expected += step;
+            step += StepDelta;
+        }
+    }
+
+    SECTION("Cubic interpolation is exact for quadratic signals")
+    {
+        constexpr int Frames = 53;
+        PaddedFrames source(Frames + 8);
+        for (int i = -InterpolationPadBefore; i < Frames + 8; ++i)
+        {
+            const auto x = static_cast<float>(i);
+            source.data()[i * 2] = .01f * x * x - .5f * x;
+            source.data()[i * 2 + 1] = 1.f - .02f * x * x;
+        }
+
+        std::vector<float> output(Frames * 2);
+        interpolateStereo(InterpolationMode::Cubic, source.data(), 1.1f, .73f, 0, output.data(), Frames);
+        for (int i = 0; i < Frames; ++i)
+        {
+            const auto x = 1.1f + static_cast<float>(i) * .73f;
+            REQUIRE(std::abs(output[i * 2] - (.01f * x * x - .5f * x)) < 1e-4f);
+            REQUIRE(std::abs(output[i * 2 + 1] - (1.f - .02f * x * x)) < 1e-4f);
+        }
+    }
+
+    SECTION("Pitch shifting moves a tone's frequency by the speed")
+    {
+        constexpr int SourceFrames = 8192, Frames = 4096;
+        constexpr double Freq = 1.0 / 128; // cycles per frame, whole cycles over the output at both pitches
+        PaddedFrames source(SourceFrames);
+        for (int i = 0; i < SourceFrames; ++i)
+        {
+            source.data()[i * 2] = static_cast<float>(std::sin(2.0 * Pi * Freq * i));
+            source.data()[i * 2 + 1] = source.data()[i * 2];
+        }
+
+        std::vector<float> output(Frames * 2);
+        for (const auto mode : {InterpolationMode::Linear, InterpolationMode::Cubic, InterpolationMode::Sinc})
+        {
+            interpolateStereo(mode, source.data(), 0, 1.5f, 0, output.data(), Frames);
+            REQUIRE(std::abs(toneAmplitude(output.data(), Frames, Freq * 1.5) - 1.0) < .01);
+            REQUIRE(toneAmplitude(output.data(), Frames, Freq) < .01);
+        }
+    }
+}
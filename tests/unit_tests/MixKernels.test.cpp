@@ -0,0 +1,114 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core/MixKernels.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace insound;
+
+static constexpr SimdPath Paths[] = {
+    SimdPath::Scalar, SimdPath::Neon, SimdPath::WasmSimd, SimdPath::Sse, SimdPath::Avx2, SimdPath::Avx512,
+};
+
+static bool near(const float a, const float b)
+{
+    return std::abs(a - b) <= 1e-5f * std::max(1.f, std::abs(b));
+}
+
+/// Samples that differ in every lane, offset so buffers don't match each other
+static std::vector<float> signal(const size_t count, const float offset)
+{
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; ++i)
+        samples[i] = std::sin(static_cast<float>(i) * .37f + offset);
+    return samples;
+}
+
+TEST_CASE("MixKernels")
+{
+    const auto original = simdPath();
+    REQUIRE(isSimdPathSupported(original));
+
+    SECTION("The widest supported path is selected on load")
+    {
+        for (const auto path : Paths)
+        {
+            if (isSimdPathSupported(path))
+                REQUIRE(path <= original);
+        }
+    }
+
+    SECTION("Unsupported paths are rejected")
+    {
+        for (const auto path : Paths)
+        {
+            if (!isSimdPathSupported(path))
+            {
+                REQUIRE(!setSimdPath(path));
+                REQUIRE(simdPath() == original);
+            }
+        }
+    }
+
+    SECTION("Every supported path matches a scalar reference")
+    {
+        constexpr uint32_t Count = 134; // 67 stereo frames, leaves a tail after each vector width
+        const auto a = signal(Count, 0), b = signal(Count, 1.f), c = signal(Count, 2.f), d = signal(Count, 3.f);
+
+        for (const auto path : Paths)
+        {
+            if (!setSimdPath(path))
+                continue;
+            INFO(simdPathName(path));
+            REQUIRE(simdPath() == path);
+            const auto &kernels = mixKernels();
+
+            auto output = signal(Count, 4.f);
+            auto expected = output;
+            kernels.add(a.data(), output.data(), Count);
+            for (uint32_t i = 0; i < Count; ++i)
+                REQUIRE(output[i] == expected[i] + a[i]);
+
+            const float *inputs[] = {a.data(), b.data(), c.data(), d.data(), a.data(), b.data(), c.data()};
+            constexpr float Gains[] = {.1f, .2f, .3f, .4f, .5f, .6f, .7f};
+            output = expected;
+            kernels.sum(inputs, nullptr, 7, output.data(), Count); // a group of four and three left over
+            for (uint32_t i = 0; i < Count; ++i)
+                REQUIRE(near(output[i], expected[i] + 2.f * (a[i] + b[i] + c[i]) + d[i]));
+
+            output = expected;
+            kernels.sum(inputs, Gains, 7, output.data(), Count);
+            for (uint32_t i = 0; i < Count; ++i)
+                REQUIRE(near(output[i], expected[i] + a[i] * .6f + b[i] * .8f + c[i] * 1.f + d[i] * .4f));
+
+            // Spans several cache blocks
+            const auto longA = signal(Count * 10, 5.f), longB = signal(Count * 10, 6.f);
+            const float *longInputs[] = {longA.data(), longB.data()};
+            std::vector<float> longOutput(Count * 10);
+            kernels.sum(longInputs, nullptr, 2, longOutput.data(), Count * 10);
+            for (uint32_t i = 0; i < Count * 10; ++i)
+                REQUIRE(longOutput[i] == longA[i] + longB[i]);
+
+            kernels.gain(a.data(), output.data(), Count, .3f);
+            for (uint32_t i = 0; i < Count; ++i)
+                REQUIRE(output[i] == a[i] * .3f);
+
+            output = a; // in-place
+            kernels.stereoRamp(output.data(), output.data(), Count / 2, .2f, .01f);
+            for (uint32_t i = 0; i < Count; ++i)
+                REQUIRE(near(output[i], a[i] * (.2f + .01f * static_cast<float>(i / 2))));
+
+            auto line = b;
+            output = a; // in-place
+            kernels.delay(output.data(), output.data(), line.data(), Count, .4f, .6f, .5f);
+            for (uint32_t i = 0; i < Count; ++i)
+            {
+                REQUIRE(near(output[i], a[i] * .4f + b[i] * .6f)); // fused on wide paths
+                REQUIRE(line[i] == a[i] * .5f);
+            }
+        }
+    }
+
+    REQUIRE(setSimdPath(original));
+}
@@ -3,6 +3,37 @@
 
 using namespace insound;
 
+/// Poolable object that allocates another pooled object from `init`, as Source does with its default effects
+struct PooledChild {
+    bool init(int value) { this->value = value; return true; }
+    void release() { value = 0; }
+    int value = 0;
+};
+
+/// Small PoolTyped hierarchy for checked casts
+struct Shape : PoolTyped {
+    virtual ~Shape() = default;
+    bool init() { return true; }
+    void release() { }
+};
+
+struct Circle final : Shape { };
+struct Square final : Shape { };
+
+struct PooledParent {
+    bool init(MultiPool *pool, int value)
+    {
+        this->pool = pool;
+        child = pool->allocate<PooledChild>(value);
+        return true;
+    }
+
+    void release() { pool->deallocate(child); }
+
+    MultiPool *pool = nullptr;
+    Handle<PooledChild> child;
+};
+
 TEST_CASE("Resizable Pool tests")
 {
     SECTION("Pool can allocate simple data types, check size")
@@ -35,4 +66,140 @@ TEST_CASE("Resizable Pool tests")
         pool.allocate();
         REQUIRE(pool.maxSize() > 256);
     }
+
+    SECTION("Expansion keeps existing elements in place")
+    {
+        Pool<int> pool;
+        auto first = pool.allocate();
+        const auto address = pool.get(first);
+        new (address) int(7);
+
+        for (int i = 0; i < 1000; ++i)
+            pool.allocate();
+
+        REQUIRE(pool.maxSize() >= 1001);
+        REQUIRE(pool.get(first) == address);
+        REQUIRE(*(int *)pool.get(first) == 7);
+
+        PoolID found;
+        REQUIRE(pool.tryFind(address, &found));
+        REQUIRE(found.index == first.index);
+        REQUIRE(found.generation == first.generation);
+    }
+
+    SECTION("Reserve rounds up to whole pages and keeps free slots")
+    {
+        Pool<int> pool;
+        pool.reserve(1);
+        REQUIRE(pool.maxSize() == Pool<int>::PageSize);
+
+        auto id = pool.allocate();
+        pool.reserve(Pool<int>::PageSize * 3);
+        REQUIRE(pool.maxSize() == Pool<int>::PageSize * 3);
+
+        // every remaining slot is usable without adding pages
+        for (size_t i = 1; i < Pool<int>::PageSize * 3; ++i)
+            REQUIRE(pool.isValid(pool.allocate()));
+        REQUIRE(pool.maxSize() == Pool<int>::PageSize * 3);
+        REQUIRE(pool.isValid(id));
+    }
+}
+
+TEST_CASE("MultiPool tests")
+{
+    SECTION("Each type gets a distinct, stable id")
+    {
+        REQUIRE(poolTypeId<PooledParent>() != poolTypeId<PooledChild>());
+        REQUIRE(poolTypeId<PooledParent>() == poolTypeId<PooledParent>());
+    }
+
+    SECTION("Objects may allocate other pooled objects during init")
+    {
+        MultiPool pool;
+        const auto parent = pool.allocate<PooledParent>(&pool, 10);
+        REQUIRE(parent.isValid());
+        REQUIRE(parent->child.isValid());
+        REQUIRE(parent->child->value == 10);
+
+        const auto child = parent->child;
+        REQUIRE(pool.deallocate(parent));
+        REQUIRE(!parent.isValid());
+        REQUIRE(!child.isValid());
+    }
+
+    SECTION("Handles are 64-bit and go stale when their slot is reused")
+    {
+        REQUIRE(sizeof(Handle<PooledChild>) == 8);
+
+        MultiPool pool;
+        const auto first = pool.allocate<PooledChild>(1);
+        REQUIRE(first.isValid());
+        REQUIRE(pool.deallocate(first));
+        REQUIRE(!first.isValid());
+        REQUIRE(static_cast<bool>(first)); // not null, just stale
+
+        const auto second = pool.allocate<PooledChild>(2);
+        REQUIRE(second.id().index == first.id().index); // same slot, new generation
+        REQUIRE(second.isValid());
+        REQUIRE(!first.isValid());
+        REQUIRE(first != second);
+
+        REQUIRE(!Handle<PooledChild>().isValid());
+        REQUIRE(!static_cast<bool>(Handle<PooledChild>()));
+        pool.deallocate(second);
+    }
+
+    SECTION("Handles into a destroyed pool are invalid")
+    {
+        Handle<PooledChild> handle;
+        {
+            MultiPool pool;
+            handle = pool.allocate<PooledChild>(1);
+            REQUIRE(handle.isValid());
+        }
+        REQUIRE(!handle.isValid());
+    }
+
+    SECTION("Casts check the concrete type stamped at allocation")
+    {
+        MultiPool pool;
+        const auto circle = pool.allocate<Circle>();
+        const auto shape = circle.cast<Shape>(); // upcasts keep the handle
+        REQUIRE(shape == circle);
+        REQUIRE(shape->isType<Circle>());
+        REQUIRE(!shape->isType<Square>());
+
+        REQUIRE(shape.getAs<Circle>() == circle.get());
+        REQUIRE(shape.getAs<Square>() == nullptr);
+        REQUIRE(shape.cast<Circle>() == circle);
+        REQUIRE(!shape.cast<Square>());
+
+        Shape *raw = shape.get();
+        REQUIRE(poolCast<Circle>(raw) == circle.get());
+        REQUIRE(poolCast<Square>(raw) == nullptr);
+        REQUIRE(poolCast<Square>(static_cast<Shape *>(nullptr)) == nullptr);
+
+        pool.deallocate(circle);
+        REQUIRE(shape.getAs<Circle>() == nullptr); // invalid handles don't cast
+    }
+
+    SECTION("Handles can be found from raw pointers")
+    {
+        MultiPool pool;
+        pool.reserve<PooledChild>(4);
+
+        const auto a = pool.allocate<PooledChild>(1);
+        const auto b = pool.allocate<PooledChild>(2);
+
+        Handle<PooledChild> found;
+        REQUIRE(pool.tryFind(b.get(), &found));
+        REQUIRE(found == b);
+        REQUIRE(found != a);
+
+        PooledChild other;
+        REQUIRE(!pool.tryFind(&other, &found));
+
+        pool.deallocate(a);
+        pool.deallocate(b);
+    }
 }
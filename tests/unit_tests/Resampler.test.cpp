@@ -0,0 +1,171 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace insound;
+
+static constexpr double Pi = 3.14159265358979323846;
+
+/// Resample a mono sine wave, flushing the filter's tail so output stays aligned with the input
+static std::vector<float> resampleSine(const int inFreq, const int outFreq, const double toneFreq,
+    const ResampleQuality quality, const uint64_t frameCount)
+{
+    std::vector<float> input(frameCount);
+    for (uint64_t i = 0; i < frameCount; ++i)
+        input[i] = static_cast<float>(std::sin(2.0 * Pi * toneFreq * static_cast<double>(i) / inFreq));
+
+    Resampler resampler;
+    REQUIRE(resampler.init(1, inFreq, outFreq, quality));
+
+    const auto outCount = frameCount * outFreq / inFreq;
+    std::vector<float> output(outCount);
+
+    uint64_t inUsed = 0, outDone = 0;
+    while (inUsed < frameCount && outDone < outCount)
+    {
+        auto inFrames = frameCount - inUsed;
+        auto outFrames = outCount - outDone;
+        resampler.process(input.data() + inUsed, &inFrames, output.data() + outDone, &outFrames);
+        REQUIRE((inFrames > 0 || outFrames > 0));
+
+        inUsed += inFrames;
+        outDone += outFrames;
+    }
+
+    // flush the tail with silence
+    auto inFrames = resampler.requiredInputFrames(outCount - outDone);
+    auto outFrames = outCount - outDone;
+    resampler.process(nullptr, &inFrames, output.data() + outDone, &outFrames);
+    outDone += outFrames;
+
+    output.resize(outDone);
+    return output;
+}
+
+/// @returns amplitude of the `freq` component in a signal via the Goertzel algorithm
+static double toneAmplitude(const float *data, const uint64_t count, const double freq, const int sampleRate)
+{
+    const auto coeff = 2.0 * std::cos(2.0 * Pi * freq / sampleRate);
+    double s1 = 0, s2 = 0;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const auto s0 = data[i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    const auto power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    return 2.0 * std::sqrt(std::max(power, 0.0)) / static_cast<double>(count);
+}
+
+/// @returns root mean square of a signal
+static double rms(const float *data, const uint64_t count)
+{
+    double sum = 0;
+    for (uint64_t i = 0; i < count; ++i)
+        sum += static_cast<double>(data[i]) * data[i];
+    return std::sqrt(sum / static_cast<double>(count));
+}
+
+TEST_CASE("Resampler")
+{
+    SECTION("Frame count estimates follow the rate ratio")
+    {
+        Resampler resampler;
+        REQUIRE(resampler.init(2, 44100, 48000));
+        REQUIRE(resampler.channels() == 2);
+        REQUIRE(resampler.inFreq() == 44100);
+        REQUIRE(resampler.outFreq() == 48000);
+
+        const auto out = resampler.expectedOutputFrames(44100);
+        REQUIRE(out <= 48000);
+        REQUIRE(out >= 48000 - resampler.inputLatency() * 2);
+        REQUIRE(resampler.requiredInputFrames(out) <= 44100);
+    }
+
+    SECTION("Higher quality tiers use longer filters")
+    {
+        Resampler low, best;
+        REQUIRE(low.init(1, 44100, 48000, ResampleQuality::Low));
+        REQUIRE(best.init(1, 44100, 48000, ResampleQuality::Best));
+        REQUIRE(low.taps() < best.taps());
+    }
+
+    SECTION("Invalid arguments fail")
+    {
+        Resampler resampler;
+        REQUIRE(!resampler.init(0, 44100, 48000));
+        REQUIRE(!resampler.init(2, 0, 48000));
+        popError();
+    }
+
+    SECTION("Passband tones keep their amplitude")
+    {
+        constexpr uint64_t FrameCount = 44100;
+        for (const auto quality : {ResampleQuality::Low, ResampleQuality::Medium, ResampleQuality::High,
+                                   ResampleQuality::Best})
+        {
+            for (const auto tone : {100.0, 1000.0, 10000.0})
+            {
+                const auto output = resampleSine(44100, 48000, tone, quality, FrameCount);
+                REQUIRE(output.size() == 48000);
+
+                // skip the filter ramp at both edges
+                const auto amplitude = toneAmplitude(output.data() + 4000, 40000, tone, 48000);
+                REQUIRE(std::abs(amplitude - 1.0) < .02);
+            }
+        }
+    }
+
+    SECTION("Tones above the output Nyquist frequency are attenuated")
+    {
+        constexpr uint64_t FrameCount = 48000;
+        for (const auto quality : {ResampleQuality::Medium, ResampleQuality::High, ResampleQuality::Best})
+        {
+            const auto output = resampleSine(48000, 22050, 15000.0, quality, FrameCount);
+            const auto level = rms(output.data() + 2000, output.size() - 4000);
+
+            // a full scale sine has an rms of ~.707, alias must sit well below -40 dB of it
+            REQUIRE(level < .707 * .01);
+        }
+    }
+
+    SECTION("Streaming in small blocks matches processing in one block")
+    {
+        constexpr uint64_t FrameCount = 4096;
+        std::vector<float> input(FrameCount * 2);
+        for (uint64_t i = 0; i < FrameCount; ++i)
+        {
+            input[i * 2] = static_cast<float>(std::sin(static_cast<double>(i) * .05));
+            input[i * 2 + 1] = static_cast<float>(std::cos(static_cast<double>(i) * .031));
+        }
+
+        Resampler whole, blocks;
+        REQUIRE(whole.init(2, 48000, 44100));
+        REQUIRE(blocks.init(2, 48000, 44100));
+
+        const auto outCount = whole.expectedOutputFrames(FrameCount);
+        std::vector<float> expected(outCount * 2), actual(outCount * 2);
+
+        uint64_t inFrames = FrameCount, outFrames = outCount;
+        whole.process(input.data(), &inFrames, expected.data(), &outFrames);
+        REQUIRE(outFrames == outCount);
+
+        uint64_t inUsed = 0, outDone = 0;
+        while (outDone < outCount)
+        {
+            uint64_t in = std::min<uint64_t>(37, FrameCount - inUsed);
+            uint64_t out = std::min<uint64_t>(29, outCount - outDone);
+            blocks.process(input.data() + inUsed * 2, &in, actual.data() + outDone * 2, &out);
+            REQUIRE((in > 0 || out > 0));
+            inUsed += in;
+            outDone += out;
+        }
+
+        for (uint64_t i = 0; i < outCount * 2; ++i)
+            REQUIRE(std::abs(actual[i] - expected[i]) < 1e-5f);
+    }
+}
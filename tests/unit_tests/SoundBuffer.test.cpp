@@ -0,0 +1,216 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core.h>
+#include <insound/core/external/miniaudio.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace insound;
+
+/// Write a 16-bit WAV file of a sine wave, returning its path
+static std::string writeSineWav(const char *name, const int channels, const int frames)
+{
+    const auto path = std::string(name) + ".test.wav";
+
+    const auto config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, channels, 48000);
+    ma_encoder encoder;
+    REQUIRE(ma_encoder_init_file(path.c_str(), &config, &encoder) == MA_SUCCESS);
+
+    std::vector<int16_t> samples(frames * channels);
+    for (int i = 0; i < frames; ++i)
+        for (int c = 0; c < channels; ++c)
+            samples[i * channels + c] = static_cast<int16_t>(std::sin(i * .01 * (c + 1)) * 20000);
+
+    REQUIRE(ma_encoder_write_pcm_frames(&encoder, samples.data(), frames, nullptr) == MA_SUCCESS);
+    ma_encoder_uninit(&encoder);
+    return path;
+}
+
+/// Append a sampler (smpl) chunk with one forward loop to a WAV file, `last` is the inclusive end frame
+static void appendSmplLoop(const std::string &path, const uint32_t first, const uint32_t last)
+{
+    std::vector<char> file;
+    {
+        std::ifstream in(path, std::ios::binary);
+        file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    const auto put32 = [&file](const uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            file.push_back(static_cast<char>(value >> (i * 8) & 0xFF));
+    };
+
+    file.insert(file.end(), {'s', 'm', 'p', 'l'});
+    put32(36 + 24);
+    for (int i = 0; i < 7; ++i) // manufacturer through smpte offset
+        put32(0);
+    put32(1); // loop count
+    put32(0); // sampler data size
+    put32(0); // cue point id
+    put32(0); // forward loop
+    put32(first);
+    put32(last);
+    put32(0); // fraction
+    put32(0); // play count, infinite
+
+    const auto riffSize = static_cast<uint32_t>(file.size() - 8);
+    for (int i = 0; i < 4; ++i)
+        file[4 + i] = static_cast<char>(riffSize >> (i * 8) & 0xFF);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(file.data(), static_cast<std::streamsize>(file.size()));
+}
+
+TEST_CASE("SoundBuffer storage")
+{
+    constexpr int Frames = 1000;
+    const auto f32 = SampleFormat(32, true, false, true);
+    const auto s16 = SampleFormat(16, false, false, true);
+
+    SECTION("Default layout is float32 stereo")
+    {
+        const auto path = writeSineWav("mono", 1, Frames);
+        SoundBuffer buffer;
+        REQUIRE(buffer.load(path, AudioSpec(48000, 2, f32)));
+
+        REQUIRE(buffer.spec().channels == 2);
+        REQUIRE(buffer.spec().format.flags() == f32.flags());
+        REQUIRE(buffer.frames() == Frames);
+        REQUIRE(buffer.size() == Frames * 2 * sizeof(float));
+        std::remove(path.c_str());
+    }
+
+    SECTION("Zero-ed channels and format keep a mono int16 source compact")
+    {
+        const auto path = writeSineWav("mono", 1, Frames);
+        SoundBuffer compact, full;
+        REQUIRE(compact.load(path, AudioSpec(48000, 0, SampleFormat())));
+        REQUIRE(full.load(path, AudioSpec(48000, 2, f32)));
+
+        REQUIRE(compact.spec().channels == 1);
+        REQUIRE(compact.spec().format.flags() == s16.flags());
+        REQUIRE(compact.frames() == Frames);
+        REQUIRE(compact.size() * 4 == full.size());
+        REQUIRE(SoundBuffer::isPlayableSpec(compact.spec()));
+
+        // same content at a quarter of the size
+        const auto compactData = reinterpret_cast<const int16_t *>(compact.data());
+        const auto fullData = reinterpret_cast<const float *>(full.data());
+        for (int i = 0; i < Frames; ++i)
+        {
+            REQUIRE(std::abs(compactData[i] / 32768.f - fullData[i * 2]) < 1e-6f);
+            REQUIRE(fullData[i * 2 + 1] == fullData[i * 2]);
+        }
+        std::remove(path.c_str());
+    }
+
+    SECTION("Int16 stereo halves the size")
+    {
+        const auto path = writeSineWav("stereo", 2, Frames);
+        SoundBuffer buffer;
+        REQUIRE(buffer.load(path, AudioSpec(48000, 0, s16)));
+
+        REQUIRE(buffer.spec().channels == 2);
+        REQUIRE(buffer.size() == Frames * 2 * sizeof(int16_t));
+        std::remove(path.c_str());
+    }
+
+    SECTION("Unplayable layouts are rejected or converted")
+    {
+        REQUIRE(!SoundBuffer::isPlayableSpec(AudioSpec(48000, 6, f32)));
+        REQUIRE(!SoundBuffer::isPlayableSpec(AudioSpec(48000, 2, SampleFormat(8, false, false, false))));
+        REQUIRE(!SoundBuffer::isPlayableSpec(AudioSpec(48000, 2, SampleFormat(16, false, true, true))));
+
+        // 8-bit storage is converted to float32
+        const auto path = writeSineWav("mono", 1, Frames);
+        SoundBuffer buffer;
+        REQUIRE(buffer.load(path, AudioSpec(48000, 1, SampleFormat(8, false, false, false))));
+        REQUIRE(buffer.spec().format.flags() == f32.flags());
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("SoundBuffer loop regions")
+{
+    constexpr int Frames = 1000;
+    const auto f32 = SampleFormat(32, true, false, true);
+
+    SECTION("Sampler chunk loops are retained on load")
+    {
+        const auto path = writeSineWav("loop", 1, Frames);
+        appendSmplLoop(path, 200, 799);
+
+        SoundBuffer buffer;
+        REQUIRE(buffer.load(path, AudioSpec(48000, 2, f32)));
+        REQUIRE(buffer.frames() == Frames);
+        REQUIRE(buffer.loopRegions().size() == 1);
+        REQUIRE(buffer.loopRegions()[0].start == 200);
+        REQUIRE(buffer.loopRegions()[0].end == 800);
+        REQUIRE(buffer.loopRegions()[0].crossfade == 0);
+        REQUIRE(buffer.crossfadeData(0) == nullptr);
+
+        // positions scale with the sample rate
+        SoundBuffer resampled;
+        REQUIRE(resampled.load(path, AudioSpec(24000, 2, f32)));
+        REQUIRE(resampled.loopRegions().size() == 1);
+        REQUIRE(resampled.loopRegions()[0].start == 100);
+        REQUIRE(resampled.loopRegions()[0].end == 400);
+        std::remove(path.c_str());
+    }
+
+    SECTION("Invalid regions are rejected")
+    {
+        const auto path = writeSineWav("loop", 2, Frames);
+        SoundBuffer buffer;
+        REQUIRE(buffer.load(path, AudioSpec(48000, 0, SampleFormat())));
+
+        REQUIRE(!buffer.addLoopRegion(500, 500));
+        REQUIRE(!buffer.addLoopRegion(100, Frames + 1));
+        REQUIRE(!buffer.addLoopRegion(50, 500, 51));   // crossfade longer than the lead-in
+        REQUIRE(!buffer.addLoopRegion(400, 500, 101)); // crossfade longer than the loop
+        REQUIRE(buffer.loopRegions().empty());
+        while (hasError())
+            popError();
+        std::remove(path.c_str());
+    }
+
+    SECTION("Crossfade blends the loop end into the frames before its start")
+    {
+        constexpr uint32_t Start = 300, End = 700, Fade = 64;
+        const auto path = writeSineWav("loop", 2, Frames);
+        SoundBuffer buffer;
+        REQUIRE(buffer.load(path, AudioSpec(48000, 0, SampleFormat())));
+
+        int index = -1;
+        REQUIRE(buffer.addLoopRegion(Start, End, Fade, &index));
+        REQUIRE(index == 0);
+        REQUIRE(buffer.loopRegions()[0].crossfade == Fade);
+
+        std::vector<float> frames(Frames * 2);
+        buffer.readFloatStereo(0, Frames, frames.data());
+
+        const auto tail = buffer.crossfadeData(index);
+        REQUIRE(tail != nullptr);
+        for (uint32_t i = 0; i < Fade; ++i)
+        {
+            const auto t = (i + .5) / Fade * 1.57079632679489661923;
+            for (int c = 0; c < 2; ++c)
+            {
+                const auto expected = frames[(End - Fade + i) * 2 + c] * std::cos(t) +
+                    frames[(Start - Fade + i) * 2 + c] * std::sin(t);
+                REQUIRE(std::abs(tail[i * 2 + c] - expected) < 1e-5);
+            }
+        }
+
+        // fades in from the loop's end and out to the frame before the start
+        REQUIRE(std::abs(tail[0] - frames[(End - Fade) * 2]) < .05f);
+        REQUIRE(std::abs(tail[(Fade - 1) * 2] - frames[(Start - 1) * 2]) < .05f);
+        std::remove(path.c_str());
+    }
+}
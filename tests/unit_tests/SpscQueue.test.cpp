@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <insound/core/SpscQueue.h>
+
+#include <thread>
+
+using namespace insound;
+
+TEST_CASE("SpscQueue")
+{
+    SECTION("Capacity rounds up to a power of two")
+    {
+        REQUIRE(SpscQueue<int>(1).capacity() == 2);
+        REQUIRE(SpscQueue<int>(64).capacity() == 64);
+        REQUIRE(SpscQueue<int>(100).capacity() == 128);
+    }
+
+    SECTION("Elements pop in order, pushes fail when full")
+    {
+        SpscQueue<int> queue(4);
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(queue.tryPush(i));
+        REQUIRE(!queue.tryPush(4));
+        REQUIRE(queue.size() == 4);
+
+        int value = -1;
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE(queue.tryPop(&value));
+            REQUIRE(value == i);
+        }
+        REQUIRE(!queue.tryPop(&value));
+        REQUIRE(queue.size() == 0);
+
+        // indices wrap around the ring
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE(queue.tryPush(i));
+            REQUIRE(queue.tryPop(&value));
+            REQUIRE(value == i);
+        }
+    }
+
+    SECTION("Producer and consumer threads")
+    {
+        constexpr int Count = 100000;
+        SpscQueue<int> queue(64);
+
+        std::thread producer([&queue]() {
+            for (int i = 0; i < Count; )
+            {
+                if (queue.tryPush(i))
+                    ++i;
+            }
+        });
+
+        int expected = 0;
+        bool ordered = true;
+        while (expected < Count)
+        {
+            int value;
+            if (queue.tryPop(&value))
+            {
+                ordered = ordered && value == expected;
+                ++expected;
+            }
+        }
+
+        producer.join();
+        REQUIRE(ordered);
+        REQUIRE(queue.size() == 0);
+    }
+}